@@ -20,25 +20,19 @@ GNU General Public License for more details.
 #include <QString>
 #include <QImageWriter>
 #include <QImageReader>
+#include <QMessageBox>
+#include <cmath>
+#include <cstring>
 #include "object.h"
 #include "editor.h"
 #include "mainwindow2.h"
 #include "layersound.h"
+#include "layerbitmap.h"
+#include "audiomixer.h"
 
 #define MIN(a,b) ((a)>(b)?(b):(a))
 
 
-
-
-qint16 safeSum ( qint16 a, qint16 b)
-{
-    if (((int)a + (int)b) > 32767)
-        return 32767;
-    if (((int)a + (int)b) < -32768)
-        return -32768;
-    return a+b;
-}
-
 void initialise()
 {
     qDebug() << "Initialize linux: <nothing, for now>";
@@ -59,11 +53,16 @@ void initialise()
     {qDebug() << "QImageWriter capability: " << format;}
 }
 
+QString AudioMixer::ffmpegPath()
+{
+    return "ffmpeg";
+}
+
 
 
 // added parameter exportFps -> frame rate of exported video
 // added parameter exportFormat -> to set ffmpeg parameters
-bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, int fps, int exportFps, QString exportFormat)
+bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, int fps, int exportFps, QString exportFormat, qreal curveOpacity)
 {
     if(!filePath.endsWith(".avi", Qt::CaseInsensitive))
     {
@@ -89,7 +88,7 @@ bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* curr
 
     QDir dir2(filePath);
     if (QFile::exists(filePath) == true) { dir2.remove(filePath); }
-    exportFrames1(startFrame, endFrame, view, currentLayer, exportSize, tempPath+"tmp", "png", 100, true, true, 2,&progress,50,fps,exportFps);
+    exportFrames1(startFrame, endFrame, view, currentLayer, exportSize, tempPath+"tmp", "png", 100, true, true, curveOpacity, &progress,50,fps,exportFps);
     // --------- Quicktime assemble call ----------
     QDir sampledir;
     qDebug() << "testmic:" << sampledir.filePath(filePath);
@@ -97,117 +96,48 @@ bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* curr
     QProcess ffmpeg;
 
     qDebug() << "Trying to export VIDEO";
-    quint32 audioDataSize = 44100*2*2*(endFrame-1)/fps;
-    qint16* audioData =(qint16*) malloc(audioDataSize);
-    for (uint i = 0; i < audioDataSize/2; i++ ) audioData[i] = 0;
-    quint16 header1[22];
-    bool audioDataValid = false;
+    // every clip is decoded once ( and cached ), the mix is computed block by block while the encoder reads it
+    AudioMixer mixer;
     for(int i = 0; i < this->getLayerCount() ; i++)
     {
         Layer* layer = this->getLayer(i);
         if(layer->type() == Layer::SOUND)
         {
-            for (int l = 0; l < ((LayerSound*)layer)->getSoundSize() ; l++)
-            {
-                if (((LayerSound*)layer)->soundIsNotNull(l))
-                {
-                    // convert audio file: 44100Hz sampling rate, stereo, signed 16 bit little endian
-                    // supported audio file types: wav, mp3, ogg... ( all file types supported by ffmpeg )
-                    qDebug() << "ffmpeg -i \"" + ((LayerSound*)layer)->getSoundFilepathAt(l) + "\" -ar 44100 -acodec pcm_s16le -ac 2 -y \"" + tempPath + "tmpaudio0.wav\"";
-                    ffmpeg.start("ffmpeg -i \"" + ((LayerSound*)layer)->getSoundFilepathAt(l) + "\" -ar 44100 -acodec pcm_s16le -ac 2 -y \"" + tempPath + "tmpaudio0.wav\"");
-                    if (ffmpeg.waitForStarted() == true)
-                    {
-                        if (ffmpeg.waitForFinished() == true)
-                        {
-                            QByteArray sErr = ffmpeg.readAllStandardError();
-                            if (sErr == "")
-                            {
-                                qDebug() << "ERROR: Could not execute FFmpeg.";
-                            }
-                            else
-                            {
-                                qDebug() << "stdout: " << ffmpeg.readAllStandardOutput();
-                                qDebug() << "stderr: " << sErr;
-                                qDebug() << "AUDIO conversion done. ( file: " << ((LayerSound*)layer)->getSoundFilepathAt(l) << ")";
-                            }
-                        }
-                        else
-                        {
-                            qDebug() << "ERROR: FFmpeg did not finish executing.";
-                        }
-                    }
-                    else
-                    {
-                        qDebug() << "ERROR: Could not execute FFmpeg.";
-                    }
-                    int frame = ((LayerSound*)layer)->getFramePositionAt(l)-1;
-                    float fframe = (float)frame/(float)fps;
-                    QFile file(tempPath+"tmpaudio0.wav");
-                    qDebug() << "audio file " + tempPath+"tmpaudio0.wav";
-                    file.open(QIODevice::ReadOnly);
-                    file.read((char*)header1,sizeof(header1));
-                    quint32 audioSize = header1[21];
-                    audioSize = audioSize * 65536 + header1[20];
-                    qDebug() << "audio len " << audioSize;
-                    // before calling malloc should check: audioSize < max credible value
-                    qint16* data = (qint16*) malloc(audioSize);
-                    file.read((char*)data,audioSize);
-                    audioDataValid = true;
-                    int delta = fframe*44100*2;
-                    qDebug() << "audio delta " << delta;
-                    int indexMax = MIN(audioSize/2,audioDataSize/2-delta);
-                    // audio files 'mixing': 'higher' sound layers overwrite 'lower' sound layers
-                    for (int index = 0; index < indexMax; index++)
-                    {
-                        audioData[index+delta] = safeSum(audioData[index+delta],data[index]);
-                    }
-                    free(data);
-                    file.close();
-                }
-            }
+            mixer.addLayer((LayerSound*)layer, fps, startFrame);
         }
     }
-    if ( audioDataValid )
-    {
-        // save mixed audio file ( will be used as audio stream )
-        QFile file(tempPath+"tmpaudio.wav");
-        file.open(QIODevice::WriteOnly);
-        header1[20] = audioDataSize % 65536;
-        header1[21] = audioDataSize / 65536;
-        file.write((char*)header1,sizeof(header1));
-        file.write((char*)audioData,audioDataSize);
-        file.close();
-    }
-
-    /*QString soundDelay = "";
-    for(int i = 0; i < this->getLayerCount() ; i++) {
-        Layer* layer = this->getLayer(i);
-        if(layer->type == Layer::SOUND) {
-            int lmax = ((LayerSound*)layer)->getSoundSize() ;
-            for (int l = 0; l < ((LayerSound*)layer)->getSoundSize() ; l++) {
-                if (((LayerSound*)layer)->soundIsNotNull(l)) {
-                    int frame = ((LayerSound*)layer)->getFramePositionAt(l)-1;
-                    float fframe = (float)frame/(float)fps;
-                    soundDelay.append("-itsoffset "+QString::number(fframe)+" -i \""+((LayerSound*)layer)->getSoundFilepathAt(l)+"\" ");
-                }
-            }
-        }
-    }*/
+    bool audioDataValid = !mixer.isEmpty();
 
     // video input:  frame sequence ( -i tmp%03d.png )
     //               frame rate     ( -r fps )
-    // audio input:                 ( -i tmpaudio.wav )
+    // audio input:  raw samples on the standard input ( -f s16le -ar 44100 -ac 2 -i - )
     // movie output:                ( filePath )
     //               frame rate     ( -r 25 )
+    QString audioInput = "";
     if ( audioDataValid )
     {
-        qDebug() << "ffmpeg -r " + QString::number(exportFps) + " -i " + tempPath + "tmp%4d.png -i " + tempPath + "tmpaudio.wav -r " + QString::number(exportFps) + " -y " + ffmpegParameter + "\"" + filePath + "\"";
-        ffmpeg.start("ffmpeg -r " + QString::number(exportFps) + " -i " + tempPath + "tmp%4d.png -i " + tempPath + "tmpaudio.wav -r " + QString::number(exportFps) + " -y " + ffmpegParameter + "\"" + filePath + "\"");
+        audioInput = "-f s16le -ar " + QString::number(AudioMixer::SAMPLE_RATE) + " -ac " + QString::number(AudioMixer::CHANNELS) + " -i - ";
     }
-    else
+    qDebug() << "ffmpeg -r " + QString::number(exportFps) + " -i " + tempPath + "tmp%4d.png " + audioInput + "-r " + QString::number(exportFps) + " -y " + ffmpegParameter + "\"" + filePath + "\"";
+    ffmpeg.start("ffmpeg -r " + QString::number(exportFps) + " -i " + tempPath + "tmp%4d.png " + audioInput + "-r " + QString::number(exportFps) + " -y " + ffmpegParameter + "\"" + filePath + "\"");
+    if ( audioDataValid && ffmpeg.waitForStarted() == true )
     {
-        qDebug() << "ffmpeg -r " + QString::number(exportFps) + " -i " + tempPath + "tmp%4d.png -r " + QString::number(exportFps) + " -y " + ffmpegParameter + "\"" + filePath + "\"";
-        ffmpeg.start("ffmpeg -r " + QString::number(exportFps) + " -i " + tempPath + "tmp%4d.png -r " + QString::number(exportFps) + " -y " + ffmpegParameter + "\"" + filePath + "\"");
+        const int blockFrames = 4096;
+        qint64 audioFrames = qint64(endFrame - startFrame + 1) * AudioMixer::SAMPLE_RATE / fps;
+        QVector<qint16> block(blockFrames * AudioMixer::CHANNELS);
+        for (qint64 position = 0; position < audioFrames; position += blockFrames)
+        {
+            int frames = MIN(blockFrames, audioFrames - position);
+            block.fill(0);
+            mixer.mix(block.data(), position, frames);
+            ffmpeg.write((const char*)block.constData(), frames * AudioMixer::CHANNELS * sizeof(qint16));
+            if (!ffmpeg.waitForBytesWritten(-1))
+            {
+                qDebug() << "ERROR: FFmpeg stopped reading the audio stream.";
+                break;
+            }
+        }
+        ffmpeg.closeWriteChannel();
     }
     if (ffmpeg.waitForStarted() == true)
     {
@@ -240,7 +170,6 @@ bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* curr
     }
 
     progress.setValue(100);
-    free(audioData);
 
 
     // --------- Clean up temp directory ---------
@@ -260,64 +189,104 @@ bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* curr
 
 void Editor::importMovie (QString filePath, int fps)
 {
-
-    int i;
-    QSettings settings("Pencil","Pencil");
-
     qDebug() << "-------IMPORT VIDEO------" << filePath;
 
-    // --------- Import all the temporary frames ----------
-    QDir::temp().mkdir("pencil");
-    QString tempPath = QDir::temp().absolutePath()+"/pencil/";
+    Layer* layer = m_pObject->getLayer( layerManager()->currentLayerIndex() );
+    if (layer == NULL || layer->type() != Layer::BITMAP)
+    {
+        QMessageBox::warning(this, tr("Warning"),
+                             tr("Please select a Bitmap layer to import a movie."),
+                             QMessageBox::Ok,
+                             QMessageBox::Ok);
+        return;
+    }
 
-    QProgressDialog progress("Importing movie...", "Abort", 0, 100, NULL);
+    // --------- Frame size and length of the movie ----------
+    QProcess ffprobe;
+    ffprobe.start("ffprobe", QStringList() << "-v" << "error" << "-select_streams" << "v:0"
+                  << "-show_entries" << "stream=width,height:format=duration"
+                  << "-of" << "default=noprint_wrappers=1" << filePath);
+    if (ffprobe.waitForStarted() == false || ffprobe.waitForFinished() == false)
+    {
+        qDebug() << "Please install FFMPEG: sudo apt-get install ffmpeg";
+        return;
+    }
+    int width = 0;
+    int height = 0;
+    double duration = 0.0;
+    foreach (QString line, QString(ffprobe.readAllStandardOutput()).split('\n'))
+    {
+        QString key = line.section('=', 0, 0).trimmed();
+        QString value = line.section('=', 1).trimmed();
+        if (key == "width") width = value.toInt();
+        if (key == "height") height = value.toInt();
+        if (key == "duration") duration = value.toDouble();
+    }
+    if (width <= 0 || height <= 0)
+    {
+        qDebug() << "ERROR: no video stream in" << filePath << ffprobe.readAllStandardError();
+        return;
+    }
+    int expectedFrames = qMax(1, (int)ceil(duration * fps));
+
+    // --------- Raw frames, read from the decoder while it runs ----------
+    // no temporary files: each frame goes into its key frame as soon as it is decoded,
+    // while ffmpeg goes on decoding the next ones
+    QProgressDialog progress("Importing movie...", "Abort", 0, expectedFrames, NULL);
     progress.setWindowModality(Qt::WindowModal);
     progress.show();
-    progress.setValue(10);
+
     QProcess ffmpeg;
-    qDebug() << "ffmpeg -i \"" << filePath << "\" -r " << QString::number(fps) << " -f image2 \"" << tempPath << "tmp_import%4d.png\"";
-    ffmpeg.start("ffmpeg -i \"" + filePath + "\" -r " + QString::number(fps) + " -f image2 \"" + tempPath + "tmp_import%4d.png\"");
-    progress.setValue(20);
-    if (ffmpeg.waitForStarted() == true)
+    ffmpeg.setReadChannel(QProcess::StandardOutput);
+    // the frames must come out at the size given by ffprobe: no rotation from the metadata,
+    // and an explicit size, which a non square pixel aspect ratio would change otherwise
+    ffmpeg.start("ffmpeg", QStringList() << "-loglevel" << "error" << "-noautorotate" << "-i" << filePath
+                 << "-r" << QString::number(fps) << "-s" << QString("%1x%2").arg(width).arg(height)
+                 << "-f" << "rawvideo" << "-pix_fmt" << "bgra" << "-");
+    if (ffmpeg.waitForStarted() == false)
     {
-        if (ffmpeg.waitForFinished() == true)
+        qDebug() << "Please install FFMPEG: sudo apt-get install ffmpeg";
+        return;
+    }
+
+    backup(tr("ImportMovie"));
+    // bgra is the memory layout of QImage::Format_ARGB32 on little endian machines,
+    // and movie frames are opaque, hence already premultiplied
+    const int rowBytes = width * 4;
+    const int frameBytes = rowBytes * height;
+    QByteArray pending;
+    int imported = 0;
+    bool decoding = true;
+    while (decoding)
+    {
+        decoding = ffmpeg.waitForReadyRead(-1);
+        pending.append(ffmpeg.readAllStandardOutput());
+
+        int offset = 0;
+        while (pending.size() - offset >= frameBytes)
         {
-            QByteArray sErr = ffmpeg.readAllStandardError();
-            if (sErr == "")
-            {qDebug() << "ERROR: Could not execute FFmpeg.";}
-            else
+            QImage frame(width, height, QImage::Format_ARGB32_Premultiplied);
+            for (int y = 0; y < height; y++)
             {
-                qDebug() << "stderr: " + ffmpeg.readAllStandardOutput();
-                qDebug() << "stdout: " << sErr;
+                memcpy(frame.scanLine(y), pending.constData() + offset + y * rowBytes, rowBytes);
             }
+            offset += frameBytes;
+
+            if (imported > 0) scrubForward();
+            importBitmapFrame((LayerBitmap*)layer, frame);
+            imported++;
+            progress.setValue(qMin(imported, expectedFrames - 1));
         }
-        else
-        {qDebug() << "ERROR: FFmpeg did not finish executing.";}
-    }
-    else
-    {qDebug() << "Please install FFMPEG: sudo apt-get install ffmpeg";}
-    progress.setValue(50);
-    QDir dir1(tempPath);
-    int nFiles = dir1.entryList().count();
-    i=1;
-    QString frameNumberString = QString::number(i);
-    while( frameNumberString.length() < 4) frameNumberString.prepend("0");
-    while (QFile::exists(tempPath+"tmp_import"+frameNumberString+".png"))
-    {
-        progress.setValue(50+i*50/nFiles);
-        if(i>1) scrubForward();
-        importImage(tempPath+"tmp_import"+frameNumberString+".png");
-        i++;
-        frameNumberString = QString::number(i);
-        while( frameNumberString.length() < 4) frameNumberString.prepend("0");
-    }
-    progress.setValue(100);
-    // --------- Clean up temp directory ---------
-    QDir dir(tempPath);
-    QStringList filtername("*.*");
-    QStringList entries = dir.entryList(filtername,QDir::Files,QDir::Type);
-    for(int i=0; i<entries.size(); i++)
-        dir.remove(entries[i]);
+        pending.remove(0, offset);
 
+        if (progress.wasCanceled())
+        {
+            ffmpeg.kill();
+            ffmpeg.waitForFinished();
+            break;
+        }
+    }
+    qDebug() << "VIDEO import done:" << imported << "frames";
+    progress.setValue(expectedFrames);
 }
 
@@ -13,6 +13,7 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
 GNU General Public License for more details.
 
 */
+#include <QFile>
 #include <QString>
 #include <QStringList>
 #include <QDir>
@@ -22,6 +23,8 @@ GNU General Public License for more details.
 #include "editor.h"
 #include "mainwindow2.h"
 #include "style.h"
+#include "pencilsettings.h"
+#include "audiomixer.h"
 
 #include <CoreFoundation/CoreFoundation.h>
 #include <Carbon/Carbon.h>
@@ -50,7 +53,27 @@ void initialise()
     qApp->setStyle(new AquaStyle());
 }
 
-bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, int fps, int exportFps, QString exportFormat)
+QString AudioMixer::ffmpegPath()
+{
+    // in the resources of the bundle, like the assembler of the movie export
+    CFURLRef pluginRef = CFBundleCopyBundleURL(CFBundleGetMainBundle());
+    CFStringRef macPath = CFURLCopyFileSystemPath(pluginRef,
+                          kCFURLPOSIXPathStyle);
+    const char* pathPtr = CFStringGetCStringPtr(macPath,
+                          CFStringGetSystemEncoding());
+    QString appPath = pathPtr;
+    CFRelease(pluginRef);
+    CFRelease(macPath);
+
+    QString bundled = appPath + "/Contents/Resources/ffmpeg";
+    if (QFile::exists(bundled))
+    {
+        return bundled;
+    }
+    return "ffmpeg";
+}
+
+bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, int fps, int exportFps, QString exportFormat, qreal curveOpacity)
 {
     Q_UNUSED(startFrame);
     Q_UNUSED(endFrame);
@@ -76,7 +99,7 @@ bool Object::exportMovie(int startFrame, int endFrame, QMatrix view, Layer* curr
     progress.show();
     //exportFrames1(startFrame, endFrame, view, currentLayer, exportSize, tempPath+"tmp", "png", 100, true, true, 2,&progress,50,fps,exportFps);
 
-    exportFrames1(startFrame, endFrame, view, currentLayer, exportSize, tempPath+"tmp", "jpg", 100, true, true, 2, &progress, 50, fps, exportFps);
+    exportFrames1(startFrame, endFrame, view, currentLayer, exportSize, tempPath+"tmp", "jpg", 100, true, true, curveOpacity, &progress, 50, fps, exportFps);
     qDebug() << "frames exported in temp directory";
 
     // --------- Quicktime assemble call ----------
@@ -121,7 +144,7 @@ void Editor::importMovie (QString filePath, int fps)
 {
 
     int i;
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
 
     qDebug() << "-------IMPORT VIDEO------" << filePath;
 
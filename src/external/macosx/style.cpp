@@ -14,6 +14,7 @@ GNU General Public License for more details.
 
 */
 #include <QtGui>
+#include "pencilsettings.h"
 #include "style.h"
 
 
@@ -211,8 +212,8 @@ void AquaStyle::drawControl(ControlElement element,
         painter->setPen( QColor(142,142,142) );
         QLinearGradient gradient(0,1,0,height);
 
-        QSettings settings("Pencil","Pencil");
-        QString style = settings.value("style").toString();
+        PencilSettings* settings = pencilSettings();
+        QString style = settings->value("style").toString();
         if(style=="") style = "default";
         if(style=="default")
         {
@@ -25,6 +25,8 @@ GNU General Public License for more details.
 #include "object.h"
 #include "editor.h"
 #include "layersound.h"
+#include "pencilsettings.h"
+#include "audiomixer.h"
 
 #define MIN(a,b) ((a)>(b)?(b):(a))
 
@@ -64,6 +66,12 @@ void initialise()
 
 
 
+QString AudioMixer::ffmpegPath()
+{
+    // shipped next to the application, where the movie export looks for it
+    return QDir::current().currentPath() + "/plugins/ffmpeg.exe";
+}
+
 // crashes when there is an empty sound layer (windows 95)
 // does not save audio
 // added parameter exportFps -> frame rate of exported video
@@ -76,7 +84,8 @@ bool Object::exportMovie(int startFrame,
                          QString filePath,
                          int fps,
                          int exportFps,
-                         QString exportFormat)
+                         QString exportFormat,
+                         qreal curveOpacity)
 {
     //  additional parameters for ffmpeg
     QString ffmpegParameter = "";
@@ -113,6 +122,7 @@ bool Object::exportMovie(int startFrame,
 					  "png",
 					  100,
 					  true, true,
+					  curveOpacity,
 					  &progress,
 					  50, fps,
 					  exportFps);
@@ -277,7 +287,7 @@ bool Object::exportMovie(int startFrame,
 void Editor::importMovie (QString filePath, int fps)
 {
     int i;
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
 
     qDebug() << "-------IMPORT VIDEO------" << filePath;
 
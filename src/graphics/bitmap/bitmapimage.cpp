@@ -15,7 +15,9 @@ GNU General Public License for more details.
 */
 #include <cmath>
 #include "bitmapimage.h"
+#include "bitmapmipmaps.h"
 #include "blur.h"
+#include "perfmonitor.h"
 #include "object.h"
 
 
@@ -24,6 +26,7 @@ BitmapImage::BitmapImage()
     // nothing
     image = NULL;
     extendable = true;
+    mipmaps = NULL;
 }
 
 BitmapImage::BitmapImage(Object* parent)
@@ -32,6 +35,7 @@ BitmapImage::BitmapImage(Object* parent)
     image = new QImage(0, 0, QImage::Format_ARGB32_Premultiplied);
     boundaries = QRect(0,0,0,0);
     extendable = true;
+    mipmaps = NULL;
 }
 
 BitmapImage::BitmapImage(Object* parent, QRect rectangle, QColor colour)
@@ -41,6 +45,7 @@ BitmapImage::BitmapImage(Object* parent, QRect rectangle, QColor colour)
     image = new QImage( boundaries.size(), QImage::Format_ARGB32_Premultiplied);
     image->fill(colour.rgba());
     extendable = true;
+    mipmaps = NULL;
 }
 
 BitmapImage::BitmapImage(Object* parent, QRect rectangle, QImage image)
@@ -50,6 +55,7 @@ BitmapImage::BitmapImage(Object* parent, QRect rectangle, QImage image)
     extendable = true;
     this->image = new QImage(image);
     if (this->image->width() != rectangle.width() || this->image->height() != rectangle.height()) qDebug() << "Error instancing bitmapImage.";
+    mipmaps = NULL;
 }
 
 /*BitmapImage::BitmapImage(Object *parent, QImage image, QPoint topLeft) {
@@ -64,6 +70,7 @@ BitmapImage::BitmapImage(const BitmapImage& a)
     boundaries=a.boundaries;
     image=new QImage(*a.image);
     extendable = true;
+    mipmaps = NULL;
 }
 
 BitmapImage::BitmapImage(Object* parent, QString path, QPoint topLeft)
@@ -73,11 +80,13 @@ BitmapImage::BitmapImage(Object* parent, QString path, QPoint topLeft)
     if (image->isNull()) qDebug() << "ERROR: Image " << path << " not loaded";
     boundaries = QRect( topLeft, image->size() );
     extendable = true;
+    mipmaps = NULL;
 }
 
 BitmapImage::~BitmapImage()
 {
     if (image) delete image;
+    delete mipmaps;
 }
 
 BitmapImage& BitmapImage::operator=(const BitmapImage& a)
@@ -85,6 +94,8 @@ BitmapImage& BitmapImage::operator=(const BitmapImage& a)
     myParent=a.myParent;
     boundaries=a.boundaries;
     image=new QImage(*a.image);
+    delete mipmaps;
+    mipmaps = NULL;
     return *this;
 }
 
@@ -124,9 +135,72 @@ void BitmapImage::setModified(bool)
 {
 }
 
+// below this size the image is always drawn directly
+static const int MIPMAP_MIN_PIXELS = 1024 * 1024;
+
 void BitmapImage::paintImage(QPainter& painter)
 {
-    painter.drawImage(topLeft(), *image);
+    // only the part of the image in view is drawn, so that a camera framing a small part
+    // of a large background costs the size of the output rather than the size of the image
+    QRect source = boundaries.intersected( visibleRect(painter) );
+    if (source.isEmpty())
+    {
+        return;
+    }
+
+    // zoomed out, a reduced copy is drawn so that only about as many pixels as on screen are filtered
+    qreal scale = sqrt( qAbs(painter.worldTransform().determinant()) );
+    int level = BitmapMipmaps::levelFor(scale);
+    if (level > 0 && image->width() * image->height() >= MIPMAP_MIN_PIXELS)
+    {
+        if (mipmaps == NULL) mipmaps = new BitmapMipmaps();
+        QImage reduced = mipmaps->image(*image, &level);
+        QRect local = source.translated(-topLeft());
+        QRect reducedSource = QRect( QPoint(local.left() >> level, local.top() >> level),
+                                     QPoint(local.right() >> level, local.bottom() >> level) ).adjusted(-1, -1, 1, 1).intersected(reduced.rect());
+        painter.save();
+        painter.translate(topLeft());
+        painter.scale(1 << level, 1 << level);
+        painter.drawImage(reducedSource.topLeft(), reduced, reducedSource);
+        painter.restore();
+        return;
+    }
+
+    if (source == boundaries)
+    {
+        painter.drawImage(topLeft(), *image);
+    }
+    else
+    {
+        painter.drawImage(source.topLeft(), *image, source.translated(-topLeft()));
+    }
+}
+
+// keeps the reduced copies up to date with a change of known extent
+void BitmapImage::pixelsChanged(qint64 keyBefore, QRect rectangle)
+{
+    if (mipmaps != NULL && image != NULL)
+    {
+        mipmaps->changed(keyBefore, *image, rectangle.translated(-topLeft()));
+    }
+}
+
+// the area of the drawing covered by the painter, rounded out by a margin for smooth scaling
+QRect BitmapImage::visibleRect(QPainter& painter)
+{
+    QPaintDevice* device = painter.device();
+    bool invertible = false;
+    QTransform inverse = painter.worldTransform().inverted(&invertible);
+    if (device == NULL || device->width() <= 0 || device->height() <= 0 || !invertible)
+    {
+        return boundaries; // unknown extent ( e.g. a picture or a generator without a size ), draw everything
+    }
+    QRectF visible = inverse.mapRect( QRectF(0, 0, device->width(), device->height()) );
+    if (painter.hasClipping())
+    {
+        visible &= painter.clipBoundingRect();
+    }
+    return visible.toAlignedRect().adjusted(-2, -2, 2, 2);
 }
 
 void outputImage(QImage* image, QSize size, QMatrix myView)
@@ -166,11 +240,13 @@ void BitmapImage::paste(BitmapImage* bitmapImage, QPainter::CompositionMode cm)
     {
         newBoundaries = boundaries.united( bitmapImage->boundaries );
     }
+    qint64 key = imageKey();
     extend( newBoundaries );
     QPainter painter(image);
     painter.setCompositionMode(cm);
     painter.drawImage( bitmapImage->boundaries.topLeft() - boundaries.topLeft(), *image2);
     painter.end();
+    pixelsChanged(key, bitmapImage->boundaries);
 }
 
 void BitmapImage::add(BitmapImage* bitmapImage)
@@ -397,7 +473,9 @@ void BitmapImage::setPixel(QPoint P, QRgb colour)
 void BitmapImage::drawLine( QPointF P1, QPointF P2, QPen pen, QPainter::CompositionMode cm, bool antialiasing)
 {
     int width = 2+pen.width();
-    extend( QRect(P1.toPoint(), P2.toPoint()).normalized().adjusted(-width,-width,width,width) );
+    QRect rectangle = QRect(P1.toPoint(), P2.toPoint()).normalized().adjusted(-width,-width,width,width);
+    qint64 key = imageKey();
+    extend( rectangle );
     if (image != NULL && !image->isNull() )
     {
         QPainter painter(image);
@@ -406,12 +484,14 @@ void BitmapImage::drawLine( QPointF P1, QPointF P2, QPen pen, QPainter::Composit
         painter.setPen(pen);
         painter.drawLine( P1-topLeft(), P2-topLeft());
         painter.end();
+        pixelsChanged(key, rectangle);
     }
 }
 
 void BitmapImage::drawRect( QRectF rectangle, QPen pen, QBrush brush, QPainter::CompositionMode cm, bool antialiasing)
 {
     int width = pen.width();
+    qint64 key = imageKey();
     extend( rectangle.adjusted(-width,-width,width,width).toRect() );
     if (brush.style() == Qt::RadialGradientPattern)
     {
@@ -430,12 +510,14 @@ void BitmapImage::drawRect( QRectF rectangle, QPen pen, QBrush brush, QPainter::
         //painter.fillRect( rectangle.translated(-topLeft()), QColor(255,0,0) );
         painter.drawRect( rectangle.translated(-topLeft()) );
         painter.end();
+        pixelsChanged(key, rectangle.adjusted(-width,-width,width,width).toAlignedRect());
     }
 }
 
 void BitmapImage::drawEllipse( QRectF rectangle, QPen pen, QBrush brush, QPainter::CompositionMode cm, bool antialiasing)
 {
     int width = pen.width();
+    qint64 key = imageKey();
     extend( rectangle.adjusted(-width,-width,width,width).toRect() );
     if (image != NULL && !image->isNull() )
     {
@@ -447,6 +529,7 @@ void BitmapImage::drawEllipse( QRectF rectangle, QPen pen, QBrush brush, QPainte
         //if (brush == Qt::NoBrush)
         painter.drawEllipse( rectangle.translated(-topLeft()) );
         painter.end();
+        pixelsChanged(key, rectangle.adjusted(-width,-width,width,width).toAlignedRect());
     }
 }
 
@@ -477,6 +560,7 @@ void BitmapImage::drawPath( QPainterPath path, QPen pen, QBrush brush, QPainter:
     int width = pen.width();
     qreal inc = 1.0+width/20.0; // qreal?
     //if (inc<1) { inc=1.0; }
+    qint64 key = imageKey();
     extend( path.controlPointRect().adjusted(-width,-width,width,width).toRect() );
 
     if (image != NULL && !image->isNull() )
@@ -510,6 +594,7 @@ void BitmapImage::drawPath( QPainterPath path, QPen pen, QBrush brush, QPainter:
             painter.drawPoint( path.elementAt(0).x, path.elementAt(0).y );
         }
         painter.end();
+        pixelsChanged(key, path.controlPointRect().adjusted(-width-1,-width-1,width+1,width+1).toAlignedRect());
     }
 }
 
@@ -540,10 +625,12 @@ void BitmapImage::clear(QRect rectangle)
 {
     QRect clearRectangle = boundaries.intersected( rectangle );
     clearRectangle.moveTopLeft( clearRectangle.topLeft() - topLeft() );
+    qint64 key = imageKey();
     QPainter painter(image);
     painter.setCompositionMode(QPainter::CompositionMode_Clear);
     painter.fillRect( clearRectangle, QColor(0,0,0,0) );
     painter.end();
+    pixelsChanged(key, rectangle);
 }
 
 int BitmapImage::sqr(int n)   // square of a number
@@ -557,9 +644,11 @@ int BitmapImage::rgbDistance(QRgb rgba1, QRgb rgba2)
     return result;
 }
 
-void BitmapImage::floodFill(BitmapImage* targetImage, BitmapImage* fillImage, QPoint point, QRgb targetColour, QRgb replacementColour, int tolerance, bool extendFillImage)
+QRect BitmapImage::floodFill(BitmapImage* targetImage, BitmapImage* fillImage, QPoint point, QRgb targetColour, QRgb replacementColour, int tolerance, bool extendFillImage)
 {
+    PERF_SCOPE("BitmapImage::floodFill");
     QList<QPoint> queue; // queue all the pixels of the filled area (as they are found)
+    QRect filled;
     int j, k;
     bool condition;
     BitmapImage* replaceImage;
@@ -615,6 +704,7 @@ void BitmapImage::floodFill(BitmapImage* targetImage, BitmapImage* fillImage, QP
             //painter1.drawLine( point.x()+j, point.y(), point.x()+k+1, point.y() );
 
             replaceImage->drawLine( QPointF(point.x()+j, point.y()), QPointF(point.x()+k, point.y()), myPen, QPainter::CompositionMode_SourceOver, false);
+            filled |= QRect(QPoint(point.x()+j, point.y()-1), QPoint(point.x()+k, point.y()+1));
             //for(int l=0; l<=k-j+1 ; l++) {
             //	replaceImage->setPixel( point.x()+j, point.y(), replacementColour );
             //}
@@ -667,5 +757,6 @@ void BitmapImage::floodFill(BitmapImage* targetImage, BitmapImage* fillImage, QP
     //painter2.end();
     delete replaceImage;
     //update();
+    return filled;
 }
 
@@ -20,6 +20,7 @@ GNU General Public License for more details.
 #include <QPainter>
 
 class Object;  // forward declaration
+class BitmapMipmaps;
 
 class BitmapImage
 {
@@ -45,6 +46,7 @@ public:
     void setModified(bool);
 
     void paintImage(QPainter& painter);
+    QRect visibleRect(QPainter& painter);
     void outputImage(QImage* image, QSize size, QMatrix myView);
 
     BitmapImage copy();
@@ -74,7 +76,8 @@ public:
 
     static int sqr(int);
     static int rgbDistance(QRgb rgba1, QRgb rgba2);
-    static void floodFill(BitmapImage* targetImage, BitmapImage* fillImage, QPoint point, QRgb targetColour, QRgb replacementColour, int tolerance, bool extendFillImage);
+    // returns the bounds of the filled area
+    static QRect floodFill(BitmapImage* targetImage, BitmapImage* fillImage, QPoint point, QRgb targetColour, QRgb replacementColour, int tolerance, bool extendFillImage);
 
     void drawLine(QPointF P1, QPointF P2, QPen pen, QPainter::CompositionMode cm, bool antialiasing);
     void drawRect( QRectF rectangle, QPen pen, QBrush brush, QPainter::CompositionMode cm, bool antialiasing);
@@ -101,6 +104,12 @@ public:
 
 protected:
     Object* myParent;
+
+private:
+    // reduced copies, drawn instead of the image when it is much zoomed out
+    BitmapMipmaps* mipmaps;
+    qint64 imageKey() { return (image != NULL) ? image->cacheKey() : 0; }
+    void pixelsChanged(qint64 keyBefore, QRect rectangle);
 };
 
 #endif
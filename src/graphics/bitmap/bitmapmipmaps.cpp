@@ -0,0 +1,144 @@
+#include "bitmapmipmaps.h"
+
+static const int MAX_LEVEL = 12;
+
+// average of four premultiplied pixels, two channels at a time
+static inline QRgb average( QRgb a, QRgb b, QRgb c, QRgb d )
+{
+    quint32 rb = ( a & 0x00ff00ff ) + ( b & 0x00ff00ff ) + ( c & 0x00ff00ff ) + ( d & 0x00ff00ff );
+    quint32 ag = ( ( a >> 8 ) & 0x00ff00ff ) + ( ( b >> 8 ) & 0x00ff00ff ) + ( ( c >> 8 ) & 0x00ff00ff ) + ( ( d >> 8 ) & 0x00ff00ff );
+    rb = ( ( rb + 0x00020002 ) >> 2 ) & 0x00ff00ff;
+    ag = ( ( ag + 0x00020002 ) >> 2 ) & 0x00ff00ff;
+    return rb | ( ag << 8 );
+}
+
+static QImage premultiplied( const QImage& image )
+{
+    if ( image.format() == QImage::Format_ARGB32_Premultiplied )
+    {
+        return image;
+    }
+    return image.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+}
+
+// half of a rectangle of pixels, rounded out
+static QRect halfRect( const QRect& rect )
+{
+    return QRect( QPoint( rect.left() / 2, rect.top() / 2 ), QPoint( rect.right() / 2, rect.bottom() / 2 ) );
+}
+
+// computes the pixels of rect in the coarser level; finer holds the pixels of the finer level from origin on
+static void halveInto( const QImage& finer, const QPoint& origin, const QSize& finerSize, QImage& coarser, const QRect& rect )
+{
+    for ( int y = rect.top(); y <= rect.bottom(); y++ )
+    {
+        int y0 = 2 * y;
+        int y1 = qMin( y0 + 1, finerSize.height() - 1 );
+        const QRgb* line0 = ( const QRgb* )finer.constScanLine( y0 - origin.y() );
+        const QRgb* line1 = ( const QRgb* )finer.constScanLine( y1 - origin.y() );
+        QRgb* out = ( QRgb* )coarser.scanLine( y );
+        for ( int x = rect.left(); x <= rect.right(); x++ )
+        {
+            int x0 = 2 * x - origin.x();
+            int x1 = qMin( 2 * x + 1, finerSize.width() - 1 ) - origin.x();
+            out[ x ] = average( line0[ x0 ], line0[ x1 ], line1[ x0 ], line1[ x1 ] );
+        }
+    }
+}
+
+int BitmapMipmaps::levelFor( qreal scale )
+{
+    int level = 0;
+    while ( scale <= 0.5 && scale > 0 && level < MAX_LEVEL )
+    {
+        scale *= 2;
+        level++;
+    }
+    return level;
+}
+
+QImage BitmapMipmaps::halved( const QImage& image )
+{
+    QImage finer = premultiplied( image );
+    QImage coarser( ( finer.width() + 1 ) / 2, ( finer.height() + 1 ) / 2, QImage::Format_ARGB32_Premultiplied );
+    halveInto( finer, QPoint( 0, 0 ), finer.size(), coarser, coarser.rect() );
+    return coarser;
+}
+
+QImage BitmapMipmaps::image( const QImage& source, int* level )
+{
+    if ( *level <= 0 || source.isNull() )
+    {
+        *level = 0;
+        return source;
+    }
+
+    if ( source.cacheKey() != m_sourceKey || source.size() != m_sourceSize )
+    {
+        clear();
+        m_sourceKey = source.cacheKey();
+        m_sourceSize = source.size();
+    }
+    else if ( !m_dirty.isEmpty() )
+    {
+        updateDirty( source );
+    }
+
+    while ( m_levels.size() < *level )
+    {
+        const QImage& finer = m_levels.isEmpty() ? source : m_levels.last();
+        if ( finer.width() <= 1 && finer.height() <= 1 )
+        {
+            break;
+        }
+        m_levels.append( halved( finer ) );
+    }
+    *level = m_levels.size() < *level ? m_levels.size() : *level;
+    return ( *level == 0 ) ? source : m_levels.at( *level - 1 );
+}
+
+void BitmapMipmaps::changed( qint64 keyBefore, const QImage& source, const QRect& dirty )
+{
+    // only when the levels were up to date, otherwise they are rebuilt anyway
+    if ( !m_levels.isEmpty() && keyBefore == m_sourceKey && source.size() == m_sourceSize )
+    {
+        m_dirty |= dirty;
+        m_sourceKey = source.cacheKey();
+    }
+}
+
+void BitmapMipmaps::clear()
+{
+    m_levels.clear();
+    m_dirty = QRect();
+    m_sourceKey = 0;
+    m_sourceSize = QSize();
+}
+
+void BitmapMipmaps::updateDirty( const QImage& source )
+{
+    QRect dirty = m_dirty.intersected( source.rect() );
+    m_dirty = QRect();
+    if ( dirty.isEmpty() )
+    {
+        return;
+    }
+
+    // level 1, from the changed part of the image only
+    QRect coarse = halfRect( dirty ).intersected( m_levels[ 0 ].rect() );
+    QRect fine = QRect( coarse.left() * 2, coarse.top() * 2, coarse.width() * 2, coarse.height() * 2 ).intersected( source.rect() );
+    if ( source.format() == QImage::Format_ARGB32_Premultiplied )
+    {
+        halveInto( source, QPoint( 0, 0 ), source.size(), m_levels[ 0 ], coarse );
+    }
+    else
+    {
+        halveInto( premultiplied( source.copy( fine ) ), fine.topLeft(), source.size(), m_levels[ 0 ], coarse );
+    }
+
+    for ( int i = 1; i < m_levels.size(); i++ )
+    {
+        coarse = halfRect( coarse ).intersected( m_levels[ i ].rect() );
+        halveInto( m_levels[ i - 1 ], QPoint( 0, 0 ), m_levels[ i - 1 ].size(), m_levels[ i ], coarse );
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef BITMAPMIPMAPS_H
+#define BITMAPMIPMAPS_H
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+
+
+/**
+ * Reduced copies of a bitmap image, for drawing it zoomed out.
+ *
+ * Level n is the image at 1/2^n of its size, each pixel the average of four
+ * pixels of the level above. The levels are built the first time they are
+ * needed. When the changes made to the image are reported with changed(),
+ * only the pixels covering them are computed again, otherwise any change of
+ * the image ( detected through QImage::cacheKey ) rebuilds the levels.
+ */
+class BitmapMipmaps
+{
+public:
+    BitmapMipmaps() : m_sourceKey( 0 ) {}
+
+    // the level to draw at this scale: the smallest one not smaller than the drawing on screen
+    static int levelFor( qreal scale );
+
+    // *level is lowered when the image is too small to have that many levels
+    QImage image( const QImage& source, int* level );
+
+    // the pixels in dirty ( image coordinates ) have changed, keyBefore is the cacheKey of the image before the change
+    void changed( qint64 keyBefore, const QImage& source, const QRect& dirty );
+    void clear();
+
+    static QImage halved( const QImage& image );
+
+private:
+    void updateDirty( const QImage& source );
+
+    QList<QImage> m_levels; // level 1 first
+    qint64 m_sourceKey;     // the image the levels are computed from
+    QSize m_sourceSize;
+    QRect m_dirty;          // changed since, in image coordinates
+};
+
+#endif // BITMAPMIPMAPS_H
@@ -0,0 +1,109 @@
+#include <QMutexLocker>
+#include "strokerenderer.h"
+
+StrokeRenderer::StrokeRenderer( QObject* parent ) : QThread( parent ),
+    m_buffer( NULL ),
+    m_generation( 0 ),
+    m_damagePosted( false ),
+    m_quit( false )
+{
+    start();
+}
+
+StrokeRenderer::~StrokeRenderer()
+{
+    m_mutex.lock();
+    m_quit = true;
+    m_queued.wakeAll();
+    m_mutex.unlock();
+    wait();
+}
+
+void StrokeRenderer::drawDab( const BrushDab& dab )
+{
+    QMutexLocker locker( &m_mutex );
+    m_queue.enqueue( dab );
+    m_queued.wakeAll();
+}
+
+void StrokeRenderer::paint( QPainter& painter )
+{
+    QMutexLocker locker( &m_mutex );
+    m_buffer.paintImage( painter );
+}
+
+void StrokeRenderer::finish( BitmapImage* target )
+{
+    QMutexLocker locker( &m_mutex );
+    while ( !m_queue.isEmpty() )
+    {
+        m_drained.wait( &m_mutex );
+    }
+    if ( !m_buffer.boundaries.isEmpty() )
+    {
+        target->paste( &m_buffer );
+    }
+    m_buffer.clear();
+}
+
+void StrokeRenderer::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    m_queue.clear();
+    m_buffer.clear();
+    m_generation++;
+    m_drained.wakeAll();
+}
+
+void StrokeRenderer::run()
+{
+    QMutexLocker locker( &m_mutex );
+    forever
+    {
+        while ( m_queue.isEmpty() && !m_quit )
+        {
+            m_queued.wait( &m_mutex );
+        }
+        if ( m_quit )
+        {
+            return;
+        }
+        BrushDab dab = m_queue.head();
+        int generation = m_generation;
+
+        // the dab is drawn unlocked, the buffer only waits for it to be pasted
+        locker.unlock();
+        BitmapImage dabImage( NULL );
+        dabImage.drawRect( dab.rect, Qt::NoPen, dab.gradient, QPainter::CompositionMode_Source, dab.antialiasing );
+        locker.relock();
+
+        if ( generation != m_generation )
+        {
+            continue;
+        }
+        m_buffer.paste( &dabImage );
+        m_queue.dequeue();
+        if ( m_queue.isEmpty() )
+        {
+            m_drained.wakeAll();
+        }
+
+        m_damage |= dab.rect;
+        if ( !m_damagePosted )
+        {
+            m_damagePosted = true;
+            QMetaObject::invokeMethod( this, "postDamage", Qt::QueuedConnection );
+        }
+    }
+}
+
+void StrokeRenderer::postDamage()
+{
+    m_mutex.lock();
+    QRectF damage = m_damage;
+    m_damage = QRectF();
+    m_damagePosted = false;
+    m_mutex.unlock();
+
+    emit dabsDrawn( damage );
+}
@@ -0,0 +1,70 @@
+#ifndef STROKERENDERER_H
+#define STROKERENDERER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QRadialGradient>
+#include <QRectF>
+#include "bitmapimage.h"
+
+class QPainter;
+
+
+// one dab of a soft brush: a radial gradient filling a square
+struct BrushDab
+{
+    QRectF rect;
+    QRadialGradient gradient;
+    bool antialiasing;
+};
+
+
+/**
+ * Draws the dabs of the bitmap brush strokes in a thread of its own.
+ *
+ * The dabs are queued as the pointer moves and drawn in order into a stroke
+ * buffer owned by the renderer, so that input handling never waits for them.
+ * The parts drawn are reported with dabsDrawn(), at most once per event loop
+ * turn. Before the stroke is committed to the drawing, finish() waits for the
+ * dabs still queued and hands the buffer over.
+ */
+class StrokeRenderer : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit StrokeRenderer( QObject* parent = 0 );
+    ~StrokeRenderer();
+
+    void drawDab( const BrushDab& dab );
+    void paint( QPainter& painter );
+
+    // waits for the queued dabs, pastes the buffer into target and clears it
+    void finish( BitmapImage* target );
+    // drops the queued dabs and the buffer
+    void clear();
+
+signals:
+    void dabsDrawn( QRectF rect );
+
+protected:
+    void run();
+
+private slots:
+    void postDamage();
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_queued;
+    QWaitCondition m_drained;
+    QQueue<BrushDab> m_queue;   // the head is being drawn
+    BitmapImage m_buffer;
+    int m_generation;           // incremented by clear(), a dab drawn before it is thrown away
+    QRectF m_damage;            // drawn since the last dabsDrawn()
+    bool m_damagePosted;
+    bool m_quit;
+};
+
+#endif // STROKERENDERER_H
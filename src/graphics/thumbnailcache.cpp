@@ -0,0 +1,205 @@
+#include <QPainter>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include "pencilsettings.h"
+#include "vectorimage.h"
+#include "thumbnailcache.h"
+
+static const int CACHE_SIZE = 400; // thumbnails
+static const int IDLE_RENDER_TIME = 10; // milliseconds spent rendering vector thumbnails per idle slice
+
+static QImage scaledThumbnail( const QImage& image )
+{
+    return image.scaledToHeight( ThumbnailCache::THUMBNAIL_HEIGHT, Qt::SmoothTransformation );
+}
+
+// scales one bitmap thumbnail in a worker thread, from a copy of the key frame image
+class ThumbnailJob : public QRunnable
+{
+public:
+    ThumbnailJob( ThumbnailCache* cache, const void* key, int request, const QImage& image )
+        : m_cache( cache ), m_key( key ), m_request( request ), m_bitmap( image ) {}
+
+    void run()
+    {
+        QImage thumbnail;
+        if ( !m_bitmap.isNull() )
+        {
+            thumbnail = scaledThumbnail( m_bitmap );
+        }
+        QMetaObject::invokeMethod( m_cache, "thumbnailRendered", Qt::QueuedConnection,
+                                   Q_ARG( qulonglong, ( qulonglong )( quintptr )m_key ),
+                                   Q_ARG( int, m_request ),
+                                   Q_ARG( QImage, thumbnail ) );
+    }
+
+private:
+    ThumbnailCache* m_cache;
+    const void* m_key;
+    int m_request;
+    QImage m_bitmap;
+};
+
+// painting a vector image reads the palette of its object, so it is done on the GUI thread
+static QImage vectorThumbnail( VectorImage& image )
+{
+    QRectF bounds;
+    for ( int i = 0; i < image.curve.size(); i++ )
+    {
+        bounds |= image.curve.at( i ).getControlBoundingRect();
+    }
+    if ( bounds.isEmpty() )
+    {
+        return QImage();
+    }
+    bounds.adjust( -2, -2, 2, 2 );
+
+    qreal scale = ThumbnailCache::THUMBNAIL_HEIGHT / bounds.height();
+    int width = qBound( 1, qRound( bounds.width() * scale ), 8 * ThumbnailCache::THUMBNAIL_HEIGHT );
+    QImage thumbnail( width, ThumbnailCache::THUMBNAIL_HEIGHT, QImage::Format_ARGB32_Premultiplied );
+    thumbnail.fill( qRgba( 0, 0, 0, 0 ) );
+
+    QPainter painter( &thumbnail );
+    painter.scale( scale, scale );
+    painter.translate( -bounds.topLeft() );
+    image.paintImage( painter, false, false, 1.0, true );
+    return thumbnail;
+}
+
+// ==== Singleton ====
+static ThumbnailCache* g_pThumbnailCache = NULL;
+
+ThumbnailCache* ThumbnailCache::instance()
+{
+    if ( g_pThumbnailCache == NULL )
+    {
+        g_pThumbnailCache = new ThumbnailCache();
+    }
+    return g_pThumbnailCache;
+}
+
+ThumbnailCache::ThumbnailCache( QObject* parent ) : QObject( parent )
+    , m_thumbnails( CACHE_SIZE )
+    , m_lastRequest( 0 )
+{
+    m_enabled = pencilSettings()->value( SETTING_TIMELINE_THUMBNAILS, false ).toBool();
+
+    m_vectorTimer.setSingleShot( true );
+    m_vectorTimer.setInterval( 0 );
+    connect( &m_vectorTimer, SIGNAL( timeout() ), this, SLOT( renderPendingVectors() ) );
+
+    // the thumbnails which arrive together are announced once
+    m_readyTimer.setSingleShot( true );
+    m_readyTimer.setInterval( 0 );
+    connect( &m_readyTimer, SIGNAL( timeout() ), this, SIGNAL( thumbnailsReady() ) );
+}
+
+void ThumbnailCache::setEnabled( int enabled )
+{
+    m_enabled = ( enabled != 0 );
+    pencilSettings()->setValue( SETTING_TIMELINE_THUMBNAILS, m_enabled );
+    emit thumbnailsReady();
+}
+
+QImage ThumbnailCache::thumbnail( const void* key )
+{
+    QMutexLocker locker( &m_mutex );
+    QImage* cached = m_thumbnails.object( key );
+    return ( cached != NULL ) ? *cached : QImage();
+}
+
+bool ThumbnailCache::startRequest( const void* key, int* request )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( key == NULL || m_thumbnails.contains( key ) || m_pending.contains( key ) )
+    {
+        return false;
+    }
+    *request = ++m_lastRequest;
+    m_pending.insert( key, *request );
+    return true;
+}
+
+void ThumbnailCache::requestBitmap( const void* key, const QImage& image )
+{
+    int request;
+    if ( startRequest( key, &request ) )
+    {
+        // the image is shared until the layer draws on it again
+        QThreadPool::globalInstance()->start( new ThumbnailJob( this, key, request, image ) );
+    }
+}
+
+void ThumbnailCache::requestVector( const void* key, const VectorImage& image )
+{
+    int request;
+    if ( startRequest( key, &request ) )
+    {
+        PendingVector pendingVector = { key, request, new VectorImage( image ) };
+        m_pendingVectors.append( pendingVector );
+        if ( !m_vectorTimer.isActive() )
+        {
+            m_vectorTimer.start();
+        }
+    }
+}
+
+void ThumbnailCache::renderPendingVectors()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while ( !m_pendingVectors.isEmpty() && elapsed.elapsed() < IDLE_RENDER_TIME )
+    {
+        PendingVector pendingVector = m_pendingVectors.takeFirst();
+        bool current;
+        {
+            QMutexLocker locker( &m_mutex );
+            current = ( m_pending.value( pendingVector.key, 0 ) == pendingVector.request );
+        }
+        // invalidated since: the key frame, even its object, may be gone
+        if ( current )
+        {
+            thumbnailRendered( ( qulonglong )( quintptr )pendingVector.key, pendingVector.request,
+                               vectorThumbnail( *pendingVector.image ) );
+        }
+        delete pendingVector.image;
+    }
+    if ( !m_pendingVectors.isEmpty() )
+    {
+        m_vectorTimer.start();
+    }
+}
+
+void ThumbnailCache::insert( const void* key, const QImage& thumbnail )
+{
+    QMutexLocker locker( &m_mutex );
+    m_pending.remove( key );
+    m_thumbnails.insert( key, new QImage( thumbnail ) );
+}
+
+void ThumbnailCache::invalidate( const void* key )
+{
+    // a thumbnail still being rendered is out of date too: its result will be dropped
+    QMutexLocker locker( &m_mutex );
+    m_pending.remove( key );
+    m_thumbnails.remove( key );
+}
+
+void ThumbnailCache::thumbnailRendered( qulonglong key, int request, QImage thumbnail )
+{
+    const void* imageKey = ( const void* )( quintptr )key;
+    {
+        QMutexLocker locker( &m_mutex );
+        if ( m_pending.value( imageKey, 0 ) != request )
+        {
+            return;
+        }
+    }
+    insert( imageKey, thumbnail );
+    if ( !m_readyTimer.isActive() )
+    {
+        m_readyTimer.start();
+    }
+}
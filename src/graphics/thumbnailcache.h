@@ -0,0 +1,77 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QTimer>
+#include <QList>
+
+class VectorImage;
+
+
+/**
+ * Small thumbnails of the key frames, drawn in the timeline.
+ *
+ * A thumbnail is looked up by the address of the key frame image. Missing
+ * bitmap thumbnails are scaled by the global thread pool from a copy of the
+ * image. Vector thumbnails are painted in idle slices of the GUI thread,
+ * since painting reads the palette of the object. The timeline is drawn
+ * without them until they arrive, and thumbnailsReady() is emitted once
+ * for those arriving together. Only the most recently used ones are kept.
+ * The cache may be looked up and filled from any thread, as projects loaded
+ * by worker threads insert the thumbnails saved with them; requests come
+ * from the GUI thread.
+ */
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ThumbnailCache* instance();
+
+    static const int THUMBNAIL_HEIGHT = 48;
+
+    bool isEnabled() const { return m_enabled; }
+
+    QImage thumbnail( const void* key );
+    void requestBitmap( const void* key, const QImage& image );
+    void requestVector( const void* key, const VectorImage& image );
+    void insert( const void* key, const QImage& thumbnail );
+    void invalidate( const void* key );
+
+signals:
+    void thumbnailsReady();
+
+public slots:
+    void setEnabled( int enabled );
+
+private slots:
+    void thumbnailRendered( qulonglong key, int request, QImage thumbnail );
+    void renderPendingVectors();
+
+private:
+    explicit ThumbnailCache( QObject* parent = 0 );
+
+    bool startRequest( const void* key, int* request );
+
+    bool m_enabled;
+    QMutex m_mutex; // guards the thumbnails and the requests
+    QCache<const void*, QImage> m_thumbnails;
+    QHash<const void*, int> m_pending; // request number of the thumbnails being rendered
+    int m_lastRequest;
+
+    struct PendingVector
+    {
+        const void* key;
+        int request;
+        VectorImage* image; // a copy
+    };
+    QList<PendingVector> m_pendingVectors;
+    QTimer m_vectorTimer;
+    QTimer m_readyTimer;
+};
+
+#endif // THUMBNAILCACHE_H
@@ -81,3 +81,30 @@ void BezierArea::loadDomElement(QDomElement element)
         vertexTag = vertexTag.nextSibling();
     }
 }
+
+void BezierArea::writeBinary(QDataStream& out) const
+{
+    out << (qint32)colourNumber << (quint32)vertex.size();
+    for(int i=0; i < vertex.size() ; i++)
+    {
+        out << (qint32)vertex.at(i).curveNumber << (qint32)vertex.at(i).vertexNumber;
+    }
+}
+
+bool BezierArea::readBinary(QDataStream& in)
+{
+    qint32 colour;
+    quint32 vertexCount;
+    in >> colour >> vertexCount;
+    if (in.status() != QDataStream::Ok) return false;
+
+    colourNumber = colour;
+    for(quint32 i=0; i < vertexCount; i++)
+    {
+        qint32 curveNumber, vertexNumber;
+        in >> curveNumber >> vertexNumber;
+        if (in.status() != QDataStream::Ok) return false;
+        vertex.append( VertexRef(curveNumber, vertexNumber) );
+    }
+    return true;
+}
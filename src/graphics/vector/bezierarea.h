@@ -34,6 +34,8 @@ public:
 
     QDomElement createDomElement(QDomDocument& doc);
     void loadDomElement(QDomElement element);
+    void writeBinary(QDataStream& out) const;
+    bool readBinary(QDataStream& in);
 
     VertexRef getVertexRef(int i);
     int getColourNumber() { return colourNumber; }
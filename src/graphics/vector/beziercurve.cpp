@@ -19,6 +19,52 @@ GNU General Public License for more details.
 #include "beziercurve.h"
 #include "object.h"
 
+// the shortest decimal strings which read back (with toDouble or toFloat) as the same value,
+// so that the XML and binary files of a vector image load identically
+static QString exactNumber(double value)
+{
+    QString result;
+    for(int precision=6; precision <= 17; precision++)
+    {
+        result = QString::number(value, 'g', precision);
+        if (result.toDouble() == value) break;
+    }
+    return result;
+}
+
+static QString exactNumber(float value)
+{
+    QString result;
+    for(int precision=6; precision <= 9; precision++)
+    {
+        result = QString::number(value, 'g', precision);
+        if (result.toFloat() == value) break;
+    }
+    return result;
+}
+
+// QBitArray has no insert/remove, the selection bits are shifted by hand
+static void insertBit(QBitArray& bits, int i, bool value)
+{
+    int n = bits.size();
+    bits.resize(n+1);
+    for(int k=n; k>i; k--)
+    {
+        bits.setBit(k, bits.testBit(k-1));
+    }
+    bits.setBit(i, value);
+}
+
+static void removeBit(QBitArray& bits, int i)
+{
+    int n = bits.size();
+    for(int k=i; k<n-1; k++)
+    {
+        bits.setBit(k, bits.testBit(k+1));
+    }
+    bits.resize(n-1);
+}
+
 BezierCurve::BezierCurve()
 {
     // nothing;
@@ -77,24 +123,25 @@ BezierCurve::BezierCurve(QList<QPointF> pointList, QList<qreal> pressureList, do
 QDomElement BezierCurve::createDomElement(QDomDocument& doc)
 {
     QDomElement curveTag = doc.createElement("curve");
-    curveTag.setAttribute("width", width);
+    curveTag.setAttribute("width", exactNumber(width));
     curveTag.setAttribute("variableWidth", variableWidth);
-    if (feather>0) curveTag.setAttribute("feather", feather);
+    if (feather>0) curveTag.setAttribute("feather", exactNumber(feather));
     curveTag.setAttribute("invisible", invisible);
     curveTag.setAttribute("colourNumber", colourNumber);
-    curveTag.setAttribute("originX", origin.x());
-    curveTag.setAttribute("originY", origin.y());
-    curveTag.setAttribute("originPressure", pressure.at(0));
-    for(int i=0; i < c1.size() ; i++)
+    curveTag.setAttribute("originX", exactNumber((float)origin.x()));
+    curveTag.setAttribute("originY", exactNumber((float)origin.y()));
+    curveTag.setAttribute("originPressure", exactNumber((float)originPressure));
+    for(int i=0; i < segments.size() ; i++)
     {
+        const BezierSegment& segment = segments.at(i);
         QDomElement segementTag = doc.createElement("segment");
-        segementTag.setAttribute("c1x", c1.at(i).x());
-        segementTag.setAttribute("c1y", c1.at(i).y());
-        segementTag.setAttribute("c2x", c2.at(i).x());
-        segementTag.setAttribute("c2y", c2.at(i).y());
-        segementTag.setAttribute("vx", vertex.at(i).x());
-        segementTag.setAttribute("vy", vertex.at(i).y());
-        segementTag.setAttribute("pressure", pressure.at(i+1));
+        segementTag.setAttribute("c1x", exactNumber((float)segment.c1.x()));
+        segementTag.setAttribute("c1y", exactNumber((float)segment.c1.y()));
+        segementTag.setAttribute("c2x", exactNumber((float)segment.c2.x()));
+        segementTag.setAttribute("c2y", exactNumber((float)segment.c2.y()));
+        segementTag.setAttribute("vx", exactNumber((float)segment.vertex.x()));
+        segementTag.setAttribute("vy", exactNumber((float)segment.vertex.y()));
+        segementTag.setAttribute("pressure", exactNumber((float)segment.pressure));
         curveTag.appendChild(segementTag);
     }
     return curveTag;
@@ -109,8 +156,9 @@ void BezierCurve::loadDomElement(QDomElement element)
     if (width == 0) invisible = true;
     colourNumber = element.attribute("colourNumber").toInt();
     origin = QPointF( element.attribute("originX").toFloat(), element.attribute("originY").toFloat() );
-    pressure.append( element.attribute("originPressure").toFloat() );
-    selected.append(false);
+    originPressure = element.attribute("originPressure").toFloat();
+    segments.clear();
+    selected = QBitArray(1);
 
     QDomNode segmentTag = element.firstChild();
     while (!segmentTag.isNull())
@@ -132,6 +180,65 @@ void BezierCurve::loadDomElement(QDomElement element)
 }
 
 
+// binary form, see VectorImage::write(): the same values as in the XML form,
+// points and pressures in single precision (as read from XML with toFloat)
+void BezierCurve::writeBinary(QDataStream& out) const
+{
+    quint8 flags = (variableWidth ? 1 : 0) | (invisible ? 2 : 0);
+    out << (quint32)segments.size() << (qint32)colourNumber << flags;
+
+    out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    out << (double)width << (double)(feather > 0 ? feather : 0);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    out << (float)origin.x() << (float)origin.y() << (float)originPressure;
+    for(int i=0; i < segments.size(); i++)
+    {
+        const BezierSegment& segment = segments.at(i);
+        out << (float)segment.c1.x() << (float)segment.c1.y()
+            << (float)segment.c2.x() << (float)segment.c2.y()
+            << (float)segment.vertex.x() << (float)segment.vertex.y()
+            << (float)segment.pressure;
+    }
+}
+
+bool BezierCurve::readBinary(QDataStream& in)
+{
+    quint32 segmentCount;
+    qint32 colour;
+    quint8 flags;
+    in >> segmentCount >> colour >> flags;
+
+    double widthValue, featherValue;
+    in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    in >> widthValue >> featherValue;
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    float x, y, p;
+    in >> x >> y >> p;
+    if (in.status() != QDataStream::Ok) return false;
+
+    width = widthValue;
+    feather = featherValue;
+    variableWidth = (flags & 1);
+    invisible = (flags & 2);
+    if (width == 0) invisible = true;
+    colourNumber = colour;
+    origin = QPointF(x, y);
+    originPressure = p;
+    segments.clear();
+    selected = QBitArray(1);
+
+    for(quint32 i=0; i < segmentCount; i++)
+    {
+        float c1x, c1y, c2x, c2y, vx, vy, pressureValue;
+        in >> c1x >> c1y >> c2x >> c2y >> vx >> vy >> pressureValue;
+        if (in.status() != QDataStream::Ok) return false;
+        appendCubic(QPointF(c1x, c1y), QPointF(c2x, c2y), QPointF(vx, vy), pressureValue);
+    }
+    return true;
+}
+
 void BezierCurve::setOrigin(const QPointF& point)
 {
     origin = point;
@@ -140,15 +247,15 @@ void BezierCurve::setOrigin(const QPointF& point)
 void BezierCurve::setOrigin(const QPointF& point, const qreal& pressureValue, const bool& trueOrFalse)
 {
     origin = point;
-    pressure[0] = pressureValue;
-    selected[0] = trueOrFalse;
+    originPressure = pressureValue;
+    selected.setBit(0, trueOrFalse);
 }
 
 void BezierCurve::setC1(int i, const QPointF& point)
 {
-    if ( i >= 0 || i < c1.size() )
+    if ( i >= 0 && i < segments.size() )
     {
-        c1[i] = point;
+        segments[i].c1 = point;
     }
     else
     {
@@ -158,9 +265,9 @@ void BezierCurve::setC1(int i, const QPointF& point)
 
 void BezierCurve::setC2(int i, const QPointF& point)
 {
-    if ( i >= 0 || i < c2.size() )
+    if ( i >= 0 && i < segments.size() )
     {
-        c2[i] = point;
+        segments[i].c2 = point;
     }
     else
     {
@@ -173,9 +280,9 @@ void BezierCurve::setVertex(int i, const QPointF& point)
     if (i==-1) { origin = point; }
     else
     {
-        if ( i >= 0 || i < vertex.size() )
+        if ( i >= 0 && i < segments.size() )
         {
-            vertex[i] = point;
+            segments[i].vertex = point;
         }
         else
         {
@@ -186,9 +293,9 @@ void BezierCurve::setVertex(int i, const QPointF& point)
 
 void BezierCurve::setLastVertex(const QPointF& point)
 {
-    if (vertex.size()>0)
+    if (segments.size()>0)
     {
-        vertex[vertex.size()-1] = point;
+        segments.last().vertex = point;
     }
     else
     {
@@ -219,22 +326,13 @@ void BezierCurve::setInvisibility(bool YesOrNo)
 
 void BezierCurve::setSelected(int i, bool YesOrNo)
 {
-    selected[i+1] = YesOrNo;
+    selected.setBit(i+1, YesOrNo);
 }
 
 BezierCurve BezierCurve::transformed(QMatrix transformation)
 {
-    BezierCurve transformedCurve = *this; // copy the curve
-    if (isSelected(-1)) { transformedCurve.setOrigin(transformation.map(origin)); }
-    for(int i=0; i< vertex.size(); i++)
-    {
-        if (isSelected(i-1)) { transformedCurve.setC1(i, transformation.map(c1.at(i))); }
-        if (isSelected(i))
-        {
-            transformedCurve.setC2(i, transformation.map(c2.at(i)));
-            transformedCurve.setVertex(i, transformation.map(vertex.at(i)));
-        }
-    }
+    BezierCurve transformedCurve = *this; // shallow copy, only detached if something is selected
+    transformedCurve.transform(transformation);
     //transformedCurve.smoothCurve();
     /*QPointF newOrigin = origin;
     if (isSelected(-1)) { newOrigin =  transformation.map(newOrigin); }
@@ -257,26 +355,31 @@ BezierCurve BezierCurve::transformed(QMatrix transformation)
 
 void BezierCurve::transform(QMatrix transformation)
 {
-    if (isSelected(-1)) setOrigin( transformation.map(origin) );
-    for(int i=0; i< vertex.size(); i++)
+    if (!isPartlySelected()) return;
+
+    bool previousSelected = selected.testBit(0);
+    if (previousSelected) origin = transformation.map(origin);
+    int n = segments.size();
+    BezierSegment* segment = segments.data();
+    for(int i=0; i< n; i++, segment++)
     {
-        if (isSelected(i-1)) c1[i] = transformation.map(c1.at(i));
-        if (isSelected(i))
+        bool vertexSelected = selected.testBit(i+1);
+        if (previousSelected) segment->c1 = transformation.map(segment->c1);
+        if (vertexSelected)
         {
-            c2[i] = transformation.map(c2.at(i));
-            vertex[i] = transformation.map(vertex.at(i));
+            segment->c2 = transformation.map(segment->c2);
+            segment->vertex = transformation.map(segment->vertex);
         }
+        previousSelected = vertexSelected;
     }
     //smoothCurve();
 }
 
 void BezierCurve::appendCubic(const QPointF& c1Point, const QPointF& c2Point, const QPointF& vertexPoint, qreal pressureValue)
 {
-    c1.append(c1Point);
-    c2.append(c2Point);
-    vertex.append(vertexPoint);
-    pressure.append(pressureValue);
-    selected.append(false);
+    BezierSegment segment = { c1Point, c2Point, vertexPoint, pressureValue };
+    segments.append(segment);
+    selected.resize(selected.size()+1);
 }
 
 void BezierCurve::addPoint(int position, const QPointF point)
@@ -288,14 +391,12 @@ void BezierCurve::addPoint(int position, const QPointF point)
         QPointF c1o = getC1(position);
         QPointF c2o = getC2(position);
 
-        c1[position] = point + 0.2*(v2-v1);
-        c2[position] = v2 + (c2o-v2)*(0.5);
+        segments[position].c1 = point + 0.2*(v2-v1);
+        segments[position].c2 = v2 + (c2o-v2)*(0.5);
 
-        c1.insert(position, v1 + (c1o-v1)*(0.5) );
-        c2.insert(position, point - 0.2*(v2-v1));
-        vertex.insert(position, point);
-        pressure.insert(position, getPressure(position));
-        selected.insert(position, isSelected(position) && isSelected(position-1));
+        BezierSegment segment = { v1 + (c1o-v1)*(0.5), point - 0.2*(v2-v1), point, getPressure(position) };
+        segments.insert(position, segment);
+        insertBit(selected, position, isSelected(position) && isSelected(position-1));
 
         //smoothCurve();
     }
@@ -326,11 +427,9 @@ void BezierCurve::addPoint(int position, const qreal t)    // t is the fraction
         setC1(position, cB1);
         setC2(position, cB2);
 
-        c1.insert(position, cA1);
-        c2.insert(position, cA2);
-        vertex.insert(position, vM);
-        pressure.insert(position, getPressure(position));
-        selected.insert(position, isSelected(position) && isSelected(position-1));
+        BezierSegment segment = { cA1, cA2, vM, getPressure(position) };
+        segments.insert(position, segment);
+        insertBit(selected, position, isSelected(position) && isSelected(position-1));
 
         //smoothCurve();
     }
@@ -342,32 +441,25 @@ void BezierCurve::addPoint(int position, const qreal t)    // t is the fraction
 
 void BezierCurve::removeVertex(int i)
 {
-    int n = vertex.size();
+    int n = segments.size();
     if (i>-2 && i< n)
     {
         if (i== -1)
         {
-            origin = vertex.at(0);
-            vertex.removeAt(0);
-            c1.removeAt(0);
-            c2.removeAt(0);
-            pressure.removeAt(0);
-            selected.removeAt(0);
+            origin = segments.at(0).vertex;
+            originPressure = segments.at(0).pressure;
+            segments.remove(0);
+            removeBit(selected, 0);
         }
         else
         {
-            vertex.removeAt(i);
-            c2.removeAt(i);
-            pressure.removeAt(i+1);
-            selected.removeAt(i+1);
+            // the next section starts where the removed one started
             if ( i != n-1 )
             {
-                c1.removeAt(i+1);
-            }
-            else
-            {
-                c1.removeAt(i);
+                segments[i+1].c1 = segments.at(i).c1;
             }
+            segments.remove(i);
+            removeBit(selected, i+1);
         }
     }
 }
@@ -454,7 +546,7 @@ void BezierCurve::drawPath(QPainter& painter, Object* object, QMatrix transforma
         qreal squareWidth = 5.0/painter.matrix().m11();
         Q_UNUSED(squareWidth);
 
-        for(int i=-1; i< vertex.size(); i++)
+        for(int i=-1; i< segments.size(); i++)
         {
             if (isSelected(i))
             {
@@ -480,9 +572,10 @@ QPainterPath BezierCurve::getSimplePath()
 {
     QPainterPath path;
     path.moveTo(origin);
-    for(int i=0; i<vertex.size(); i++)
+    for(int i=0; i<segments.size(); i++)
     {
-        path.cubicTo(c1.at(i), c2.at(i), vertex.at(i));
+        const BezierSegment& segment = segments.at(i);
+        path.cubicTo(segment.c1, segment.c2, segment.vertex);
     }
     return path;
 }
@@ -503,61 +596,61 @@ QPainterPath BezierCurve::getStrokedPath(qreal width, bool usePressure)
     QPointF tangentVec, normalVec, normalVec2, normalVec2_1, normalVec2_2;
     qreal width2 = width;
     path.setFillRule(Qt::WindingFill);
-    int n = vertex.size();
-    normalVec = QPointF(-(c1.at(0) - origin).y(), (c1.at(0) - origin).x());
+    int n = segments.size();
+    normalVec = QPointF(-(getC1(0) - origin).y(), (getC1(0) - origin).x());
     normalise(normalVec);
-    if (usePressure) width2 = width * 0.5 * pressure.at(0);
+    if (usePressure) width2 = width * 0.5 * getPressure(0);
     if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
     path.moveTo(origin + width2*normalVec);
     for(int i=0; i<n; i++)
     {
         if (i==n-1)
         {
-            normalVec2 = QPointF(-(vertex.at(i) - c2.at(i)).y(), (vertex.at(i) - c2.at(i)).x());
+            normalVec2 = QPointF(-(getVertex(i) - getC2(i)).y(), (getVertex(i) - getC2(i)).x());
         }
         else
         {
-            normalVec2_1 = QPointF(-(vertex.at(i) - c2.at(i)).y(), (vertex.at(i) - c2.at(i)).x());
+            normalVec2_1 = QPointF(-(getVertex(i) - getC2(i)).y(), (getVertex(i) - getC2(i)).x());
             normalise(normalVec2_1);
-            normalVec2_2 = QPointF(-(c1.at(i+1) - vertex.at(i)).y(), (c1.at(i+1) - vertex.at(i)).x());
+            normalVec2_2 = QPointF(-(getC1(i+1) - getVertex(i)).y(), (getC1(i+1) - getVertex(i)).x());
             normalise(normalVec2_2);
             normalVec2 = normalVec2_1 + normalVec2_2;
         }
         normalise(normalVec2);
-        if (usePressure) width2 = width * 0.5 * pressure.at(i);
+        if (usePressure) width2 = width * 0.5 * getPressure(i);
         if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
         //if (i==n-1) width2 = 0.0;
-        path.cubicTo(c1.at(i) + width2*normalVec, c2.at(i) + width2*normalVec2, vertex.at(i) + width2*normalVec2);
-        //path.moveTo(vertex.at(i) + width*normalVec2);
-        //path.lineTo(vertex.at(i) - width*normalVec2);
+        path.cubicTo(getC1(i) + width2*normalVec, getC2(i) + width2*normalVec2, getVertex(i) + width2*normalVec2);
+        //path.moveTo(getVertex(i) + width*normalVec2);
+        //path.lineTo(getVertex(i) - width*normalVec2);
         normalVec = normalVec2;
     }
-    if (usePressure) width2 = width * 0.5 * pressure.at(n-1);
+    if (usePressure) width2 = width * 0.5 * getPressure(n-1);
     if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
 
-    //path.lineTo(vertex.at(n-1) - width2*normalVec);
-    tangentVec = (vertex.at(n-1)-c2.at(n-1));
+    //path.lineTo(getVertex(n-1) - width2*normalVec);
+    tangentVec = (getVertex(n-1)-getC2(n-1));
     normalise(tangentVec);
-    path.cubicTo(vertex.at(n-1) + width2*(normalVec+1.8*tangentVec), vertex.at(n-1) + width2*(-normalVec+1.8*tangentVec), vertex.at(n-1) - width2*normalVec);
+    path.cubicTo(getVertex(n-1) + width2*(normalVec+1.8*tangentVec), getVertex(n-1) + width2*(-normalVec+1.8*tangentVec), getVertex(n-1) - width2*normalVec);
 
     for(int i=n-2; i>-1; i--)
     {
-        normalVec2_1 = QPointF((vertex.at(i) - c1.at(i+1)).y(), -(vertex.at(i) - c1.at(i+1)).x());
+        normalVec2_1 = QPointF((getVertex(i) - getC1(i+1)).y(), -(getVertex(i) - getC1(i+1)).x());
         normalise(normalVec2_1);
-        normalVec2_2 = QPointF((c2.at(i) - vertex.at(i)).y(), -(c2.at(i) - vertex.at(i)).x());
+        normalVec2_2 = QPointF((getC2(i) - getVertex(i)).y(), -(getC2(i) - getVertex(i)).x());
         normalise(normalVec2_2);
         normalVec2 = normalVec2_1 + normalVec2_2;
         normalise(normalVec2);
-        if (usePressure) width2 = width * 0.5 * pressure.at(i);
+        if (usePressure) width2 = width * 0.5 * getPressure(i);
         if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
-        path.cubicTo(c2.at(i+1) - width2*normalVec, c1.at(i+1) - width2*normalVec2, vertex.at(i) - width2*normalVec2);
+        path.cubicTo(getC2(i+1) - width2*normalVec, getC1(i+1) - width2*normalVec2, getVertex(i) - width2*normalVec2);
         normalVec = normalVec2;
     }
-    normalVec2 = QPointF((origin - c1.at(0)).y(), -(origin - c1.at(0)).x());
+    normalVec2 = QPointF((origin - getC1(0)).y(), -(origin - getC1(0)).x());
     normalise(normalVec2);
-    if (usePressure) width2 = width * 0.5 * pressure.at(0);
+    if (usePressure) width2 = width * 0.5 * getPressure(0);
     if (n==1 && width2 == 0.0)  width2 = 0.15 * width;
-    path.cubicTo(c2.at(0) - width2*normalVec, c1.at(0) - width2*normalVec2, origin - width2*normalVec2);
+    path.cubicTo(getC2(0) - width2*normalVec, getC1(0) - width2*normalVec2, origin - width2*normalVec2);
     path.closeSubpath();
     return path;
 }
@@ -567,30 +660,45 @@ QRectF BezierCurve::getBoundingRect()
     return getSimplePath().boundingRect();
 }
 
+QRectF BezierCurve::getControlBoundingRect() const
+{
+    // a cubic section lies within the convex hull of its control points
+    qreal left = origin.x();
+    qreal right = origin.x();
+    qreal top = origin.y();
+    qreal bottom = origin.y();
+    for(int i=0; i < segments.size(); i++)
+    {
+        const BezierSegment& segment = segments.at(i);
+        const QPointF* points[3] = { &segment.c1, &segment.c2, &segment.vertex };
+        for(int j=0; j < 3; j++)
+        {
+            left = qMin(left, points[j]->x());
+            right = qMax(right, points[j]->x());
+            top = qMin(top, points[j]->y());
+            bottom = qMax(bottom, points[j]->y());
+        }
+    }
+    return QRectF(left, top, right - left, bottom - top);
+}
+
 void BezierCurve::createCurve(QList<QPointF>& pointList, QList<qreal>& pressureList )
 {
     int p = 0;
     int n = pointList.size();
     // generate the Bezier (cubic) curve from the simplified path and mouse pressure
     // first, empty everything
-    while (c1.size()>0) c1.removeAt(0);
-    while (c2.size()>0) c2.removeAt(0);
-    while (vertex.size()>0) vertex.removeAt(0);
-    while (selected.size()>0) selected.removeAt(0);
-    while (pressure.size()>0) pressure.removeAt(0);
+    segments.clear();
+    selected = QBitArray(n);
 
     setOrigin( pointList.at(0) );
-    selected.append(false);
-    pressure.append(pressureList.at(0));
+    originPressure = pressureList.at(0);
 
+    segments.reserve(n-1);
     for(p=1; p<n; p++)
     {
-        c1.append(pointList.at(p));
-        c2.append(pointList.at(p));
-        vertex.append(pointList.at(p));
-        pressure.append(pressureList.at(p));
-        selected.append(false);
-
+        BezierSegment segment = { pointList.at(p), pointList.at(p), pointList.at(p), pressureList.at(p) };
+        segments.append(segment);
     }
     smoothCurve();
     //colourNumber = 0;
@@ -601,7 +709,7 @@ void BezierCurve::createCurve(QList<QPointF>& pointList, QList<qreal>& pressureL
 void BezierCurve::smoothCurve()
 {
     QPointF c1, c2, c2old, tangentVec, normalVec;
-    int n = vertex.size();
+    int n = segments.size();
     c2old = QPointF(-100,-100); // bogus point
     for(int p=0; p<n-1; p++)
     {
@@ -628,18 +736,18 @@ void BezierCurve::smoothCurve()
 
         if (p==0)
         {
-            c2old  = 0.5*(vertex.at(0)+c1);
+            c2old  = 0.5*(segments.at(0).vertex+c1);
         }
 
-        this->c1[p] = c2old;
-        this->c2[p] = c1;
+        segments[p].c1 = c2old;
+        segments[p].c2 = c1;
         //appendCubic(c2old, c1, D, pressureList->at(p));
         c2old = c2;
     }
     if (n>2)
     {
-        this->c1[n-1] = c2old;
-        this->c2[n-1] = 0.5*(c2old+vertex.at(n-1));
+        segments[n-1].c1 = c2old;
+        segments[n-1].c2 = 0.5*(c2old+segments.at(n-1).vertex);
     }
 }
 
@@ -816,7 +924,7 @@ bool BezierCurve::intersects(QRectF rectangle)
     bool result = false;
     if ( getSimplePath().controlPointRect().intersects(rectangle))
     {
-        for(int i=0; i<vertex.size(); i++)
+        for(int i=0; i<segments.size(); i++)
         {
             if ( rectangle.contains( getVertex(i) ) ) return true;
         }
@@ -18,9 +18,21 @@ GNU General Public License for more details.
 
 #include <QtXml>
 #include <QPainter>
+#include <QVector>
+#include <QBitArray>
 
 class Object;
 
+// one cubic section of a curve, ending at "vertex"
+struct BezierSegment
+{
+    QPointF c1;
+    QPointF c2;
+    QPointF vertex;
+    qreal pressure;
+};
+Q_DECLARE_TYPEINFO(BezierSegment, Q_MOVABLE_TYPE);
+
 struct Intersection
 {
     QPointF point;
@@ -39,21 +51,23 @@ public:
 
     QDomElement createDomElement(QDomDocument& doc);
     void loadDomElement(QDomElement element);
+    void writeBinary(QDataStream& out) const;
+    bool readBinary(QDataStream& in);
 
     qreal getWidth() const { return width; }
     qreal getFeather() const { return feather; }
     bool getVariableWidth() const { return variableWidth; }
     int getColourNumber() const { return colourNumber; }
     void decreaseColourNumber() { colourNumber--; }
-    int getVertexSize() const { return vertex.size(); }
+    int getVertexSize() const { return segments.size(); }
     QPointF getOrigin() const {	return origin; }
-    QPointF getVertex(int i) const { if (i==-1) { return origin; } else { return vertex.at(i);} }
-    QPointF getC1(int i) const { return c1.at(i); }
-    QPointF getC2(int i) const { return c2.at(i); }
-    qreal getPressure(int i) const { return pressure.at(i); }
-    bool isSelected(int i) const { return selected.at(i+1); }
-    bool isSelected() const { bool result=true; for(int i=0; i<selected.size(); i++) result = result && selected[i]; return result; }
-    bool isPartlySelected() const { bool result=false; for(int i=0; i<selected.size(); i++) result = result || selected[i]; return result; }
+    QPointF getVertex(int i) const { if (i==-1) { return origin; } else { return segments.at(i).vertex;} }
+    QPointF getC1(int i) const { return segments.at(i).c1; }
+    QPointF getC2(int i) const { return segments.at(i).c2; }
+    qreal getPressure(int i) const { if (i==0) { return originPressure; } else { return segments.at(i-1).pressure; } } // 0 is the origin
+    bool isSelected(int i) const { return selected.testBit(i+1); }
+    bool isSelected() const { return selected.count(true) == selected.size(); }
+    bool isPartlySelected() const { return selected.count(true) > 0; }
     bool isInvisible() const { return invisible; }
     bool intersects(QPointF point, qreal distance);
     bool intersects(QRectF rectangle);
@@ -69,7 +83,7 @@ public:
     void setVariableWidth(bool YesOrNo);
     void setInvisibility(bool YesOrNo);
     void setColourNumber(int colourNumber) { this->colourNumber = colourNumber; }
-    void setSelected(bool YesOrNo) { for(int i=0; i<selected.size(); i++) { selected[i] = YesOrNo; } }
+    void setSelected(bool YesOrNo) { selected.fill(YesOrNo); }
     void setSelected(int i, bool YesOrNo);
 
     BezierCurve transformed(QMatrix transformation);
@@ -85,6 +99,7 @@ public:
     QPainterPath getStrokedPath(qreal width);
     QPainterPath getStrokedPath(qreal width, bool pressure);
     QRectF getBoundingRect();
+    QRectF getControlBoundingRect() const; // contains the curve, cheaper than getBoundingRect()
 
     void drawPath(QPainter& painter, Object* object, QMatrix transformation, bool simplified, bool showThinLines, qreal opacity);
     void createCurve(QList<QPointF>& pointList, QList<qreal>& pressureList );
@@ -101,17 +116,15 @@ public:
 
 private:
     QPointF origin;
-    QList<QPointF> c1;
-    QList<QPointF> c2;
-    QList<QPointF> vertex;
-    QList<qreal> pressure; // this list has one more element than the other list (the first element is for the origin)
+    qreal originPressure;
+    QVector<BezierSegment> segments; // contiguous and implicitly shared, so copies for undo and transformed() are cheap
     int colourNumber;
     qreal width;
     qreal feather;
     bool variableWidth;
     //bool selected;
     bool invisible;
-    QList<bool> selected; // this list has one more element than the other list (the first element is for the origin)
+    QBitArray selected; // one bit per vertex, the first one is for the origin
 };
 
 #endif
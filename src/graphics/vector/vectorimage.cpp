@@ -14,23 +14,32 @@ GNU General Public License for more details.
 
 */
 #include <QtGui>
+#include <QtEndian>
 #include <math.h>
 #include "vectorimage.h"
 #include "object.h"
+#include "perfmonitor.h"
 
 
 VectorImage::VectorImage()
 {
-    // nothing
+    modified = false;
+    wholeChanged = false;
 }
 
 VectorImage::VectorImage(Object* parent)
 {
     myParent = parent;
+    modified = false;
+    wholeChanged = false;
     deselectAll();
 }
 
 
+// binary vector images start with "PVEC" followed by the version of the format
+static const quint32 BINARY_MAGIC = 0x50564543;
+static const quint16 BINARY_VERSION = 1;
+
 bool VectorImage::read(QString filePath)
 {
     QFileInfo fileInfo(filePath);
@@ -43,6 +52,15 @@ bool VectorImage::read(QString filePath)
         return false;
     }
 
+    QByteArray header = file->peek(4);
+    if ( header.size() == 4 && qFromBigEndian<quint32>((const uchar*)header.constData()) == BINARY_MAGIC )
+    {
+        QDataStream in(file);
+        bool ok = readBinary(in);
+        file->close();
+        return ok;
+    }
+
     QDomDocument doc;
     if (!doc.setContent(file)) return false; // this is not a XML file
     QDomDocumentType type = doc.doctype();
@@ -91,6 +109,13 @@ bool VectorImage::write(QString filePath, QString format)
         file->close();
         return true;
     }
+    else if (format == "BIN")
+    {
+        QDataStream stream(file);
+        writeBinary(stream);
+        file->close();
+        return stream.status() == QDataStream::Ok;
+    }
     else
     {
         file->close();
@@ -99,6 +124,57 @@ bool VectorImage::write(QString filePath, QString format)
     }
 }
 
+void VectorImage::writeBinary(QDataStream& out)
+{
+    out.setVersion(QDataStream::Qt_4_6);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << BINARY_MAGIC << BINARY_VERSION;
+
+    out << (quint32)curve.size();
+    for(int i=0; i < curve.size() ; i++)
+    {
+        curve.at(i).writeBinary(out);
+    }
+    out << (quint32)area.size();
+    for(int i=0; i < area.size() ; i++)
+    {
+        area.at(i).writeBinary(out);
+    }
+}
+
+bool VectorImage::readBinary(QDataStream& in)
+{
+    in.setVersion(QDataStream::Qt_4_6);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic;
+    quint16 version;
+    in >> magic >> version;
+    if (magic != BINARY_MAGIC || version > BINARY_VERSION) return false;
+
+    quint32 curveCount;
+    in >> curveCount;
+    for(quint32 i=0; i < curveCount && in.status() == QDataStream::Ok; i++)
+    {
+        BezierCurve newCurve = BezierCurve();
+        if (!newCurve.readBinary(in)) return false;
+        curve.append(newCurve);
+    }
+    quint32 areaCount;
+    in >> areaCount;
+    for(quint32 i=0; i < areaCount && in.status() == QDataStream::Ok; i++)
+    {
+        BezierArea newArea = BezierArea();
+        if (!newArea.readBinary(in)) return false;
+        addArea(newArea);
+    }
+    if (in.status() != QDataStream::Ok) return false;
+
+    clean();
+    modification();
+    return true;
+}
+
 QDomElement VectorImage::createDomElement(QDomDocument& doc)
 {
     QDomElement imageTag = doc.createElement("image");
@@ -207,6 +283,7 @@ void VectorImage::addCurve(BezierCurve& newCurve, qreal factor)
 {
     if (newCurve.getVertexSize() < 1) return; // security - a new curve should have a least 2 vertices
     qreal tol = qMax(newCurve.getWidth() / factor, 3.0 / factor); // tolerance for taking the intersection as an existing vertex on a curve
+    QList<int> touched; // the other curves moved onto the new one
     //qDebug() << "tolerance" << tol;
     // finds if the new curve interesects itself
     for(int k=0; k < newCurve.getVertexSize(); k++)   // for each cubic section of the new curve
@@ -330,12 +407,14 @@ void VectorImage::addCurve(BezierCurve& newCurve, qreal factor)
             if (dist1 < 0.2*tol)
             {
                 curve[i].setVertex(-1, P1);  // memo: curve.at(i) is just a copy which can be read, curve[i] is a reference which can be modified
+                touched.append(i);
             }
             else
             {
                 if (dist2 < 0.2*tol)
                 {
                     curve[i].setVertex(-1, P2);
+                    touched.append(i);
                 }
                 else
                 {
@@ -350,6 +429,7 @@ void VectorImage::addCurve(BezierCurve& newCurve, qreal factor)
                         {
                             P = nearestPoint;
                             curve[i].setOrigin(P);
+                            touched.append(i);
                             newCurve.addPoint(k, P); //qDebug() << "--i " << P;
                         }
                     }
@@ -361,12 +441,14 @@ void VectorImage::addCurve(BezierCurve& newCurve, qreal factor)
             if (dist1 < 0.2*tol)
             {
                 curve[i].setVertex(curve.at(i).getVertexSize()-1, P1);
+                touched.append(i);
             }
             else
             {
                 if (dist2 < 0.2*tol)
                 {
                     curve[i].setVertex(curve.at(i).getVertexSize()-1, P2);
+                    touched.append(i);
                 }
                 else
                 {
@@ -381,6 +463,7 @@ void VectorImage::addCurve(BezierCurve& newCurve, qreal factor)
                         {
                             Q = nearestPoint;
                             curve[i].setLastVertex(Q);
+                            touched.append(i);
                             newCurve.addPoint(k, Q); //qDebug() << "--j " << Q;
                         }
                     }
@@ -422,6 +505,7 @@ void VectorImage::addCurve(BezierCurve& newCurve, qreal factor)
                     if ( BezierCurve::eLength(intersectionPoint - curve.at(i).getVertex(j-1)) <= 0.1*tol )   // the first point is close to the intersection
                     {
                         curve[i].setVertex(j-1, intersectionPoint); //qDebug() << "--n " << intersectionPoint;
+                        touched.append(i);
                         //qDebug() << "-------- recal2 " << j-1 << intersectionPoint;
                     }
                     else
@@ -429,6 +513,7 @@ void VectorImage::addCurve(BezierCurve& newCurve, qreal factor)
                         if ( BezierCurve::eLength(intersectionPoint - curve.at(i).getVertex(j)) <= 0.1*tol )   // the second point is close to the intersection
                         {
                             curve[i].setVertex(j, intersectionPoint); //qDebug() << "--o " << intersectionPoint;
+                            touched.append(i);
                             //qDebug() << "-------- recal2 " << j << intersectionPoint;
                         }
                         else     // none of the point is close to the intersection -> we add a new point
@@ -443,7 +528,16 @@ void VectorImage::addCurve(BezierCurve& newCurve, qreal factor)
         }
     }
     curve.append(newCurve);
-    modification();
+
+    // only the new curve and the curves whose points were moved onto it have changed
+    qreal width = newCurve.getWidth();
+    QRectF changed = newCurve.getControlBoundingRect().adjusted(-width, -width, width, width);
+    foreach (int i, touched)
+    {
+        width = curve.at(i).getWidth();
+        changed |= curve.at(i).getControlBoundingRect().adjusted(-width, -width, width, width);
+    }
+    modification(changed.adjusted(-tol, -tol, tol, tol));
     //QPainter painter(&image);
     //painter.setRenderHint(QPainter::Antialiasing, true);
     //newCurve.drawPath(&painter);
@@ -807,6 +901,13 @@ void VectorImage::paste(VectorImage vectorImage)
 
 void VectorImage::modification()
 {
+    wholeChanged = true;
+    setModified(true);
+}
+
+void VectorImage::modification(QRectF rect)
+{
+    changedRect |= rect;
     setModified(true);
 }
 
@@ -818,6 +919,21 @@ bool VectorImage::isModified()
 void VectorImage::setModified(bool trueOrFalse)
 {
     modified = trueOrFalse;
+    if (!modified)
+    {
+        wholeChanged = false;
+        changedRect = QRectF();
+    }
+    else if (changedRect.isNull())
+    {
+        // changed from outside, without an extent: anything may have changed
+        wholeChanged = true;
+    }
+}
+
+QRectF VectorImage::getChangedRect()
+{
+    return wholeChanged ? QRectF() : changedRect;
 }
 
 QColor VectorImage::getColour(int colourNumber)
@@ -866,6 +982,7 @@ void VectorImage::paintImage(QPainter& painter,
 							 bool simplified, bool showThinCurves,
 							 qreal curveOpacity, bool antialiasing)
 {
+    PERF_SCOPE("VectorImage::paintImage");
     painter.setRenderHint(QPainter::Antialiasing, antialiasing);
     painter.setClipping(false);
     painter.setOpacity(1.0);
@@ -907,8 +1024,15 @@ void VectorImage::paintImage(QPainter& painter,
     //simplified = true;
     painter.setClipRect( viewRect );
     painter.setClipping(true);
+    qreal margin = 8.0 / qMax(sqrt(qAbs(painterMatrix.determinant())), 0.0001); // room for the selection highlights
     for(int i=0; i< curve.size(); i++)
     {
+        // skip the curves which are out of view (the selected ones may be transformed)
+        if (!curve[i].isPartlySelected())
+        {
+            qreal extent = margin + curve[i].getWidth();
+            if (!curve[i].getControlBoundingRect().adjusted(-extent, -extent, extent, extent).intersects(viewRect)) continue;
+        }
         curve[i].drawPath(painter, myParent, selectionTransformation, simplified, showThinCurves, curveOpacity);
     }
     //painter.resetMatrix(); ?????
@@ -1134,11 +1258,11 @@ QPointF VectorImage::getVertex(int curveNumber, int vertexNumber)
     QPointF result = QPointF(11.11, 11.11); // bogus point
     if (curveNumber > -1 && curveNumber < curve.size())
     {
-        BezierCurve myCurve = curve.at(curveNumber);
-        if ( myCurve.isPartlySelected() ) myCurve = myCurve.transformed(selectionTransformation);
+        const BezierCurve& myCurve = curve.at(curveNumber);
         if ( vertexNumber > -2 && vertexNumber < myCurve.getVertexSize())
         {
             result = myCurve.getVertex(vertexNumber);
+            if ( myCurve.isSelected(vertexNumber) ) result = selectionTransformation.map(result);
         }
     }
     return result;
@@ -1154,11 +1278,11 @@ QPointF VectorImage::getC1(int curveNumber, int vertexNumber)
     QPointF result = QPointF(11.11, 11.11); // bogus point
     if (curveNumber > -1 && curveNumber < curve.size())
     {
-        BezierCurve myCurve = curve.at(curveNumber);
-        if ( myCurve.isPartlySelected() ) myCurve = myCurve.transformed(selectionTransformation);
+        const BezierCurve& myCurve = curve.at(curveNumber);
         if ( vertexNumber > -1 && vertexNumber < myCurve.getVertexSize())
         {
             result = myCurve.getC1(vertexNumber);
+            if ( myCurve.isSelected(vertexNumber-1) ) result = selectionTransformation.map(result);
         }
     }
     return result;
@@ -1174,11 +1298,11 @@ QPointF VectorImage::getC2(int curveNumber, int vertexNumber)
     QPointF result = QPointF(11.11, 11.11); // bogus point
     if (curveNumber > -1 && curveNumber < curve.size())
     {
-        BezierCurve myCurve = curve.at(curveNumber);
-        if ( myCurve.isPartlySelected() ) myCurve = myCurve.transformed(selectionTransformation);
+        const BezierCurve& myCurve = curve.at(curveNumber);
         if ( vertexNumber > -1 && vertexNumber < myCurve.getVertexSize())
         {
             result = myCurve.getC2(vertexNumber);
+            if ( myCurve.isSelected(vertexNumber) ) result = selectionTransformation.map(result);
         }
     }
     return result;
@@ -1392,7 +1516,8 @@ void VectorImage::updateArea(BezierArea& bezierArea)
         }
         else
         {
-            if (bezierArea.vertex[i-1].curveNumber == bezierArea.vertex[i].curveNumber )   // the two points are on the same curve
+            if (bezierArea.vertex[i-1].curveNumber == bezierArea.vertex[i].curveNumber
+                    && qAbs(bezierArea.vertex[i-1].vertexNumber - bezierArea.vertex[i].vertexNumber) == 1 )   // the two points are consecutive on the same curve
             {
                 if (bezierArea.vertex[i-1].vertexNumber < bezierArea.vertex[i].vertexNumber )   // the points follow the curve progression
                 {
@@ -1424,6 +1549,218 @@ void VectorImage::updateArea(BezierArea& bezierArea)
     bezierArea.path.setFillRule( Qt::WindingFill );
 }
 
+// one direction of a curve section, seen as an edge of the planar graph formed by the curves
+struct ContourEdge
+{
+    int from; // graph nodes: vertices which coincide (within the tolerance) are one node
+    int to;
+    VertexRef start;
+    VertexRef end;
+    qreal angle; // direction in which the section leaves "from"
+    bool removed;
+};
+
+static qreal leavingAngle(QPointF p, QPointF c1, QPointF c2, QPointF q)
+{
+    QPointF d = c1 - p;
+    if (qAbs(d.x()) + qAbs(d.y()) < 1.0e-9) d = c2 - p;
+    if (qAbs(d.x()) + qAbs(d.y()) < 1.0e-9) d = q - p;
+    return atan2(d.y(), d.x());
+}
+
+QList<VertexRef> VectorImage::getContourAt(QPointF point, qreal tolerance)
+{
+    // Finds the region enclosing the point directly from the curves: the curves form a planar graph
+    // (they are connected at their vertices), and the region is the face of this graph around the point.
+
+    // --- nodes: vertices closer than the tolerance are merged, using a grid of buckets
+    qreal cellSize = qMax(tolerance, 0.001);
+    QHash< QPair<int,int>, QList<int> > grid;
+    QList<QPointF> nodePosition;
+    QList< QList<int> > nodeOfVertex; // index [curveNumber][vertexNumber+1]
+    for(int c=0; c < curve.size(); c++)
+    {
+        QList<int> nodes;
+        for(int v=-1; v < curve.at(c).getVertexSize(); v++)
+        {
+            QPointF position = getVertex(c, v);
+            int gx = (int)floor(position.x() / cellSize);
+            int gy = (int)floor(position.y() / cellSize);
+            int node = -1;
+            for(int dx=-1; dx <= 1 && node == -1; dx++)
+            {
+                for(int dy=-1; dy <= 1 && node == -1; dy++)
+                {
+                    QHash< QPair<int,int>, QList<int> >::const_iterator bucket = grid.constFind(qMakePair(gx+dx, gy+dy));
+                    if (bucket == grid.constEnd()) continue;
+                    for(int k=0; k < bucket->size(); k++)
+                    {
+                        if (BezierCurve::eLength(nodePosition.at(bucket->at(k)) - position) <= tolerance)
+                        {
+                            node = bucket->at(k);
+                            break;
+                        }
+                    }
+                }
+            }
+            if (node == -1)
+            {
+                node = nodePosition.size();
+                nodePosition.append(position);
+                grid[qMakePair(gx, gy)].append(node);
+            }
+            nodes.append(node);
+        }
+        nodeOfVertex.append(nodes);
+    }
+
+    // --- edges: each curve section gives two opposite edges, stored at 2k and 2k+1
+    QList<ContourEdge> edges;
+    QVector< QList<int> > outgoing(nodePosition.size());
+    for(int c=0; c < curve.size(); c++)
+    {
+        for(int i=0; i < curve.at(c).getVertexSize(); i++)
+        {
+            int nodeA = nodeOfVertex.at(c).at(i);
+            int nodeB = nodeOfVertex.at(c).at(i+1);
+            if (nodeA == nodeB) continue;
+            VertexRef a(c, i-1);
+            VertexRef b(c, i);
+            QPointF pA = getVertex(a);
+            QPointF pB = getVertex(b);
+            QPointF c1 = getC1(b);
+            QPointF c2 = getC2(b);
+            ContourEdge forward = { nodeA, nodeB, a, b, leavingAngle(pA, c1, c2, pB), false };
+            ContourEdge backward = { nodeB, nodeA, b, a, leavingAngle(pB, c2, c1, pA), false };
+            outgoing[nodeA].append(edges.size());
+            edges.append(forward);
+            outgoing[nodeB].append(edges.size());
+            edges.append(backward);
+        }
+    }
+
+    // --- dangling strokes cannot enclose anything: prune them
+    QVector<int> degree(nodePosition.size());
+    QList<int> danglingNodes;
+    for(int n=0; n < nodePosition.size(); n++)
+    {
+        degree[n] = outgoing.at(n).size();
+        if (degree[n] == 1) danglingNodes.append(n);
+    }
+    while (!danglingNodes.isEmpty())
+    {
+        int node = danglingNodes.takeLast();
+        if (degree[node] != 1) continue;
+        for(int k=0; k < outgoing.at(node).size(); k++)
+        {
+            int e = outgoing.at(node).at(k);
+            if (edges.at(e).removed) continue;
+            edges[e].removed = true;
+            edges[e^1].removed = true;
+            degree[node]--;
+            int other = edges.at(e).to;
+            degree[other]--;
+            if (degree[other] == 1) danglingNodes.append(other);
+            break;
+        }
+    }
+
+    // --- sort the edges leaving each node by angle
+    QVector<int> slot(edges.size()); // position of an edge in the sorted list of its node
+    for(int n=0; n < nodePosition.size(); n++)
+    {
+        QList< QPair<qreal,int> > sorted;
+        for(int k=0; k < outgoing.at(n).size(); k++)
+        {
+            int e = outgoing.at(n).at(k);
+            if (!edges.at(e).removed) sorted.append(qMakePair(edges.at(e).angle, e));
+        }
+        qSort(sorted);
+        outgoing[n].clear();
+        for(int k=0; k < sorted.size(); k++)
+        {
+            outgoing[n].append(sorted.at(k).second);
+            slot[sorted.at(k).second] = k;
+        }
+    }
+
+    // --- cast a ray from the point to the right: the sections it crosses border the candidate regions,
+    // the edge oriented with the point on its left is kept
+    QList< QPair<qreal,int> > crossings;
+    const int nSteps = 16;
+    for(int e=0; e < edges.size(); e += 2)
+    {
+        if (edges.at(e).removed) continue;
+        QPointF p0 = getVertex(edges.at(e).start);
+        QPointF p3 = getVertex(edges.at(e).end);
+        QPointF p1 = getC1(edges.at(e).end);
+        QPointF p2 = getC2(edges.at(e).end);
+        if (qMax(qMax(p0.x(), p1.x()), qMax(p2.x(), p3.x())) < point.x()) continue;
+        if (qMin(qMin(p0.y(), p1.y()), qMin(p2.y(), p3.y())) > point.y()) continue;
+        if (qMax(qMax(p0.y(), p1.y()), qMax(p2.y(), p3.y())) < point.y()) continue;
+        QPointF previous = p0;
+        for(int k=1; k <= nSteps; k++)
+        {
+            qreal t = (k+0.0)/nSteps;
+            QPointF q = (1.0-t)*(1.0-t)*(1.0-t)*p0 + 3*t*(1.0-t)*(1.0-t)*p1 + 3*t*t*(1.0-t)*p2 + t*t*t*p3;
+            if ( (previous.y() <= point.y()) != (q.y() <= point.y()) )
+            {
+                qreal x = previous.x() + (point.y() - previous.y()) * (q.x() - previous.x()) / (q.y() - previous.y());
+                if (x > point.x())
+                {
+                    crossings.append( qMakePair(x, q.y() > previous.y() ? e : e+1) );
+                }
+            }
+            previous = q;
+        }
+    }
+    qSort(crossings);
+
+    // --- walk around the faces, nearest first, until one contains the point
+    QVector<bool> visited(edges.size());
+    for(int i=0; i < crossings.size(); i++)
+    {
+        int startEdge = crossings.at(i).second;
+        if (visited.at(startEdge)) continue;
+
+        QList<int> face;
+        int e = startEdge;
+        bool closed = false;
+        while (face.size() <= edges.size())
+        {
+            face.append(e);
+            visited[e] = true;
+            // the next edge is the one just before the way back, in the order of angles
+            const QList<int>& edgesOut = outgoing.at(edges.at(e).to);
+            int twinSlot = slot.at(e^1);
+            e = edgesOut.at( (twinSlot - 1 + edgesOut.size()) % edgesOut.size() );
+            if (e == startEdge)
+            {
+                closed = true;
+                break;
+            }
+        }
+        if (!closed) continue;
+
+        QList<VertexRef> contour;
+        for(int k=0; k < face.size(); k++)
+        {
+            ContourEdge edge = edges.at(face.at(k));
+            if (contour.isEmpty() || contour.last() != edge.start) contour.append(edge.start);
+            contour.append(edge.end);
+        }
+        if (contour.size() > 1 && contour.first() == contour.last()) contour.removeLast();
+
+        BezierArea candidate(contour, 0);
+        updateArea(candidate);
+        if (candidate.path.contains(point))
+        {
+            return contour;
+        }
+    }
+    return QList<VertexRef>();
+}
+
 qreal VectorImage::getDistance(VertexRef r1, VertexRef r2)
 {
     qreal dist = BezierCurve::eLength(getVertex(r1)-getVertex(r2));
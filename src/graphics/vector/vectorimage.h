@@ -39,7 +39,9 @@ public:
     //VectorImage(QImage newImage, Object* parent);
 
     bool read(QString filePath);
-    bool write(QString filePath, QString format);
+    bool write(QString filePath, QString format); // format is "VEC" (XML) or "BIN"
+    void writeBinary(QDataStream& out);
+    bool readBinary(QDataStream& in);
     QDomElement createDomElement(QDomDocument& doc);
     void loadDomElement(QDomElement element);
 
@@ -76,6 +78,8 @@ public:
 
     bool isModified();
     void setModified(bool);
+    // what changed since setModified(false), in world coordinates; a null rect when it may be anything
+    QRectF getChangedRect();
 
     QColor getColour(int i);
     int  getColourNumber(QPointF point);
@@ -103,6 +107,7 @@ public:
     int  getLastAreaNumber(QPointF point, int maxAreaNumber);
     void removeArea(QPointF point);
     void updateArea(BezierArea& bezierArea);
+    QList<VertexRef> getContourAt(QPointF point, qreal tolerance); // closed path around the point, empty if there is none
 
 
     QList<int> getCurvesCloseTo(QPointF thisPoint, qreal maxDistance);
@@ -129,7 +134,10 @@ public:
 
 private:
     void modification();
+    void modification(QRectF rect);
     bool modified;
+    bool wholeChanged;
+    QRectF changedRect;
 
     Object* myParent;
 
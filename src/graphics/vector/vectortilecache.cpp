@@ -0,0 +1,298 @@
+#include <cmath>
+#include <QPainter>
+#include <QElapsedTimer>
+#include "pencilsettings.h"
+#include "vectorimage.h"
+#include "vectortilecache.h"
+
+// one pixel border around each tile, so that smooth scaling does not
+// produce visible seams between neighbouring tiles
+static const int TILE_GUTTER = 1;
+static const int MIN_LEVEL = -6;
+static const int MAX_LEVEL = 6;
+static const int FALLBACK_LEVELS = 4;
+static const int IDLE_RENDER_TIME = 12; // milliseconds spent rendering pending tiles per idle slice
+static const int DEFAULT_MEMORY_BUDGET = 96; // megabytes
+
+// ==== Singleton ====
+static VectorTileCache* g_pTileCache = NULL;
+
+VectorTileCache* VectorTileCache::instance()
+{
+    if ( g_pTileCache == NULL )
+    {
+        g_pTileCache = new VectorTileCache();
+    }
+    return g_pTileCache;
+}
+
+VectorTileCache::VectorTileCache( QObject* parent ) : QObject( parent )
+{
+    int budget = pencilSettings()->value( SETTING_VECTOR_CACHE_SIZE, DEFAULT_MEMORY_BUDGET ).toInt();
+    setMemoryBudget( budget );
+
+    m_idleTimer.setSingleShot( true );
+    m_idleTimer.setInterval( 0 );
+    connect( &m_idleTimer, SIGNAL( timeout() ), this, SLOT( renderPendingTiles() ) );
+}
+
+void VectorTileCache::setMemoryBudget( int megabytes )
+{
+    m_tiles.setMaxCost( qMax( megabytes, 8 ) * 1024 );
+}
+
+int VectorTileCache::memoryBudget() const
+{
+    return m_tiles.maxCost() / 1024;
+}
+
+int VectorTileCache::styleOf( const RenderOptions& options )
+{
+    return ( options.simplified ? 1 : 0 )
+        | ( options.showThinLines ? 2 : 0 )
+        | ( options.antialiasing ? 4 : 0 )
+        | ( qRound( options.curveOpacity * 100 ) << 3 );
+}
+
+int VectorTileCache::levelOf( const QMatrix& view )
+{
+    qreal scale = sqrt( qAbs( view.determinant() ) );
+    if ( scale <= 0.0 )
+    {
+        return 0;
+    }
+    // round up, so that tiles are never magnified on screen
+    int level = ( int )ceil( log( scale ) / log( 2.0 ) - 1.0e-6 );
+    return qBound( MIN_LEVEL, level, MAX_LEVEL );
+}
+
+qreal VectorTileCache::tileWorldSize( int level )
+{
+    return TILE_SIZE / pow( 2.0, level );
+}
+
+void VectorTileCache::paintImage( QPainter& painter,
+                                  VectorImage* vectorImage,
+                                  QMatrix view,
+                                  bool simplified,
+                                  bool showThinLines,
+                                  qreal curveOpacity,
+                                  bool antialiasing )
+{
+    RenderOptions options = { simplified, showThinLines, curveOpacity, antialiasing };
+    int style = styleOf( options );
+    int level = levelOf( view );
+    qreal ws = tileWorldSize( level );
+
+    // the view has moved on to another zoom level: what is still waiting to be rendered is useless
+    for ( int i = m_pending.size() - 1; i >= 0; i-- )
+    {
+        const VectorTileKey& pendingKey = m_pending.at( i ).key;
+        if ( pendingKey.image == vectorImage && ( pendingKey.level != level || pendingKey.style != style ) )
+        {
+            m_pending.removeAt( i );
+        }
+    }
+
+    painter.save();
+    painter.setWorldMatrix( view );
+    painter.setWorldMatrixEnabled( true );
+
+    // no filtering when the tiles map exactly onto the screen pixels
+    qreal scale = sqrt( qAbs( view.determinant() ) );
+    bool exactScale = view.m12() == 0 && view.m21() == 0 && qFuzzyCompare( scale, pow( 2.0, level ) );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform, !exactScale );
+
+    QRectF worldRect = view.inverted().mapRect( QRectF( 0, 0, painter.device()->width(), painter.device()->height() ) );
+    if ( painter.hasClipping() )
+    {
+        worldRect &= painter.clipBoundingRect();
+    }
+
+    int left = ( int )floor( worldRect.left() / ws );
+    int right = ( int )floor( worldRect.right() / ws );
+    int top = ( int )floor( worldRect.top() / ws );
+    int bottom = ( int )floor( worldRect.bottom() / ws );
+
+    QRectF source( TILE_GUTTER, TILE_GUTTER, TILE_SIZE, TILE_SIZE );
+    for ( int y = top; y <= bottom; y++ )
+    {
+        for ( int x = left; x <= right; x++ )
+        {
+            VectorTileKey key = { vectorImage, style, level, x, y };
+            QRectF target( x * ws, y * ws, ws, ws );
+
+            QImage* cachedTile = m_tiles.object( key );
+            if ( cachedTile != NULL )
+            {
+                painter.drawImage( target, *cachedTile, source );
+            }
+            else if ( paintFallback( painter, key, target ) )
+            {
+                schedule( key, vectorImage, options );
+            }
+            else
+            {
+                QImage tile = renderTile( vectorImage, key, options );
+                painter.drawImage( target, tile, source );
+            }
+        }
+    }
+    painter.restore();
+}
+
+QImage VectorTileCache::renderTile( VectorImage* vectorImage, const VectorTileKey& key, const RenderOptions& options )
+{
+    qreal scale = pow( 2.0, key.level );
+    qreal ws = tileWorldSize( key.level );
+
+    QImage tile( TILE_SIZE + 2 * TILE_GUTTER, TILE_SIZE + 2 * TILE_GUTTER, QImage::Format_ARGB32_Premultiplied );
+    tile.fill( qRgba( 0, 0, 0, 0 ) );
+
+    QMatrix tileView;
+    tileView.translate( TILE_GUTTER, TILE_GUTTER );
+    tileView.scale( scale, scale );
+    tileView.translate( -key.x * ws, -key.y * ws );
+
+    QPainter painter( &tile );
+    painter.setWorldMatrix( tileView );
+    vectorImage->paintImage( painter, options.simplified, options.showThinLines, options.curveOpacity, options.antialiasing );
+    painter.end();
+
+    m_tiles.insert( key, new QImage( tile ), qMax( 1, tile.byteCount() / 1024 ) );
+    return tile;
+}
+
+bool VectorTileCache::paintFallback( QPainter& painter, const VectorTileKey& key, const QRectF& target )
+{
+    // a coarser level: one tile covers the target, drawn magnified
+    for ( int d = 1; d <= FALLBACK_LEVELS && key.level - d >= MIN_LEVEL; d++ )
+    {
+        int coarseLevel = key.level - d;
+        qreal coarseScale = pow( 2.0, coarseLevel );
+        qreal coarseSize = tileWorldSize( coarseLevel );
+        int cx = ( int )floor( target.left() / coarseSize + 1.0e-6 );
+        int cy = ( int )floor( target.top() / coarseSize + 1.0e-6 );
+
+        VectorTileKey coarseKey = { key.image, key.style, coarseLevel, cx, cy };
+        QImage* coarseTile = m_tiles.object( coarseKey );
+        if ( coarseTile != NULL )
+        {
+            QRectF source( ( target.left() - cx * coarseSize ) * coarseScale + TILE_GUTTER,
+                           ( target.top() - cy * coarseSize ) * coarseScale + TILE_GUTTER,
+                           target.width() * coarseScale,
+                           target.height() * coarseScale );
+            painter.drawImage( target, *coarseTile, source );
+            return true;
+        }
+    }
+
+    // the next finer level: four tiles cover the target, drawn reduced;
+    // only when all four are there, since the target is drawn again over a partial set
+    // and the translucent layers would show the overlap
+    if ( key.level + 1 <= MAX_LEVEL )
+    {
+        QImage* fineTiles[ 4 ];
+        for ( int k = 0; k < 4; k++ )
+        {
+            VectorTileKey fineKey = { key.image, key.style, key.level + 1, 2 * key.x + k % 2, 2 * key.y + k / 2 };
+            fineTiles[ k ] = m_tiles.object( fineKey );
+            if ( fineTiles[ k ] == NULL )
+            {
+                return false;
+            }
+        }
+        QRectF source( TILE_GUTTER, TILE_GUTTER, TILE_SIZE, TILE_SIZE );
+        qreal half = 0.5 * target.width();
+        for ( int k = 0; k < 4; k++ )
+        {
+            painter.drawImage( QRectF( target.left() + ( k % 2 ) * half, target.top() + ( k / 2 ) * half, half, half ), *fineTiles[ k ], source );
+        }
+        return true;
+    }
+    return false;
+}
+
+void VectorTileCache::schedule( const VectorTileKey& key, VectorImage* vectorImage, const RenderOptions& options )
+{
+    for ( int i = 0; i < m_pending.size(); i++ )
+    {
+        if ( m_pending.at( i ).key == key )
+        {
+            return;
+        }
+    }
+    PendingTile pendingTile = { key, vectorImage, options };
+    m_pending.append( pendingTile );
+    if ( !m_idleTimer.isActive() )
+    {
+        m_idleTimer.start();
+    }
+}
+
+void VectorTileCache::renderPendingTiles()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    bool rendered = false;
+    while ( !m_pending.isEmpty() && elapsed.elapsed() < IDLE_RENDER_TIME )
+    {
+        PendingTile pendingTile = m_pending.takeFirst();
+        if ( !m_tiles.contains( pendingTile.key ) )
+        {
+            renderTile( pendingTile.image, pendingTile.key, pendingTile.options );
+            rendered = true;
+        }
+    }
+
+    if ( !m_pending.isEmpty() )
+    {
+        m_idleTimer.start();
+    }
+    if ( rendered )
+    {
+        emit tilesRendered();
+    }
+}
+
+void VectorTileCache::invalidate( const VectorImage* vectorImage, const QRectF& worldRect )
+{
+    foreach ( VectorTileKey key, m_tiles.keys() )
+    {
+        if ( key.image != vectorImage )
+        {
+            continue;
+        }
+        if ( !worldRect.isNull() )
+        {
+            // the gutter, and a pixel more for the antialiasing, reach into the neighbours
+            qreal ws = tileWorldSize( key.level );
+            qreal margin = ( TILE_GUTTER + 1 ) * ws / TILE_SIZE;
+            QRectF tileRect( key.x * ws - margin, key.y * ws - margin, ws + 2 * margin, ws + 2 * margin );
+            if ( !tileRect.intersects( worldRect ) )
+            {
+                continue;
+            }
+        }
+        m_tiles.remove( key );
+    }
+    if ( !worldRect.isNull() )
+    {
+        // the tiles still to be rendered will be rendered from the image as it is now
+        return;
+    }
+    for ( int i = m_pending.size() - 1; i >= 0; i-- )
+    {
+        if ( m_pending.at( i ).image == vectorImage )
+        {
+            m_pending.removeAt( i );
+        }
+    }
+}
+
+void VectorTileCache::clear()
+{
+    m_tiles.clear();
+    m_pending.clear();
+}
@@ -0,0 +1,104 @@
+#ifndef VECTORTILECACHE_H
+#define VECTORTILECACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QMatrix>
+#include <QTimer>
+#include <QList>
+
+class QPainter;
+class VectorImage;
+
+
+struct VectorTileKey
+{
+    const VectorImage* image;
+    int style; // render options packed into an int, see VectorTileCache::styleOf()
+    int level; // the tile is rendered at a scale of 2^level
+    int x;
+    int y;
+};
+
+inline bool operator==( const VectorTileKey& a, const VectorTileKey& b )
+{
+    return a.image == b.image && a.style == b.style && a.level == b.level && a.x == b.x && a.y == b.y;
+}
+
+inline uint qHash( const VectorTileKey& key )
+{
+    return qHash( reinterpret_cast<quintptr>( key.image ) )
+        ^ ( uint( key.style ) << 20 )
+        ^ ( uint( key.level & 0xff ) << 12 )
+        ^ uint( key.x * 73856093 )
+        ^ uint( key.y * 19349663 );
+}
+
+
+/**
+ * Multi-resolution cache of the rendered vector frames.
+ *
+ * Frames are rendered into square tiles laid out in world space, one grid
+ * per power-of-two scale. Panning only renders the tiles that scroll into
+ * view. After a zoom the tiles of the nearest available level are drawn
+ * rescaled, and the tiles of the exact level are rendered in idle time.
+ * All tiles share one LRU cache bounded by a memory budget.
+ */
+class VectorTileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static VectorTileCache* instance();
+
+    static const int TILE_SIZE = 256;
+
+    void paintImage( QPainter& painter, VectorImage* vectorImage, QMatrix view,
+                     bool simplified, bool showThinLines, qreal curveOpacity, bool antialiasing );
+
+    // drops the tiles of an image which meet worldRect, or all of them when it is null
+    void invalidate( const VectorImage* vectorImage, const QRectF& worldRect = QRectF() );
+    void clear();
+
+    void setMemoryBudget( int megabytes );
+    int memoryBudget() const;
+
+signals:
+    void tilesRendered();
+
+private slots:
+    void renderPendingTiles();
+
+private:
+    explicit VectorTileCache( QObject* parent = 0 );
+
+    struct RenderOptions
+    {
+        bool simplified;
+        bool showThinLines;
+        qreal curveOpacity;
+        bool antialiasing;
+    };
+
+    struct PendingTile
+    {
+        VectorTileKey key;
+        VectorImage* image;
+        RenderOptions options;
+    };
+
+    static int styleOf( const RenderOptions& options );
+    static int levelOf( const QMatrix& view );
+    static qreal tileWorldSize( int level );
+
+    QImage renderTile( VectorImage* vectorImage, const VectorTileKey& key, const RenderOptions& options );
+    bool paintFallback( QPainter& painter, const VectorTileKey& key, const QRectF& target );
+    void schedule( const VectorTileKey& key, VectorImage* vectorImage, const RenderOptions& options );
+
+    QCache<VectorTileKey, QImage> m_tiles; // cost in kilobytes
+    QList<PendingTile> m_pending;
+    QTimer m_idleTimer;
+};
+
+#endif // VECTORTILECACHE_H
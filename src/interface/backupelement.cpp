@@ -1,3 +1,126 @@
+#include <cstring>
 #include "backupelement.h"
 
+static int tileIndex(int coordinate, int tileSize)
+{
+    // rounds towards minus infinity
+    return ( coordinate >= 0 ) ? coordinate / tileSize : ( coordinate - tileSize + 1 ) / tileSize;
+}
 
+void BackupBitmapElement::capture( BitmapImage* bitmapImage, BackupBitmapElement* previous )
+{
+    QImage source = *bitmapImage->image;
+    if ( source.format() != QImage::Format_ARGB32_Premultiplied )
+    {
+        source = source.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+    }
+    boundaries = QRect( bitmapImage->boundaries.topLeft(), source.size() );
+    m_tiles.clear();
+    m_tileRect = QRect();
+    m_cost = 0;
+    if ( boundaries.isEmpty() )
+    {
+        return;
+    }
+
+    m_tileRect = QRect( QPoint( tileIndex( boundaries.left(), TILE_SIZE ), tileIndex( boundaries.top(), TILE_SIZE ) ),
+                        QPoint( tileIndex( boundaries.right(), TILE_SIZE ), tileIndex( boundaries.bottom(), TILE_SIZE ) ) );
+    m_tiles.reserve( m_tileRect.width() * m_tileRect.height() );
+
+    for ( int ty = m_tileRect.top(); ty <= m_tileRect.bottom(); ty++ )
+    {
+        for ( int tx = m_tileRect.left(); tx <= m_tileRect.right(); tx++ )
+        {
+            QRect tileWorld( tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE );
+            QRect covered = tileWorld & boundaries;
+            QImage previousTile = ( previous != NULL ) ? previous->tileAt( tx, ty ) : QImage();
+
+            if ( covered == tileWorld )
+            {
+                // whole tile: compare the rows in place, and only copy them if they changed
+                bool same = !previousTile.isNull();
+                int x = covered.left() - boundaries.left();
+                for ( int y = 0; y < TILE_SIZE && same; y++ )
+                {
+                    const uchar* row = source.constScanLine( covered.top() - boundaries.top() + y ) + x * 4;
+                    same = ( memcmp( row, previousTile.constScanLine( y ), TILE_SIZE * 4 ) == 0 );
+                }
+                m_tiles.append( same ? previousTile : source.copy( covered.translated( -boundaries.topLeft() ) ) );
+            }
+            else
+            {
+                // tile on the border: the part outside the image is transparent
+                QImage tile( TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied );
+                tile.fill( 0 );
+                for ( int y = covered.top(); y <= covered.bottom(); y++ )
+                {
+                    memcpy( tile.scanLine( y - tileWorld.top() ) + ( covered.left() - tileWorld.left() ) * 4,
+                            source.constScanLine( y - boundaries.top() ) + ( covered.left() - boundaries.left() ) * 4,
+                            covered.width() * 4 );
+                }
+                m_tiles.append( ( !previousTile.isNull() && previousTile == tile ) ? previousTile : tile );
+            }
+        }
+    }
+    updateCost( previous );
+}
+
+void BackupBitmapElement::updateCost( BackupBitmapElement* previous )
+{
+    m_cost = 0;
+    for ( int ty = m_tileRect.top(); ty <= m_tileRect.bottom(); ty++ )
+    {
+        for ( int tx = m_tileRect.left(); tx <= m_tileRect.right(); tx++ )
+        {
+            QImage tile = tileAt( tx, ty );
+            if ( previous == NULL || previous->tileAt( tx, ty ).cacheKey() != tile.cacheKey() )
+            {
+                m_cost += tile.byteCount();
+            }
+        }
+    }
+}
+
+QImage BackupBitmapElement::tileAt( int tx, int ty )
+{
+    if ( !m_tileRect.contains( tx, ty ) )
+    {
+        return QImage();
+    }
+    return m_tiles.at( ( ty - m_tileRect.top() ) * m_tileRect.width() + ( tx - m_tileRect.left() ) );
+}
+
+QImage BackupBitmapElement::image()
+{
+    QImage result( boundaries.size(), QImage::Format_ARGB32_Premultiplied );
+    for ( int ty = m_tileRect.top(); ty <= m_tileRect.bottom(); ty++ )
+    {
+        for ( int tx = m_tileRect.left(); tx <= m_tileRect.right(); tx++ )
+        {
+            QImage tile = tileAt( tx, ty );
+            QRect tileWorld( tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE );
+            QRect covered = tileWorld & boundaries;
+            for ( int y = covered.top(); y <= covered.bottom(); y++ )
+            {
+                memcpy( result.scanLine( y - boundaries.top() ) + ( covered.left() - boundaries.left() ) * 4,
+                        tile.constScanLine( y - tileWorld.top() ) + ( covered.left() - tileWorld.left() ) * 4,
+                        covered.width() * 4 );
+            }
+        }
+    }
+    return result;
+}
+
+int BackupVectorElement::cost()
+{
+    int result = sizeof( VectorImage );
+    for ( int i = 0; i < vectorImage.curve.size(); i++ )
+    {
+        result += sizeof( BezierCurve ) + ( vectorImage.curve.at( i ).getVertexSize() + 1 ) * sizeof( BezierSegment );
+    }
+    for ( int i = 0; i < vectorImage.area.size(); i++ )
+    {
+        result += sizeof( BezierArea ) + vectorImage.area.at( i ).vertex.size() * sizeof( VertexRef );
+    }
+    return result;
+}
@@ -20,17 +20,35 @@ public:
 
     virtual int type() { return UNDEFINED; }
     virtual void restore(Editor*) { qDebug() << "Wrong"; }
+    virtual int cost() { return 0; } // approximate memory used by the backup, in bytes
 };
 
 class BackupBitmapElement : public BackupElement
 {
     Q_OBJECT
 public:
+    static const int TILE_SIZE = 64;
+
+    BackupBitmapElement() : m_cost( 0 ) {}
+
     int layer, frame;
-    BitmapImage bitmapImage;
+    QRect boundaries; // of the saved image
     //BackupBitmapElement() { type = BackupElement::BITMAP_MODIF; }
     int type() { return BackupElement::BITMAP_MODIF; }
     void restore(Editor*);
+    int cost() { return m_cost; }
+
+    // the image is saved as tiles, sharing the unchanged ones with the previous backup of the same frame
+    void capture(BitmapImage* bitmapImage, BackupBitmapElement* previous);
+    void updateCost(BackupBitmapElement* previous);
+    QImage image();
+
+private:
+    QImage tileAt(int tx, int ty);
+
+    QRect m_tileRect; // in tile units
+    QVector<QImage> m_tiles; // row by row over m_tileRect
+    int m_cost;
 };
 
 class BackupVectorElement : public BackupElement
@@ -42,6 +60,7 @@ public:
     //BackupVectorElement() { type = BackupElement::VECTOR_MODIF; }
     int type() { return BackupElement::VECTOR_MODIF; }
     void restore(Editor*);
+    int cost();
 };
 
 #endif // BACKUPELEMENT_H
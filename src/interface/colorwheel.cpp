@@ -4,6 +4,7 @@
 #include <QStyleOption>
 #include <QtCore/qmath.h>
 #include <QRect>
+#include <QVector>
 #include <QDebug>
 
 #include "colorwheel.h"
@@ -11,6 +12,7 @@
 ColorWheel::ColorWheel(QWidget *parent) : QWidget(parent),
     m_initSize(200, 200),
     m_wheelWidth(25),
+    m_squareHue(-1),
     m_currentColor(Qt::red),
     m_isInWheel(false),
     m_isInSquare(false)
@@ -184,6 +186,19 @@ void ColorWheel::paintEvent(QPaintEvent *)
     style()->drawPrimitive(QStyle::PE_Widget, &opt, &painter, this);
 }
 
+const QGradientStops& ColorWheel::hueStops()
+{
+    static QGradientStops stops;
+    if (stops.isEmpty())
+    {
+        for (int hue = 0; hue < 360; hue +=1)
+        {
+            stops.append(QGradientStop(hue / 360.0, QColor::fromHsv(hue, 255, 255)));
+        }
+    }
+    return stops;
+}
+
 void ColorWheel::drawWheelImage(const QSize &newSize)
 {
     int r = qMin(newSize.width(), newSize.height());
@@ -193,7 +208,14 @@ void ColorWheel::drawWheelImage(const QSize &newSize)
 
     QBrush backgroundBrush = option.palette.window();
 
-    m_wheelImage = QImage(newSize, QImage::Format_ARGB32_Premultiplied);
+    // the wheel only depends on the shorter side, so most resizes keep it
+    if (m_wheelImage.width() == r && m_wheelBackground == backgroundBrush.color())
+    {
+        return;
+    }
+    m_wheelBackground = backgroundBrush.color();
+
+    m_wheelImage = QImage(r, r, QImage::Format_ARGB32_Premultiplied);
 
     //m_wheelImage.fill(background.color());  // Only in 4.8
 
@@ -203,11 +225,7 @@ void ColorWheel::drawWheelImage(const QSize &newSize)
     painter.fillRect(m_wheelImage.rect(), backgroundBrush);
 
     QConicalGradient conicalGradient(0, 0, 0);
-
-    for (int hue = 0; hue < 360; hue +=1)
-    {
-        conicalGradient.setColorAt( hue / 360.0,  QColor::fromHsv(hue, 255, 255));
-    }
+    conicalGradient.setStops(hueStops());
 
     /* outer circle */
     painter.translate(r / 2, r / 2);
@@ -237,21 +255,41 @@ void ColorWheel::drawSquareImage(const int &hue)
     // left corner of square
     qreal m = (w /2.0) - (ir / qSqrt(2));
 
-    QImage square(255, 255, QImage::Format_ARGB32_Premultiplied);
-    QColor color;
+    int SquareWidth = qMax(2, int(2 * ir / qSqrt(2)));
+    m_squareRegion = QRegion(m, m, SquareWidth, SquareWidth);
+
+    if (hue == m_squareHue && m_squareImage.width() == SquareWidth)
+    {
+        return;
+    }
+    m_squareHue = hue;
+
+    // Each channel at (s, v) is v * (1 - s * (1 - c)), where c is the channel of
+    // the pure hue, so the factor of every column is worked out once, in 16.16
+    // fixed point, and each pixel costs a multiply per channel.
+    QRgb pure = QColor::fromHsv(hue, 255, 255).rgb();
+    QVector<uint> red(SquareWidth), green(SquareWidth), blue(SquareWidth);
+    for (int x = 0; x < SquareWidth; ++x)
+    {
+        uint s = x * 255 / (SquareWidth - 1);
+        red[x] = ((65025 - s * (255 - qRed(pure))) * 65536u + 32512) / 65025;
+        green[x] = ((65025 - s * (255 - qGreen(pure))) * 65536u + 32512) / 65025;
+        blue[x] = ((65025 - s * (255 - qBlue(pure))) * 65536u + 32512) / 65025;
+    }
 
-    for (int i = 0; i < 255; ++i)
+    QImage square(SquareWidth, SquareWidth, QImage::Format_RGB32);
+    for (int y = 0; y < SquareWidth; ++y)
     {
-        for (int j = 0; j < 255; ++j)
+        uint v = 255 - y * 255 / (SquareWidth - 1);
+        QRgb* line = reinterpret_cast<QRgb*>(square.scanLine(y));
+        for (int x = 0; x < SquareWidth; ++x)
         {
-            color = QColor::fromHsv(hue, i, 255 - j);
-            QRgb rgb = qRgb(color.red(), color.green(), color.blue());
-            square.setPixel(i, j, rgb);
+            line[x] = qRgb((v * red[x] + 32768) >> 16,
+                           (v * green[x] + 32768) >> 16,
+                           (v * blue[x] + 32768) >> 16);
         }
     }
-    qreal SquareWidth = 2 * ir / qSqrt(2);
-    m_squareImage = square.scaled(SquareWidth, SquareWidth);
-    m_squareRegion = QRegion(m, m, SquareWidth, SquareWidth);
+    m_squareImage = square;
 }
 
 void ColorWheel::drawHueIndicator(const int &hue)
@@ -332,7 +370,7 @@ void ColorWheel::hueChanged(const int &hue)
 
     drawSquareImage(hue);
 
-    repaint();
+    update();
     emit colorChanged(m_currentColor);
 }
 
@@ -347,6 +385,6 @@ void ColorWheel::svChanged(const QColor &newcolor)
         return;
     }
 
-    repaint();
+    update();
     emit colorChanged(m_currentColor);
 }
\ No newline at end of file
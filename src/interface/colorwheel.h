@@ -2,6 +2,7 @@
 #define COLORWHEEL_H
 
 #include <QWidget>
+#include <QGradient>
 
 
 class ColorWheel : public QWidget
@@ -38,11 +39,14 @@ private:
 
     void drawWheelImage(const QSize &newSize);
     void drawSquareImage(const int &hue);
+    static const QGradientStops& hueStops();
     void composeWheel(QPixmap& pixmap);
 
     QSize m_initSize;
-    QImage m_wheelImage;
-    QImage m_squareImage;
+    QImage m_wheelImage;    // just the wheel, rebuilt when its size or the background change
+    QImage m_squareImage;   // at display size, rebuilt when the hue or the size change
+    QColor m_wheelBackground;
+    int m_squareHue;
     QPixmap m_wheelPixmap;
    
     int m_wheelWidth;
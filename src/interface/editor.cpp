@@ -46,6 +46,10 @@ GNU General Public License for more details.
 #include "colorpalettewidget.h"
 #include "toolmanager.h"
 #include "layermanager.h"
+#include "pencilsettings.h"
+#include "audioplayer.h"
+#include "soundwaveform.h"
+#include "thumbnailcache.h"
 #include "editor.h"
 
 #define MIN(a,b) ((a)>(b)?(b):(a))
@@ -67,45 +71,51 @@ Editor::Editor( MainWindow2* parent )
 {
     mainWindow = parent;
 
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
 
     altpress = false;
     numberOfModifications = 0;
-    autosave = settings.value( "autosave" ).toBool();
-    autosaveNumber = settings.value( "autosaveNumber" ).toInt();
+    autosave = settings->boolValue( "autosave" );
+    autosaveNumber = settings->intValue( "autosaveNumber" );
     if ( autosaveNumber == 0 )
     {
         autosaveNumber = 20;
-        settings.setValue( "autosaveNumber", 20 );
+        settings->setValue( "autosaveNumber", 20 );
     }
     backupIndex = -1;
     clipboardBitmapOk = false;
     clipboardVectorOk = false;
 
-    if ( settings.value( "onionLayer1Opacity" ).isNull() ) settings.setValue( "onionLayer1Opacity", 50 );
-    if ( settings.value( "onionLayer2Opacity" ).isNull() ) settings.setValue( "onionLayer2Opacity", 0 );
-    if ( settings.value( "onionLayer3Opacity" ).isNull() ) settings.setValue( "onionLayer3Opacity", 0 );
-    onionLayer1Opacity = settings.value( "onionLayer1Opacity" ).toInt();
-    onionLayer2Opacity = settings.value( "onionLayer2Opacity" ).toInt();
-    onionLayer3Opacity = settings.value( "onionLayer3Opacity" ).toInt();
+    if ( settings->value( "onionLayer1Opacity" ).isNull() ) settings->setValue( "onionLayer1Opacity", 50 );
+    if ( settings->value( "onionLayer2Opacity" ).isNull() ) settings->setValue( "onionLayer2Opacity", 0 );
+    if ( settings->value( "onionLayer3Opacity" ).isNull() ) settings->setValue( "onionLayer3Opacity", 0 );
+    onionLayer1Opacity = settings->intValue( "onionLayer1Opacity" );
+    onionLayer2Opacity = settings->intValue( "onionLayer2Opacity" );
+    onionLayer3Opacity = settings->intValue( "onionLayer3Opacity" );
 
-    fps = settings.value( "fps" ).toInt();
+    fps = settings->intValue( "fps" );
     if ( fps == 0 )
     {
         fps = 12;
-        settings.setValue( "fps", 12 );
+        settings->setValue( "fps", 12 );
     }
 
     maxFrame = 1;
     timer = new QTimer( this );
     timer->setInterval( 1000 / fps );
     connect( timer, SIGNAL( timeout() ), this, SLOT( playNextFrame() ) );
+    // the values read above follow the preferences
+    connect( settings, SIGNAL( valueChanged( QString, QVariant ) ), this, SLOT( settingChanged( QString ) ) );
     playing = false;
     looping = false;
     loopControl = false;
     loopStart = 1;
     loopEnd = 2;
     sound = true;
+    m_pAudioPlayer = new AudioPlayer( this );
+    m_soundMixerValid = false;
+    m_soundMixerEmpty = true;
+    connect( SoundWaveformCache::instance(), SIGNAL( waveformReady() ), this, SLOT( soundDecoded() ) );
 
     // Layouts
     QHBoxLayout* mainLayout = new QHBoxLayout();
@@ -230,8 +240,8 @@ void Editor::importImageSequence()
     QFileDialog w;
     w.setFileMode( QFileDialog::AnyFile );
 
-    QSettings settings( "Pencil", "Pencil" );
-    QString initialPath = settings.value( "lastImportPath", QVariant( QDir::homePath() ) ).toString();
+    PencilSettings* settings = pencilSettings();
+    QString initialPath = settings->value( "lastImportPath", QVariant( QDir::homePath() ) ).toString();
     if ( initialPath.isEmpty() ) initialPath = QDir::homePath();
     QStringList files = w.getOpenFileNames( this,
                                             "Select one or more files to open",
@@ -258,9 +268,9 @@ void Editor::importImageSequence()
 
 bool Editor::importMov()
 {
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
 
-    QString initialPath = settings.value( "lastExportPath", QDir::homePath() ).toString();
+    QString initialPath = settings->value( "lastExportPath", QDir::homePath() ).toString();
 
     if ( initialPath.isEmpty() )
     {
@@ -278,7 +288,7 @@ bool Editor::importMov()
     }
     else
     {
-        settings.setValue( "lastExportPath", QVariant( filePath ) );
+        settings->setValue( "lastExportPath", QVariant( filePath ) );
         importMovie( filePath, fps );
         return true;
     }
@@ -316,45 +326,66 @@ void Editor::setFrontColour( int i, QColor newColour )
 
 void Editor::changeAutosave( int x )
 {
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
     if ( x == 0 )
     {
         autosave = false;
-        settings.setValue( "autosave", "false" );
+        settings->setValue( "autosave", "false" );
     }
     else
     {
         autosave = true;
-        settings.setValue( "autosave", "true" );
+        settings->setValue( "autosave", "true" );
     }
 }
 
 void Editor::changeAutosaveNumber( int number )
 {
     autosaveNumber = number;
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "autosaveNumber", number );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "autosaveNumber", number );
+}
+
+void Editor::changeVectorFormat( int x )
+{
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( SETTING_VECTOR_BINARY_FORMAT, x != 0 );
 }
 
 void Editor::onionLayer1OpacityChangeSlot( int number )
 {
     onionLayer1Opacity = number;
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "onionLayer1Opacity", number );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "onionLayer1Opacity", number );
 }
 
 void Editor::onionLayer2OpacityChangeSlot( int number )
 {
     onionLayer2Opacity = number;
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "onionLayer2Opacity", number );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "onionLayer2Opacity", number );
 }
 
 void Editor::onionLayer3OpacityChangeSlot( int number )
 {
     onionLayer3Opacity = number;
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "onionLayer3Opacity", number );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "onionLayer3Opacity", number );
+}
+
+void Editor::settingChanged( const QString& key )
+{
+    PencilSettings* settings = pencilSettings();
+    if ( key == "onionLayer1Opacity" ) onionLayer1Opacity = settings->intValue( key );
+    if ( key == "onionLayer2Opacity" ) onionLayer2Opacity = settings->intValue( key );
+    if ( key == "onionLayer3Opacity" ) onionLayer3Opacity = settings->intValue( key );
+    if ( key == "autosave" ) autosave = settings->boolValue( key );
+    if ( key == "autosaveNumber" ) autosaveNumber = settings->intValue( key );
+    if ( key == "fps" )
+    {
+        int newFps = settings->intValue( key );
+        if ( newFps > 0 && newFps != fps ) changeFps( newFps );
+    }
 }
 
 void Editor::currentKeyFrameModification()
@@ -400,11 +431,6 @@ void Editor::backup( int backupLayer, int backupFrame, QString undoText )
     {
         delete backupList.takeLast();
     }
-    while ( backupList.size() > 19 )   // we authorize only 20 levels of cancellation
-    {
-        delete backupList.takeFirst();
-        backupIndex--;
-    }
     Layer* layer = m_pObject->getLayer( backupLayer );
     if ( layer != NULL )
     {
@@ -421,10 +447,14 @@ void Editor::backup( int backupLayer, int backupFrame, QString undoText )
             BitmapImage* bitmapImage = ( ( LayerBitmap* )layer )->getLastBitmapImageAtFrame( backupFrame, 0 );
             if ( bitmapImage != NULL )
             {
-                element->bitmapImage = bitmapImage->copy();  // copy the image
+                element->capture( bitmapImage, lastBitmapBackup( backupLayer, backupFrame, backupList.size() ) );  // only the changed tiles take memory
                 backupList.append( element );
                 backupIndex++;
             }
+            else
+            {
+                delete element;
+            }
         }
         if ( layer->type() == Layer::VECTOR )
         {
@@ -443,8 +473,73 @@ void Editor::backup( int backupLayer, int backupFrame, QString undoText )
                 backupList.append( element );
                 backupIndex++;
             }
+            else
+            {
+                delete element;
+            }
+        }
+    }
+
+    // the history is limited by the memory it uses rather than by a number of steps
+    qint64 budget = qint64( pencilSettings()->value( SETTING_UNDO_MEMORY, 256 ).toInt() ) * 1024 * 1024;
+    qint64 used = 0;
+    foreach ( BackupElement* element, backupList )
+    {
+        used += element->cost();
+    }
+    while ( used > budget && backupList.size() > 2 )
+    {
+        BackupElement* oldest = backupList.takeFirst();
+        backupIndex--;
+        used -= oldest->cost();
+        if ( oldest->type() == BackupElement::BITMAP_MODIF )
+        {
+            // the next backup of this frame no longer shares its tiles with the removed one
+            BackupBitmapElement* bitmapElement = ( BackupBitmapElement* )oldest;
+            BackupBitmapElement* next = nextBitmapBackup( bitmapElement->layer, bitmapElement->frame );
+            if ( next != NULL )
+            {
+                used -= next->cost();
+                next->updateCost( NULL );
+                used += next->cost();
+            }
+        }
+        delete oldest;
+    }
+}
+
+BackupBitmapElement* Editor::lastBitmapBackup( int layerNumber, int frameNumber, int beforeIndex )
+{
+    for ( int i = beforeIndex - 1; i >= 0; i-- )
+    {
+        BackupElement* element = backupList.at( i );
+        if ( element->type() == BackupElement::BITMAP_MODIF )
+        {
+            BackupBitmapElement* bitmapElement = ( BackupBitmapElement* )element;
+            if ( bitmapElement->layer == layerNumber && bitmapElement->frame == frameNumber )
+            {
+                return bitmapElement;
+            }
+        }
+    }
+    return NULL;
+}
+
+BackupBitmapElement* Editor::nextBitmapBackup( int layerNumber, int frameNumber )
+{
+    for ( int i = 0; i < backupList.size(); i++ )
+    {
+        BackupElement* element = backupList.at( i );
+        if ( element->type() == BackupElement::BITMAP_MODIF )
+        {
+            BackupBitmapElement* bitmapElement = ( BackupBitmapElement* )element;
+            if ( bitmapElement->layer == layerNumber && bitmapElement->frame == frameNumber )
+            {
+                return bitmapElement;
+            }
         }
     }
+    return NULL;
 }
 
 void BackupBitmapElement::restore( Editor* editor )
@@ -454,7 +549,10 @@ void BackupBitmapElement::restore( Editor* editor )
     {
         if ( layer->type() == Layer::BITMAP )
         {
-            *( ( ( LayerBitmap* )layer )->getLastBitmapImageAtFrame( this->frame, 0 ) ) = this->bitmapImage;  // restore the image
+            BitmapImage* bitmapImage = ( ( LayerBitmap* )layer )->getLastBitmapImageAtFrame( this->frame, 0 );
+            *bitmapImage->image = this->image();  // restore the image
+            bitmapImage->boundaries = this->boundaries;
+            ThumbnailCache::instance()->invalidate( bitmapImage );
         }
     }
     editor->getScribbleArea()->somethingSelected = this->somethingSelected;
@@ -473,7 +571,9 @@ void BackupVectorElement::restore( Editor* editor )
     {
         if ( layer->type() == Layer::VECTOR )
         {
-            *( ( ( LayerVector* )layer )->getLastVectorImageAtFrame( this->frame, 0 ) ) = this->vectorImage;  // restore the image
+            VectorImage* vectorImage = ( ( LayerVector* )layer )->getLastVectorImageAtFrame( this->frame, 0 );
+            *vectorImage = this->vectorImage;  // restore the image
+            ThumbnailCache::instance()->invalidate( vectorImage );
             //((LayerVector*)layer)->getLastVectorImageAtFrame(this->frame, 0)->setModified(true); // why?
             //editor->scribbleArea->setModified(layer, this->frame);
         }
@@ -771,8 +871,8 @@ void Editor::saveLength( QString x )
 {
     bool ok;
     int dec = x.toInt( &ok, 10 );
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "length", dec );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "length", dec );
 }
 
 void Editor::resetUI()
@@ -793,7 +893,16 @@ void Editor::setObject( Object* newObject )
     {
         return;
     }
+    if ( m_pObject != NULL )
+    {
+        disconnect( m_pObject, SIGNAL( soundChanged() ), this, SLOT( invalidateSoundMixer() ) );
+        disconnect( m_pObject, SIGNAL( layerChanged( Layer* ) ), this, SIGNAL( layerChanged( Layer* ) ) );
+    }
     m_pObject = newObject;
+    connect( m_pObject, SIGNAL( soundChanged() ), this, SLOT( invalidateSoundMixer() ) );
+    connect( m_pObject, SIGNAL( layerChanged( Layer* ) ), this, SIGNAL( layerChanged( Layer* ) ) );
+    invalidateSoundMixer();
+    emit layerChanged( NULL );
 
     // the default selected layer is the last one
     layerManager()->setCurrentLayerIndex( m_pObject->getLayerCount() - 1 );
@@ -936,13 +1045,13 @@ void Editor::createExportFlashDialog()
     exportFlashDialog = new QDialog( this, Qt::Dialog );
     QGridLayout* mainLayout = new QGridLayout;
 
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
 
     exportFlashDialog_compression = new QSlider( Qt::Horizontal );
     exportFlashDialog_compression->setTickPosition( QSlider::TicksBelow );
     exportFlashDialog_compression->setMinimum( 0 );
     exportFlashDialog_compression->setMaximum( 10 );
-    exportFlashDialog_compression->setValue( 10 - settings.value( "flashCompressionLevel" ).toInt() );
+    exportFlashDialog_compression->setValue( 10 - settings->value( "flashCompressionLevel" ).toInt() );
     QLabel* label1 = new QLabel( "Large file" );
     QLabel* label2 = new QLabel( "Small file" );
 
@@ -1006,14 +1115,14 @@ bool Editor::exportSeqCLI( QString filePath = "", QString format = "PNG" )
     view = m_pScribbleArea->getView() * view;
 
     updateMaxFrame();
-    m_pObject->exportFrames( 1, maxFrame, view, getCurrentLayer(), exportSize, filePath, exportFormat, -1, false, true, NULL, 0 );
+    m_pObject->exportFrames( 1, maxFrame, view, getCurrentLayer(), exportSize, filePath, exportFormat, -1, false, true, pencilSettings()->curveOpacity(), NULL, 0 );
     return true;
 }
 
 bool Editor::exportSeq()
 {
-    QSettings settings( "Pencil", "Pencil" );
-    QString initialPath = settings.value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
+    PencilSettings* settings = pencilSettings();
+    QString initialPath = settings->value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
     if ( initialPath.isEmpty() )
     {
         QString initialPath = QDir::homePath() + "/untitled";
@@ -1025,7 +1134,7 @@ bool Editor::exportSeq()
     }
     else
     {
-        settings.setValue( "lastExportPath", QVariant( filePath ) );
+        settings->setValue( "lastExportPath", QVariant( filePath ) );
 
         if ( !exportFramesDialog ) createExportFramesDialog();
         exportFramesDialog_hBox->setValue( m_pScribbleArea->getViewRect().toRect().width() );
@@ -1040,15 +1149,15 @@ bool Editor::exportSeq()
 
         QByteArray exportFormat( exportFramesDialog_format->currentText().toLatin1() );
         updateMaxFrame();
-        m_pObject->exportFrames( 1, maxFrame, view, getCurrentLayer(), exportSize, filePath, exportFormat, -1, false, true, NULL, 0 );
+        m_pObject->exportFrames( 1, maxFrame, view, getCurrentLayer(), exportSize, filePath, exportFormat, -1, false, true, settings->curveOpacity(), NULL, 0 );
         return true;
     }
 }
 
 bool Editor::exportX()
 {
-    QSettings settings( "Pencil", "Pencil" );
-    QString initialPath = settings.value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
+    PencilSettings* settings = pencilSettings();
+    QString initialPath = settings->value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
     if ( initialPath.isEmpty() ) initialPath = QDir::homePath() + "/untitled";
     QString filePath = QFileDialog::getSaveFileName( this, tr( "Save As" ), initialPath );
     if ( filePath.isEmpty() )
@@ -1058,14 +1167,14 @@ bool Editor::exportX()
     }
     else
     {
-        settings.setValue( "lastExportPath", QVariant( filePath ) );
+        settings->setValue( "lastExportPath", QVariant( filePath ) );
 
         QSize exportSize = m_pScribbleArea->getViewRect().toRect().size();
         QMatrix view = map( m_pScribbleArea->getViewRect(), QRectF( QPointF( 0, 0 ), exportSize ) );
         view = m_pScribbleArea->getView() * view;
 
         updateMaxFrame();
-        if ( !m_pObject->exportX( 1, maxFrame, view, exportSize, filePath, true ) ) {
+        if ( !m_pObject->exportX( 1, maxFrame, view, exportSize, filePath, true, settings->curveOpacity() ) ) {
             QMessageBox::warning( this, tr( "Warning" ),
                                   tr( "Unable to export image." ),
                                   QMessageBox::Ok,
@@ -1078,8 +1187,8 @@ bool Editor::exportX()
 
 bool Editor::exportImage()
 {
-    QSettings settings( "Pencil", "Pencil" );
-    QString initialPath = settings.value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
+    PencilSettings* settings = pencilSettings();
+    QString initialPath = settings->value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
     if ( initialPath.isEmpty() )
     {
         initialPath = QDir::homePath() + "/untitled.png";
@@ -1100,14 +1209,14 @@ bool Editor::exportImage()
     }
     else
     {
-        settings.setValue( "lastExportPath", QVariant( filePath ) );
+        settings->setValue( "lastExportPath", QVariant( filePath ) );
 
         QSize exportSize = m_pScribbleArea->getViewRect().toRect().size();
         QMatrix view = map( m_pScribbleArea->getViewRect(), QRectF( QPointF( 0, 0 ), exportSize ) );
         view = m_pScribbleArea->getView() * view;
 
         updateMaxFrame();
-        if ( !m_pObject->exportIm( layerManager()->currentFrameIndex(), maxFrame, view, exportSize, filePath, true ) ) {
+        if ( !m_pObject->exportIm( layerManager()->currentFrameIndex(), maxFrame, view, exportSize, filePath, true, settings->curveOpacity() ) ) {
             QMessageBox::warning( this, tr( "Warning" ),
                                   tr( "Unable to export image." ),
                                   QMessageBox::Ok,
@@ -1121,8 +1230,8 @@ bool Editor::exportImage()
 
 bool Editor::exportMov()
 {
-    QSettings settings( "Pencil", "Pencil" );
-    QString initialPath = settings.value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
+    PencilSettings* settings = pencilSettings();
+    QString initialPath = settings->value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
     if ( initialPath.isEmpty() ) initialPath = QDir::homePath() + "/untitled.avi";
     //  QString filePath = QFileDialog::getSaveFileName(this, tr("Export As"),initialPath);
     QString filePath = QFileDialog::getSaveFileName( this, tr( "Export Movie As..." ), initialPath, tr( "AVI (*.avi);;MOV(*.mov);;WMV(*.wmv)" ) );
@@ -1132,7 +1241,7 @@ bool Editor::exportMov()
     }
     else
     {
-        settings.setValue( "lastExportPath", QVariant( filePath ) );
+        settings->setValue( "lastExportPath", QVariant( filePath ) );
         if ( !exportMovieDialog ) createExportMovieDialog();
         exportMovieDialog_hBox->setValue( m_pScribbleArea->getViewRect().toRect().width() );
         exportMovieDialog_vBox->setValue( m_pScribbleArea->getViewRect().toRect().height() );
@@ -1144,15 +1253,15 @@ bool Editor::exportMov()
         view = m_pScribbleArea->getView() * view;
 
         updateMaxFrame();
-        m_pObject->exportMovie( 1, maxFrame, view, getCurrentLayer(), exportSize, filePath, fps, exportMovieDialog_fpsBox->value(), exportMovieDialog_format->currentText() );
+        m_pObject->exportMovie( 1, maxFrame, view, getCurrentLayer(), exportSize, filePath, fps, exportMovieDialog_fpsBox->value(), exportMovieDialog_format->currentText(), settings->curveOpacity() );
         return true;
     }
 }
 
 bool Editor::exportFlash()
 {
-    QSettings settings( "Pencil", "Pencil" );
-    QString initialPath = settings.value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
+    PencilSettings* settings = pencilSettings();
+    QString initialPath = settings->value( "lastExportPath", QVariant( QDir::homePath() ) ).toString();
     if ( initialPath.isEmpty() ) initialPath = QDir::homePath() + "/untitled.swf";
     //  QString filePath = QFileDialog::getSaveFileName(this, tr("Export SWF As"),initialPath);
     QString filePath = QFileDialog::getSaveFileName( this, tr( "Export Movie As..." ), initialPath, tr( "SWF (*.swf)" ) );
@@ -1162,12 +1271,12 @@ bool Editor::exportFlash()
     }
     else
     {
-        settings.setValue( "lastExportPath", QVariant( filePath ) );
+        settings->setValue( "lastExportPath", QVariant( filePath ) );
         if ( !exportFlashDialog ) createExportFlashDialog();
         exportFlashDialog->exec();
         if ( exportFlashDialog->result() == QDialog::Rejected ) return false;
 
-        settings.setValue( "flashCompressionLevel", 10 - exportFlashDialog_compression->value() );
+        settings->setValue( "flashCompressionLevel", 10 - exportFlashDialog_compression->value() );
 
         QSize exportSize = m_pScribbleArea->getViewRect().toRect().size();
         QMatrix view = map( m_pScribbleArea->getViewRect(), QRectF( QPointF( 0, 0 ), exportSize ) );
@@ -1184,6 +1293,37 @@ void Editor::importImageFromDialog()
     importImage( "fromDialog" );
 }
 
+// pastes the image in the key frame at the current frame, which is created if needed
+void Editor::importBitmapFrame( LayerBitmap* layer, const QImage& importedImage )
+{
+    BitmapImage* bitmapImage = layer->getBitmapImageAtFrame( layerManager()->currentFrameIndex() );
+    if ( bitmapImage == NULL )
+    {
+        addNewKey();
+        bitmapImage = layer->getBitmapImageAtFrame( layerManager()->currentFrameIndex() );
+    }
+
+    QRect boundaries = importedImage.rect();
+    //boundaries.moveTopLeft( scribbleArea->getView().inverted().map(QPoint(0,0)) );
+    boundaries.moveTopLeft( m_pScribbleArea->getCentralPoint().toPoint() - QPoint( boundaries.width() / 2, boundaries.height() / 2 ) );
+    BitmapImage* importedBitmapImage = new BitmapImage( NULL, boundaries, importedImage );
+    if ( m_pScribbleArea->somethingSelected )
+    {
+        QRectF selection = m_pScribbleArea->getSelection();
+        if ( importedImage.width() <= selection.width() && importedImage.height() <= selection.height() )
+        {
+            importedBitmapImage->boundaries.moveTopLeft( selection.topLeft().toPoint() );
+        }
+        else
+        {
+            importedBitmapImage->transform( selection.toRect(), true );
+        }
+    }
+
+    bitmapImage->paste( importedBitmapImage );
+    delete importedBitmapImage;
+}
+
 void Editor::importImage( QString filePath )
 {
     Layer* layer = m_pObject->getLayer( layerManager()->currentLayerIndex() );
@@ -1204,11 +1344,11 @@ void Editor::importImage( QString filePath )
 
     if ( filePath == "fromDialog" )
     {
-        QSettings settings( "Pencil", "Pencil" );
-        QString initialPath = settings.value( "lastImportPath", QVariant( QDir::homePath() ) ).toString();
+        PencilSettings* settings = pencilSettings();
+        QString initialPath = settings->value( "lastImportPath", QVariant( QDir::homePath() ) ).toString();
         if ( initialPath.isEmpty() ) initialPath = QDir::homePath();
         filePath = QFileDialog::getOpenFileName( this, tr( "Import image..." ), initialPath, tr( "PNG (*.png);;JPG(*.jpg *.jpeg);;TIFF(*.tiff);;TIF(*.tif);;BMP(*.bmp);;GIF(*.gif)" ) );
-        if ( !filePath.isEmpty() ) settings.setValue( "lastImportPath", QVariant( filePath ) );
+        if ( !filePath.isEmpty() ) settings->setValue( "lastImportPath", QVariant( filePath ) );
     }
 
     if ( !filePath.isEmpty() )
@@ -1232,31 +1372,7 @@ void Editor::importImage( QString filePath )
             {
                 do
                 {
-                    BitmapImage* bitmapImage = ( ( LayerBitmap* )layer )->getBitmapImageAtFrame( layerManager()->currentFrameIndex() );
-                    if ( bitmapImage == NULL )
-                    {
-                        addNewKey();
-                        bitmapImage = ( ( LayerBitmap* )layer )->getBitmapImageAtFrame( layerManager()->currentFrameIndex() );
-                    }
-
-                    QRect boundaries = importedImage->rect();
-                    //boundaries.moveTopLeft( scribbleArea->getView().inverted().map(QPoint(0,0)) );
-                    boundaries.moveTopLeft( m_pScribbleArea->getCentralPoint().toPoint() - QPoint( boundaries.width() / 2, boundaries.height() / 2 ) );
-                    BitmapImage* importedBitmapImage = new BitmapImage( NULL, boundaries, *importedImage );
-                    if ( m_pScribbleArea->somethingSelected )
-                    {
-                        QRectF selection = m_pScribbleArea->getSelection();
-                        if ( importedImage->width() <= selection.width() && importedImage->height() <= selection.height() )
-                        {
-                            importedBitmapImage->boundaries.moveTopLeft( selection.topLeft().toPoint() );
-                        }
-                        else
-                        {
-                            importedBitmapImage->transform( selection.toRect(), true );
-                        }
-                    }
-
-                    bitmapImage->paste( importedBitmapImage );
+                    importBitmapFrame( ( LayerBitmap* )layer, *importedImage );
                     timeLeft -= ( timeLeft / ( 1000 / fps ) + 1 )*( 1000 / fps );
 
                     while ( timeLeft<0 && numImages > 0 )
@@ -1347,13 +1463,13 @@ void Editor::importSound( QString filePath )
 
     if ( filePath.isEmpty() || filePath == "fromDialog" )
     {
-        QSettings settings( "Pencil", "Pencil" );
-        QString initialPath = settings.value( "lastImportPath", QVariant( QDir::homePath() ) ).toString();
+        PencilSettings* settings = pencilSettings();
+        QString initialPath = settings->value( "lastImportPath", QVariant( QDir::homePath() ) ).toString();
         if ( initialPath.isEmpty() ) initialPath = QDir::homePath();
         filePath = QFileDialog::getOpenFileName( this, tr( "Import sound..." ), initialPath, tr( "WAV(*.wav);;MP3(*.mp3)" ) );
         if ( !filePath.isEmpty() )
         {
-            settings.setValue( "lastImportPath", QVariant( filePath ) );
+            settings->setValue( "lastImportPath", QVariant( filePath ) );
         }
         else
         {
@@ -1392,6 +1508,90 @@ void Editor::scrubTo( int frameNumber )
     m_pScribbleArea->update();
 }
 
+void Editor::scrubWithSound( int frameNumber )
+{
+    scrubTo( frameNumber );
+    if ( sound && !playing && updateSoundMixer() )
+    {
+        m_pAudioPlayer->playSlice( soundPosition( layerManager()->currentFrameIndex() ), AudioMixer::SAMPLE_RATE / fps );
+    }
+}
+
+// the mix is made again only after a change of the clips, not on every frame.
+// The clips are decoded in the background beforehand: until they all are, there is no mix
+bool Editor::updateSoundMixer()
+{
+    if ( !m_soundMixerValid )
+    {
+        if ( !decodeSounds() )
+        {
+            return false;
+        }
+        AudioMixer mixer;
+        m_pObject->mixSounds( mixer, fps, 1 );
+        m_pAudioPlayer->setMixer( mixer );
+        m_soundMixerEmpty = mixer.isEmpty();
+        m_soundMixerValid = true;
+    }
+    return !m_soundMixerEmpty;
+}
+
+void Editor::invalidateSoundMixer()
+{
+    m_soundMixerValid = false;
+    decodeSounds(); // ahead of the next play
+}
+
+// true when every clip heard can be mixed without waiting for its decoder
+bool Editor::decodeSounds()
+{
+    if ( m_pObject == NULL )
+    {
+        return false;
+    }
+    bool decoded = true;
+    for ( int i = 0; i < m_pObject->getLayerCount(); i++ )
+    {
+        Layer* layer = m_pObject->getLayer( i );
+        if ( layer->type() != Layer::SOUND || !layer->visible )
+        {
+            continue;
+        }
+        LayerSound* soundLayer = ( LayerSound* )layer;
+        for ( int k = 0; k < soundLayer->getSoundSize(); k++ )
+        {
+            if ( soundLayer->soundIsNotNull( k ) && !SoundWaveformCache::instance()->decode( soundLayer->getSoundFilepathAt( k ) ) )
+            {
+                decoded = false;
+            }
+        }
+    }
+    return decoded;
+}
+
+// a clip has been decoded: the sound joins in if it was waiting for it
+void Editor::soundDecoded()
+{
+    if ( m_soundMixerValid || m_pObject == NULL )
+    {
+        return;
+    }
+    if ( playing && sound && !m_pAudioPlayer->isPlaying() && updateSoundMixer() )
+    {
+        m_pAudioPlayer->play( soundPosition( layerManager()->currentFrameIndex() ) );
+    }
+}
+
+qint64 Editor::soundPosition( int frameNumber )
+{
+    return qint64( frameNumber - 1 ) * AudioMixer::SAMPLE_RATE / fps;
+}
+
+int Editor::soundFrame( qint64 position )
+{
+    return int( position * fps / AudioMixer::SAMPLE_RATE ) + 1;
+}
+
 void Editor::scrubForward()
 {
     scrubTo( layerManager()->currentFrameIndex() + 1 );
@@ -1569,12 +1769,16 @@ void Editor::startOrStop()
     {
         playing = true;
         timer->start();
+        if ( sound && updateSoundMixer() )
+        {
+            m_pAudioPlayer->play( soundPosition( layerManager()->currentFrameIndex() ) );
+        }
     }
     else
     {
         playing = false;
         timer->stop();
-        m_pObject->stopSoundIfAny();
+        m_pAudioPlayer->stop();
     }
 }
 
@@ -1643,8 +1847,23 @@ void Editor::playNextFrame()
     }
     if ( layerManager()->currentFrameIndex() < maxFrame )
     {
-        if ( sound ) m_pObject->playSoundIfAny( layerManager()->currentFrameIndex(), fps );
-        scrubForward();
+        // without an audio output that plays, the timer is the clock
+        if ( sound && m_pAudioPlayer->isClockRunning() )
+        {
+            // the sound is the clock: the frame being heard is shown, so the picture
+            // waits when it is ahead and skips frames when it is behind. The sound
+            // only seeks after a jump of the frame, a loop or a click in the timeline.
+            m_pAudioPlayer->sync( soundPosition( layerManager()->currentFrameIndex() ), AudioMixer::SAMPLE_RATE / 2 );
+            int heardFrame = qMin( soundFrame( m_pAudioPlayer->position() ), maxFrame );
+            if ( heardFrame > layerManager()->currentFrameIndex() )
+            {
+                scrubTo( heardFrame );
+            }
+        }
+        else
+        {
+            scrubForward();
+        }
     }
     else
     {
@@ -1664,7 +1883,6 @@ void Editor::playPrevFrame()
 {
     if ( layerManager()->currentFrameIndex() > 0 )
     {
-        if ( sound ) m_pObject->playSoundIfAny( layerManager()->currentFrameIndex(), fps );
         scrubBackward();
     }
 }
@@ -1673,6 +1891,7 @@ void Editor::changeFps( int x )
 {
     fps = x;
     timer->setInterval( 1000 / fps );
+    invalidateSoundMixer();
     getTimeLine()->updateContent();
 }
 
@@ -1705,6 +1924,15 @@ void Editor::setSound()
 {
     if ( sound ) sound = false;
     else sound = true;
+
+    if ( !sound )
+    {
+        m_pAudioPlayer->stop();
+    }
+    else if ( playing && updateSoundMixer() )
+    {
+        m_pAudioPlayer->play( soundPosition( layerManager()->currentFrameIndex() ) );
+    }
 }
 
 void Editor::setCurrentLayer( int layerNumber )
@@ -1718,6 +1946,7 @@ void Editor::switchVisibilityOfLayer( int layerNumber )
 {
     Layer* layer = m_pObject->getLayer( layerNumber );
     if ( layer != NULL ) layer->switchVisibility();
+    if ( layer != NULL && layer->type() == Layer::SOUND ) invalidateSoundMixer(); // hidden layers are not heard
     m_pScribbleArea->updateAllFrames();
     getTimeLine()->updateContent();
 }
@@ -1753,14 +1982,14 @@ void Editor::updateMaxFrame()
 
 void Editor::restorePalettesSettings( bool restoreFloating, bool restorePosition, bool restoreSize )
 {
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
 
     ColorPaletteWidget* colourPalette = mainWindow->m_pColorPalette;
     if ( colourPalette != NULL )
     {
-        QPoint pos = settings.value( "colourPalettePosition", QPoint( 100, 100 ) ).toPoint();
-        QSize size = settings.value( "colourPaletteSize", QSize( 400, 300 ) ).toSize();
-        bool floating = settings.value( "colourPaletteFloating", false ).toBool();
+        QPoint pos = settings->value( "colourPalettePosition", QPoint( 100, 100 ) ).toPoint();
+        QSize size = settings->value( "colourPaletteSize", QSize( 400, 300 ) ).toSize();
+        bool floating = settings->value( "colourPaletteFloating", false ).toBool();
         if ( restoreFloating ) colourPalette->setFloating( floating );
         if ( restorePosition ) colourPalette->move( pos );
         if ( restoreSize ) colourPalette->resize( size );
@@ -1770,9 +1999,9 @@ void Editor::restorePalettesSettings( bool restoreFloating, bool restorePosition
     TimeLine* timelinePalette = getTimeLine();
     if ( timelinePalette != NULL )
     {
-        QPoint pos = settings.value( "timelinePalettePosition", QPoint( 100, 100 ) ).toPoint();
-        QSize size = settings.value( "timelinePaletteSize", QSize( 400, 300 ) ).toSize();
-        bool floating = settings.value( "timelinePaletteFloating", false ).toBool();
+        QPoint pos = settings->value( "timelinePalettePosition", QPoint( 100, 100 ) ).toPoint();
+        QSize size = settings->value( "timelinePaletteSize", QSize( 400, 300 ) ).toSize();
+        bool floating = settings->value( "timelinePaletteFloating", false ).toBool();
         if ( restoreFloating ) timelinePalette->setFloating( floating );
         if ( restorePosition ) timelinePalette->move( pos );
         if ( restoreSize ) timelinePalette->resize( size );
@@ -1782,9 +2011,9 @@ void Editor::restorePalettesSettings( bool restoreFloating, bool restorePosition
     QDockWidget* toolWidget = mainWindow->m_pToolBox;
     if ( toolWidget != NULL )
     {
-        QPoint pos = settings.value( "drawPalettePosition", QPoint( 100, 100 ) ).toPoint();
-        QSize size = settings.value( "drawPaletteSize", QSize( 400, 300 ) ).toSize();
-        bool floating = settings.value( "drawPaletteFloating", false ).toBool();
+        QPoint pos = settings->value( "drawPalettePosition", QPoint( 100, 100 ) ).toPoint();
+        QSize size = settings->value( "drawPaletteSize", QSize( 400, 300 ) ).toSize();
+        bool floating = settings->value( "drawPaletteFloating", false ).toBool();
         if ( restoreFloating ) toolWidget->setFloating( floating );
         if ( restorePosition ) toolWidget->move( pos );
         if ( restoreSize ) toolWidget->resize( size );
@@ -1794,9 +2023,9 @@ void Editor::restorePalettesSettings( bool restoreFloating, bool restorePosition
     QDockWidget* optionPalette = mainWindow->m_pToolOptionWidget;
     if ( optionPalette != NULL )
     {
-        QPoint pos = settings.value( "optionPalettePosition", QPoint( 100, 100 ) ).toPoint();
-        QSize size = settings.value( "optionPaletteSize", QSize( 400, 300 ) ).toSize();
-        bool floating = settings.value( "optionPaletteFloating", false ).toBool();
+        QPoint pos = settings->value( "optionPalettePosition", QPoint( 100, 100 ) ).toPoint();
+        QSize size = settings->value( "optionPaletteSize", QSize( 400, 300 ) ).toSize();
+        bool floating = settings->value( "optionPaletteFloating", false ).toBool();
         if ( restoreFloating ) optionPalette->setFloating( floating );
         if ( restorePosition ) optionPalette->move( pos );
         if ( restoreSize ) optionPalette->resize( size );
@@ -1806,9 +2035,9 @@ void Editor::restorePalettesSettings( bool restoreFloating, bool restorePosition
     QDockWidget* displayPalette = mainWindow->m_pDisplayOptionWidget;
     if ( displayPalette != NULL )
     {
-        QPoint pos = settings.value( "displayPalettePosition", QPoint( 100, 100 ) ).toPoint();
-        QSize size = settings.value( "displayPaletteSize", QSize( 400, 300 ) ).toSize();
-        bool floating = settings.value( "displayPaletteFloating", false ).toBool();
+        QPoint pos = settings->value( "displayPalettePosition", QPoint( 100, 100 ) ).toPoint();
+        QSize size = settings->value( "displayPaletteSize", QSize( 400, 300 ) ).toSize();
+        bool floating = settings->value( "displayPaletteFloating", false ).toBool();
         if ( restoreFloating ) displayPalette->setFloating( floating );
         if ( restorePosition ) displayPalette->move( pos );
         if ( restoreSize ) displayPalette->resize( size );
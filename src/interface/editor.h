@@ -39,6 +39,8 @@ class ColorManager;
 class ToolManager;
 class LayerManager;
 class ScribbleArea;
+class AudioPlayer;
+class LayerBitmap;
 
 
 class Editor : public QWidget
@@ -118,6 +120,9 @@ signals:
     // save
     void needSave();
 
+    // the track of a layer has to be drawn again; NULL: all of them
+    void layerChanged( Layer* );
+
 public slots:
 
     void clearCurrentFrame();
@@ -144,6 +149,7 @@ public slots:
     void updateFrameAndVector( int frameNumber );
 
     void scrubTo( int frameNumber );
+    void scrubWithSound( int frameNumber ); // scrubbing by the user, who hears the frame
     void scrubNextKeyframe();
     void scrubPreviousKeyframe();
     void scrubForward();
@@ -186,6 +192,7 @@ public slots:
 
     void changeAutosave( int );
     void changeAutosaveNumber( int );
+    void changeVectorFormat( int );
 
     void onionLayer1OpacityChangeSlot( int );
     void onionLayer2OpacityChangeSlot( int );
@@ -227,6 +234,9 @@ public slots:
 private slots:
     void saveLength( QString );
     void getCameraLayer();
+    void invalidateSoundMixer();
+    void soundDecoded();
+    void settingChanged( const QString& key );
 
 private:
     Object* m_pObject;  // the object to be edited by the editor
@@ -237,6 +247,9 @@ private:
     ColorManager* m_colorManager;
     ToolManager* m_pToolManager;
     LayerManager* m_pLayerManager;
+    AudioPlayer* m_pAudioPlayer;
+    bool m_soundMixerValid; // false when a sound clip, layer or the fps changed since the mix was made
+    bool m_soundMixerEmpty;
 
     bool altpress;
     int numberOfModifications;
@@ -251,8 +264,18 @@ private:
     void makeConnections();
     void addKey( int layerNumber, int frameNumber );
 
+    void importBitmapFrame( LayerBitmap* layer, const QImage& importedImage );
+
+    // sound
+    bool updateSoundMixer();
+    bool decodeSounds();
+    qint64 soundPosition( int frameNumber );
+    int soundFrame( qint64 position );
+
     // backup
     void clearBackup();
+    BackupBitmapElement* lastBitmapBackup( int layerNumber, int frameNumber, int beforeIndex );
+    BackupBitmapElement* nextBitmapBackup( int layerNumber, int frameNumber );
     int lastModifiedFrame, lastModifiedLayer;
 
     // clipboard
@@ -53,6 +53,7 @@ GNU General Public License for more details.
 #include "fileformat.h"		//contains constants used by Pencil File Format
 #include "JlCompress.h"		//compress and decompress New Pencil File Format
 #include "recentfilemenu.h"
+#include "perfmonitor.h"
 
 #include "mainwindow2.h"
 #include "ui_mainwindow2.h"
@@ -278,6 +279,16 @@ void MainWindow2::createMenus()
     connect( editor, SIGNAL( onionNextChanged( bool ) ), ui->actionOnionNext, SLOT( setChecked( bool ) ) );
     connect( editor, SIGNAL(multiLayerOnionSkinChanged(bool)), ui->actionMultiLayerOnionSkin, SLOT(setChecked(bool)));
 
+#ifdef PENCIL_PROFILING
+    // timings of the hot paths, see PerfMonitor
+    ui->menuView->addSeparator();
+    QAction* perfOverlayAction = ui->menuView->addAction( tr( "Performance Overlay" ) );
+    perfOverlayAction->setCheckable( true );
+    connect( perfOverlayAction, &QAction::toggled, m_pScribbleArea, &ScribbleArea::togglePerfOverlay );
+    QAction* perfTraceAction = ui->menuView->addAction( tr( "Save Performance Trace..." ) );
+    connect( perfTraceAction, &QAction::triggered, this, &MainWindow2::savePerfTrace );
+#endif
+
     /// --- Animation Menu ---
     connect( ui->actionPlay, &QAction::triggered, editor, &Editor::play );
     connect( ui->actionLoop, &QAction::triggered, editor, &Editor::setLoop );
@@ -343,8 +354,8 @@ void MainWindow2::createMenus()
 
 void MainWindow2::setOpacity( int opacity )
 {
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "windowOpacity", 100 - opacity );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "windowOpacity", 100 - opacity );
     setWindowOpacity( opacity / 100.0 );
 }
 
@@ -390,9 +401,9 @@ void MainWindow2::openDocument()
 {
     if ( maybeSave() )
     {
-        QSettings settings( "Pencil", "Pencil" );
+        PencilSettings* settings = pencilSettings();
 
-        QString myPath = settings.value( "lastFilePath", QVariant( QDir::homePath() ) ).toString();
+        QString myPath = settings->value( "lastFilePath", QVariant( QDir::homePath() ) ).toString();
         QString fileName = QFileDialog::getOpenFileName(
             this,
             tr( "Open File..." ),
@@ -426,9 +437,9 @@ void MainWindow2::openDocument()
 
 bool MainWindow2::saveAsNewDocument()
 {
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
 
-    QString strDefaultFileName = settings.value( "lastFilePath", QVariant( QDir::homePath() ) ).toString();
+    QString strDefaultFileName = settings->value( "lastFilePath", QVariant( QDir::homePath() ) ).toString();
 
     if ( strDefaultFileName.isEmpty() )
     {
@@ -447,8 +458,8 @@ bool MainWindow2::saveAsNewDocument()
         {
             fileName = fileName + PFF_EXTENSION;
         }
-        QSettings settings( "Pencil", "Pencil" );
-        settings.setValue( "lastFilePath", QVariant( fileName ) );
+        PencilSettings* settings = pencilSettings();
+        settings->setValue( "lastFilePath", QVariant( fileName ) );
 
         return saveObject( fileName );
     }
@@ -475,6 +486,7 @@ void MainWindow2::openFile( QString filename )
 
 bool MainWindow2::openObject( QString strFilePath )
 {
+    PERF_SCOPE( "MainWindow2::openObject" );
     QProgressDialog progress( tr("Opening document..."), tr("Abort"), 0, 100, this );
     progress.setWindowModality( Qt::WindowModal );
     progress.show();
@@ -494,8 +506,8 @@ bool MainWindow2::openObject( QString strFilePath )
         m_object = pObject;
 
         pObject->setFilePath( strFilePath );
-        QSettings settings( "Pencil", "Pencil" );
-        settings.setValue( "lastFilePath", QVariant( pObject->filePath() ) );
+        PencilSettings* settings = pencilSettings();
+        settings->setValue( "lastFilePath", QVariant( pObject->filePath() ) );
 
         editor->setObject( pObject );
         editor->updateObject();
@@ -585,8 +597,8 @@ bool MainWindow2::openObject( QString strFilePath )
     // -----------------------------
 
 
-    //QSettings settings("Pencil","Pencil");
-    //settings.setValue("lastFilePath", QVariant(object->strCurrentFilePath) );
+    //PencilSettings* settings = pencilSettings();
+    //settings->setValue("lastFilePath", QVariant(object->strCurrentFilePath) );
 
     QString dataLayersDir;
     if ( openingTheOLDWAY )
@@ -736,127 +748,46 @@ void MainWindow2::resetToolsSettings()
 }
 
 
-bool MainWindow2::saveObject( QString strSavedFilename )
+void MainWindow2::savePerfTrace()
 {
-    QString filePath = strSavedFilename;
-
-    bool savingTheOLDWAY = filePath.endsWith( PFF_OLD_EXTENSION );
-
-    QFileInfo fileInfo( filePath );
-    if ( fileInfo.isDir() ) return false;
-
-    QString tmpFilePath;
-    if ( !savingTheOLDWAY )
-    {// create temporary directory for compressing files
-        tmpFilePath = QDir::tempPath() + "/" + fileInfo.completeBaseName() + PFF_TMP_COMPRESS_EXT;
-        QFileInfo tmpDataInfo( tmpFilePath );
-        if ( !tmpDataInfo.exists() )
-        {
-            QDir dir( QDir::tempPath() ); // --the directory where filePath is or will be saved
-            dir.mkpath( tmpFilePath ); // --creates a directory with the same name +".data"
-        }
-    }
-    else
+    QString filePath = QFileDialog::getSaveFileName( this, tr( "Save Performance Trace" ), "pencil-trace.json", tr( "Chrome trace (*.json)" ) );
+    if ( filePath.isEmpty() )
     {
-        tmpFilePath = fileInfo.absolutePath();
-    }
-
-
-    QString dataLayersDir;
-    if ( savingTheOLDWAY )
-    {
-        dataLayersDir = filePath + "." + PFF_LAYERS_DIR;
-    }
-    else
-    {
-        dataLayersDir = tmpFilePath + "/" + PFF_LAYERS_DIR;
+        return;
     }
-    QFileInfo dataInfo( dataLayersDir );
-    if ( !dataInfo.exists() )
+    if ( !PerfMonitor::instance()->saveChromeTrace( filePath ) )
     {
-        QDir dir( tmpFilePath ); // the directory where filePath is or will be saved
-        dir.mkpath( dataLayersDir ); // creates a directory with the same name +".data"
+        QMessageBox::warning( this, tr( "Warning" ), tr( "Could not write the trace to %1" ).arg( filePath ) );
     }
+}
+
+bool MainWindow2::saveObject( QString strSavedFilename )
+{
+    PERF_SCOPE( "MainWindow2::saveObject" );
+    QFileInfo fileInfo( strSavedFilename );
+    if ( fileInfo.isDir() ) return false;
 
-    //savedName = filePath;
-    this->setWindowTitle( filePath );
+    this->setWindowTitle( strSavedFilename );
 
     QProgressDialog progress( tr("Saving document..."), tr("Abort"), 0, 100, this );
     progress.setWindowModality( Qt::WindowModal );
     progress.show();
-    int progressValue = 0;
 
-    // save data
-    int nLayers = m_object->getLayerCount();
-    qDebug( "Layer Count=%d", nLayers );
+    // the editor state is saved along with the object
+    QDomDocument editorDoc;
+    QDomElement editorElement = createDomElement( editorDoc );
 
-    for ( int i = 0; i < nLayers; i++ )
+    ObjectSaveLoader objectSaver( this );
+    connect( &objectSaver, SIGNAL( progressValueChanged( int ) ), &progress, SLOT( setValue( int ) ) );
+    if ( !objectSaver.saveToFile( m_object, strSavedFilename, editorElement ) )
     {
-        Layer* layer = m_object->getLayer( i );
-        qDebug() << "Saving Layer " << i << "(" << layer->name << ")";
-
-        progressValue = (i * 100) / nLayers;
-        progress.setValue( progressValue );
-        if ( layer->type() == Layer::BITMAP ) ((LayerBitmap*)layer)->saveImages( dataLayersDir, i );
-        if ( layer->type() == Layer::VECTOR ) ((LayerVector*)layer)->saveImages( dataLayersDir, i );
-        if ( layer->type() == Layer::SOUND ) ((LayerSound*)layer)->saveImages( dataLayersDir, i );
-    }
-
-    // save palette
-    m_object->savePalette( dataLayersDir );
-
-    // -------- save main XML file -----------
-    QString mainXMLfile;
-    if ( !savingTheOLDWAY )
-    {
-        mainXMLfile = tmpFilePath + "/" + PFF_XML_FILE_NAME;
-    }
-    else
-    {
-        mainXMLfile = filePath;
-    }
-    QFile* file = new QFile( mainXMLfile );
-    if ( !file->open( QFile::WriteOnly | QFile::Text ) )
-    {
-        //QMessageBox::warning(this, "Warning", "Cannot write file");
+        progress.close();
+        QMessageBox::warning( this, tr( "Warning" ), tr( "Cannot write file %1" ).arg( strSavedFilename ) );
         return false;
     }
-    QTextStream out( file );
-    QDomDocument doc( "PencilDocument" );
-    QDomElement root = doc.createElement( "document" );
-    doc.appendChild( root );
-
-    // save editor information
-    QDomElement editorElement = createDomElement( doc );
-    root.appendChild( editorElement );
-    qDebug( "Save Editor Node." );
-
-    // save object
-    QDomElement objectElement = m_object->createDomElement( doc );
-    root.appendChild( objectElement );
-    qDebug( "Save Object Node." );
-
-    int IndentSize = 2;
-    doc.save( out, IndentSize );
-    // -----------------------------------
-
-    if ( !savingTheOLDWAY )
-    {
-        qDebug() << "Now compressing data to PFF - PCLX ...";
-
-        JlCompress::compressDir( filePath, tmpFilePath );
-        removePFFTmpDirectory( tmpFilePath ); // --removing temporary files
-
-        qDebug() << "Compressed. File saved.";
-    }
 
-    progress.setValue( 100 );
-
-    m_object->modified = false;
     m_pTimeLine->updateContent();
 
-    m_object->setFilePath( strSavedFilename );
-
     m_recentFileMenu->addRecentFile( strSavedFilename );
     m_recentFileMenu->saveToDisk();
 
@@ -948,6 +879,7 @@ void MainWindow2::showPreferences()
 
     connect( m_pPreferences, SIGNAL( autosaveChange( int ) ), editor, SLOT( changeAutosave( int ) ) );
     connect( m_pPreferences, SIGNAL( autosaveNumberChange( int ) ), editor, SLOT( changeAutosaveNumber( int ) ) );
+    connect( m_pPreferences, SIGNAL( vectorFormatChange( int ) ), editor, SLOT( changeVectorFormat( int ) ) );
 
     connect( m_pPreferences, SIGNAL( onionLayer1OpacityChange( int ) ), editor, SLOT( onionLayer1OpacityChangeSlot( int ) ) );
     connect( m_pPreferences, SIGNAL( onionLayer2OpacityChange( int ) ), editor, SLOT( onionLayer2OpacityChangeSlot( int ) ) );
@@ -972,7 +904,7 @@ void MainWindow2::dockAllPalettes()
 
 void MainWindow2::readSettings()
 {
-    QSettings* settings = pencilSettings();
+    PencilSettings* settings = pencilSettings();
     QRect desktopRect = QApplication::desktop()->screenGeometry();
     desktopRect.adjust( 80, 80, -80, -80 );
 
@@ -992,48 +924,48 @@ void MainWindow2::readSettings()
 
 void MainWindow2::writeSettings()
 {
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "editorPosition", pos() );
-    settings.setValue( "editorSize", size() );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "editorPosition", pos() );
+    settings->setValue( "editorSize", size() );
 
     ColorPaletteWidget* colourPalette = m_pColorPalette;
     if ( colourPalette != NULL )
     {
-        settings.setValue( "colourPalettePosition", colourPalette->pos() );
-        settings.setValue( "colourPaletteSize", colourPalette->size() );
-        settings.setValue( "colourPaletteFloating", colourPalette->isFloating() );
+        settings->setValue( "colourPalettePosition", colourPalette->pos() );
+        settings->setValue( "colourPaletteSize", colourPalette->size() );
+        settings->setValue( "colourPaletteFloating", colourPalette->isFloating() );
     }
 
     TimeLine* timelinePalette = editor->getTimeLine();
     if ( timelinePalette != NULL )
     {
-        settings.setValue( "timelinePalettePosition", timelinePalette->pos() );
-        settings.setValue( "timelinePaletteSize", timelinePalette->size() );
-        settings.setValue( "timelinePaletteFloating", timelinePalette->isFloating() );
+        settings->setValue( "timelinePalettePosition", timelinePalette->pos() );
+        settings->setValue( "timelinePaletteSize", timelinePalette->size() );
+        settings->setValue( "timelinePaletteFloating", timelinePalette->isFloating() );
     }
 
     QDockWidget* toolWidget = m_pToolBox;
     if ( toolWidget != NULL )
     {
-        settings.setValue( "drawPalettePosition", toolWidget->pos() );
-        settings.setValue( "drawPaletteSize", toolWidget->size() );
-        settings.setValue( "drawPaletteFloating", toolWidget->isFloating() );
+        settings->setValue( "drawPalettePosition", toolWidget->pos() );
+        settings->setValue( "drawPaletteSize", toolWidget->size() );
+        settings->setValue( "drawPaletteFloating", toolWidget->isFloating() );
     }
 
     QDockWidget* optionPalette = m_pToolOptionWidget;
     if ( optionPalette != NULL )
     {
-        settings.setValue( "optionPalettePosition", optionPalette->pos() );
-        settings.setValue( "optionPaletteSize", optionPalette->size() );
-        settings.setValue( "optionPaletteFloating", optionPalette->isFloating() );
+        settings->setValue( "optionPalettePosition", optionPalette->pos() );
+        settings->setValue( "optionPaletteSize", optionPalette->size() );
+        settings->setValue( "optionPaletteFloating", optionPalette->isFloating() );
     }
 
     QDockWidget* displayPalette = m_pDisplayOptionWidget;
     if ( displayPalette != NULL )
     {
-        settings.setValue( "displayPalettePosition", displayPalette->pos() );
-        settings.setValue( "displayPaletteSize", displayPalette->size() );
-        settings.setValue( "displayPaletteFloating", displayPalette->isFloating() );
+        settings->setValue( "displayPalettePosition", displayPalette->pos() );
+        settings->setValue( "displayPaletteSize", displayPalette->size() );
+        settings->setValue( "displayPaletteFloating", displayPalette->isFloating() );
     }
 }
 
@@ -1167,8 +1099,8 @@ void MainWindow2::undoActSetEnabled( void )
 
 void MainWindow2::exportPalette()
 {
-    QSettings settings( "Pencil", "Pencil" );
-    QString initialPath = settings.value( "lastPalettePath",
+    PencilSettings* settings = pencilSettings();
+    QString initialPath = settings->value( "lastPalettePath",
         QVariant( QDir::homePath() ) ).toString();
     if ( initialPath.isEmpty() )
     {
@@ -1178,14 +1110,14 @@ void MainWindow2::exportPalette()
     if ( !filePath.isEmpty() )
     {
         m_object->exportPalette( filePath );
-        settings.setValue( "lastPalettePath", QVariant( filePath ) );
+        settings->setValue( "lastPalettePath", QVariant( filePath ) );
     }
 }
 
 void MainWindow2::importPalette()
 {
-    QSettings settings( "Pencil", "Pencil" );
-    QString initialPath = settings.value( "lastPalettePath", QVariant( QDir::homePath() ) ).toString();
+    PencilSettings* settings = pencilSettings();
+    QString initialPath = settings->value( "lastPalettePath", QVariant( QDir::homePath() ) ).toString();
     if ( initialPath.isEmpty() )
     {
         initialPath = QDir::homePath() + "/untitled.xml";
@@ -1195,7 +1127,7 @@ void MainWindow2::importPalette()
     {
         m_object->importPalette( filePath );
         m_pColorPalette->refreshColorList();
-        settings.setValue( "lastPalettePath", QVariant( filePath ) );
+        settings->setValue( "lastPalettePath", QVariant( filePath ) );
     }
 }
 
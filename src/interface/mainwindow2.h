@@ -87,6 +87,8 @@ private slots:
     void importPalette();
     void exportPalette();
 
+    void savePerfTrace();
+
     // XML save/load
     QDomElement createDomElement(QDomDocument& doc);
     bool loadDomElement(QDomElement docElem, QString filePath);
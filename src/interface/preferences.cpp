@@ -28,7 +28,9 @@ GNU General Public License for more details.
 #include <QPushButton>
 #include "preferences.h"
 #include "scribblearea.h"
+#include "thumbnailcache.h"
 #include "shortcutspage.h"
+#include "pencilsettings.h"
 
 
 Preferences::Preferences( QWidget* parent ) : QDialog(parent)
@@ -136,7 +138,7 @@ void Preferences::changePage(QListWidgetItem* current, QListWidgetItem* previous
 
 GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
 {
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
     QVBoxLayout* lay = new QVBoxLayout();
 
     QGroupBox* windowOpacityBox = new QGroupBox(tr("Window opacity"));
@@ -149,7 +151,7 @@ GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
     QSlider* windowOpacityLevel = new QSlider(Qt::Horizontal);
     windowOpacityLevel->setMinimum(30);
     windowOpacityLevel->setMaximum(100);
-    int value = settings.value("windowOpacity").toInt();
+    int value = settings->value("windowOpacity").toInt();
     windowOpacityLevel->setValue( 100 - value );
 
     QButtonGroup* backgroundButtons = new QButtonGroup();
@@ -196,27 +198,27 @@ GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
     backgroundLayout->addWidget(greyBackgroundButton);
     backgroundLayout->addWidget(dotsBackgroundButton);
     backgroundLayout->addWidget(weaveBackgroundButton);
-    if ( settings.value("background").toString() == "checkerboard" ) checkerBackgroundButton->setChecked(true);
-    if ( settings.value("background").toString() == "white" ) whiteBackgroundButton->setChecked(true);
-    if ( settings.value("background").toString() == "grey" ) greyBackgroundButton->setChecked(true);
-    if ( settings.value("background").toString() == "dots" ) dotsBackgroundButton->setChecked(true);
-    if ( settings.value("background").toString() == "weave" ) weaveBackgroundButton->setChecked(true);
+    if ( settings->value("background").toString() == "checkerboard" ) checkerBackgroundButton->setChecked(true);
+    if ( settings->value("background").toString() == "white" ) whiteBackgroundButton->setChecked(true);
+    if ( settings->value("background").toString() == "grey" ) greyBackgroundButton->setChecked(true);
+    if ( settings->value("background").toString() == "dots" ) dotsBackgroundButton->setChecked(true);
+    if ( settings->value("background").toString() == "weave" ) weaveBackgroundButton->setChecked(true);
 
     QCheckBox* shadowsBox = new QCheckBox(tr("Shadows"));
     shadowsBox->setChecked(false); // default
-    if (settings.value("shadows").toString()=="true") shadowsBox->setChecked(true);
+    if (settings->value("shadows").toString()=="true") shadowsBox->setChecked(true);
 
     QCheckBox* toolCursorsBox = new QCheckBox(tr("Tool Cursors"));
     toolCursorsBox->setChecked(true); // default
-    if (settings.value("toolCursors").toString()=="false") toolCursorsBox->setChecked(false);
+    if (settings->value("toolCursors").toString()=="false") toolCursorsBox->setChecked(false);
 
     QCheckBox* aquaBox = new QCheckBox(tr("Aqua Style"));
     aquaBox->setChecked(false); // default
-    if (settings.value("style").toString()=="aqua") aquaBox->setChecked(true);
+    if (settings->value("style").toString()=="aqua") aquaBox->setChecked(true);
 
     QCheckBox* antialiasingBox = new QCheckBox(tr("Antialiasing"));
     antialiasingBox->setChecked(true); // default
-    if (settings.value("antialiasing").toString()=="false") antialiasingBox->setChecked(false);
+    if (settings->value("antialiasing").toString()=="false") antialiasingBox->setChecked(false);
 
     QButtonGroup* gradientsButtons = new QButtonGroup();
     QRadioButton* gradient1Button = new QRadioButton(tr("None"));
@@ -238,22 +240,22 @@ GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
     gradientsLayout->addWidget(gradient2Button);
     gradientsLayout->addWidget(gradient3Button);
     gradientsLayout->addWidget(gradient4Button);
-    if ( settings.value("gradients").toString() == "1" ) gradient1Button->setChecked(true);
-    if ( settings.value("gradients").toString() == "2" ) gradient2Button->setChecked(true);
-    if ( settings.value("gradients").toString() == "" )  gradient2Button->setChecked(true); // default
-    if ( settings.value("gradients").toString() == "3" ) gradient3Button->setChecked(true);
-    if ( settings.value("gradients").toString() == "4" ) gradient4Button->setChecked(true);
+    if ( settings->value("gradients").toString() == "1" ) gradient1Button->setChecked(true);
+    if ( settings->value("gradients").toString() == "2" ) gradient2Button->setChecked(true);
+    if ( settings->value("gradients").toString() == "" )  gradient2Button->setChecked(true); // default
+    if ( settings->value("gradients").toString() == "3" ) gradient3Button->setChecked(true);
+    if ( settings->value("gradients").toString() == "4" ) gradient4Button->setChecked(true);
 
 
     /*QCheckBox *gradientsBox = new QCheckBox(tr("Gradients"));
     gradientsBox->setChecked(true); // default
-    if (settings.value("gradients").toString()=="0") gradientsBox->setChecked(false);*/
+    if (settings->value("gradients").toString()=="0") gradientsBox->setChecked(false);*/
 
     QLabel* curveOpacityLabel = new QLabel(tr("Vector curve opacity"));
     QSlider* curveOpacityLevel = new QSlider(Qt::Horizontal);
     curveOpacityLevel->setMinimum(0);
     curveOpacityLevel->setMaximum(100);
-    curveOpacityLevel->setValue( 100 - settings.value("curveOpacity").toInt() );
+    curveOpacityLevel->setValue( 100 - settings->value("curveOpacity").toInt() );
 
     QGridLayout* windowOpacityLayout = new QGridLayout();
     windowOpacityBox->setLayout(windowOpacityLayout);
@@ -279,11 +281,11 @@ GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
     QSlider* curveSmoothingLevel = new QSlider(Qt::Horizontal);
     curveSmoothingLevel->setMinimum(1);
     curveSmoothingLevel->setMaximum(100);
-    value = settings.value("curveSmoothing").toInt();
+    value = settings->value("curveSmoothing").toInt();
     curveSmoothingLevel->setValue( value );
 
     QCheckBox* highResBox = new QCheckBox(tr("Tablet high-resolution position"));
-    if (settings.value(SETTING_HIGH_RESOLUTION) == "true")
+    if (settings->value(SETTING_HIGH_RESOLUTION) == "true")
     {
         highResBox->setChecked(true);
     }
@@ -321,7 +323,7 @@ GeneralPage::GeneralPage(QWidget* parent) : QWidget(parent)
 
 TimelinePage::TimelinePage(QWidget* parent) : QWidget(parent)
 {
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
 
     QVBoxLayout* lay = new QVBoxLayout();
 
@@ -336,7 +338,10 @@ TimelinePage::TimelinePage(QWidget* parent) : QWidget(parent)
 
     QCheckBox* scrubBox = new QCheckBox(tr("Short scrub"));
     scrubBox->setChecked(false); // default
-    if (settings.value("shortScrub").toBool()) scrubBox->setChecked(true);
+    if (settings->value("shortScrub").toBool()) scrubBox->setChecked(true);
+
+    QCheckBox* thumbnailBox = new QCheckBox(tr("Show key frame thumbnails"));
+    thumbnailBox->setChecked(ThumbnailCache::instance()->isEnabled());
 
     fontSize->setMinimum(4);
     fontSize->setMaximum(20);
@@ -347,26 +352,28 @@ TimelinePage::TimelinePage(QWidget* parent) : QWidget(parent)
     frameSize->setFixedWidth(50);
     lengthSize->setFixedWidth(50);
 
-    if (settings.value("drawLabel")=="false") drawLabel->setChecked(false);
+    if (settings->value("drawLabel")=="false") drawLabel->setChecked(false);
     else drawLabel->setChecked(true);
-    fontSize->setValue(settings.value("labelFontSize").toInt());
-    frameSize->setValue(settings.value("frameSize").toInt());
-    if (settings.value("labelFontSize").toInt()==0) fontSize->setValue(12);
-    if (settings.value("frameSize").toInt()==0) frameSize->setValue(6);
-    lengthSize->setText(settings.value("length").toString());
-    if (settings.value("length").toInt()==0) lengthSize->setText("240");
+    fontSize->setValue(settings->value("labelFontSize").toInt());
+    frameSize->setValue(settings->value("frameSize").toInt());
+    if (settings->value("labelFontSize").toInt()==0) fontSize->setValue(12);
+    if (settings->value("frameSize").toInt()==0) frameSize->setValue(6);
+    lengthSize->setText(settings->value("length").toString());
+    if (settings->value("length").toInt()==0) lengthSize->setText("240");
 
     connect(fontSize, SIGNAL(valueChanged(int)), parent, SIGNAL(fontSizeChange(int)));
     connect(frameSize, SIGNAL(valueChanged(int)), parent, SIGNAL(frameSizeChange(int)));
     connect(lengthSize, SIGNAL(textChanged(QString)), parent, SIGNAL(lengthSizeChange(QString)));
     connect(drawLabel, SIGNAL(stateChanged(int)), parent, SIGNAL(labelChange(int)));
     connect(scrubBox, SIGNAL(stateChanged(int)), parent, SIGNAL(scrubChange(int)));
+    connect(thumbnailBox, SIGNAL(stateChanged(int)), ThumbnailCache::instance(), SLOT(setEnabled(int)));
 
     lay->addWidget(frameSizeLabel);
     lay->addWidget(frameSize);
     lay->addWidget(lengthSizeLabel);
     lay->addWidget(lengthSize);
     lay->addWidget(scrubBox);
+    lay->addWidget(thumbnailBox);
     timeLineBox->setLayout(lay);
 
     QVBoxLayout* lay2 = new QVBoxLayout();
@@ -377,7 +384,7 @@ TimelinePage::TimelinePage(QWidget* parent) : QWidget(parent)
 
 FilesPage::FilesPage(QWidget* parent) : QWidget(parent)
 {
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
 
     QVBoxLayout* lay = new QVBoxLayout();
 
@@ -391,10 +398,10 @@ FilesPage::FilesPage(QWidget* parent) : QWidget(parent)
     autosaveNumberBox->setFixedWidth(50);
 
     autosaveCheckBox->setChecked(false);
-    if (settings.value("autosave")=="true") autosaveCheckBox->setChecked(true);
+    if (settings->value("autosave")=="true") autosaveCheckBox->setChecked(true);
 
-    autosaveNumberBox->setValue(settings.value("autosaveNumber").toInt());
-    if (settings.value("autosaveNumber").toInt()==0) autosaveNumberBox->setValue(20);
+    autosaveNumberBox->setValue(settings->value("autosaveNumber").toInt());
+    if (settings->value("autosaveNumber").toInt()==0) autosaveNumberBox->setValue(20);
 
     connect(autosaveNumberBox, SIGNAL(valueChanged(int)), parent, SIGNAL(autosaveNumberChange(int)));
     connect(autosaveCheckBox, SIGNAL(stateChanged(int)), parent, SIGNAL(autosaveChange(int)));
@@ -404,15 +411,25 @@ FilesPage::FilesPage(QWidget* parent) : QWidget(parent)
     lay->addWidget(autosaveNumberBox);
     autosaveBox->setLayout(lay);
 
+    QGroupBox* vectorBox = new QGroupBox(tr("Vector frames"));
+    QCheckBox* vectorBinaryBox = new QCheckBox(tr("Save in the compact binary format (not readable by older versions)"));
+    vectorBinaryBox->setChecked(settings->value(SETTING_VECTOR_BINARY_FORMAT, false).toBool());
+    connect(vectorBinaryBox, SIGNAL(stateChanged(int)), parent, SIGNAL(vectorFormatChange(int)));
+
+    QVBoxLayout* vectorLay = new QVBoxLayout();
+    vectorLay->addWidget(vectorBinaryBox);
+    vectorBox->setLayout(vectorLay);
+
     QVBoxLayout* lay2 = new QVBoxLayout();
     lay2->addWidget(autosaveBox);
+    lay2->addWidget(vectorBox);
     lay2->addStretch(1);
     setLayout(lay2);
 }
 
 ToolsPage::ToolsPage(QWidget* parent) : QWidget(parent)
 {
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
 
     QVBoxLayout* lay = new QVBoxLayout();
 
@@ -434,9 +451,9 @@ ToolsPage::ToolsPage(QWidget* parent) : QWidget(parent)
     onionLayer3OpacityBox->setMaximum(100);
     onionLayer3OpacityBox->setFixedWidth(50);
 
-    onionLayer1OpacityBox->setValue(settings.value("onionLayer1Opacity").toInt());
-    onionLayer2OpacityBox->setValue(settings.value("onionLayer2Opacity").toInt());
-    onionLayer3OpacityBox->setValue(settings.value("onionLayer3Opacity").toInt());
+    onionLayer1OpacityBox->setValue(settings->value("onionLayer1Opacity").toInt());
+    onionLayer2OpacityBox->setValue(settings->value("onionLayer2Opacity").toInt());
+    onionLayer3OpacityBox->setValue(settings->value("onionLayer3Opacity").toInt());
 
     connect(onionLayer1OpacityBox, SIGNAL(valueChanged(int)), parent, SIGNAL(onionLayer1OpacityChange(int)));
     connect(onionLayer2OpacityBox, SIGNAL(valueChanged(int)), parent, SIGNAL(onionLayer2OpacityChange(int)));
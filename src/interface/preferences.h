@@ -47,6 +47,7 @@ signals:
 
     void autosaveChange(int);
     void autosaveNumberChange(int);
+    void vectorFormatChange(int);
 
     void lengthSizeChange(QString);
     void fontSizeChange(int);
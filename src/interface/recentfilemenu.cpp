@@ -1,4 +1,4 @@
-#include <QSettings>
+#include "pencilsettings.h"
 #include <QVariant>
 #include <QDebug>
 
@@ -32,8 +32,8 @@ void RecentFileMenu::setRecentFiles(QStringList filenames)
 
 bool RecentFileMenu::loadFromDisk()
 {
-    QSettings settings("Pencil", "Pencil");
-    QVariant _recent = settings.value("RecentFiles");
+    PencilSettings* settings = pencilSettings();
+    QVariant _recent = settings->value("RecentFiles");
     if (_recent.isNull())
     {
         return false;
@@ -45,8 +45,8 @@ bool RecentFileMenu::loadFromDisk()
 
 bool RecentFileMenu::saveToDisk()
 {
-    QSettings settings("Pencil", "Pencil");
-    settings.setValue("RecentFiles", QVariant(m_recentFiles));
+    PencilSettings* settings = pencilSettings();
+    settings->setValue("RecentFiles", QVariant(m_recentFiles));
     return true;
 }
 
@@ -29,6 +29,9 @@ GNU General Public License for more details.
 #include "strokemanager.h"
 #include "layermanager.h"
 #include "popupcolorpalettewidget.h"
+#include "vectortilecache.h"
+#include "strokerenderer.h"
+#include "perfmonitor.h"
 
 #include "scribblearea.h"
 
@@ -41,27 +44,27 @@ ScribbleArea::ScribbleArea( QWidget *parent, Editor *editor )
     this->m_pEditor = editor;
     m_strokeManager = new StrokeManager();
 
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
 
     followContour = 0;
 
-    curveOpacity = ( 100 - settings.value( "curveOpacity" ).toInt() ) / 100.0; // default value is 1.0
-    int curveSmoothingLevel = settings.value( "curveSmoothing" ).toInt();
-    if ( curveSmoothingLevel == 0 ) { curveSmoothingLevel = 20; settings.setValue( "curveSmoothing", curveSmoothingLevel ); } // default
+    curveOpacity = ( 100 - settings->value( "curveOpacity" ).toInt() ) / 100.0; // default value is 1.0
+    int curveSmoothingLevel = settings->value( "curveSmoothing" ).toInt();
+    if ( curveSmoothingLevel == 0 ) { curveSmoothingLevel = 20; settings->setValue( "curveSmoothing", curveSmoothingLevel ); } // default
     curveSmoothing = curveSmoothingLevel / 20.0; // default value is 1.0
 
-    if ( settings.value( SETTING_HIGH_RESOLUTION ).toString() == "true" )
+    if ( settings->value( SETTING_HIGH_RESOLUTION ).toString() == "true" )
     {
         m_strokeManager->useHighResPosition( true );
     }
 
     m_antialiasing = true; // default value is true (because it's prettier)
-    if ( settings.value( "antialiasing" ).toString() == "false" )
+    if ( settings->value( "antialiasing" ).toString() == "false" )
     {
         m_antialiasing = false;
     }
     shadows = false; // default value is false
-    if ( settings.value( "shadows" ).toString() == "true" )
+    if ( settings->value( "shadows" ).toString() == "true" )
     {
         shadows = true;
     }
@@ -84,11 +87,14 @@ ScribbleArea::ScribbleArea( QWidget *parent, Editor *editor )
     transMatrix = QMatrix();
     centralView = QMatrix();
 
-    QString background = settings.value( "background" ).toString();
+    QString background = settings->value( "background" ).toString();
 
     background = "white";
     setBackgroundBrush( background );
     bufferImg = new BitmapImage( NULL );
+    m_strokeRenderer = new StrokeRenderer( this );
+    m_showPerfOverlay = false;
+    connect( m_strokeRenderer, SIGNAL( dabsDrawn( QRectF ) ), this, SLOT( strokeRendered( QRectF ) ) );
 
     QRect newSelection( QPoint( 0, 0 ), QSize( 0, 0 ) );
     mySelection = newSelection;
@@ -97,6 +103,7 @@ ScribbleArea::ScribbleArea( QWidget *parent, Editor *editor )
     offset.setX( 0 );
     offset.setY( 0 );
     selectionTransformation.reset();
+    selectionSourceKey = 0;
 
     tol = 7.0;
 
@@ -117,6 +124,9 @@ ScribbleArea::ScribbleArea( QWidget *parent, Editor *editor )
     // color wheel popup
     m_popupPaletteWidget = new PopupColorPaletteWidget( this );
 
+    // vector tiles refined in idle time replace the rescaled ones
+    connect( VectorTileCache::instance(), SIGNAL( tilesRendered() ), this, SLOT( updateAllFrames() ) );
+
     onionBlue = true;
     onionRed = true;
     //onionColor = Qt::blue;
@@ -134,45 +144,45 @@ void ScribbleArea::updateToolCursor()
 void ScribbleArea::setCurveOpacity( int newOpacity )
 {
     curveOpacity = newOpacity / 100.0;
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "curveOpacity", 100 - newOpacity );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "curveOpacity", 100 - newOpacity );
     updateAllVectorLayers();
 }
 
 void ScribbleArea::setCurveSmoothing( int newSmoothingLevel )
 {
     curveSmoothing = newSmoothingLevel / 20.0;
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "curveSmoothing", newSmoothingLevel );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "curveSmoothing", newSmoothingLevel );
 }
 
 void ScribbleArea::setHighResPosition( int x )
 {
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
     if ( x == 0 )
     {
         m_strokeManager->useHighResPosition( false );
-        settings.setValue( SETTING_HIGH_RESOLUTION, "false" );
+        settings->setValue( SETTING_HIGH_RESOLUTION, "false" );
     }
     else {
         m_strokeManager->useHighResPosition( true );
-        settings.setValue( SETTING_HIGH_RESOLUTION, "true" );
+        settings->setValue( SETTING_HIGH_RESOLUTION, "true" );
     }
 }
 
 void ScribbleArea::setAntialiasing( int x )
 {
-    QSettings settings( "Pencil", "Pencil" );
-    if ( x == 0 ) { m_antialiasing = false; settings.setValue( "antialiasing", "false" ); }
-    else { m_antialiasing = true; settings.setValue( "antialiasing", "true" ); }
+    PencilSettings* settings = pencilSettings();
+    if ( x == 0 ) { m_antialiasing = false; settings->setValue( "antialiasing", "false" ); }
+    else { m_antialiasing = true; settings->setValue( "antialiasing", "true" ); }
     updateAllVectorLayers();
 }
 
 void ScribbleArea::setShadows( int x )
 {
-    QSettings settings( "Pencil", "Pencil" );
-    if ( x == 0 ) { shadows = false; settings.setValue( "shadows", "false" ); }
-    else { shadows = true; settings.setValue( "shadows", "true" ); }
+    PencilSettings* settings = pencilSettings();
+    if ( x == 0 ) { shadows = false; settings->setValue( "shadows", "false" ); }
+    else { shadows = true; settings->setValue( "shadows", "true" ); }
     update();
 }
 
@@ -183,9 +193,9 @@ void ScribbleArea::setToolCursors( int x )
 
 void ScribbleArea::setStyle( int x )
 {
-    QSettings settings( "Pencil", "Pencil" );
-    if ( x == 0 ) { settings.setValue( "style", "default" ); }
-    else { settings.setValue( "style", "aqua" ); }
+    PencilSettings* settings = pencilSettings();
+    if ( x == 0 ) { settings->setValue( "style", "default" ); }
+    else { settings->setValue( "style", "aqua" ); }
     update();
 }
 
@@ -201,8 +211,8 @@ void ScribbleArea::setBackground( int number )
 
 void ScribbleArea::setBackgroundBrush( QString brushName )
 {
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "background", brushName );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "background", brushName );
     backgroundBrush = getBackgroundBrush( brushName );
 }
 
@@ -257,6 +267,7 @@ void ScribbleArea::updateFrame( int frame )
     setView();
     int frameNumber = m_pEditor->layerManager()->LastFrameAtFrame( frame );
     QPixmapCache::remove( "frame" + QString::number( frameNumber ) );
+    m_frameDamage.remove( frameNumber );
     readCanvasFromCache = true;
 
     update();
@@ -266,11 +277,29 @@ void ScribbleArea::updateAllFrames()
 {
     setView();
     QPixmapCache::clear();
+    m_frameDamage.clear();
     readCanvasFromCache = true;
     update();
     updateAll = false;
 }
 
+void ScribbleArea::addDamage( const QRectF& rect )
+{
+    if ( rect.isEmpty() ) { return; }
+    QRect damaged = rect.toAlignedRect().adjusted( -1, -1, 1, 1 );
+
+    // the other cached frames may show this drawing too, as an onion skin
+    QHash<int, QRegion>::iterator i;
+    for ( i = m_frameDamage.begin(); i != m_frameDamage.end(); ++i )
+    {
+        i.value() += damaged;
+    }
+    int frameNumber = m_pEditor->layerManager()->LastFrameAtFrame( m_pEditor->layerManager()->currentFrameIndex() );
+    m_frameDamage[ frameNumber ] += damaged;
+
+    update( myTempView.mapRect( damaged ).adjusted( -1, -1, 1, 1 ) );
+}
+
 void ScribbleArea::updateAllVectorLayersAtCurrentFrame()
 {
     updateAllVectorLayersAt( m_pEditor->layerManager()->currentFrameIndex() );
@@ -313,6 +342,23 @@ void ScribbleArea::setModified( int layerNumber, int frameNumber )
     updateAllFrames();
 }
 
+void ScribbleArea::setModified( int layerNumber, int frameNumber, const QRectF& rect )
+{
+    Layer *layer = m_pEditor->object()->getLayer( layerNumber );
+    if ( layer->type() == Layer::VECTOR )
+    {
+        ( ( LayerVector * )layer )->setModified( frameNumber, true );
+    }
+    if ( layer->type() == Layer::BITMAP )
+    {
+        ( ( LayerImage * )layer )->setModified( frameNumber, true );
+    }
+
+    emit modification( layerNumber );
+
+    addDamage( rect );
+}
+
 void ScribbleArea::togglePopupPalette()
 {
     m_popupPaletteWidget->popup();
@@ -724,9 +770,12 @@ void ScribbleArea::mouseDoubleClickEvent( QMouseEvent *event )
 
 void ScribbleArea::paintBitmapBuffer()
 {
+    PERF_SCOPE( "ScribbleArea::paintBitmapBuffer" );
     Layer *layer = m_pEditor->getCurrentLayer();
     // ---- checks ------
     if ( layer == NULL ) { return; }
+    // the dabs still being drawn belong to this stroke
+    m_strokeRenderer->finish( bufferImg );
     // Clear the temporary pixel path
     BitmapImage *targetImage = ( ( LayerBitmap * )layer )->getLastBitmapImageAtFrame( m_pEditor->layerManager()->currentFrameIndex(), 0 );
     if ( targetImage != NULL )
@@ -763,24 +812,28 @@ void ScribbleArea::paintBitmapBuffer()
         }
         targetImage->paste( bufferImg, cm );
     }
-    QRect rect = myTempView.mapRect( bufferImg->boundaries );
+    QRect rect = bufferImg->boundaries;
     // Clear the buffer
     bufferImg->clear();
 
     //setModified(layer, editor->currentFrame);
     ( ( LayerImage * )layer )->setModified( m_pEditor->layerManager()->currentFrameIndex(), true );
     emit modification();
-    QPixmapCache::remove( "frame" + QString::number( m_pEditor->layerManager()->currentFrameIndex() ) );
     readCanvasFromCache = false;
-    updateCanvas( m_pEditor->layerManager()->currentFrameIndex(), rect.adjusted( -1, -1, 1, 1 ) );
-    update( rect );
+    addDamage( rect );
 }
 
 void ScribbleArea::clearBitmapBuffer()
 {
+    m_strokeRenderer->clear();
     bufferImg->clear();
 }
 
+void ScribbleArea::strokeRendered( QRectF rect )
+{
+    update( myTempView.mapRect( rect ).toAlignedRect().adjusted( -1, -1, 1, 1 ) );
+}
+
 void ScribbleArea::drawLine( QPointF P1, QPointF P2, QPen pen, QPainter::CompositionMode cm )
 {
     bufferImg->drawLine( P1, P2, pen, cm, m_antialiasing );
@@ -812,6 +865,7 @@ void ScribbleArea::grid()
 
 void ScribbleArea::paintEvent( QPaintEvent *event )
 {
+    PERF_SCOPE( "ScribbleArea::paintEvent" );
     //qDebug() << "paint event!" << QDateTime::currentDateTime() << event->rect();
     QPainter painter( this );
 
@@ -833,12 +887,33 @@ void ScribbleArea::paintEvent( QPaintEvent *event )
         int frameNumber = m_pEditor->layerManager()->LastFrameAtFrame( curIndex );
 
         QString strCachedFrameKey = "frame" + QString::number( frameNumber );
+        PERF_COUNT( "canvas cache lookups", 1 );
         if ( !QPixmapCache::find( strCachedFrameKey, canvas ) )
         {
-            updateCanvas( m_pEditor->layerManager()->currentFrameIndex(), event->rect() );
+            PERF_COUNT( "canvas cache misses", 1 );
+            // the whole canvas, not just the exposed part, since it is cached as the whole frame
+            updateCanvas( m_pEditor->layerManager()->currentFrameIndex(), rect() );
             QPixmapCache::insert( strCachedFrameKey, canvas );
+            m_frameDamage.insert( frameNumber, QRegion() );
         }
     }
+
+    // --- composites again only what the tools have changed since
+    int damagedFrame = m_pEditor->layerManager()->LastFrameAtFrame( m_pEditor->layerManager()->currentFrameIndex() );
+    QRegion damaged = m_frameDamage.value( damagedFrame );
+    if ( !damaged.isEmpty() )
+    {
+        QRegion clip;
+        foreach ( QRect rect, damaged.rects() )
+        {
+            clip += myTempView.mapRect( rect ).adjusted( -1, -1, 1, 1 );
+        }
+        QString strCachedFrameKey = "frame" + QString::number( damagedFrame );
+        QPixmapCache::remove( strCachedFrameKey ); // so that the canvas is not copied when painted on
+        updateCanvas( m_pEditor->layerManager()->currentFrameIndex(), clip );
+        QPixmapCache::insert( strCachedFrameKey, canvas );
+        m_frameDamage.insert( damagedFrame, QRegion() );
+    }
     if ( currentTool()->type() == MOVE )
     {
         Layer *layer = m_pEditor->getCurrentLayer();
@@ -954,6 +1029,7 @@ void ScribbleArea::paintEvent( QPaintEvent *event )
             if ( m_pEditor->getCurrentLayer()->type() == Layer::BITMAP ) { painter.setWorldMatrixEnabled( true ); }
             if ( m_pEditor->getCurrentLayer()->type() == Layer::VECTOR ) { painter.setWorldMatrixEnabled( false ); }
             bufferImg->paintImage( painter );
+            m_strokeRenderer->paint( painter );
         }
 
         // paints the selection outline
@@ -1034,11 +1110,74 @@ void ScribbleArea::paintEvent( QPaintEvent *event )
         painter.setBrush( shadow );
         painter.drawRect( QRect( width() - radius2, 0, width(), height() ) );
     }
+    if ( m_showPerfOverlay )
+    {
+        drawPerfOverlay( painter );
+    }
     event->accept();
 }
 
-void ScribbleArea::updateCanvas( int frame, QRect rect )
+void ScribbleArea::drawPerfOverlay( QPainter& painter )
+{
+    PerfMonitor* monitor = PerfMonitor::instance();
+    QStringList lines;
+    lines << tr( "Frame: %1 ms" ).arg( monitor->stat( "ScribbleArea::paintEvent" ).average / 1000.0, 0, 'f', 2 );
+    lines << tr( "Compose: %1 ms" ).arg( monitor->stat( "ScribbleArea::updateCanvas" ).average / 1000.0, 0, 'f', 2 );
+    qint64 lookups = monitor->counter( "canvas cache lookups" );
+    if ( lookups > 0 )
+    {
+        qreal hitRate = 100.0 * ( lookups - monitor->counter( "canvas cache misses" ) ) / lookups;
+        lines << tr( "Cache hits: %1%" ).arg( hitRate, 0, 'f', 1 );
+    }
+    // pixels held by the key frames of the bitmap layers
+    Object* object = m_pEditor->object();
+    for ( int i = 0; object != NULL && i < object->getLayerCount(); i++ )
+    {
+        Layer* layer = object->getLayer( i );
+        if ( layer->type() != Layer::BITMAP )
+        {
+            continue;
+        }
+        qint64 bytes = 0;
+        LayerBitmap* layerBitmap = ( LayerBitmap* )layer;
+        for ( int k = 0; layerBitmap->getBitmapImageAtIndex( k ) != NULL; k++ )
+        {
+            bytes += layerBitmap->getBitmapImageAtIndex( k )->image->byteCount();
+        }
+        lines << tr( "%1: %2 MB" ).arg( layer->name ).arg( bytes / ( 1024.0 * 1024.0 ), 0, 'f', 1 );
+    }
+
+    painter.save();
+    painter.setWorldMatrixEnabled( false );
+    painter.setFont( QFont( "Monospace", 9 ) );
+    QFontMetrics metrics = painter.fontMetrics();
+    int lineHeight = metrics.height();
+    int boxWidth = 0;
+    foreach ( QString line, lines )
+    {
+        boxWidth = qMax( boxWidth, metrics.width( line ) );
+    }
+    QRect box( 8, 8, boxWidth + 12, lines.size() * lineHeight + 8 );
+    painter.setPen( Qt::NoPen );
+    painter.setBrush( QColor( 0, 0, 0, 160 ) );
+    painter.drawRect( box );
+    painter.setPen( Qt::white );
+    for ( int i = 0; i < lines.size(); i++ )
+    {
+        painter.drawText( box.left() + 6, box.top() + 4 + i * lineHeight + metrics.ascent(), lines.at( i ) );
+    }
+    painter.restore();
+}
+
+void ScribbleArea::togglePerfOverlay( bool checked )
+{
+    m_showPerfOverlay = checked;
+    update();
+}
+
+void ScribbleArea::updateCanvas( int frame, const QRegion& region )
 {
+    PERF_SCOPE( "ScribbleArea::updateCanvas" );
     //qDebug() << "paint canvas!" << QDateTime::currentDateTime();
     // merge the different layers into the ScribbleArea
     QPainter painter( &canvas );
@@ -1050,7 +1189,7 @@ void ScribbleArea::updateCanvas( int frame, QRect rect )
     {
         painter.setRenderHint( QPainter::SmoothPixmapTransform, m_antialiasing );
     }
-    painter.setClipRect( rect );
+    painter.setClipRegion( region );
     painter.setClipping( true );
     setView();
     painter.setWorldMatrix( myTempView );
@@ -1063,7 +1202,6 @@ void ScribbleArea::updateCanvas( int frame, QRect rect )
 
     QRectF viewRect = getViewRect();
     QRectF vectorViewRect = viewRect.translated( -viewRect.left(), -viewRect.top() );
-    QSize sz = viewRect.size().toSize();
 
     Object *object = m_pEditor->object();
     qreal opacity;
@@ -1170,48 +1308,24 @@ void ScribbleArea::updateCanvas( int frame, QRect rect )
             if ( layer->type() == Layer::VECTOR )
             {
                 LayerVector *layerVector = ( LayerVector * )layer;
-                QImage *pImage = layerVector->getLastImageAtFrame( frame, 0,
-                                                                   sz,
-                                                                   m_isSimplified, m_showThinLines,
-                                                                   curveOpacity,
-                                                                   m_antialiasing );
-
-                if ( pImage != NULL )
+                if ( layerVector->getLastVectorImageAtFrame( frame, 0 ) != NULL )
                 {
                     painter.setWorldMatrixEnabled( false );
 
                     // previous frame (onion skin)
                     if ( onionPrev ) {
-                        QImage *previousImage = layerVector->getLastImageAtFrame( frame, -1, sz,
-                                                                                  m_isSimplified,
-                                                                                  m_showThinLines,
-                                                                                  curveOpacity,
-                                                                                  m_antialiasing );
-                        if ( previousImage != NULL )
-                        {
-                            painter.setOpacity( opacity * m_pEditor->getOnionLayer1Opacity() / 100.0 );
-                            painter.drawImage( QPoint( 0, 0 ), *previousImage );
-                        }
-                        QImage* previousImage2 = layerVector->getLastImageAtFrame( frame, -2, sz,
-                                                                                   m_isSimplified,
-                                                                                   m_showThinLines,
-                                                                                   curveOpacity,
-                                                                                   m_antialiasing );
-                        if ( previousImage2 != NULL )
-                        {
-                            painter.setOpacity( opacity * m_pEditor->getOnionLayer2Opacity() / 100.0 );
-                            painter.drawImage( QPoint( 0, 0 ), *previousImage2 );
-                        }
-                        QImage *previousImage3 = layerVector->getLastImageAtFrame( frame, -3, sz,
-                                                                                   m_isSimplified,
-                                                                                   m_showThinLines,
-                                                                                   curveOpacity,
-                                                                                   m_antialiasing );
-                        if ( previousImage3 != NULL )
-                        {
-                            painter.setOpacity( opacity * m_pEditor->getOnionLayer3Opacity() / 100.0 );
-                            painter.drawImage( QPoint( 0, 0 ), *previousImage3 );
-                        }
+                        painter.setOpacity( opacity * m_pEditor->getOnionLayer1Opacity() / 100.0 );
+                        layerVector->paintImageAtFrame( painter, frame, -1,
+                                                        m_isSimplified, m_showThinLines,
+                                                        curveOpacity, m_antialiasing );
+                        painter.setOpacity( opacity * m_pEditor->getOnionLayer2Opacity() / 100.0 );
+                        layerVector->paintImageAtFrame( painter, frame, -2,
+                                                        m_isSimplified, m_showThinLines,
+                                                        curveOpacity, m_antialiasing );
+                        painter.setOpacity( opacity * m_pEditor->getOnionLayer3Opacity() / 100.0 );
+                        layerVector->paintImageAtFrame( painter, frame, -3,
+                                                        m_isSimplified, m_showThinLines,
+                                                        curveOpacity, m_antialiasing );
                         if ( onionBlue || onionRed ) {
                             painter.setOpacity( 1.0 );
                             painter.setCompositionMode( QPainter::CompositionMode_Lighten );
@@ -1227,25 +1341,18 @@ void ScribbleArea::updateCanvas( int frame, QRect rect )
 
                     // next frame (onion skin)
                     if ( onionNext ) {
-                        QImage* nextImage = layerVector->getLastImageAtFrame( frame, 1, sz, m_isSimplified, m_showThinLines, curveOpacity, m_antialiasing );
-                        if ( nextImage != NULL )
-                        {
-                            painter.setOpacity( opacity * m_pEditor->getOnionLayer1Opacity() / 100.0 );
-                            painter.drawImage( QPoint( 0, 0 ), *nextImage );
-                        }
-                        QImage* nextImage2 = layerVector->getLastImageAtFrame( frame, 2, sz,
-                                                                               m_isSimplified, m_showThinLines, curveOpacity, m_antialiasing );
-                        if ( nextImage2 != NULL )
-                        {
-                            painter.setOpacity( opacity * m_pEditor->getOnionLayer2Opacity() / 100.0 );
-                            painter.drawImage( QPoint( 0, 0 ), *nextImage2 );
-                        }
-                        QImage* nextImage3 = layerVector->getLastImageAtFrame( frame, 3, sz, m_isSimplified, m_showThinLines, curveOpacity, m_antialiasing );
-                        if ( nextImage3 != NULL )
-                        {
-                            painter.setOpacity( opacity * m_pEditor->getOnionLayer3Opacity() / 100.0 );
-                            painter.drawImage( QPoint( 0, 0 ), *nextImage3 );
-                        }
+                        painter.setOpacity( opacity * m_pEditor->getOnionLayer1Opacity() / 100.0 );
+                        layerVector->paintImageAtFrame( painter, frame, 1,
+                                                        m_isSimplified, m_showThinLines,
+                                                        curveOpacity, m_antialiasing );
+                        painter.setOpacity( opacity * m_pEditor->getOnionLayer2Opacity() / 100.0 );
+                        layerVector->paintImageAtFrame( painter, frame, 2,
+                                                        m_isSimplified, m_showThinLines,
+                                                        curveOpacity, m_antialiasing );
+                        painter.setOpacity( opacity * m_pEditor->getOnionLayer3Opacity() / 100.0 );
+                        layerVector->paintImageAtFrame( painter, frame, 3,
+                                                        m_isSimplified, m_showThinLines,
+                                                        curveOpacity, m_antialiasing );
                         if ( onionBlue || onionRed ) {
                             painter.setOpacity( 1.0 );
                             painter.setCompositionMode( QPainter::CompositionMode_Lighten );
@@ -1294,21 +1401,7 @@ void ScribbleArea::updateCanvas( int frame, QRect rect )
                         bitmapImage->paintImage( painter );
                         painter.setClipping( false );
                         // transforms the bitmap selection
-                        bool smoothTransform = false;
-
-                        if ( myTempTransformedSelection.width() != mySelection.width() || myTempTransformedSelection.height() != mySelection.height() || myRotatedAngle != 0 ) { smoothTransform = true; }
-                        BitmapImage selectionClip = bitmapImage->copy( mySelection.toRect() );
-                        selectionClip.transform( myTransformedSelection, smoothTransform );
-                        QMatrix rm;
-                        //TODO: complete matrix calls ( sounds funny :)
-                        rm.scale( myFlipX, myFlipY );
-                        rm.rotate( myRotatedAngle );
-                        QImage rotImg = selectionClip.image->transformed( rm );
-                        QPoint dxy = QPoint( ( myTempTransformedSelection.width() - rotImg.rect().width() ) / 2,
-                                             ( myTempTransformedSelection.height() - rotImg.rect().height() ) / 2 );
-                        *selectionClip.image = rotImg; // TODO: find/create a func. (*object = data is not very orthodox)
-                        selectionClip.boundaries.translate( dxy );
-                        selectionClip.paintImage( painter );
+                        drawTransformedBitmapSelection( painter, bitmapImage );
                         //painter.drawImage(selectionClip.topLeft(), *(selectionClip.image));
                     }
                     else
@@ -1333,14 +1426,13 @@ void ScribbleArea::updateCanvas( int frame, QRect rect )
                     vectorImage->setSelectionTransformation( selectionTransformation );
                     //vectorImage->setTransformedSelection(myTempTransformedSelection);
                 }
-                QImage* image = layerVector->getLastImageAtFrame( frame, 0, sz,
-                                                                  m_isSimplified, m_showThinLines,
-                                                                  curveOpacity, m_antialiasing );
-                if ( image != NULL )
+                if ( vectorImage != NULL )
                 {
                     painter.setWorldMatrixEnabled( false );
                     painter.setOpacity( opacity );
-                    painter.drawImage( QPoint( 0, 0 ), *image );
+                    layerVector->paintImageAtFrame( painter, frame, 0,
+                                                    m_isSimplified, m_showThinLines,
+                                                    curveOpacity, m_antialiasing );
                 }
             }
         }
@@ -1457,10 +1549,18 @@ void ScribbleArea::drawBrush( QPointF thePoint, qreal brushWidth, qreal offset,
     }
     else
     {
-        tempBitmapImage = new BitmapImage( NULL );
-        tempBitmapImage->drawRect( rectangle, Qt::NoPen, radialGrad, QPainter::CompositionMode_Source, m_antialiasing );
+        // drawn in the stroke renderer thread
+        delete tempBitmapImage;
+        BrushDab dab;
+        dab.rect = rectangle;
+        dab.gradient = radialGrad;
+        dab.antialiasing = m_antialiasing;
+        m_strokeRenderer->drawDab( dab );
+        return;
     }
 
+    // reads the drawing, so it is drawn here after the dabs queued before
+    m_strokeRenderer->finish( bufferImg );
     bufferImg->paste( tempBitmapImage );
     delete tempBitmapImage;
 }
@@ -1814,6 +1914,49 @@ void ScribbleArea::calculateSelectionTransformation() // Vector layer transform
     //modification();
 }
 
+QMatrix ScribbleArea::bitmapSelectionTransform() const
+{
+    qreal scaleX = ( mySelection.width() == 0 ) ? 1.0 : myTempTransformedSelection.width() / mySelection.width();
+    qreal scaleY = ( mySelection.height() == 0 ) ? 1.0 : myTempTransformedSelection.height() / mySelection.height();
+    QMatrix matrix;
+    matrix.translate( myTempTransformedSelection.center().x(), myTempTransformedSelection.center().y() );
+    matrix.scale( myFlipX, myFlipY );
+    matrix.rotate( myRotatedAngle );
+    matrix.scale( scaleX, scaleY );
+    matrix.translate( -mySelection.center().x(), -mySelection.center().y() );
+    return matrix;
+}
+
+void ScribbleArea::drawTransformedBitmapSelection( QPainter& painter, BitmapImage* bitmapImage )
+{
+    // the original pixels stay untouched while the selection is transformed
+    QRect sourceRect = mySelection.toRect();
+    if ( selectionSource.isNull() || bitmapImage->image->cacheKey() != selectionSourceKey || sourceRect != selectionSourceRect )
+    {
+        selectionSource = *bitmapImage->copy( sourceRect ).image;
+        selectionSourceKey = bitmapImage->image->cacheKey();
+        selectionSourceRect = sourceRect;
+    }
+
+    QMatrix matrix = bitmapSelectionTransform();
+    bool moveOnly = matrix.m12() == 0 && matrix.m21() == 0 && qAbs( matrix.m11() ) == 1.0 && qAbs( matrix.m22() ) == 1.0;
+    if ( moveOnly )
+    {
+        // whole pixels, so that a moved selection stays sharp
+        matrix.setMatrix( matrix.m11(), 0, 0, matrix.m22(), qRound( matrix.dx() ), qRound( matrix.dy() ) );
+    }
+
+    // zoomed out, the pixels are drawn from the averaged ones of a smaller copy
+    int level = moveOnly ? 0 : BitmapMipmaps::levelFor( sqrt( qAbs( ( matrix * painter.worldMatrix() ).determinant() ) ) );
+    QImage image = selectionMipmaps.image( selectionSource, &level );
+
+    painter.save();
+    painter.setWorldMatrix( QMatrix().translate( sourceRect.left(), sourceRect.top() ).scale( 1 << level, 1 << level ) * matrix, true );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform, !moveOnly );
+    painter.drawImage( 0, 0, image );
+    painter.restore();
+}
+
 void ScribbleArea::paintTransformedSelection()
 {
     Layer *layer = m_pEditor->getCurrentLayer();
@@ -1836,18 +1979,17 @@ void ScribbleArea::paintTransformedSelection()
                 return;
             }
 
-            bool smoothTransform = false;
-            if ( myTransformedSelection.width() != mySelection.width() || myTransformedSelection.height() != mySelection.height() || m_moveMode == ROTATION ) { smoothTransform = true; }
-            QMatrix rm;
-            rm.scale( myFlipX, myFlipY );
-            rm.rotate( myRotatedAngle );
-            BitmapImage selectionClip = bitmapImage->copy( mySelection.toRect() );
-            selectionClip.transform( myTransformedSelection, smoothTransform );
-            QImage rotImg = selectionClip.image->transformed( rm, Qt::SmoothTransformation );
-            QPoint dxy = QPoint( ( myTempTransformedSelection.width() - rotImg.rect().width() ) / 2,
-                                 ( myTempTransformedSelection.height() - rotImg.rect().height() ) / 2 );
-            *selectionClip.image = rotImg; // TODO: find/create a func. (*object = data is not very orthodox)
-            selectionClip.boundaries.translate( dxy );
+            // the pixels are resampled once, from the original ones
+            QRect target = bitmapSelectionTransform().mapRect( mySelection ).toAlignedRect();
+            BitmapImage selectionClip( NULL, target, QColor( 0, 0, 0, 0 ) );
+            QPainter painter( selectionClip.image );
+            painter.translate( -target.topLeft() );
+            drawTransformedBitmapSelection( painter, bitmapImage );
+            painter.end();
+            selectionSource = QImage();
+            selectionSourceKey = 0;
+            selectionMipmaps.clear();
+
             bitmapImage->clear( mySelection.toRect() );
             bitmapImage->paste( &selectionClip );
         }
@@ -2010,6 +2152,28 @@ void ScribbleArea::toggleGridB( bool checked )
 }
 
 void ScribbleArea::floodFill( VectorImage *vectorImage, QPoint point, QRgb targetColour, QRgb replacementColour, int tolerance )
+{
+    PERF_SCOPE( "ScribbleArea::floodFill" );
+    bool invertible;
+
+    QPointF initialPoint = myTempView.inverted( &invertible ).map( QPointF( point ) );
+    qreal tol2 = 1.5 / qAbs( myTempView.m11() ); // tolerance for connecting vertices from different curves
+
+    // finds the closed loop of curves around the point, without rasterizing anything
+    QList<VertexRef> contour = vectorImage->getContourAt( initialPoint, tol2 );
+    if ( !contour.isEmpty() )
+    {
+        vectorImage->addArea( BezierArea( contour, m_pEditor->colorManager()->frontColorNumber() ) );
+        deselectAll();
+        update();
+        return;
+    }
+
+    // the curves don't enclose the point (there may be small gaps between them): pixel-based search
+    floodFillRaster( vectorImage, point, targetColour, replacementColour, tolerance );
+}
+
+void ScribbleArea::floodFillRaster( VectorImage *vectorImage, QPoint point, QRgb targetColour, QRgb replacementColour, int tolerance )
 {
     bool invertible;
 
@@ -2322,6 +2486,7 @@ void ScribbleArea::floodFill( VectorImage *vectorImage, QPoint point, QRgb targe
     QMessageBox::warning(this, tr("My Application"), tr("all the tree points"), QMessageBox::Ok, QMessageBox::Ok);
     }*/
     delete targetImage;
+    delete replaceImage;
     update();
 }
 
@@ -22,8 +22,10 @@ GNU General Public License for more details.
 #include <QWidget>
 #include <QFrame>
 #include <QHash>
+#include <QRegion>
 #include "vectorimage.h"
 #include "bitmapimage.h"
+#include "bitmapmipmaps.h"
 #include "colourref.h"
 #include "vectorselection.h"
 #include "basetool.h"
@@ -32,6 +34,7 @@ GNU General Public License for more details.
 class Editor;
 class Layer;
 class StrokeManager;
+class StrokeRenderer;
 class BaseTool;
 class ColorManager;
 class PopupColorPaletteWidget;
@@ -92,7 +95,6 @@ public:
 
     void updateFrame();
     void updateFrame( int frame );
-    void updateAllFrames();
     void updateAllVectorLayersAtCurrentFrame();
     void updateAllVectorLayersAt( int frame );
     void updateAllVectorLayers();
@@ -100,6 +102,10 @@ public:
     bool shouldUpdateAll() const { return updateAll; }
     void setAllDirty() { updateAll = true; }
 
+    // the part of the drawing a tool has changed, in canvas coordinates;
+    // only that part of the cached canvases is composited again
+    void addDamage( const QRectF& rect );
+
     BaseTool* currentTool();
     BaseTool* getTool( ToolType eToolMode );
     void setCurrentTool( ToolType eToolMode );
@@ -133,6 +139,7 @@ public slots:
     void calculateSelectionTransformation();
     void paintTransformedSelection();
     void setModified( int layerNumber, int frameNumber );
+    void setModified( int layerNumber, int frameNumber, const QRectF& rect );
 
     void selectAll();
     void deselectAll();
@@ -172,9 +179,14 @@ public slots:
 
     void toggleMultiLayerOnionSkin( bool );
     void togglePopupPalette();
+    void togglePerfOverlay( bool ); // timings of the profiling build, see PerfMonitor
 
 public slots:
     void updateToolCursor();
+    void updateAllFrames();
+
+private slots:
+    void strokeRendered( QRectF rect );
 
 protected:
     void tabletEvent( QTabletEvent *event );
@@ -211,8 +223,15 @@ public:
     void setGaussianGradient( QGradient &gradient, QColor colour, qreal opacity, qreal offset );
 
 protected:
-    void updateCanvas( int frame, QRect rect );
+    void updateCanvas( int frame, const QRegion& region );
 
+    // the moved, scaled, rotated and flipped bitmap selection, drawn from a cached copy of the original pixels
+    QMatrix bitmapSelectionTransform() const;
+    void drawTransformedBitmapSelection( QPainter& painter, BitmapImage* bitmapImage );
+
+    void drawPerfOverlay( QPainter& painter );
+
+    void floodFillRaster( VectorImage *vectorImage, QPoint point, QRgb targetColour, QRgb replacementColour, int tolerance );
     void floodFillError( int errorType );
 
     MoveMode m_moveMode;
@@ -220,6 +239,7 @@ protected:
     ToolType prevToolType; // previous tool (except temporal)
 
     StrokeManager *m_strokeManager;
+    StrokeRenderer *m_strokeRenderer; // draws the brush dabs in a thread of its own
 
     Editor *m_pEditor;
 
@@ -243,8 +263,10 @@ protected:
     QColor onionColor;
 
     bool updateAll;
+    QHash<int, QRegion> m_frameDamage; // changed parts of each cached canvas, in canvas coordinates
 
     bool followContour;
+    bool m_showPerfOverlay;
 
     bool useGridA;
     bool useGridB;
@@ -269,6 +291,11 @@ private:
     VectorSelection vectorSelection;
     QMatrix selectionTransformation;
 
+    QImage selectionSource;           // the selected pixels, as they were before the transformation
+    qint64 selectionSourceKey;        // cacheKey of the bitmap image they were copied from
+    QRect selectionSourceRect;
+    BitmapMipmaps selectionMipmaps;
+
     QMatrix myView, myTempView, centralView, transMatrix;
     QPixmap canvas;
 
@@ -1,7 +1,6 @@
 #include <QDebug>
 #include <QMap>
 #include <QStringRef>
-#include <QSettings>
 #include <QGroupBox>
 #include <QVBoxLayout>
 #include <QLabel>
@@ -78,10 +77,9 @@ void ShortcutsPage::keyCapLineEditTextChanged(QKeySequence keySeqence)
     QString strCmdName = QString("Cmd%1").arg( actionItem->text() );
     QString strKeySeq  = keySeqence.toString( QKeySequence::PortableText );
 
-    QSettings setting("Pencil", "Pencil");
-    setting.beginGroup("shortcuts");
+    PencilSettings* settings = pencilSettings();
 
-    if (isKeySequenceExist(setting, strCmdName, keySeqence))
+    if (isKeySequenceExist(settings, strCmdName, keySeqence))
     {
         QMessageBox msgBox;
         msgBox.setText("Shortcut Conflict!");
@@ -97,12 +95,10 @@ void ShortcutsPage::keyCapLineEditTextChanged(QKeySequence keySeqence)
             ui->keySeqLineEdit->setText( keyseqItem->text() );
             return;
         }
-        removeDuplicateKeySequence(&setting, keySeqence);
+        removeDuplicateKeySequence(settings, keySeqence);
     }
 
-    setting.setValue(strCmdName, strKeySeq);
-    setting.endGroup();
-    setting.sync();
+    settings->setValue(QString(SHORTCUTS_GROUP) + "/" + strCmdName, strKeySeq);
 
     treeModelLoadShortcutsSetting();
 
@@ -115,16 +111,16 @@ void ShortcutsPage::restoreShortcutsButtonClicked()
     treeModelLoadShortcutsSetting();
 }
 
-bool ShortcutsPage::isKeySequenceExist(const QSettings& settings, QString strTargetCmdName, QKeySequence targetkeySeq)
+bool ShortcutsPage::isKeySequenceExist(const PencilSettings* settings, QString strTargetCmdName, QKeySequence targetkeySeq)
 {
-    foreach (QString strCmdName, settings.allKeys())
+    foreach (QString strCmdName, settings->allKeys(SHORTCUTS_GROUP))
     {
         if (strTargetCmdName == strCmdName)
         {
             continue;
         }
 
-        QString strCmdKeySeq = settings.value(strCmdName).toString();
+        QString strCmdKeySeq = settings->value(QString(SHORTCUTS_GROUP) + "/" + strCmdName).toString();
         /*
         qDebug() << "Compare:"
         << QKeySequence(strCmdKeySeq).toString()
@@ -139,15 +135,15 @@ bool ShortcutsPage::isKeySequenceExist(const QSettings& settings, QString strTar
     return false;
 }
 
-void ShortcutsPage::removeDuplicateKeySequence(QSettings* settings, QKeySequence keySeq)
+void ShortcutsPage::removeDuplicateKeySequence(PencilSettings* settings, QKeySequence keySeq)
 {
-    foreach(QString strCmdName, settings->allKeys())
+    foreach(QString strCmdName, settings->allKeys(SHORTCUTS_GROUP))
     {
-        QString strCmdKeySeq = settings->value(strCmdName).toString();
+        QString strCmdKeySeq = settings->value(QString(SHORTCUTS_GROUP) + "/" + strCmdName).toString();
 
         if ( strCmdKeySeq == keySeq.toString(QKeySequence::PortableText))
         {
-            settings->setValue(strCmdName, "");
+            settings->setValue(QString(SHORTCUTS_GROUP) + "/" + strCmdName, "");
         }
     }
 }
@@ -155,18 +151,17 @@ void ShortcutsPage::removeDuplicateKeySequence(QSettings* settings, QKeySequence
 void ShortcutsPage::treeModelLoadShortcutsSetting()
 {
     // Load shortcuts from settings
-    QSettings settings("Pencil", "Pencil");
-    settings.beginGroup("shortcuts");
+    QStringList commands = pencilSettings()->allKeys(SHORTCUTS_GROUP);
 
     m_treeModel->clear(); // release all existing items.
 
-    m_treeModel->setRowCount( settings.allKeys().size() );
+    m_treeModel->setRowCount( commands.size() );
     m_treeModel->setColumnCount( 2 );
 
     int row = 0;
-    foreach (QString strCmdName, settings.allKeys())
+    foreach (QString strCmdName, commands)
     {
-        QString strKeySequence = settings.value(strCmdName).toString();
+        QString strKeySequence = pencilSettings()->value(QString(SHORTCUTS_GROUP) + "/" + strCmdName).toString();
 
         //convert to native format
         strKeySequence = QKeySequence(strKeySequence).toString( QKeySequence::NativeText );
@@ -185,7 +180,6 @@ void ShortcutsPage::treeModelLoadShortcutsSetting()
 
         row++;
     }
-    settings.endGroup();
 
     ui->treeView->resizeColumnToContents( 0 );
 }
@@ -202,9 +196,7 @@ void ShortcutsPage::clearButtonClicked()
 
     QString strCmdName = QString("shortcuts/Cmd%1").arg( actionItem->text() );
 
-    QSettings setting("Pencil", "Pencil");
-    setting.setValue( strCmdName, "" );
-    setting.sync();
+    pencilSettings()->setValue( strCmdName, "" );
 
     ui->keySeqLineEdit->setText("");
 
@@ -4,13 +4,13 @@
 #include <QWidget>
 #include <QModelIndex>
 #include <QKeySequence>
-#include <QSettings>
 
 class QTreeView;
 class QStandardItem;
 class QStandardItemModel;
 class QLabel;
 class QLineEdit;
+class PencilSettings;
 
 
 namespace Ui
@@ -33,8 +33,8 @@ private slots:
     void clearButtonClicked();
 
 private:
-    bool isKeySequenceExist(const QSettings&, QString, QKeySequence);
-    void removeDuplicateKeySequence(QSettings*, QKeySequence);
+    bool isKeySequenceExist(const PencilSettings*, QString, QKeySequence);
+    void removeDuplicateKeySequence(PencilSettings*, QKeySequence);
     void treeModelLoadShortcutsSetting();
 
     QStandardItemModel* m_treeModel;
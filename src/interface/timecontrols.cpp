@@ -16,13 +16,14 @@ GNU General Public License for more details.
 
 #include <QtGui>
 #include <QLabel>
+#include "pencilsettings.h"
 #include "timecontrols.h"
 
 
 TimeControls::TimeControls(QWidget* parent) : QToolBar(parent)
 {
 
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
 
     //QFrame* frame = new QFrame();
 
@@ -30,7 +31,7 @@ TimeControls::TimeControls(QWidget* parent) : QToolBar(parent)
     //fpsBox->setFixedWidth(50);
     fpsBox->setFont( QFont("Helvetica", 10) );
     fpsBox->setFixedHeight(22);
-    fpsBox->setValue(settings.value("fps").toInt());
+    fpsBox->setValue(settings->value("fps").toInt());
     fpsBox->setMinimum(1);
     fpsBox->setMaximum(50);
     fpsBox->setToolTip("Frames per second");
@@ -39,7 +40,7 @@ TimeControls::TimeControls(QWidget* parent) : QToolBar(parent)
     loopStart = new QSpinBox();
     loopStart->setFont( QFont("Helvetica", 10) );
     loopStart->setFixedHeight(22);
-    loopStart->setValue(settings.value("loopStart").toInt());
+    loopStart->setValue(settings->value("loopStart").toInt());
     loopStart->setMinimum(1);
     loopStart->setToolTip(tr("Start of loop"));
     loopStart->setFocusPolicy(Qt::NoFocus);
@@ -47,7 +48,7 @@ TimeControls::TimeControls(QWidget* parent) : QToolBar(parent)
     loopEnd= new QSpinBox();
     loopEnd->setFont( QFont("Helvetica", 10) );
     loopEnd->setFixedHeight(22);
-    loopEnd->setValue(settings.value("loopEnd").toInt());
+    loopEnd->setValue(settings->value("loopEnd").toInt());
     loopEnd->setMinimum(2);
     loopEnd->setToolTip(tr("End of loop"));
     loopEnd->setFocusPolicy(Qt::NoFocus);
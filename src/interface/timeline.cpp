@@ -27,6 +27,9 @@ GNU General Public License for more details.
 #include "toolbox.h"
 #include "timecontrols.h"
 #include "timelinecells.h"
+#include "soundwaveform.h"
+#include "thumbnailcache.h"
+#include "pencilsettings.h"
 #include "timeline.h"
 
 TimeLine::TimeLine(QWidget* parent, Editor* editor) : QDockWidget(parent, Qt::Tool)
@@ -176,6 +179,8 @@ TimeLine::TimeLine(QWidget* parent, Editor* editor) : QDockWidget(parent, Qt::To
     connect(hScrollBar,SIGNAL(valueChanged(int)), cells, SLOT(hScrollChange(int)));
     connect(vScrollBar,SIGNAL(valueChanged(int)), cells, SLOT(vScrollChange(int)));
     connect(vScrollBar,SIGNAL(valueChanged(int)), list, SLOT(vScrollChange(int)));
+    connect(SoundWaveformCache::instance(), SIGNAL(waveformReady()), cells, SLOT(tracksChanged()));
+    connect(ThumbnailCache::instance(), SIGNAL(thumbnailsReady()), cells, SLOT(tracksChanged()));
 
     connect(addKeyButton, SIGNAL(clicked()), this, SIGNAL(addKeyClick()));
     connect(removeKeyButton, SIGNAL(clicked()), this, SIGNAL(removeKeyClick()));
@@ -261,8 +266,8 @@ void TimeLine::forceUpdateLength(QString newLength)
     {
         updateLength(dec);
         updateContent();
-        QSettings settings("Pencil","Pencil");
-        settings.setValue("length", dec);
+        PencilSettings* settings = pencilSettings();
+        settings->setValue("length", dec);
     }
 }
 
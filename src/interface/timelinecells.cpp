@@ -1,6 +1,6 @@
 #include "timelinecells.h"
 
-#include <QSettings>
+#include "pencilsettings.h"
 #include "editor.h"
 #include "timeline.h"
 #include "layermanager.h"
@@ -13,15 +13,15 @@ TimeLineCells::TimeLineCells( TimeLine* parent, Editor* editor, TIMELINE_CELL_TY
     m_eType = type;
 
     cache = NULL;
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
 
-    frameLength = settings.value( "length" ).toInt();
+    frameLength = settings->value( "length" ).toInt();
     if ( frameLength == 0 )
     {
-        frameLength = 240; settings.setValue( "length", frameLength );
+        frameLength = 240; settings->setValue( "length", frameLength );
     }
 
-    shortScrub = settings.value( "shortScrub" ).toBool();
+    shortScrub = settings->value( "shortScrub" ).toBool();
 
     startY = 0;
     endY = 0;
@@ -29,19 +29,25 @@ TimeLineCells::TimeLineCells( TimeLine* parent, Editor* editor, TIMELINE_CELL_TY
     startLayerNumber = -1;
     frameOffset = 0;
     layerOffset = 0;
+    m_trackFrameOffset = -1;
+    m_trackFrameSize = -1;
+    m_trackFps = -1;
 
-    frameSize = ( settings.value( "frameSize" ).toInt() );
-    if ( frameSize == 0 ) { frameSize = 12; settings.setValue( "frameSize", frameSize ); }
+    frameSize = settings->intValue( "frameSize" );
+    if ( frameSize == 0 ) { frameSize = 12; settings->setValue( "frameSize", frameSize ); }
 
-    fontSize = ( settings.value( "labelFontSize" ).toInt() );
-    if ( fontSize == 0 ) { fontSize = 12; settings.setValue( "labelFontSize", fontSize ); }
+    fontSize = settings->intValue( "labelFontSize" );
+    if ( fontSize == 0 ) { fontSize = 12; settings->setValue( "labelFontSize", fontSize ); }
 
-    layerHeight = ( settings.value( "layerHeight" ).toInt() );
-    if ( layerHeight == 0 ) { layerHeight = 20; settings.setValue( "layerHeight", layerHeight ); }
+    layerHeight = settings->intValue( "layerHeight" );
+    if ( layerHeight == 0 ) { layerHeight = 20; settings->setValue( "layerHeight", layerHeight ); }
 
     setMinimumSize( 500, 4 * layerHeight );
     setSizePolicy( QSizePolicy( QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding ) );
     setAttribute( Qt::WA_OpaquePaintEvent, false );
+
+    connect( editor, SIGNAL( layerChanged( Layer* ) ), this, SLOT( layerChanged( Layer* ) ) );
+    connect( settings, SIGNAL( valueChanged( QString, QVariant ) ), this, SLOT( settingChanged( QString ) ) );
 }
 
 int TimeLineCells::getFrameNumber( int x )
@@ -51,6 +57,11 @@ int TimeLineCells::getFrameNumber( int x )
     return frameNumber;
 }
 
+int TimeLineCells::getFps()
+{
+    return editor->fps;
+}
+
 int TimeLineCells::getFrameX( int frameNumber )
 {
     int x = m_offsetX + ( frameNumber - frameOffset )*frameSize;
@@ -91,6 +102,25 @@ void TimeLineCells::updateContent()
     update();
 }
 
+void TimeLineCells::layerChanged( Layer* layer )
+{
+    for ( int i = 0; i < m_trackRows.size(); i++ )
+    {
+        if ( layer == NULL || m_trackRows[ i ].layer == layer )
+        {
+            m_trackRows[ i ].dirty = true;
+        }
+    }
+    update();
+}
+
+// thumbnails and waveforms arrive in the background, for any layer
+void TimeLineCells::tracksChanged()
+{
+    layerChanged( NULL );
+    updateContent();
+}
+
 void TimeLineCells::drawContent()
 {
     if ( cache == NULL ) { cache = new QPixmap( size() ); }
@@ -108,54 +138,44 @@ void TimeLineCells::drawContent()
     painter.setBrush( Qt::lightGray );
     painter.drawRect( QRect( 0, 0, width(), height() ) );
 
+    // the rows are drawn again after a scroll, a zoom or a change of frame rate
+    if ( frameOffset != m_trackFrameOffset || frameSize != m_trackFrameSize || editor->fps != m_trackFps )
+    {
+        for ( int i = 0; i < m_trackRows.size(); i++ )
+        {
+            m_trackRows[ i ].dirty = true;
+        }
+        m_trackFrameOffset = frameOffset;
+        m_trackFrameSize = frameSize;
+        m_trackFps = editor->fps;
+    }
+
     // --- draw layers of the current object
+    int currentLayerIndex = editor->layerManager()->currentLayerIndex();
     for ( int i = 0; i < object->getLayerCount(); i++ )
     {
-        if ( i != editor->layerManager()->currentLayerIndex() )
+        if ( i != currentLayerIndex )
         {
             Layer* layeri = object->getLayer( i );
             if ( layeri != NULL )
             {
-                switch ( m_eType )
-                {
-                case TIMELINE_CELL_TYPE::Tracks:
-                    layeri->paintTrack( painter, this, m_offsetX,
-                                        getLayerY( i ), width() - m_offsetX,
-                                        getLayerHeight(), false, frameSize );
-                    break;
-
-                case TIMELINE_CELL_TYPE::Layers:
-                    layeri->paintLabel( painter, this, 0,
-                                        getLayerY( i ), width() - 1,
-                                        getLayerHeight(), false, editor->allLayers() );
-                    break;
-                }
+                drawLayer( painter, layeri, i, getLayerY( i ), false );
             }
         }
     }
     if ( abs( getMouseMoveY() ) > 5 )
     {
-        if ( m_eType == TIMELINE_CELL_TYPE::Tracks )
-        {
-            layer->paintTrack( painter, this, m_offsetX, getLayerY( editor->layerManager()->currentLayerIndex() ) + getMouseMoveY(), width() - m_offsetX, getLayerHeight(), true, frameSize );
-        }
-        if ( m_eType == TIMELINE_CELL_TYPE::Layers )
-        {
-            layer->paintLabel( painter, this, 0, getLayerY( editor->layerManager()->currentLayerIndex() ) + getMouseMoveY(), width() - 1, getLayerHeight(), true, editor->allLayers() );
-        }
+        drawLayer( painter, layer, currentLayerIndex, getLayerY( currentLayerIndex ) + getMouseMoveY(), true );
         painter.setPen( Qt::black );
         painter.drawRect( 0, getLayerY( getLayerNumber( endY ) ) - 1, width(), 2 );
     }
     else
     {
-        if ( m_eType == TIMELINE_CELL_TYPE::Tracks )
-        {
-            layer->paintTrack( painter, this, m_offsetX, getLayerY( editor->layerManager()->currentLayerIndex() ), width() - m_offsetX, getLayerHeight(), true, frameSize );
-        }
-        if ( m_eType == TIMELINE_CELL_TYPE::Layers )
-        {
-            layer->paintLabel( painter, this, 0, getLayerY( editor->layerManager()->currentLayerIndex() ), width() - 1, getLayerHeight(), true, editor->allLayers() );
-        }
+        drawLayer( painter, layer, currentLayerIndex, getLayerY( currentLayerIndex ), true );
+    }
+    if ( m_trackRows.size() > object->getLayerCount() )
+    {
+        m_trackRows.resize( object->getLayerCount() );
     }
 
     // --- draw top
@@ -216,6 +236,40 @@ void TimeLineCells::drawContent()
     }
 }
 
+void TimeLineCells::drawLayer( QPainter& painter, Layer* layer, int layerNumber, int y, bool selected )
+{
+    // rows scrolled out of view are not drawn at all
+    if ( y + layerHeight < m_offsetY || y > height() )
+    {
+        return;
+    }
+
+    if ( m_eType == TIMELINE_CELL_TYPE::Layers )
+    {
+        layer->paintLabel( painter, this, 0, y, width() - 1, getLayerHeight(), selected, editor->allLayers() );
+        return;
+    }
+
+    // tracks are kept as one pixmap per layer, repainted once the layer has reported a change
+    if ( m_trackRows.size() <= layerNumber )
+    {
+        m_trackRows.resize( layerNumber + 1 );
+    }
+    TrackRow& row = m_trackRows[ layerNumber ];
+    QSize rowSize( width(), layerHeight + 1 );
+    if ( row.dirty || row.layer != layer || row.selected != selected || row.pixmap.size() != rowSize )
+    {
+        row.pixmap = QPixmap( rowSize );
+        row.pixmap.fill( Qt::lightGray );
+        QPainter rowPainter( &row.pixmap );
+        layer->paintTrack( rowPainter, this, m_offsetX, 1, width() - m_offsetX, getLayerHeight(), selected, frameSize );
+        row.layer = layer;
+        row.selected = selected;
+        row.dirty = false;
+    }
+    painter.drawPixmap( 0, y - 1, row.pixmap );
+}
+
 void TimeLineCells::paintEvent( QPaintEvent* event )
 {
     Q_UNUSED( event );
@@ -323,7 +377,7 @@ void TimeLineCells::mousePressEvent( QMouseEvent* event )
             {
                 if ( frameNumber > 0 )
                 {
-                    editor->scrubTo( frameNumber );
+                    editor->scrubWithSound( frameNumber );
                     timeLine->scrubbing = true;
                 }
             }
@@ -346,7 +400,7 @@ void TimeLineCells::mouseMoveEvent( QMouseEvent* event )
     {
         if ( timeLine->scrubbing )
         {
-            editor->scrubTo( frameNumber );
+            editor->scrubWithSound( frameNumber );
         }
         else
         {
@@ -410,39 +464,39 @@ void TimeLineCells::mouseDoubleClickEvent( QMouseEvent* event )
 void TimeLineCells::fontSizeChange( int x )
 {
     fontSize = x;
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "labelFontSize", x );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "labelFontSize", x );
     updateContent();
 }
 
 void TimeLineCells::frameSizeChange( int x )
 {
     frameSize = x;
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "frameSize", x );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "frameSize", x );
     updateContent();
 }
 
 void TimeLineCells::scrubChange( int x )
 {
-    QSettings settings( "Pencil", "Pencil" );
-    if ( x == 0 ) { shortScrub = false; settings.setValue( "shortScrub", "false" ); }
-    else { shortScrub = true; settings.setValue( "shortScrub", "true" ); }
+    PencilSettings* settings = pencilSettings();
+    if ( x == 0 ) { shortScrub = false; settings->setValue( "shortScrub", "false" ); }
+    else { shortScrub = true; settings->setValue( "shortScrub", "true" ); }
     update();
 }
 
 void TimeLineCells::labelChange( int x )
 {
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
     if ( x == 0 )
     {
         drawFrameNumber = false;
-        settings.setValue( "drawLabel", "false" );
+        settings->setValue( "drawLabel", "false" );
     }
     else
     {
         drawFrameNumber = true;
-        settings.setValue( "drawLabel", "true" );
+        settings->setValue( "drawLabel", "true" );
     }
     updateContent();
 }
@@ -454,8 +508,40 @@ void TimeLineCells::lengthChange( QString x )
     frameLength = dec;
     timeLine->updateLength( frameLength );
     updateContent();
-    QSettings settings( "Pencil", "Pencil" );
-    settings.setValue( "length", dec );
+    PencilSettings* settings = pencilSettings();
+    settings->setValue( "length", dec );
+}
+
+// the sizes read in the constructor follow the preferences, whoever changes them
+void TimeLineCells::settingChanged( const QString& key )
+{
+    PencilSettings* settings = pencilSettings();
+    int x = settings->intValue( key );
+    if ( key == "frameSize" && x > 0 && x != frameSize )
+    {
+        frameSize = x;
+        updateContent();
+    }
+    else if ( key == "labelFontSize" && x > 0 && x != fontSize )
+    {
+        fontSize = x;
+        updateContent();
+    }
+    else if ( key == "layerHeight" && x > 0 && x != layerHeight )
+    {
+        layerHeight = x;
+        updateContent();
+    }
+    else if ( key == "shortScrub" )
+    {
+        shortScrub = settings->boolValue( key );
+        update();
+    }
+    else if ( key == "drawLabel" && drawFrameNumber != settings->boolValue( key ) )
+    {
+        drawFrameNumber = settings->boolValue( key );
+        updateContent();
+    }
 }
 
 void TimeLineCells::hScrollChange( int x )
@@ -3,6 +3,8 @@
 
 #include <QWidget>
 #include <QString>
+#include <QPixmap>
+#include <QVector>
 
 
 class TimeLine;
@@ -10,6 +12,8 @@ class QPaintEvent;
 class QMouseEvent;
 class QResizeEvent;
 class Editor;
+class Layer;
+class QPainter;
 
 enum class TIMELINE_CELL_TYPE
 {
@@ -31,6 +35,7 @@ public:
     int getOffsetY() { return m_offsetY; }
     int getLayerHeight() { return layerHeight; }
     int getFrameLength() {return frameLength;}
+    int getFps();
 
 signals:
     void mouseMovedY(int);
@@ -46,9 +51,13 @@ public slots:
     void hScrollChange(int);
     void vScrollChange(int);
     void setMouseMoveY(int x) { mouseMoveY = x;}
+    void layerChanged(Layer* layer);
+    void tracksChanged();
+    void settingChanged(const QString& key);
 
 protected:
     void drawContent();
+    void drawLayer(QPainter& painter, Layer* layer, int layerNumber, int y, bool selected);
     void paintEvent(QPaintEvent* event);
     void resizeEvent(QResizeEvent* event);
     void mousePressEvent(QMouseEvent* event);
@@ -75,6 +84,20 @@ private:
     int startY, endY, startLayerNumber;
     int mouseMoveY;
     int frameOffset, layerOffset;
+
+    struct TrackRow
+    {
+        TrackRow() : layer( NULL ), selected( false ), dirty( true ) {}
+        QPixmap pixmap;
+        Layer* layer;
+        bool selected;
+        bool dirty; // set when the layer reports a change
+    };
+    QVector<TrackRow> m_trackRows; // one per layer
+    // the view the rows were drawn for
+    int m_trackFrameOffset;
+    int m_trackFrameSize;
+    int m_trackFps;
 };
 
 #endif // TIMELINECELLS_H
@@ -3,7 +3,7 @@
 #include <QToolButton>
 #include <QCheckBox>
 #include <QGridLayout>
-#include <QSettings>
+#include "pencilsettings.h"
 #include <QDebug>
 #include "spinslider.h"
 #include "toolmanager.h"
@@ -24,14 +24,14 @@ void ToolOptionWidget::createUI()
     pLayout->setMargin( 8 );
     pLayout->setSpacing( 8 );
 
-    QSettings settings( "Pencil", "Pencil" );
+    PencilSettings* settings = pencilSettings();
 
     sizeSlider = new SpinSlider( tr( "Size" ), "log", "real", 0.2, 200.0, this );
-    sizeSlider->setValue( settings.value( "pencilWidth" ).toDouble() );
+    sizeSlider->setValue( settings->value( "pencilWidth" ).toDouble() );
     sizeSlider->setToolTip( tr( "Set Pen Width <br><b>[SHIFT]+drag</b><br>for quick adjustment" ) );
 
     featherSlider = new SpinSlider( tr( "Feather" ), "log", "real", 0.2, 200.0, this );
-    featherSlider->setValue( settings.value( "pencilFeather" ).toDouble() );
+    featherSlider->setValue( settings->value( "pencilFeather" ).toDouble() );
     featherSlider->setToolTip( tr( "Set Pen Feather <br><b>[CTRL]+drag</b><br>for quick adjustment" ) );
 
     usePressureBox = new QCheckBox( tr( "Pressure" ) );
@@ -15,15 +15,41 @@ GNU General Public License for more details.
 */
 #include <QApplication>
 #include <QDir>
+#include <QTextStream>
 #include "pencildef.h"
+#include "pencilsettings.h"
 #include "editor.h"
 #include "mainwindow2.h"
+#include "projectgenerator.h"
+#include "batchrenderer.h"
 
 void initialise();
+int generateProject(QStringList arguments);
+int renderProjects(QStringList arguments);
+int mergeShards(QStringList arguments);
 
 
 int main(int argc, char* argv[])
 {   
+    // builds a project for benchmarks and stress tests, without any window
+    if (argc > 1 && QString(argv[1]) == QString("--generate-project"))
+    {
+        QCoreApplication app(argc, argv);
+        return generateProject(app.arguments());
+    }
+    // renders frames of saved projects, without any window or display
+    if (argc > 1 && QString(argv[1]) == QString("--render"))
+    {
+        QCoreApplication app(argc, argv);
+        return renderProjects(app.arguments());
+    }
+    // puts together the frames rendered by the shards of a job
+    if (argc > 1 && QString(argv[1]) == QString("--merge"))
+    {
+        QCoreApplication app(argc, argv);
+        return mergeShards(app.arguments());
+    }
+
     QApplication app(argc, argv);
     app.setApplicationName("Pencil");
 
@@ -151,3 +177,239 @@ int main(int argc, char* argv[])
         }
     }
 }
+
+int generateProject(QStringList arguments)
+{
+    ProjectGenerator::Parameters parameters;
+    QString outputFile = "";
+    bool error = false;
+
+    for (int i = 2; i < arguments.size(); i++)
+    {
+        QString option = arguments.at(i);
+        if (!option.startsWith("--"))
+        {
+            outputFile = option;
+            continue;
+        }
+        if (i + 1 >= arguments.size())
+        {
+            qDebug() << "Error: No value for" << option;
+            error = true;
+            break;
+        }
+        QString value = arguments.at(++i);
+        bool ok = true;
+        if (option == "--seed") parameters.seed = value.toUInt(&ok);
+        else if (option == "--bitmap-layers") parameters.bitmapLayers = value.toInt(&ok);
+        else if (option == "--vector-layers") parameters.vectorLayers = value.toInt(&ok);
+        else if (option == "--frames") parameters.frames = value.toInt(&ok);
+        else if (option == "--key-interval") parameters.keyInterval = value.toInt(&ok);
+        else if (option == "--strokes") parameters.strokesPerBitmapKey = value.toInt(&ok);
+        else if (option == "--density") parameters.bitmapDensity = value.toDouble(&ok);
+        else if (option == "--curves") parameters.curvesPerVectorKey = value.toInt(&ok);
+        else if (option == "--areas") parameters.areasPerVectorKey = value.toInt(&ok);
+        else if (option == "--size")
+        {
+            QStringList size = value.split("x");
+            ok = (size.size() == 2);
+            bool okHeight = false;
+            if (ok) parameters.canvasSize = QSize(size.at(0).toInt(&ok), size.at(1).toInt(&okHeight));
+            ok = ok && okHeight && !parameters.canvasSize.isEmpty();
+        }
+        else ok = false;
+
+        if (!ok)
+        {
+            qDebug() << "Error: Invalid option" << option << value;
+            error = true;
+        }
+    }
+    if (outputFile.isEmpty())
+    {
+        qDebug() << "Error: No output file specified.";
+        error = true;
+    }
+    qint64 bitmapBytes = ProjectGenerator(parameters).bitmapBytes();
+    if (bitmapBytes > ProjectGenerator::MAX_BITMAP_BYTES)
+    {
+        qDebug() << "Error: The bitmap keys would take" << bitmapBytes / (1 << 20) << "MB, over the"
+                 << ProjectGenerator::MAX_BITMAP_BYTES / (1 << 20) << "MB the project is built in.";
+        error = true;
+    }
+
+    if (error)
+    {
+        qDebug() << "Syntax:";
+        qDebug() << "   " << arguments.at(0) << "--generate-project PATH [--seed N] [--bitmap-layers N] [--vector-layers N]";
+        qDebug() << "       [--frames N] [--key-interval N] [--size WxH] [--strokes N] [--density D] [--curves N] [--areas N]";
+        qDebug() << "The whole project is built in memory: the bitmap keys, which grow with --size and --density,";
+        qDebug() << "may take up to" << ProjectGenerator::MAX_BITMAP_BYTES / (1 << 20) << "MB.";
+        qDebug() << "Example:";
+        qDebug() << "   " << arguments.at(0) << "--generate-project /tmp/stress.pclx --seed 7 --bitmap-layers 20 --frames 2000 --key-interval 10 --density 0.05";
+        return 1;
+    }
+
+    qDebug() << "Generating" << outputFile << "...";
+    if (!ProjectGenerator(parameters).generate(outputFile))
+    {
+        qDebug() << "Error: Could not save" << outputFile;
+        return 1;
+    }
+    qDebug() << "Done.";
+    return 0;
+}
+
+int renderProjects(QStringList arguments)
+{
+    int threads = QThread::idealThreadCount();
+    QStringList jobArguments;
+    bool error = false;
+    for (int i = 2; i < arguments.size(); i++)
+    {
+        if (arguments.at(i) == "--threads" && i + 1 < arguments.size())
+        {
+            bool ok = true;
+            threads = arguments.at(++i).toInt(&ok);
+            if (!ok || threads < 1)
+            {
+                qDebug() << "Error: Invalid option --threads" << arguments.at(i);
+                error = true;
+            }
+            continue;
+        }
+        jobArguments.append(arguments.at(i));
+    }
+
+    // a job file, or a single job on the command line
+    QList<RenderJob> jobs;
+    QString message;
+    if (jobArguments.size() == 1 && !jobArguments.first().startsWith("--"))
+    {
+        error = error || !BatchRenderer::readJobFile(jobArguments.first(), &jobs, &message);
+    }
+    else
+    {
+        RenderJob job;
+        error = error || !BatchRenderer::parseJob(jobArguments, &job, &message);
+        jobs.append(job);
+    }
+
+    if (error)
+    {
+        if (!message.isEmpty()) qDebug() << "Error:" << message;
+        qDebug() << "Syntax:";
+        qDebug() << "   " << arguments.at(0) << "--render PROJECT OUTPUT [--start N] [--end N] [--size WxH] [--camera NAME]";
+        qDebug() << "       [--quality Q] [--background] [--no-antialiasing] [--shard K/N] [--threads N]";
+        qDebug() << "   " << arguments.at(0) << "--render JOBFILE [--threads N]";
+        qDebug() << "A job file has one job per line, PROJECT OUTPUT and the options above but --threads.";
+        qDebug() << "Example:";
+        qDebug() << "   " << arguments.at(0) << "--render /path/to/your/file.pclx /path/to/export/frame.png --start 1 --end 100 --size 1280x720";
+        qDebug() << "   " << arguments.at(0) << "--render /path/to/your/file.pclx /path/to/export/frame.png --shard 3/8";
+        return RenderResult::BAD_JOB;
+    }
+
+    // the vector strokes look as they do in the application
+    qreal curveOpacity = pencilSettings()->curveOpacity();
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        jobs[i].curveOpacity = curveOpacity;
+    }
+
+    // one line per job on the standard output, for the scripts that run it
+    QTextStream out(stdout);
+    BatchRenderer renderer(threads);
+    int exitCode = RenderResult::OK;
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        const RenderJob& job = jobs.at(i);
+        RenderResult result = renderer.render(job);
+        out << "job " << i + 1 << ": " << job.projectPath << " -> " << job.outputPath;
+        if (job.shardCount > 1)
+        {
+            out << " shard " << job.shard << "/" << job.shardCount;
+        }
+        out << ": " << result.framesWritten << " frames in " << result.milliseconds << " ms, exit code " << result.exitCode;
+        if (!result.error.isEmpty())
+        {
+            out << " (" << result.error << ")";
+        }
+        out << endl;
+        if (exitCode == RenderResult::OK)
+        {
+            exitCode = result.exitCode;
+        }
+    }
+    return exitCode;
+}
+
+int mergeShards(QStringList arguments)
+{
+    QString outputFile = "";
+    QString movieFile = "";
+    QStringList folders;
+    int shardCount = 0;
+    int fps = 12;
+    bool error = false;
+
+    for (int i = 2; i < arguments.size(); i++)
+    {
+        QString option = arguments.at(i);
+        if (!option.startsWith("--"))
+        {
+            outputFile = option;
+            continue;
+        }
+        if (i + 1 >= arguments.size())
+        {
+            qDebug() << "Error: No value for" << option;
+            error = true;
+            break;
+        }
+        QString value = arguments.at(++i);
+        bool ok = true;
+        if (option == "--shards") shardCount = value.toInt(&ok);
+        else if (option == "--from") folders << value;
+        else if (option == "--movie") movieFile = value;
+        else if (option == "--fps") fps = value.toInt(&ok);
+        else ok = false;
+
+        if (!ok)
+        {
+            qDebug() << "Error: Invalid option" << option << value;
+            error = true;
+        }
+    }
+    if (outputFile.isEmpty() || shardCount < 1)
+    {
+        qDebug() << "Error: No output file or number of shards specified.";
+        error = true;
+    }
+    else if (shardCount == 1)
+    {
+        // a job rendered in one piece is already whole, and leaves no manifest
+        qDebug() << "Error: There is nothing to merge in 1 shard.";
+        error = true;
+    }
+
+    if (error)
+    {
+        qDebug() << "Syntax:";
+        qDebug() << "   " << arguments.at(0) << "--merge OUTPUT --shards N [--from FOLDER]... [--movie FILE] [--fps N]";
+        qDebug() << "OUTPUT is the output of the --render jobs of the shards. The frames are gathered into its folder";
+        qDebug() << "from the other folders, if there are any, and encoded into the movie, if one is given.";
+        qDebug() << "Example:";
+        qDebug() << "   " << arguments.at(0) << "--merge /path/to/export/frame.png --shards 8 --from /mnt/node2/export --movie /path/to/movie.mp4 --fps 24";
+        return RenderResult::BAD_JOB;
+    }
+
+    RenderResult result = BatchRenderer::mergeShards(outputFile, shardCount, folders, movieFile, fps);
+    QTextStream out(stdout);
+    out << "merge: " << outputFile << ": " << result.framesWritten << " frames in " << result.milliseconds << " ms, exit code " << result.exitCode;
+    if (!result.error.isEmpty())
+    {
+        out << " (" << result.error << ")";
+    }
+    out << endl;
+    return result.exitCode;
+}
@@ -13,16 +13,23 @@ INCLUDEPATH += src/external/flash \
 # Input
 HEADERS +=  src/interfaces.h \
     src/graphics/bitmap/bitmapimage.h \
+    src/graphics/bitmap/bitmapmipmaps.h \
+    src/graphics/bitmap/strokerenderer.h \
     src/graphics/vector/bezierarea.h \
     src/graphics/vector/beziercurve.h \
     src/graphics/vector/colourref.h \
     src/graphics/vector/vectorimage.h \
+    src/graphics/vector/vectortilecache.h \
     src/graphics/vector/vertexref.h \
+    src/graphics/thumbnailcache.h \
     src/structure/layer.h \
     src/structure/layerbitmap.h \
     src/structure/layercamera.h \
     src/structure/layerimage.h \
     src/structure/layersound.h \
+    src/structure/audiomixer.h \
+    src/structure/audioplayer.h \
+    src/structure/soundwaveform.h \
     src/structure/layervector.h \
     src/structure/object.h \
     src/interface/editor.h \
@@ -58,6 +65,8 @@ HEADERS +=  src/interfaces.h \
     src/util/pencildef.h \
     src/interface/keycapturelineedit.h \
     src/structure/objectsaveloader.h \
+    src/structure/projectgenerator.h \
+    src/structure/batchrenderer.h \
     src/tool/strokemanager.h \
     src/tool/stroketool.h \
     src/util/blitrect.h \
@@ -69,8 +78,10 @@ HEADERS +=  src/interfaces.h \
     src/interface/flowlayout.h \
     src/structure/keyframe.h \
     src/structure/camera.h \
+    src/structure/cameratrack.h \
     src/interface/recentfilemenu.h \
     src/util/util.h \
+    src/util/perfmonitor.h \
     src/managers/colormanager.h \
     src/managers/toolmanager.h \
     src/managers/layermanager.h \
@@ -80,16 +91,23 @@ HEADERS +=  src/interfaces.h \
 
 SOURCES +=  src/graphics/bitmap/blur.cpp \
     src/graphics/bitmap/bitmapimage.cpp \
+    src/graphics/bitmap/bitmapmipmaps.cpp \
+    src/graphics/bitmap/strokerenderer.cpp \
     src/graphics/vector/bezierarea.cpp \
     src/graphics/vector/beziercurve.cpp \
     src/graphics/vector/colourref.cpp \
     src/graphics/vector/vectorimage.cpp \
+    src/graphics/vector/vectortilecache.cpp \
     src/graphics/vector/vertexref.cpp \
+    src/graphics/thumbnailcache.cpp \
     src/structure/layer.cpp \
     src/structure/layerbitmap.cpp \
     src/structure/layercamera.cpp \
     src/structure/layerimage.cpp \
     src/structure/layersound.cpp \
+    src/structure/audiomixer.cpp \
+    src/structure/audioplayer.cpp \
+    src/structure/soundwaveform.cpp \
     src/structure/layervector.cpp \
     src/structure/object.cpp \
     src/interface/editor.cpp \
@@ -124,6 +142,8 @@ SOURCES +=  src/graphics/bitmap/blur.cpp \
     src/graphics/vector/vectorselection.cpp \
     src/interface/keycapturelineedit.cpp \
     src/structure/objectsaveloader.cpp \
+    src/structure/projectgenerator.cpp \
+    src/structure/batchrenderer.cpp \
     src/tool/strokemanager.cpp \
     src/tool/stroketool.cpp \
     src/util/blitrect.cpp \
@@ -135,14 +155,21 @@ SOURCES +=  src/graphics/bitmap/blur.cpp \
     src/interface/flowlayout.cpp \
     src/structure/keyframe.cpp \
     src/structure/camera.cpp \
+    src/structure/cameratrack.cpp \
     src/interface/recentfilemenu.cpp \
     src/util/util.cpp \
+    src/util/perfmonitor.cpp \
     src/managers/colormanager.cpp \
     src/managers/toolmanager.cpp \
     src/managers/layermanager.cpp \
     src/util/pencilerror.cpp \
     src/managers/basemanager.cpp
 
+# qmake CONFIG+=profiling times the hot paths, see perfmonitor.h
+profiling {
+    DEFINES += PENCIL_PROFILING
+}
+
 win32 {
     INCLUDEPATH += . libwin32
     SOURCES += src/external/win32/win32.cpp
@@ -0,0 +1,182 @@
+#include <cstring>
+#include <QtDebug>
+#include <QProcess>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCache>
+#include <QStringList>
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define AUDIOMIXER_SSE2
+#elif defined( __ARM_NEON )
+#include <arm_neon.h>
+#define AUDIOMIXER_NEON
+#endif
+#include "layersound.h"
+#include "audiomixer.h"
+
+static const int DECODED_CACHE_SIZE = 512; // megabytes
+
+// decoded clips, cost in kilobytes
+static QCache<QString, QVector<qint16> > g_decodedClips( DECODED_CACHE_SIZE * 1024 );
+
+static inline qint16 saturatedSum( qint16 a, qint16 b )
+{
+    int sum = ( int )a + ( int )b;
+    if ( sum > 32767 )
+    {
+        return 32767;
+    }
+    if ( sum < -32768 )
+    {
+        return -32768;
+    }
+    return ( qint16 )sum;
+}
+
+static void addSaturated( qint16* destination, const qint16* source, int count )
+{
+    int i = 0;
+#if defined( AUDIOMIXER_SSE2 )
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        __m128i a = _mm_loadu_si128( ( const __m128i* )( destination + i ) );
+        __m128i b = _mm_loadu_si128( ( const __m128i* )( source + i ) );
+        _mm_storeu_si128( ( __m128i* )( destination + i ), _mm_adds_epi16( a, b ) );
+    }
+#elif defined( AUDIOMIXER_NEON )
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        vst1q_s16( destination + i, vqaddq_s16( vld1q_s16( destination + i ), vld1q_s16( source + i ) ) );
+    }
+#endif
+    for ( ; i < count; i++ )
+    {
+        destination[ i ] = saturatedSum( destination[ i ], source[ i ] );
+    }
+}
+
+static QString cacheKey( const QFileInfo& info )
+{
+    return info.absoluteFilePath() + "@" + QString::number( info.lastModified().toMSecsSinceEpoch() );
+}
+
+QVector<qint16> AudioMixer::decode( const QString& filePath )
+{
+    QFileInfo info( filePath );
+    if ( !info.exists() )
+    {
+        return QVector<qint16>();
+    }
+    QVector<qint16>* cached = g_decodedClips.object( cacheKey( info ) );
+    if ( cached != NULL )
+    {
+        return *cached;
+    }
+
+    QProcess ffmpeg;
+    ffmpeg.setReadChannel( QProcess::StandardOutput );
+    ffmpeg.start( ffmpegPath(), decoderArguments( filePath ) );
+    if ( !ffmpeg.waitForStarted() )
+    {
+        qDebug() << "ERROR: could not start" << ffmpegPath();
+        return QVector<qint16>();
+    }
+
+    QByteArray data;
+    while ( ffmpeg.waitForReadyRead( -1 ) )
+    {
+        data.append( ffmpeg.readAllStandardOutput() );
+    }
+    ffmpeg.waitForFinished();
+    data.append( ffmpeg.readAllStandardOutput() );
+    if ( ffmpeg.exitCode() != 0 )
+    {
+        qDebug() << "ERROR: could not decode" << filePath << ffmpeg.readAllStandardError();
+    }
+
+    QVector<qint16> samples = samplesFromDecoder( data );
+    insertDecoded( filePath, samples );
+    return samples;
+}
+
+bool AudioMixer::isDecoded( const QString& filePath )
+{
+    return g_decodedClips.contains( cacheKey( QFileInfo( filePath ) ) );
+}
+
+QStringList AudioMixer::decoderArguments( const QString& filePath )
+{
+    // supported audio file types: wav, mp3, ogg... ( all file types supported by ffmpeg )
+    // the raw samples are read from the decoder output, nothing is written to disk
+    QStringList arguments;
+    arguments << "-i" << QFileInfo( filePath ).absoluteFilePath()
+              << "-f" << "s16le" << "-acodec" << "pcm_s16le"
+              << "-ar" << QString::number( SAMPLE_RATE )
+              << "-ac" << QString::number( CHANNELS )
+              << "-";
+    return arguments;
+}
+
+QVector<qint16> AudioMixer::samplesFromDecoder( const QByteArray& data )
+{
+    // whole sample frames only
+    int count = data.size() / ( sizeof( qint16 ) * CHANNELS ) * CHANNELS;
+    QVector<qint16> samples( count );
+    memcpy( samples.data(), data.constData(), count * sizeof( qint16 ) );
+    return samples;
+}
+
+void AudioMixer::insertDecoded( const QString& filePath, const QVector<qint16>& samples )
+{
+    qDebug() << "AUDIO decoded:" << filePath << samples.size() / CHANNELS << "sample frames";
+    int cost = qMax( 1, int( samples.size() * sizeof( qint16 ) / 1024 ) );
+    g_decodedClips.insert( cacheKey( QFileInfo( filePath ) ), new QVector<qint16>( samples ), cost );
+}
+
+void AudioMixer::clearCache()
+{
+    g_decodedClips.clear();
+}
+
+void AudioMixer::addClip( const QVector<qint16>& samples, qint64 startFrame )
+{
+    if ( samples.isEmpty() )
+    {
+        return;
+    }
+    Clip clip;
+    clip.samples = samples;
+    clip.start = startFrame;
+    m_clips.append( clip );
+}
+
+void AudioMixer::addLayer( LayerSound* layer, int fps, int firstFrame )
+{
+    for ( int i = 0; i < layer->getSoundSize(); i++ )
+    {
+        if ( layer->soundIsNotNull( i ) )
+        {
+            // sample-exact offset of the clip, relative to the first exported frame
+            qint64 offset = qint64( layer->getFramePositionAt( i ) - firstFrame ) * SAMPLE_RATE / fps;
+            addClip( decode( layer->getSoundFilepathAt( i ) ), offset );
+        }
+    }
+}
+
+void AudioMixer::mix( qint16* buffer, qint64 position, int frames ) const
+{
+    qint64 end = position + frames;
+    foreach ( const Clip& clip, m_clips )
+    {
+        qint64 clipEnd = clip.start + clip.samples.size() / CHANNELS;
+        qint64 from = qMax( position, clip.start );
+        qint64 to = qMin( end, clipEnd );
+        if ( from < to )
+        {
+            addSaturated( buffer + ( from - position ) * CHANNELS,
+                          clip.samples.constData() + ( from - clip.start ) * CHANNELS,
+                          int( to - from ) * CHANNELS );
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class LayerSound;
+
+
+/**
+ * Mixes the sound clips of a project into one stream.
+ *
+ * Every clip is decoded once, to 44100 Hz stereo signed 16 bit samples,
+ * and kept in a cache shared by all the mixers. The mix is computed on
+ * demand, block by block, so a whole film never has to be held in memory.
+ * Positions and lengths are counted in sample frames (one sample per channel).
+ */
+class AudioMixer
+{
+public:
+    static const int SAMPLE_RATE = 44100;
+    static const int CHANNELS = 2;
+
+    static QVector<qint16> decode( const QString& filePath );
+    static bool isDecoded( const QString& filePath );
+    static void clearCache();
+
+    // the FFmpeg program: the one shipped with the application on Windows and in a Mac bundle,
+    // else the one in the PATH ( defined with the code of each platform )
+    static QString ffmpegPath();
+
+    // for decoding without blocking: run ffmpegPath() with these arguments, then insert its output
+    static QStringList decoderArguments( const QString& filePath );
+    static QVector<qint16> samplesFromDecoder( const QByteArray& data );
+    static void insertDecoded( const QString& filePath, const QVector<qint16>& samples );
+
+    void addClip( const QVector<qint16>& samples, qint64 startFrame );
+    void addLayer( LayerSound* layer, int fps, int firstFrame );
+    void clear() { m_clips.clear(); }
+    bool isEmpty() const { return m_clips.isEmpty(); }
+
+    // adds the clips overlapping [position, position + frames) to the buffer
+    void mix( qint16* buffer, qint64 position, int frames ) const;
+
+private:
+    struct Clip
+    {
+        QVector<qint16> samples;
+        qint64 start;
+    };
+    QList<Clip> m_clips;
+};
+
+#endif // AUDIOMIXER_H
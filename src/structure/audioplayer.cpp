@@ -0,0 +1,129 @@
+#include <cstring>
+#include <QAudioOutput>
+#include <QAudioFormat>
+#include "audioplayer.h"
+
+static const int OUTPUT_LATENCY = 50; // milliseconds buffered by the audio output
+
+AudioMixStream::AudioMixStream( QObject* parent ) : QIODevice( parent )
+    , m_start( 0 )
+    , m_position( 0 )
+    , m_end( -1 )
+{
+}
+
+void AudioMixStream::setRange( qint64 start, qint64 end )
+{
+    m_start = start;
+    m_position = start;
+    m_end = end;
+}
+
+qint64 AudioMixStream::readData( char* data, qint64 maxSize )
+{
+    const int frameBytes = AudioMixer::CHANNELS * sizeof( qint16 );
+    qint64 frames = maxSize / frameBytes;
+    if ( m_end >= 0 )
+    {
+        frames = qMin( frames, m_end - m_position );
+    }
+    if ( frames <= 0 )
+    {
+        return 0;
+    }
+
+    memset( data, 0, frames * frameBytes );
+    m_mixer.mix( reinterpret_cast< qint16* >( data ), m_position, int( frames ) );
+    m_position += frames;
+    return frames * frameBytes;
+}
+
+qint64 AudioMixStream::writeData( const char* data, qint64 maxSize )
+{
+    Q_UNUSED( data );
+    Q_UNUSED( maxSize );
+    return -1;
+}
+
+AudioPlayer::AudioPlayer( QObject* parent ) : QObject( parent )
+    , m_playing( false )
+{
+    QAudioFormat format;
+    format.setSampleRate( AudioMixer::SAMPLE_RATE );
+    format.setChannelCount( AudioMixer::CHANNELS );
+    format.setSampleSize( 16 );
+    format.setSampleType( QAudioFormat::SignedInt );
+    format.setByteOrder( QAudioFormat::LittleEndian );
+    format.setCodec( "audio/pcm" );
+
+    m_pOutput = new QAudioOutput( format, this );
+    m_pOutput->setBufferSize( AudioMixer::SAMPLE_RATE * AudioMixer::CHANNELS * sizeof( qint16 ) * OUTPUT_LATENCY / 1000 );
+
+    m_pStream = new AudioMixStream( this );
+    m_pStream->open( QIODevice::ReadOnly );
+}
+
+AudioPlayer::~AudioPlayer()
+{
+    m_pOutput->stop();
+}
+
+void AudioPlayer::setMixer( const AudioMixer& mixer )
+{
+    m_pStream->setMixer( mixer );
+}
+
+void AudioPlayer::play( qint64 position )
+{
+    restart( position, -1 );
+    m_playing = true;
+}
+
+void AudioPlayer::playSlice( qint64 position, int frames )
+{
+    if ( m_playing )
+    {
+        return;
+    }
+    restart( position, position + frames );
+}
+
+void AudioPlayer::sync( qint64 position, int tolerance )
+{
+    if ( !m_playing )
+    {
+        play( position );
+    }
+    else if ( qAbs( this->position() - position ) > tolerance )
+    {
+        restart( position, -1 );
+    }
+}
+
+void AudioPlayer::stop()
+{
+    m_playing = false;
+    m_pOutput->stop();
+}
+
+bool AudioPlayer::isClockRunning() const
+{
+    if ( !m_playing || m_pOutput->error() != QAudio::NoError )
+    {
+        return false;
+    }
+    return m_pOutput->state() == QAudio::ActiveState || m_pOutput->state() == QAudio::IdleState;
+}
+
+qint64 AudioPlayer::position() const
+{
+    // what has actually been played, not what has been handed to the output
+    return m_pStream->start() + m_pOutput->processedUSecs() * AudioMixer::SAMPLE_RATE / 1000000;
+}
+
+void AudioPlayer::restart( qint64 start, qint64 end )
+{
+    m_pOutput->stop();
+    m_pStream->setRange( start, end );
+    m_pOutput->start( m_pStream );
+}
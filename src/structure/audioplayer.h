@@ -0,0 +1,76 @@
+#ifndef AUDIOPLAYER_H
+#define AUDIOPLAYER_H
+
+#include <QObject>
+#include <QIODevice>
+#include "audiomixer.h"
+
+class QAudioOutput;
+
+
+// pulls the mix of the sound clips, from a given sample frame
+class AudioMixStream : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit AudioMixStream( QObject* parent = 0 );
+
+    void setMixer( const AudioMixer& mixer ) { m_mixer = mixer; }
+    void setRange( qint64 start, qint64 end );
+    qint64 start() const { return m_start; }
+
+    bool isSequential() const { return true; }
+
+protected:
+    qint64 readData( char* data, qint64 maxSize );
+    qint64 writeData( const char* data, qint64 maxSize );
+
+private:
+    AudioMixer m_mixer;
+    qint64 m_start;
+    qint64 m_position;
+    qint64 m_end; // -1 to play on
+};
+
+
+/**
+ * Plays all the sound clips through a single audio output.
+ *
+ * The clips are mixed from their decoded samples, so playback can start on
+ * any sample frame. During playback the sound is the clock: the caller shows
+ * the frame at position(), and sync() only seeks when the frame is further
+ * than the tolerance from it, after a jump, so drift never makes the sound
+ * restart. The sound is only a clock while the output really plays, see
+ * isClockRunning(): without a device, or with a format it refuses,
+ * position() does not move. Scrubbing plays a slice of one frame.
+ */
+class AudioPlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AudioPlayer( QObject* parent = 0 );
+    ~AudioPlayer();
+
+    void setMixer( const AudioMixer& mixer );
+
+    void play( qint64 position );
+    void playSlice( qint64 position, int frames );
+    void sync( qint64 position, int tolerance );
+    void stop();
+
+    bool isPlaying() const { return m_playing; }
+    // playing, and position() moves on with the sound
+    bool isClockRunning() const;
+    qint64 position() const;
+
+private:
+    void restart( qint64 start, qint64 end );
+
+    QAudioOutput* m_pOutput;
+    AudioMixStream* m_pStream;
+    bool m_playing;
+};
+
+#endif // AUDIOPLAYER_H
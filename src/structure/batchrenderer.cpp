@@ -0,0 +1,541 @@
+#include <QtDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <QProcess>
+#include "object.h"
+#include "layercamera.h"
+#include "objectsaveloader.h"
+#include "thumbnailcache.h"
+#include "perfmonitor.h"
+#include "audiomixer.h"
+#include "batchrenderer.h"
+
+static const QSize DEFAULT_SIZE( 1920, 1080 ); // without a camera
+
+RenderJob::RenderJob()
+    : startFrame( 1 ),
+      endFrame( -1 ),
+      quality( -1 ),
+      background( false ),
+      antialiasing( true ),
+      curveOpacity( 1.0 ),
+      shard( 1 ),
+      shardCount( 1 )
+{
+}
+
+
+// renders every step-th frame of a job with a copy of the project of its own
+class RenderTask : public QRunnable
+{
+public:
+    RenderTask( const QString& projectPath )
+        : m_projectPath( projectPath ), m_firstFrame( 1 ), m_step( 1 ), m_object( NULL ),
+          m_cameraIndex( -1 ), m_format( NULL ), m_exitCode( RenderResult::OK ), m_framesWritten( 0 )
+    {
+        setAutoDelete( false );
+    }
+
+    ~RenderTask()
+    {
+        delete m_object;
+        m_loader.cleanUpTempFolder();
+    }
+
+    bool load()
+    {
+        m_object = m_loader.loadFromFile( m_projectPath );
+        return ( m_object != NULL );
+    }
+
+    // the job must have its frame range and size worked out
+    void setJob( const RenderJob& job, int firstFrame, int step, int cameraIndex, const QMatrix& view, const char* format )
+    {
+        m_job = job;
+        m_firstFrame = firstFrame;
+        m_step = step;
+        m_cameraIndex = cameraIndex;
+        m_view = view;
+        m_format = format;
+    }
+
+    void run()
+    {
+        if ( m_object == NULL && !load() )
+        {
+            m_exitCode = RenderResult::CANNOT_OPEN;
+            return;
+        }
+        Layer* camera = ( m_cameraIndex >= 0 ) ? m_object->getLayer( m_cameraIndex ) : NULL;
+        for ( int frame = m_firstFrame; frame <= m_job.endFrame; frame += m_step )
+        {
+            if ( !m_object->exportFrames( frame, frame, m_view, camera, m_job.size, m_job.outputPath, m_format,
+                                          m_job.quality, m_job.background, m_job.antialiasing, m_job.curveOpacity, NULL, 0 ) )
+            {
+                m_exitCode = RenderResult::CANNOT_WRITE;
+                return;
+            }
+            m_framesWritten++;
+        }
+    }
+
+    Object* object() { return m_object; }
+    int exitCode() { return m_exitCode; }
+    int framesWritten() { return m_framesWritten; }
+
+private:
+    QString m_projectPath;
+    RenderJob m_job;
+    int m_firstFrame;
+    int m_step;
+    ObjectSaveLoader m_loader;
+    Object* m_object;
+    int m_cameraIndex;
+    QMatrix m_view;
+    const char* m_format;
+    int m_exitCode;
+    int m_framesWritten;
+};
+
+
+BatchRenderer::BatchRenderer( int threads ) : m_threads( qMax( 1, threads ) )
+{
+}
+
+RenderResult BatchRenderer::render( const RenderJob& originalJob )
+{
+    PERF_SCOPE( "BatchRenderer::render" );
+    QElapsedTimer timer;
+    timer.start();
+
+    RenderJob job = originalJob;
+    RenderResult result;
+    const char* format = formatOf( job.outputPath );
+    if ( format == NULL )
+    {
+        result.exitCode = RenderResult::BAD_JOB;
+        result.error = "Unsupported output format: " + job.outputPath;
+        return result;
+    }
+    if ( job.shardCount < 1 || job.shard < 1 || job.shard > job.shardCount )
+    {
+        result.exitCode = RenderResult::BAD_JOB;
+        result.error = QString( "Invalid shard %1/%2" ).arg( job.shard ).arg( job.shardCount );
+        return result;
+    }
+    if ( !QFileInfo( job.outputPath ).absoluteDir().exists() )
+    {
+        result.exitCode = RenderResult::CANNOT_WRITE;
+        result.error = "No such folder: " + QFileInfo( job.outputPath ).absolutePath();
+        return result;
+    }
+
+    // the loaded projects insert their thumbnails into the cache, which must belong to this thread
+    ThumbnailCache::instance();
+
+    // the first copy is loaded here, to find out the frames and the camera
+    QList<RenderTask*> tasks;
+    tasks.append( new RenderTask( job.projectPath ) );
+    if ( !tasks.first()->load() )
+    {
+        qDeleteAll( tasks );
+        result.exitCode = RenderResult::CANNOT_OPEN;
+        result.error = "Cannot open " + job.projectPath;
+        return result;
+    }
+    Object* object = tasks.first()->object();
+
+    int cameraIndex = -1;
+    for ( int i = 0; i < object->getLayerCount() && job.camera != "none"; i++ )
+    {
+        Layer* layer = object->getLayer( i );
+        if ( layer->type() == Layer::CAMERA && ( job.camera.isEmpty() || layer->name == job.camera ) )
+        {
+            cameraIndex = i;
+            break;
+        }
+    }
+    if ( cameraIndex == -1 && !job.camera.isEmpty() && job.camera != "none" )
+    {
+        qDeleteAll( tasks );
+        result.exitCode = RenderResult::BAD_JOB;
+        result.error = "No camera layer named " + job.camera;
+        return result;
+    }
+    if ( job.size.isEmpty() )
+    {
+        job.size = ( cameraIndex >= 0 ) ? ( ( LayerCamera* )object->getLayer( cameraIndex ) )->getViewRect().size() : DEFAULT_SIZE;
+    }
+    if ( job.endFrame == -1 )
+    {
+        job.endFrame = job.startFrame;
+        for ( int i = 0; i < object->getLayerCount(); i++ )
+        {
+            job.endFrame = qMax( job.endFrame, object->getLayer( i )->getMaxFramePosition() );
+        }
+    }
+    if ( job.startFrame < 1 || job.endFrame < job.startFrame )
+    {
+        qDeleteAll( tasks );
+        result.exitCode = RenderResult::BAD_JOB;
+        result.error = QString( "Invalid frame range %1-%2" ).arg( job.startFrame ).arg( job.endFrame );
+        return result;
+    }
+
+    // without a camera, the centre of the canvas is the centre of the images
+    QMatrix view;
+    view.translate( job.size.width() / 2.0, job.size.height() / 2.0 );
+
+    // the frames of the shard are dealt out to the threads, which load their copies themselves
+    int shardFrames = ( job.endFrame - job.startFrame + 1 - job.shard + job.shardCount ) / job.shardCount;
+    int threads = qMin( m_threads, shardFrames );
+    for ( int i = 0; i < threads; i++ )
+    {
+        if ( i > 0 )
+        {
+            tasks.append( new RenderTask( job.projectPath ) );
+        }
+        int firstFrame = job.startFrame + job.shard - 1 + i * job.shardCount;
+        tasks.at( i )->setJob( job, firstFrame, threads * job.shardCount, cameraIndex, view, format );
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount( qMax( 1, threads ) );
+    for ( int i = 0; i < threads; i++ )
+    {
+        pool.start( tasks.at( i ) );
+    }
+    pool.waitForDone();
+
+    foreach ( RenderTask* task, tasks )
+    {
+        result.framesWritten += task->framesWritten();
+        if ( result.exitCode == RenderResult::OK && task->exitCode() != RenderResult::OK )
+        {
+            result.exitCode = task->exitCode();
+            result.error = ( task->exitCode() == RenderResult::CANNOT_OPEN ) ? "Cannot open " + job.projectPath
+                                                                             : "Cannot write " + job.outputPath;
+        }
+    }
+    qDeleteAll( tasks );
+
+    // tells mergeShards() that this shard is complete
+    if ( result.exitCode == RenderResult::OK && job.shardCount > 1 )
+    {
+        QFile manifest( shardManifestPath( job.outputPath, job.shard, job.shardCount ) );
+        if ( manifest.open( QIODevice::WriteOnly | QIODevice::Text ) )
+        {
+            QTextStream out( &manifest );
+            out << "shard " << job.shard << " " << job.shardCount << "\n";
+            out << "frames " << job.startFrame << " " << job.endFrame << "\n";
+        }
+        if ( manifest.error() != QFile::NoError )
+        {
+            result.exitCode = RenderResult::CANNOT_WRITE;
+            result.error = "Cannot write " + manifest.fileName();
+        }
+    }
+
+    result.milliseconds = timer.elapsed();
+    return result;
+}
+
+// the frame range of a shard manifest, false if there is none
+static bool readShardManifest( const QString& filePath, int* startFrame, int* endFrame )
+{
+    QFile file( filePath );
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        return false;
+    }
+    QTextStream in( &file );
+    bool ok = false;
+    while ( !in.atEnd() )
+    {
+        QStringList words = in.readLine().split( " ", QString::SkipEmptyParts );
+        if ( words.size() == 3 && words.at( 0 ) == "frames" )
+        {
+            *startFrame = words.at( 1 ).toInt( &ok );
+            *endFrame = words.at( 2 ).toInt( &ok );
+        }
+    }
+    return ok;
+}
+
+RenderResult BatchRenderer::mergeShards( const QString& outputPath, int shardCount, const QStringList& folders,
+                                         const QString& moviePath, int fps )
+{
+    PERF_SCOPE( "BatchRenderer::mergeShards" );
+    QElapsedTimer timer;
+    timer.start();
+
+    RenderResult result;
+    if ( formatOf( outputPath ) == NULL )
+    {
+        result.exitCode = RenderResult::BAD_JOB;
+        result.error = "Unsupported output format: " + outputPath;
+        return result;
+    }
+    // a job that is not split leaves no manifest
+    if ( shardCount < 2 )
+    {
+        result.exitCode = RenderResult::BAD_JOB;
+        result.error = QString( "Nothing to merge in %1 shard" ).arg( shardCount );
+        return result;
+    }
+
+    // the folder of the output first, then the others in order
+    QDir outputFolder = QFileInfo( outputPath ).absoluteDir();
+    QList<QDir> searched;
+    searched << outputFolder;
+    foreach ( QString folder, folders )
+    {
+        searched << QDir( folder );
+    }
+
+    // every shard must have finished, over the same range
+    int startFrame = 0;
+    int endFrame = -1;
+    QStringList manifests;
+    QList<QDir> shardFolders;
+    for ( int shard = 1; shard <= shardCount; shard++ )
+    {
+        QString fileName = QFileInfo( shardManifestPath( outputPath, shard, shardCount ) ).fileName();
+        int shardStart = 0;
+        int shardEnd = -1;
+        int found = -1;
+        for ( int i = 0; i < searched.size() && found == -1; i++ )
+        {
+            if ( readShardManifest( searched.at( i ).filePath( fileName ), &shardStart, &shardEnd ) )
+            {
+                found = i;
+            }
+        }
+        if ( found == -1 )
+        {
+            result.exitCode = RenderResult::INCOMPLETE;
+            result.error = QString( "Shard %1/%2 has not finished" ).arg( shard ).arg( shardCount );
+            return result;
+        }
+        if ( shard > 1 && ( shardStart != startFrame || shardEnd != endFrame ) )
+        {
+            result.exitCode = RenderResult::BAD_JOB;
+            result.error = QString( "Shard %1/%2 rendered frames %3-%4, not %5-%6" )
+                .arg( shard ).arg( shardCount ).arg( shardStart ).arg( shardEnd ).arg( startFrame ).arg( endFrame );
+            return result;
+        }
+        startFrame = shardStart;
+        endFrame = shardEnd;
+        manifests << searched.at( found ).filePath( fileName );
+        shardFolders << searched.at( found );
+    }
+
+    // brings the frames of the other folders next to the output, then checks that none is missing
+    QStringList missing;
+    for ( int frame = startFrame; frame <= endFrame; frame++ )
+    {
+        QString fileName = QFileInfo( framePath( outputPath, frame ) ).fileName();
+        QString target = outputFolder.filePath( fileName );
+        QString source = shardFolders.at( ( frame - startFrame ) % shardCount ).filePath( fileName );
+        if ( !QFile::exists( target ) && QFile::exists( source ) )
+        {
+            QFile::copy( source, target );
+        }
+        if ( !QFile::exists( target ) )
+        {
+            missing << QString::number( frame );
+        }
+    }
+    if ( !missing.isEmpty() )
+    {
+        result.exitCode = RenderResult::INCOMPLETE;
+        result.error = QString( "%1 frames missing: %2" ).arg( missing.size() ).arg( missing.mid( 0, 10 ).join( " " ) );
+        return result;
+    }
+    result.framesWritten = endFrame - startFrame + 1;
+
+    if ( !moviePath.isEmpty() )
+    {
+        // the frame numbers have 4 digits at least, as %04d gives
+        QFileInfo output( outputPath );
+        QString pattern = outputFolder.filePath( output.completeBaseName() + "%04d." + output.suffix() );
+        QStringList arguments;
+        arguments << "-y" << "-r" << QString::number( fps ) << "-start_number" << QString::number( startFrame )
+                  << "-i" << pattern << "-r" << QString::number( fps ) << moviePath;
+        QProcess ffmpeg;
+        ffmpeg.start( AudioMixer::ffmpegPath(), arguments );
+        if ( !ffmpeg.waitForStarted() || !ffmpeg.waitForFinished( -1 ) || ffmpeg.exitCode() != 0 )
+        {
+            qDebug() << "ERROR: could not encode" << moviePath << ffmpeg.readAllStandardError();
+            result.exitCode = RenderResult::CANNOT_WRITE;
+            result.error = "Cannot encode " + moviePath;
+            return result;
+        }
+    }
+
+    // the sequence is whole: the manifests have done their job
+    foreach ( QString manifest, manifests )
+    {
+        QFile::remove( manifest );
+    }
+    result.milliseconds = timer.elapsed();
+    return result;
+}
+
+bool BatchRenderer::parseJob( const QStringList& arguments, RenderJob* job, QString* error )
+{
+    QStringList paths;
+    for ( int i = 0; i < arguments.size(); i++ )
+    {
+        QString option = arguments.at( i );
+        if ( !option.startsWith( "--" ) )
+        {
+            paths.append( option );
+            continue;
+        }
+        if ( option == "--background" )
+        {
+            job->background = true;
+            continue;
+        }
+        if ( option == "--no-antialiasing" )
+        {
+            job->antialiasing = false;
+            continue;
+        }
+        if ( i + 1 >= arguments.size() )
+        {
+            *error = "No value for " + option;
+            return false;
+        }
+        QString value = arguments.at( ++i );
+        bool ok = true;
+        if ( option == "--start" ) job->startFrame = value.toInt( &ok );
+        else if ( option == "--end" ) job->endFrame = value.toInt( &ok );
+        else if ( option == "--quality" ) job->quality = value.toInt( &ok );
+        else if ( option == "--camera" ) job->camera = value;
+        else if ( option == "--shard" )
+        {
+            QStringList shard = value.split( "/" );
+            ok = ( shard.size() == 2 );
+            if ( ok ) job->shard = shard.at( 0 ).toInt();
+            if ( ok ) job->shardCount = shard.at( 1 ).toInt();
+            ok = ok && job->shardCount >= 1 && job->shard >= 1 && job->shard <= job->shardCount;
+        }
+        else if ( option == "--size" )
+        {
+            QStringList size = value.split( "x" );
+            ok = ( size.size() == 2 );
+            if ( ok ) job->size = QSize( size.at( 0 ).toInt(), size.at( 1 ).toInt() );
+            ok = ok && !job->size.isEmpty();
+        }
+        else ok = false;
+
+        if ( !ok )
+        {
+            *error = "Invalid option " + option + " " + value;
+            return false;
+        }
+    }
+    if ( paths.size() != 2 )
+    {
+        *error = "A job needs a project and an output file";
+        return false;
+    }
+    job->projectPath = paths.at( 0 );
+    job->outputPath = paths.at( 1 );
+    return true;
+}
+
+// splits a line at the spaces, except between double quotes
+static QStringList splitLine( const QString& line )
+{
+    QStringList words;
+    QString word;
+    bool quoted = false;
+    bool inWord = false;
+    for ( int i = 0; i < line.size(); i++ )
+    {
+        QChar c = line.at( i );
+        if ( c == '"' )
+        {
+            quoted = !quoted;
+            inWord = true;
+        }
+        else if ( c.isSpace() && !quoted )
+        {
+            if ( inWord ) words.append( word );
+            word.clear();
+            inWord = false;
+        }
+        else
+        {
+            word.append( c );
+            inWord = true;
+        }
+    }
+    if ( inWord ) words.append( word );
+    return words;
+}
+
+bool BatchRenderer::readJobFile( const QString& filePath, QList<RenderJob>* jobs, QString* error )
+{
+    QFile file( filePath );
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        *error = "Cannot open " + filePath;
+        return false;
+    }
+    QDir folder = QFileInfo( filePath ).absoluteDir();
+
+    QTextStream in( &file );
+    int lineNumber = 0;
+    while ( !in.atEnd() )
+    {
+        QString line = in.readLine();
+        lineNumber++;
+        if ( line.trimmed().isEmpty() || line.trimmed().startsWith( "#" ) )
+        {
+            continue;
+        }
+
+        RenderJob job;
+        QString lineError;
+        if ( !parseJob( splitLine( line ), &job, &lineError ) )
+        {
+            *error = QString( "%1:%2: %3" ).arg( filePath ).arg( lineNumber ).arg( lineError );
+            return false;
+        }
+        job.projectPath = folder.absoluteFilePath( job.projectPath );
+        job.outputPath = folder.absoluteFilePath( job.outputPath );
+        jobs->append( job );
+    }
+    return true;
+}
+
+const char* BatchRenderer::formatOf( const QString& outputPath )
+{
+    QString suffix = QFileInfo( outputPath ).suffix().toLower();
+    if ( suffix == "png" ) return "PNG";
+    if ( suffix == "jpg" || suffix == "jpeg" ) return "JPG";
+    if ( suffix == "tif" ) return "TIF";
+    if ( suffix == "bmp" ) return "BMP";
+    return NULL;
+}
+
+QString BatchRenderer::framePath( const QString& outputPath, int frame )
+{
+    QFileInfo output( outputPath );
+    return output.path() + "/" + output.completeBaseName() + QString::number( frame ).rightJustified( 4, '0' ) + "." + output.suffix();
+}
+
+QString BatchRenderer::shardManifestPath( const QString& outputPath, int shard, int shardCount )
+{
+    QFileInfo output( outputPath );
+    return output.path() + "/" + output.completeBaseName() + QString( ".shard-%1-of-%2" ).arg( shard ).arg( shardCount );
+}
@@ -0,0 +1,93 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <QtGlobal>
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+
+// a range of frames of a saved project to render into an image sequence
+struct RenderJob
+{
+    RenderJob();
+
+    QString projectPath;
+    QString outputPath;     // the frame numbers go before the extension, which gives the format
+    int startFrame;
+    int endFrame;           // -1: the last key frame of the project
+    QSize size;             // empty: the size of the camera
+    QString camera;         // name of the camera layer; empty: the first one, "none": no camera
+    int quality;            // -1: the default of the format
+    bool background;
+    bool antialiasing;
+    qreal curveOpacity;     // of the vector strokes, 1 by default
+    int shard;              // renders frame startFrame+k only if k % shardCount == shard - 1
+    int shardCount;
+};
+
+struct RenderResult
+{
+    enum ExitCode
+    {
+        OK = 0,
+        BAD_JOB = 1,
+        CANNOT_OPEN = 2,
+        CANNOT_WRITE = 3,
+        INCOMPLETE = 4
+    };
+
+    RenderResult() : exitCode( OK ), milliseconds( 0 ), framesWritten( 0 ) {}
+
+    int exitCode;
+    qint64 milliseconds;
+    int framesWritten;
+    QString error;
+};
+
+
+/**
+ * Renders saved projects to image sequences without any window, for
+ * scripts and render servers.
+ *
+ * The frames of a job are shared out between threads. Painting an object
+ * fills caches of its images ( mipmaps, the areas of vector images, the
+ * camera track ), so rather than sharing one object every thread loads a
+ * copy of the project of its own and renders every n-th frame of the range
+ * with it. The objects are deleted by the thread that called render().
+ *
+ * A job can also be one shard of a range split between several processes or
+ * machines, which render into the same file names. Each shard leaves a small
+ * manifest next to its frames when it is done, and mergeShards() checks
+ * that every shard and every frame is there before it gathers the sequence
+ * into one folder or encodes it into a movie.
+ */
+class BatchRenderer
+{
+public:
+    explicit BatchRenderer( int threads = QThread::idealThreadCount() );
+
+    RenderResult render( const RenderJob& job );
+
+    // gathers the frames of the shards of outputPath found in folders into the folder of outputPath,
+    // then encodes them into moviePath with FFmpeg, unless it is empty; shardCount is 2 at least
+    static RenderResult mergeShards( const QString& outputPath, int shardCount, const QStringList& folders,
+                                     const QString& moviePath, int fps );
+
+    // PROJECT OUTPUT [--start N] [--end N] [--size WxH] [--camera NAME] [--quality Q] [--background] [--no-antialiasing] [--shard K/N]
+    static bool parseJob( const QStringList& arguments, RenderJob* job, QString* error );
+    // one job per line in the syntax of parseJob; # starts a comment, relative paths are relative to the file
+    static bool readJobFile( const QString& filePath, QList<RenderJob>* jobs, QString* error );
+    // the image format of an output path, NULL if it is not supported
+    static const char* formatOf( const QString& outputPath );
+    // the file of a frame, named like Object::exportFrames() does, with the suffix of outputPath
+    static QString framePath( const QString& outputPath, int frame );
+    static QString shardManifestPath( const QString& outputPath, int shard, int shardCount );
+
+private:
+    int m_threads;
+};
+
+#endif // BATCHRENDERER_H
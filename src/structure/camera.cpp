@@ -3,6 +3,7 @@
 Camera::Camera()
 {
     view = QMatrix();
+    easing = QEasingCurve::Linear;
 }
 
 Camera::~Camera()
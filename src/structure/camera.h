@@ -2,6 +2,7 @@
 #define CAMERA_H
 
 #include <QMatrix>
+#include <QEasingCurve>
 
 class Camera
 {
@@ -9,6 +10,7 @@ public:
     Camera();
     ~Camera();
     QMatrix view;
+    QEasingCurve::Type easing; // towards the next key
 };
 
 #endif // CAMERA_H
@@ -0,0 +1,135 @@
+#include <cmath>
+#include "cameratrack.h"
+
+static const qreal PI = 3.14159265358979323846;
+
+static inline qreal mix( qreal a, qreal b, qreal t )
+{
+    return a + ( b - a ) * t;
+}
+
+void CameraTrack::addKey( int frame, const QMatrix& view, QEasingCurve::Type easing )
+{
+    Key key;
+    key.frame = frame;
+    key.view = view;
+    key.easing = QEasingCurve( easing );
+
+    // view = scale and shear, then rotation, then the translation bringing the centre to the origin
+    key.scaleX = std::sqrt( view.m11() * view.m11() + view.m12() * view.m12() );
+    key.angle = std::atan2( view.m12(), view.m11() );
+    if ( key.scaleX > 0 )
+    {
+        key.shear = ( view.m11() * view.m21() + view.m12() * view.m22() ) / key.scaleX;
+        key.scaleY = view.determinant() / key.scaleX;
+    }
+    else
+    {
+        key.shear = 0;
+        key.scaleY = 0;
+    }
+    QPointF center = view.inverted().map( QPointF( 0, 0 ) );
+    key.centerX = center.x();
+    key.centerY = center.y();
+    key.angleDelta = 0;
+    key.geometricScale = false;
+
+    if ( !m_keys.isEmpty() )
+    {
+        Key& previous = m_keys.last();
+        // the shortest way round
+        qreal delta = key.angle - previous.angle;
+        while ( delta > PI ) delta -= 2 * PI;
+        while ( delta < -PI ) delta += 2 * PI;
+        previous.angleDelta = delta;
+        previous.geometricScale = ( previous.scaleX > 0 && key.scaleX > 0 && previous.scaleY > 0 && key.scaleY > 0 );
+    }
+    m_keys.append( key );
+}
+
+int CameraTrack::segmentAt( int frame ) const
+{
+    int low = 0;
+    int high = m_keys.size();
+    while ( low < high )
+    {
+        int middle = ( low + high ) / 2;
+        if ( m_keys.at( middle ).frame <= frame )
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low - 1;
+}
+
+QMatrix CameraTrack::viewInSegment( int index, int frame ) const
+{
+    if ( index < 0 )
+    {
+        return m_keys.isEmpty() ? QMatrix() : m_keys.first().view;
+    }
+    const Key& a = m_keys.at( index );
+    if ( frame == a.frame || index + 1 >= m_keys.size() )
+    {
+        return a.view;
+    }
+    const Key& b = m_keys.at( index + 1 );
+
+    qreal t = a.easing.valueForProgress( qreal( frame - a.frame ) / ( b.frame - a.frame ) );
+    qreal angle = a.angle + a.angleDelta * t;
+    qreal shear = mix( a.shear, b.shear, t );
+    qreal scaleX, scaleY;
+    if ( a.geometricScale )
+    {
+        scaleX = a.scaleX * std::pow( b.scaleX / a.scaleX, t );
+        scaleY = a.scaleY * std::pow( b.scaleY / a.scaleY, t );
+    }
+    else
+    {
+        scaleX = mix( a.scaleX, b.scaleX, t );
+        scaleY = mix( a.scaleY, b.scaleY, t );
+    }
+    qreal centerX = mix( a.centerX, b.centerX, t );
+    qreal centerY = mix( a.centerY, b.centerY, t );
+
+    qreal c = std::cos( angle );
+    qreal s = std::sin( angle );
+    qreal m11 = scaleX * c;
+    qreal m12 = scaleX * s;
+    qreal m21 = shear * c - scaleY * s;
+    qreal m22 = shear * s + scaleY * c;
+    return QMatrix( m11, m12, m21, m22,
+                    -( m11 * centerX + m21 * centerY ),
+                    -( m12 * centerX + m22 * centerY ) );
+}
+
+QMatrix CameraTrack::viewAt( int frame ) const
+{
+    return viewInSegment( segmentAt( frame ), frame );
+}
+
+QVector<QMatrix> CameraTrack::views( int firstFrame, int lastFrame ) const
+{
+    QVector<QMatrix> result;
+    if ( lastFrame < firstFrame )
+    {
+        return result;
+    }
+    result.reserve( lastFrame - firstFrame + 1 );
+
+    // one search, then the segments are walked along with the frames
+    int index = segmentAt( firstFrame );
+    for ( int frame = firstFrame; frame <= lastFrame; frame++ )
+    {
+        while ( index + 1 < m_keys.size() && m_keys.at( index + 1 ).frame <= frame )
+        {
+            index++;
+        }
+        result.append( viewInSegment( index, frame ) );
+    }
+    return result;
+}
@@ -0,0 +1,49 @@
+#ifndef CAMERATRACK_H
+#define CAMERATRACK_H
+
+#include <QMatrix>
+#include <QVector>
+#include <QEasingCurve>
+
+
+/**
+ * The views of a camera layer between its key frames.
+ *
+ * Each key is decomposed once into the point of the drawing at the centre
+ * of the camera, a rotation, a scale and a shear. In between two keys these
+ * are interpolated separately, following the easing curve of the first key,
+ * so a rotating camera keeps its zoom and pans in a straight line. Zooming
+ * is interpolated geometrically so that it looks steady.
+ */
+class CameraTrack
+{
+public:
+    void clear() { m_keys.clear(); }
+    bool isEmpty() const { return m_keys.isEmpty(); }
+
+    // keys are added in frame order, the easing applies up to the next key
+    void addKey( int frame, const QMatrix& view, QEasingCurve::Type easing = QEasingCurve::Linear );
+
+    QMatrix viewAt( int frame ) const;
+    QVector<QMatrix> views( int firstFrame, int lastFrame ) const; // one view per frame, both included
+
+private:
+    struct Key
+    {
+        int frame;
+        QMatrix view;
+        QEasingCurve easing;
+        qreal centerX, centerY;
+        qreal angle, scaleX, scaleY, shear;
+        // towards the next key
+        qreal angleDelta;
+        bool geometricScale;
+    };
+
+    int segmentAt( int frame ) const; // index of the last key at or before the frame, -1 before the first one
+    QMatrix viewInSegment( int index, int frame ) const;
+
+    QVector<Key> m_keys;
+};
+
+#endif // CAMERATRACK_H
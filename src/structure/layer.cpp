@@ -21,6 +21,7 @@ GNU General Public License for more details.
 #include "layer.h"
 #include "object.h"
 #include "timeline.h"
+#include "pencilsettings.h"
 
 Layer::Layer(Object* pObject) : QObject( pObject )
 {
@@ -122,8 +123,8 @@ void Layer::paintLabel(QPainter& painter, TimeLineCells* cells, int x, int y, in
 void Layer::paintSelection(QPainter& painter, int x, int y, int width, int height)
 {
     QLinearGradient linearGrad(QPointF(0, y), QPointF(0, y + height));
-    QSettings settings("Pencil","Pencil");
-    QString style = settings.value("style").toString();
+    PencilSettings* settings = pencilSettings();
+    QString style = settings->value("style").toString();
     if (style == "aqua")
     {
         linearGrad.setColorAt(0, QColor(225,225,255,100) );
@@ -48,7 +48,7 @@ public:
 
     LAYER_TYPE type() { return m_eType; }
 
-    void switchVisibility() { visible = !visible;}
+    void switchVisibility() { visible = !visible; emit changed(this); }
     // keyframe interface
     static const int NO_KEYFRAME = -1;
     virtual int getMaxFramePosition() { return NO_KEYFRAME; }
@@ -74,6 +74,10 @@ public:
 
     virtual void editProperties();
 
+signals:
+    // the track of the layer has to be drawn again: its key frames or their selection changed
+    void changed(Layer* layer);
+
 protected:
     LAYER_TYPE m_eType;
     Object* m_pObject;
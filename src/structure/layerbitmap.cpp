@@ -14,6 +14,7 @@ GNU General Public License for more details.
 
 */
 #include "layerbitmap.h"
+#include "thumbnailcache.h"
 #include <QtDebug>
 
 LayerBitmap::LayerBitmap(Object* object) : LayerImage(object)
@@ -30,7 +31,11 @@ LayerBitmap::LayerBitmap(Object* object) : LayerImage(object)
 LayerBitmap::~LayerBitmap()
 {
     while (!m_framesBitmap.empty())
-        delete m_framesBitmap.takeFirst();
+    {
+        BitmapImage* bitmapImage = m_framesBitmap.takeFirst();
+        ThumbnailCache::instance()->invalidate(bitmapImage);
+        delete bitmapImage;
+    }
 }
 
 // ------
@@ -75,6 +80,7 @@ bool LayerBitmap::addImageAtFrame( int frameNumber )
         framesFilename.append("");
         framesModified.append(false);
         bubbleSort();
+        emit changed(this);
 
         return true;
     }
@@ -89,6 +95,7 @@ void LayerBitmap::removeImageAtFrame(int frameNumber)
     int index = getIndexAtFrame(frameNumber);
     if (index != -1  && framesPosition.size() > 1)  // TODO: maybe size=0 is acceptable?
     {
+        ThumbnailCache::instance()->invalidate(m_framesBitmap.at(index));
         delete m_framesBitmap.at(index);
         m_framesBitmap.removeAt(index);
         framesPosition.removeAt(index);
@@ -96,6 +103,7 @@ void LayerBitmap::removeImageAtFrame(int frameNumber)
         framesFilename.removeAt(index);
         framesModified.removeAt(index);
         bubbleSort();
+        emit changed(this);
     }
 }
 
@@ -107,6 +115,16 @@ void LayerBitmap::loadImageAtFrame(QString path, QPoint topLeft, int frameNumber
     m_framesBitmap[index] = new BitmapImage(m_pObject, path, topLeft);
     QFileInfo fi(path);
     framesFilename[index] = fi.fileName();
+    loadThumbnail(index, path);
+}
+
+void LayerBitmap::requestThumbnail(int index)
+{
+    BitmapImage* bitmapImage = getBitmapImageAtIndex(index);
+    if (bitmapImage != NULL && bitmapImage->image != NULL)
+    {
+        ThumbnailCache::instance()->requestBitmap(bitmapImage, *bitmapImage->image);
+    }
 }
 
 void LayerBitmap::swap(int i, int j)
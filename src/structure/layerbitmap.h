@@ -40,6 +40,9 @@ public:
     bool saveImage( int, QString, int );
     QString fileName( int index, int layerNumber );
 
+    const void* getThumbnailKey( int index ) { return getBitmapImageAtIndex( index ); }
+    void requestThumbnail( int index );
+
     QDomElement createDomElement( QDomDocument& doc );
     void loadDomElement( QDomElement element, QString dataDirPath );
 
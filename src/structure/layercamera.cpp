@@ -15,6 +15,7 @@ GNU General Public License for more details.
 */
 #include <QLineEdit>
 #include <QSpinBox>
+#include <QComboBox>
 #include <QLabel>
 #include <QPushButton>
 #include <QHBoxLayout>
@@ -47,6 +48,16 @@ CameraPropertiesDialog::CameraPropertiesDialog(QString name, int width, int heig
     sizeLayout->addWidget(widthBox);
     sizeLayout->addWidget(heightBox);
 
+    QLabel* easingLabel = new QLabel(tr("Easing of the selected keys:"));
+    easingBox = new QComboBox();
+    easingBox->addItem(tr("Linear"), (int)QEasingCurve::Linear);
+    easingBox->addItem(tr("Ease in"), (int)QEasingCurve::InQuad);
+    easingBox->addItem(tr("Ease out"), (int)QEasingCurve::OutQuad);
+    easingBox->addItem(tr("Ease in and out"), (int)QEasingCurve::InOutQuad);
+    QHBoxLayout* easingLayout = new QHBoxLayout();
+    easingLayout->addWidget(easingLabel);
+    easingLayout->addWidget(easingBox);
+
     QPushButton* okButton = new QPushButton(tr("Ok"));
     QPushButton* cancelButton = new QPushButton(tr("Cancel"));
     QHBoxLayout* buttonLayout = new QHBoxLayout();
@@ -56,7 +67,8 @@ CameraPropertiesDialog::CameraPropertiesDialog(QString name, int width, int heig
     QGridLayout* layout = new QGridLayout();
     layout->addLayout(nameLayout, 0, 0);
     layout->addLayout(sizeLayout, 1, 0);
-    layout->addLayout(buttonLayout, 2, 0);
+    layout->addLayout(easingLayout, 2, 0);
+    layout->addLayout(buttonLayout, 3, 0);
     setLayout(layout);
     connect(okButton, SIGNAL(pressed()), this, SLOT(accept()));
     connect(cancelButton, SIGNAL(pressed()), this, SLOT(reject()));
@@ -96,6 +108,17 @@ void CameraPropertiesDialog::setHeight(int height)
     heightBox->setValue(height);
 }
 
+QEasingCurve::Type CameraPropertiesDialog::getEasing()
+{
+    return (QEasingCurve::Type)easingBox->itemData(easingBox->currentIndex()).toInt();
+}
+
+void CameraPropertiesDialog::setEasing(QEasingCurve::Type easing)
+{
+    int index = easingBox->findData((int)easing);
+    easingBox->setCurrentIndex(index == -1 ? 0 : index);
+}
+
 // ------
 
 LayerCamera::LayerCamera(Object* object) : LayerImage(object)
@@ -104,6 +127,7 @@ LayerCamera::LayerCamera(Object* object) : LayerImage(object)
     name = QString(tr("Camera Layer"));
     viewRect = QRect( QPoint(-320,-240), QSize(640,480) );
     dialog = NULL;
+    cameraTrackValid = false;
     addImageAtFrame(1);
 }
 
@@ -139,42 +163,29 @@ Camera* LayerCamera::getLastCameraAtFrame(int frameNumber, int increment)
     return getCameraAtIndex(index + increment);
 }
 
-QMatrix LayerCamera::getViewAtFrame(int frameNumber)
+const CameraTrack& LayerCamera::track()
 {
-    //qDebug() << ">> " << frameNumber;
-    int index = getLastIndexAtFrame(frameNumber);
-    int frame1 = -1;
-    int frame2 = -1;
-    Camera* camera1 = getCameraAtIndex(index);
-    if (camera1) frame1 = framesPosition.at(index);
-    Camera* camera2 = getCameraAtIndex(index+1);
-    if (camera2) frame2 = framesPosition.at(index+1);
-    if (camera1 == NULL && camera2 == NULL)
+    if (!cameraTrackValid)
     {
-        return QMatrix();
-    }
-    if (camera1 == NULL && camera2 != NULL)
-    {
-        return camera2->view;
-    }
-    if (camera2 == NULL && camera1 != NULL)
-    {
-        return camera1->view;
-    }
-    if (camera1 != NULL && camera2 != NULL)
-    {
-        // linear interpolation
-        qreal c2 = (frameNumber-frame1+0.0)/(frame2-frame1);
-        qreal c1 = 1.0 - c2;
-        //qDebug() << ">> -- " << c1 << c2;
-        return QMatrix( c1*camera1->view.m11() + c2*camera2->view.m11(),
-                        c1*camera1->view.m12() + c2*camera2->view.m12(),
-                        c1*camera1->view.m21() + c2*camera2->view.m21(),
-                        c1*camera1->view.m22() + c2*camera2->view.m22(),
-                        c1*camera1->view.dx() + c2*camera2->view.dx(),
-                        c1*camera1->view.dy() + c2*camera2->view.dy()	);
+        cameraTrack.clear();
+        for (int i = 0; i < framesCamera.size(); i++)
+        {
+            cameraTrack.addKey(framesPosition.at(i), framesCamera.at(i)->view, framesCamera.at(i)->easing);
+        }
+        cameraTrackValid = true;
     }
-    return QMatrix();
+    return cameraTrack;
+}
+
+QMatrix LayerCamera::getViewAtFrame(int frameNumber)
+{
+    return track().viewAt(frameNumber);
+}
+
+// the views of a range of frames at once, for exporting
+QVector<QMatrix> LayerCamera::getViewsInRange(int firstFrame, int lastFrame)
+{
+    return track().views(firstFrame, lastFrame);
 }
 
 QRect LayerCamera::getViewRect()
@@ -209,6 +220,8 @@ bool LayerCamera::addImageAtFrame(int frameNumber)
         framesFilename.append("");
         framesModified.append(false);
         bubbleSort();
+        emit changed(this);
+        cameraTrackValid = false;
         int frameNumber1 = frameNumber;
         if (index>0) frameNumber1 = framesPosition.at(index-1);
         if (index<framesPosition.size()-1) frameNumber1 = framesPosition.at(index+1);
@@ -232,6 +245,8 @@ void LayerCamera::removeImageAtFrame(int frameNumber)
         framesFilename.removeAt(index);
         framesModified.removeAt(index);
         bubbleSort();
+        emit changed(this);
+        cameraTrackValid = false;
     }
 }
 
@@ -239,14 +254,21 @@ void LayerCamera::loadImageAtFrame(int frameNumber, QMatrix view)
 {
     if (getIndexAtFrame(frameNumber) == -1) addImageAtFrame(frameNumber);
     int index = getIndexAtFrame(frameNumber);
-    framesCamera[index] = new Camera();
     framesCamera[index]->view = view;
+    cameraTrackValid = false;
 }
 
 void LayerCamera::swap(int i, int j)
 {
     LayerImage::swap(i, j);
     framesCamera.swap(i,j);
+    cameraTrackValid = false;
+}
+
+void LayerCamera::mouseRelease(QMouseEvent* event, int frameNumber)
+{
+    LayerImage::mouseRelease(event, frameNumber); // the selected keys may have moved
+    cameraTrackValid = false;
 }
 
 bool LayerCamera::saveImage(int index, QString path, int layerNumber)
@@ -273,11 +295,26 @@ void LayerCamera::editProperties()
     dialog->setName(name);
     dialog->setWidth(viewRect.width());
     dialog->setHeight(viewRect.height());
+
+    // the easing applies to the selected keys, or to all of them when none is selected
+    QList<Camera*> keys;
+    for (int i = 0; i < framesCamera.size(); i++)
+    {
+        if (framesSelected.at(i)) keys.append(framesCamera.at(i));
+    }
+    if (keys.isEmpty()) keys = framesCamera;
+    dialog->setEasing(keys.isEmpty() ? QEasingCurve::Linear : keys.first()->easing);
+
     int result = dialog->exec();
     if (result == QDialog::Accepted)
     {
         name = dialog->getName();
         viewRect = QRect(-dialog->getWidth()/2, -dialog->getHeight()/2, dialog->getWidth(), dialog->getHeight());
+        for (int i = 0; i < keys.size(); i++)
+        {
+            keys.at(i)->easing = dialog->getEasing();
+        }
+        cameraTrackValid = false;
     }
 }
 
@@ -300,6 +337,7 @@ QDomElement LayerCamera::createDomElement(QDomDocument& doc)
         keyTag.setAttribute("m22", framesCamera[index]->view.m22());
         keyTag.setAttribute("dx", framesCamera[index]->view.dx());
         keyTag.setAttribute("dy", framesCamera[index]->view.dy());
+        keyTag.setAttribute("easing", (int)framesCamera[index]->easing);
         layerTag.appendChild(keyTag);
     }
     return layerTag;
@@ -335,6 +373,7 @@ void LayerCamera::loadDomElement(QDomElement element, QString dataDirPath)
                 qreal dy = imageElement.attribute("dy").toDouble();
 
                 loadImageAtFrame(frame, QMatrix(m11,m12,m21,m22,dx,dy) );
+                getCameraAtFrame(frame)->easing = (QEasingCurve::Type)imageElement.attribute("easing", "0").toInt();
             }
             /*if (imageElement.tagName() == "image") {
                 int frame = imageElement.attribute("frame").toInt();
@@ -23,12 +23,14 @@ GNU General Public License for more details.
 #include <QString>
 #include <QPainter>
 #include "camera.h"
+#include "cameratrack.h"
 #include "layerimage.h"
 #include "bitmapimage.h"
 
 
 class QLineEdit;
 class QSpinBox;
+class QComboBox;
 
 class CameraPropertiesDialog : public QDialog
 {
@@ -42,9 +44,12 @@ public:
     void setWidth(int);
     int getHeight();
     void setHeight(int);
+    QEasingCurve::Type getEasing();
+    void setEasing(QEasingCurve::Type);
 protected:
     QLineEdit* nameBox;
     QSpinBox* widthBox, *heightBox;
+    QComboBox* easingBox;
 };
 
 class LayerCamera : public LayerImage
@@ -65,6 +70,7 @@ public:
     bool saveImage(int, QString, int);
 
     void editProperties();
+    void mouseRelease(QMouseEvent* event, int frameNumber);
 
     QDomElement createDomElement(QDomDocument& doc);
     void loadDomElement(QDomElement element, QString dataDirPath);
@@ -73,6 +79,7 @@ public:
     Camera* getCameraAtFrame(int frameNumber);
     Camera* getLastCameraAtFrame(int frameNumber, int increment);
     QMatrix getViewAtFrame(int frameNumber);
+    QVector<QMatrix> getViewsInRange(int firstFrame, int lastFrame);
 
     QRect getViewRect();
 
@@ -82,6 +89,11 @@ protected:
 
     QList<Camera*> framesCamera;
     void swap(int i, int j);
+
+    // interpolation data, rebuilt after the keys have changed
+    const CameraTrack& track();
+    CameraTrack cameraTrack;
+    bool cameraTrackValid;
 };
 
 #endif
@@ -17,9 +17,11 @@ GNU General Public License for more details.
 #include <QMouseEvent>
 #include <QImage>
 #include <QPainter>
+#include <QtAlgorithms>
 #include "object.h"
 #include "timeline.h"
 #include "timelinecells.h"
+#include "thumbnailcache.h"
 
 #include "layerimage.h"
 
@@ -128,6 +130,12 @@ int LayerImage::getLastIndexAtFrame(int frameNumber)
     return index;
 }
 
+// index of the first key frame at or after this frame ( framesPosition is sorted )
+int LayerImage::getFirstIndexFrom(int frameNumber)
+{
+    return qLowerBound(framesPosition.begin(), framesPosition.end(), frameNumber) - framesPosition.begin();
+}
+
 void LayerImage::paintTrack(QPainter& painter, TimeLineCells* cells, int x, int y, int width, int height, bool selected, int frameSize)
 {
     painter.setFont(QFont("helvetica", height/2));
@@ -162,12 +170,14 @@ void LayerImage::paintTrack(QPainter& painter, TimeLineCells* cells, int x, int
 
 void LayerImage::paintImages(QPainter& painter, TimeLineCells* cells, int x, int y, int width, int height, bool selected, int frameSize)
 {
-    Q_UNUSED(x);
-    Q_UNUSED(width);
     painter.setPen(QPen(QBrush(QColor(40,40,40)), 1, Qt::SolidLine, Qt::RoundCap,Qt::RoundJoin));
     if (visible)
     {
-        for(int i=0; i < framesPosition.size(); i++)
+        // only the key frames in view, widened by the offset of the frames being dragged
+        int margin = qAbs(frameOffset);
+        int firstFrame = cells->getFrameNumber(x) - margin;
+        int lastFrame = cells->getFrameNumber(x + width) + margin;
+        for(int i = getFirstIndexFrom(firstFrame); i < framesPosition.size() && framesPosition.at(i) <= lastFrame; i++)
         {
             if (framesSelected.at(i))
             {
@@ -186,10 +196,59 @@ void LayerImage::paintImages(QPainter& painter, TimeLineCells* cells, int x, int
                 //painter.drawRect(x+(framesPosition.at(i)-1)*frameSize+2, y+1, frameSize-2, height-4);
                 //painter.drawText(QPoint( (framesPosition.at(i)-1)*frameSize+5, y+(2*height)/3), QString::number(i) );
             }
+            if (ThumbnailCache::instance()->isEnabled())
+            {
+                paintThumbnail(painter, cells, i, y, height, frameSize);
+            }
         }
     }
 }
 
+// the thumbnail spans from the key frame towards the next one, it is drawn once it has been rendered
+void LayerImage::paintThumbnail(QPainter& painter, TimeLineCells* cells, int index, int y, int height, int frameSize)
+{
+    QImage thumbnail = getThumbnail(index);
+    if (thumbnail.isNull())
+    {
+        return;
+    }
+    int offset = framesSelected.at(index) ? frameOffset : 0;
+    int left = cells->getFrameX(framesPosition.at(index)+offset)-frameSize+3;
+    int right = left + (height-6)*4/3;
+    if (index + 1 < framesPosition.size())
+    {
+        right = qMin(right, cells->getFrameX(framesPosition.at(index+1))-frameSize);
+    }
+    QRect box(left, y+2, right-left, height-6);
+    if (box.width() < 4)
+    {
+        return;
+    }
+    QSize size = thumbnail.size();
+    size.scale(box.size(), Qt::KeepAspectRatio);
+    painter.drawImage(QRect(box.topLeft(), size), thumbnail);
+}
+
+QImage LayerImage::getThumbnail(int index)
+{
+    const void* key = getThumbnailKey(index);
+    QImage thumbnail = ThumbnailCache::instance()->thumbnail(key);
+    if (thumbnail.isNull())
+    {
+        requestThumbnail(index); // drawn later, when thumbnailsReady() is emitted
+    }
+    return thumbnail;
+}
+
+void LayerImage::loadThumbnail(int index, QString imagePath)
+{
+    QImage thumbnail(imagePath + ".thumb.png");
+    if (!thumbnail.isNull())
+    {
+        ThumbnailCache::instance()->insert(getThumbnailKey(index), thumbnail);
+    }
+}
+
 void LayerImage::mousePress(QMouseEvent* event, int frameNumber)
 {
     frameClicked = frameNumber;
@@ -213,6 +272,7 @@ void LayerImage::mousePress(QMouseEvent* event, int frameNumber)
             framesSelected[i] = true;
         }
     }
+    emit changed(this);
 }
 
 void LayerImage::mouseDoubleClick(QMouseEvent* event, int frameNumber)
@@ -226,6 +286,7 @@ void LayerImage::mouseDoubleClick(QMouseEvent* event, int frameNumber)
             framesSelected[i] = true;
         }
     }
+    emit changed(this);
 }
 
 
@@ -252,6 +313,7 @@ void LayerImage::mouseMove(QMouseEvent* event, int frameNumber)
         }
     }
     if (ok == false) frameOffset = 0;
+    emit changed(this);
 }
 
 void LayerImage::mouseRelease(QMouseEvent* event, int frameNumber)
@@ -272,6 +334,7 @@ void LayerImage::mouseRelease(QMouseEvent* event, int frameNumber)
     }
     bubbleSort();
     frameOffset = 0;
+    emit changed(this);
 }
 
 bool LayerImage::addImageAtFrame(int frameNumber)
@@ -284,6 +347,7 @@ bool LayerImage::addImageAtFrame(int frameNumber)
         framesFilename.append("");
         framesModified.append(false);
         bubbleSort();
+        emit changed(this);
 
         return true;
     }
@@ -302,6 +366,7 @@ void LayerImage::removeImageAtFrame(int frameNumber)
         framesSelected.removeAt(index);
         framesFilename.removeAt(index);
         framesModified.removeAt(index);
+        emit changed(this);
     }
     bubbleSort();
 }
@@ -349,6 +414,11 @@ void LayerImage::setModified(int frameNumber, bool trueOrFalse)
     {
         framesModified[index] = trueOrFalse;
         m_pObject->modification();
+        if (trueOrFalse)
+        {
+            ThumbnailCache::instance()->invalidate(getThumbnailKey(index));
+        }
+        emit changed(this);
     }
 }
 
@@ -358,6 +428,7 @@ void LayerImage::deselectAllFrames()
     {
         framesSelected[i] = false;
     }
+    emit changed(this);
 }
 
 bool LayerImage::saveImages(QString path, int layerNumber)
@@ -370,6 +441,18 @@ bool LayerImage::saveImages(QString path, int layerNumber)
     {
         qDebug() << "Trying to save " << framesFilename.at(i) << " of layer n. " << layerNumber;
         saveImage(i, path, layerNumber);
+
+        // the thumbnails already rendered are kept with the project, stale ones are removed
+        QString thumbnailPath = path + "/" + framesFilename.at(i) + ".thumb.png";
+        QImage thumbnail = ThumbnailCache::instance()->thumbnail(getThumbnailKey(i));
+        if (ThumbnailCache::instance()->isEnabled() && !thumbnail.isNull())
+        {
+            thumbnail.save(thumbnailPath, "PNG");
+        }
+        else
+        {
+            dir.remove(thumbnailPath);
+        }
     }
     qDebug() << "Layer " << layerNumber << "done";
     return true;
@@ -47,6 +47,7 @@ public:
     int getFramePositionAt(int index);
     int getIndexAtFrame(int frameNumber);
     int getLastIndexAtFrame(int frameNumber);
+    int getFirstIndexFrom(int frameNumber);
 
     // FIXME: this API only used in vector layer
     virtual QImage* getImageAtIndex( int, QSize, bool, bool, qreal, bool, int ) { return NULL; }
@@ -56,6 +57,11 @@ public:
     virtual void setModified(int frameNumber, bool trueOrFalse);
     void deselectAllFrames();
 
+    // timeline thumbnails, looked up by the image of the key frame
+    virtual const void* getThumbnailKey(int index) { Q_UNUSED(index); return NULL; }
+    virtual void requestThumbnail(int index) { Q_UNUSED(index); }
+    QImage getThumbnail(int index);
+
     bool saveImages(QString path, int layerNumber);
     virtual bool saveImage(int index, QString path, int layerNumber);
     virtual QString fileName(int index, int layerNumber);
@@ -82,6 +88,9 @@ protected:
     int frameClicked;
     int frameOffset;
 
+    void loadThumbnail(int index, QString imagePath);
+    void paintThumbnail(QPainter& painter, TimeLineCells* cells, int index, int y, int height, int frameSize);
+
     // sorts all QList according to frame position
     void bubbleSort();
     virtual void swap(int i, int j);
@@ -13,10 +13,13 @@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
 GNU General Public License for more details.
 
 */
+#include <cmath>
 #include <QtDebug>
-#include <QMediaPlayer>
 #include "object.h"
 #include "layersound.h"
+#include "audiomixer.h"
+#include "soundwaveform.h"
+#include "timelinecells.h"
 
 
 LayerSound::LayerSound(Object* object) : LayerImage(object)
@@ -27,20 +30,16 @@ LayerSound::LayerSound(Object* object) : LayerImage(object)
 
 LayerSound::~LayerSound()
 {
-    while (!sound.empty())
-        delete sound.takeFirst();
 }
 
 
 void LayerSound::paintImages(QPainter& painter, TimeLineCells* cells, int x, int y, int width, int height, bool selected, int frameSize)
 {
-    Q_UNUSED(cells);
-    Q_UNUSED(width);
     Q_UNUSED(selected);
 
-    for (int i = 0; i < sound.size(); i++)
+    for (int i = 0; i < soundValid.size(); i++)
     {
-        qreal h = x + (framesPosition.at(i)-1)*frameSize+2;
+        qreal h = cells->getFrameX(framesPosition.at(i)) - frameSize + 2;
         if (framesSelected.at(i))
         {
             painter.setBrush(QColor(60,60,60));
@@ -50,25 +49,63 @@ void LayerSound::paintImages(QPainter& painter, TimeLineCells* cells, int x, int
         {
             painter.setBrush(QColor(125,125,125));
         }
+        if (soundValid.at(i))
+        {
+            paintWaveform(painter, SoundWaveformCache::instance()->waveform(soundFilepath.at(i)), h - 2, x, y, width, height, cells->getFps(), frameSize);
+        }
         QPointF points[3] = { QPointF(h, y+4), QPointF(h, y+height-4), QPointF(h+15, y+0.5*height) };
         painter.drawPolygon( points, 3 );
         painter.drawText(QPoint( h + 20, y+(2*height)/3), framesFilename.at(i) );
     }
 }
 
+void LayerSound::paintWaveform(QPainter& painter, const SoundWaveform& waveform, qreal clipX, int x, int y, int width, int height, int fps, int frameSize)
+{
+    if (waveform.isEmpty() || fps <= 0 || frameSize <= 0)
+    {
+        return;
+    }
+    // one vertical line per pixel column: the cost depends on the width drawn, not on the length of the clip
+    qreal framesPerPixel = qreal(AudioMixer::SAMPLE_RATE) / (fps * frameSize);
+    int left = qMax(x, int(floor(clipX)));
+    int right = qMin(x + width, int(ceil(clipX + waveform.frameCount() / framesPerPixel)));
+    if (left >= right)
+    {
+        return;
+    }
+
+    qreal middle = y + 0.5*height;
+    qreal scale = (0.5*height - 2) / 32768.0;
+    QVector<QLineF> lines;
+    lines.reserve(right - left);
+    for (int column = left; column < right; column++)
+    {
+        qint64 from = qint64((column - clipX) * framesPerPixel);
+        qint64 to = qint64((column + 1 - clipX) * framesPerPixel);
+        qint16 low, high;
+        waveform.peak(from, qMax(to, from + 1), &low, &high);
+        lines.append(QLineF(column + 0.5, middle - high*scale, column + 0.5, middle - low*scale));
+    }
+    painter.save();
+    painter.setPen(QPen(QColor(90,90,90), 1));
+    painter.drawLines(lines);
+    painter.restore();
+}
+
 bool LayerSound::addImageAtFrame(int frameNumber)
 {
     int index = getIndexAtFrame(frameNumber);
     if (index == -1)
     {
-        sound.append(NULL);
+        soundValid.append(false);
         soundFilepath.append("");
         framesPosition.append(frameNumber);
         framesSelected.append(false);
         framesFilename.append("");
         framesModified.append(false);
-        soundSize.append(0);
         bubbleSort();
+        emit soundChanged();
+        emit changed(this);
         return true;
     }
     else
@@ -82,15 +119,15 @@ void LayerSound::removeImageAtFrame(int frameNumber)
     int index = getIndexAtFrame(frameNumber);
     if (index != -1  && framesPosition.size() != 0)
     {
-        delete sound.at(index);
-
+        soundValid.removeAt(index);
         soundFilepath.removeAt(index);
         framesPosition.removeAt(index);
         framesSelected.removeAt(index);
         framesFilename.removeAt(index);
         framesModified.removeAt(index);
-        soundSize.removeAt(index);
         bubbleSort();
+        emit soundChanged();
+        emit changed(this);
     }
 }
 
@@ -104,33 +141,35 @@ void LayerSound::loadSoundAtFrame(QString filePathString, int frameNumber)
     QFileInfo fi(filePathString);
     if (fi.exists())
     {
-        //Phonon::MediaObject* media = new Phonon::MediaObject();
-        //connect(media, SIGNAL(totalTimeChanged(qint64)), this, SLOT(addTimelineKey(qint64)));
-        //media->setCurrentSource(filePathString);
-        QMediaPlayer* pPlayer = new QMediaPlayer( this );
-        pPlayer->setMedia( QUrl::fromLocalFile(filePathString) );
-
-        // quick and dirty trick to calculate soundSize
-        // totalTime() return a value only after a call to media.play()
-        //  ( and when signal totaltimechanged is emitted totalTime() returns the correct value )
-        
-        sound[index] = pPlayer;
+        soundValid[index] = true;
         soundFilepath[index] = filePathString;
         framesFilename[index] = fi.fileName();
         framesModified[index] = true;
     }
     else
     {
-        sound[index] = NULL;
+        soundValid[index] = false;
         soundFilepath[index] = tr("Wrong file");
         framesFilename[index] = tr("Wrong file") + filePathString;
     }
+    emit soundChanged();
+    emit changed(this);
+}
+
+void LayerSound::mouseRelease(QMouseEvent* event, int frameNumber)
+{
+    bool moved = (frameOffset != 0);
+    LayerImage::mouseRelease(event, frameNumber);
+    if (moved)
+    {
+        emit soundChanged();
+    }
 }
 
 void LayerSound::swap(int i, int j)
 {
     LayerImage::swap(i, j);
-    sound.swap(i, j);
+    soundValid.swap(i, j);
     soundFilepath.swap(i,j);
 }
 
@@ -141,60 +180,13 @@ bool LayerSound::saveImage(int index, QString path, int layerNumber)
     
     QFile originalFile( soundFilepath.at(index) );
     originalFile.copy( path + "/" + framesFilename.at(index) );
+    // the peaks are kept next to the sound, so that the waveform shows without decoding it again
+    SoundWaveformCache::instance()->save( soundFilepath.at(index), SoundWaveformCache::peaksPathOf( path + "/" + framesFilename.at(index) ) );
     framesModified[index] = false;
 
     return true;
 }
 
-void LayerSound::playSound(int frame, int fps)
-{
-    for (int i = 0; i < sound.size(); ++i)
-    {
-        QMediaPlayer* media = sound.at(i);
-        if (media != NULL && visible)
-        {
-            int position = framesPosition.at(i);
-            if (frame < position)
-            {
-                media->stop();
-            }
-            else
-            {
-                int offsetInMs = floor((frame - position) * float(1000) / fps);
-                if (media->state() == QMediaPlayer::PlayingState)
-                {
-                    if (fabs((float)media->position() - offsetInMs) > 500.0f)
-                        media->setPosition(offsetInMs);
-                }
-                else
-                {
-                    if (frame > position)
-                    {
-                        media->pause();
-                        media->setPosition(offsetInMs);
-                    }
-                    if (offsetInMs < soundSize[i])
-                    {                        
-                        media->play();
-                    }
-                }
-            }
-        }
-    }
-}
-
-
-
-void LayerSound::stopSound()
-{
-    for(int i=0; i < sound.size(); i++)
-    {
-        Q_ASSERT( sound[i] );
-        sound[i]->stop();
-    }
-}
-
-
 QDomElement LayerSound::createDomElement(QDomDocument& doc)
 {
     QDomElement layerTag = doc.createElement("layer");
@@ -24,7 +24,7 @@ GNU General Public License for more details.
 //#include <phonon/AudioOutput>
 #include "layerimage.h"
 
-class QMediaPlayer;
+class SoundWaveform;
 
 class LayerSound : public LayerImage
 {
@@ -42,26 +42,31 @@ public:
     void loadSoundAtFrame( QString filePathString, int frame );
 
     bool saveImage(int index, QString path, int layerNumber);
-    void playSound(int frame,int fps);
-    void stopSound();
 
-    bool isEmpty() const { return sound.count() == 0; }
+    bool isEmpty() const { return soundValid.count() == 0; }
     // graphic representation -- could be put in another class
     void paintImages(QPainter& painter, TimeLineCells* cells, int x, int y, int width, int height, bool selected, int frameSize);
 
     QString getSoundFilepathAt(int index) { return soundFilepath.at(index); }
-    int getSoundSize() { return sound.size(); }
-    bool soundIsNotNull(int index) { return (sound[index] != NULL); }
+    int getSoundSize() { return soundValid.size(); }
+    bool soundIsNotNull(int index) { return soundValid[index]; }
+
+    void mouseRelease(QMouseEvent* event, int frameNumber);
+
+signals:
+    // a clip was added, removed, moved or replaced: the mix has to be made again
+    void soundChanged();
 
 protected:
 
     QList<QString> soundFilepath;
-    QList<qint64> soundSize;
-    
+
     // graphic representation -- could be put in another class
+    void paintWaveform(QPainter& painter, const SoundWaveform& waveform, qreal clipX, int x, int y, int width, int height, int fps, int frameSize);
     void swap(int i, int j);
 
-    QList<QMediaPlayer*> sound;
+    // the clips are decoded and played by AudioMixer and AudioPlayer
+    QList<bool> soundValid;
 };
 
 #endif
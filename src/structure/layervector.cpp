@@ -14,6 +14,9 @@ GNU General Public License for more details.
 
 */
 #include "layervector.h"
+#include "vectortilecache.h"
+#include "thumbnailcache.h"
+#include "pencilsettings.h"
 #include <QtDebug>
 
 LayerVector::LayerVector(Object* object) : LayerImage(object)
@@ -27,60 +30,44 @@ LayerVector::LayerVector(Object* object) : LayerImage(object)
 LayerVector::~LayerVector()
 {
     while (!framesVector.empty())
-        delete framesVector.takeFirst();
-    while (!framesImage.empty())
-        delete framesImage.takeFirst();
-}
-
-// ------
-
-QImage* LayerVector::getImageAtIndex( int index,
-									  QSize size,
-									  bool simplified,
-									  bool showThinLines,
-									  qreal curveOpacity,
-									  bool antialiasing)
-{
-    if ( index < 0 || index >= framesImage.size() )
     {
-        return NULL;
-    }
-    else
-    {
-        VectorImage* vectorImage = getVectorImageAtIndex(index);
-        QImage* image = framesImage.at(index);
-        if (vectorImage->isModified() || size != image->size() )
-        {
-            if ( image->size() != size)
-            {
-                delete image;
-                framesImage[index] = image = new QImage(size, QImage::Format_ARGB32_Premultiplied);
-            }
-            vectorImage->outputImage(image, size, myView,
-									 simplified, showThinLines,
-									 curveOpacity, antialiasing );
-            vectorImage->setModified(false);
-        }
-        return image;
+        VectorImage* vectorImage = framesVector.takeFirst();
+        VectorTileCache::instance()->invalidate(vectorImage);
+        ThumbnailCache::instance()->invalidate(vectorImage);
+        delete vectorImage;
     }
 }
 
-QImage* LayerVector::getLastImageAtFrame(int frameNumber,
-										 int increment,
-										 QSize size,
-										 bool simplified, bool showThinLines,
-										 qreal curveOpacity,
-										 bool antialiasing )
+// ------
+
+// the frames are drawn through the shared tile cache, so that panning and zooming
+// only render the parts of the drawing which are not already cached
+void LayerVector::paintImageAtFrame(QPainter& painter,
+                                    int frameNumber,
+                                    int increment,
+                                    bool simplified,
+                                    bool showThinLines,
+                                    qreal curveOpacity,
+                                    bool antialiasing)
 {
     int index = getLastIndexAtFrame(frameNumber);
     if (index == -1)
     {
-        return NULL;
+        return;
     }
-    else
+    VectorImage* vectorImage = getVectorImageAtIndex(index + increment);
+    if (vectorImage == NULL)
+    {
+        return;
+    }
+    if (vectorImage->isModified())
     {
-        return getImageAtIndex(index + increment, size, simplified, showThinLines, curveOpacity, antialiasing );
+        VectorTileCache::instance()->invalidate(vectorImage, vectorImage->getChangedRect());
+        vectorImage->setModified(false);
     }
+    VectorTileCache::instance()->paintImage(painter, vectorImage, myView,
+                                            simplified, showThinLines,
+                                            curveOpacity, antialiasing);
 }
 
 // ------
@@ -111,8 +98,8 @@ VectorImage* LayerVector::getLastVectorImageAtFrame(int frameNumber, int increme
 
 void LayerVector::setView(QMatrix view)
 {
+    // the cached tiles are laid out in world space and stay valid
     myView = view;
-    setModified(true);
 }
 
 void LayerVector::setModified(bool trueOrFalse)
@@ -156,13 +143,13 @@ bool LayerVector::addImageAtFrame(int frameNumber)
     {
         //framesVector.append(new VectorImage(imageSize, QImage::Format_ARGB32_Premultiplied, object));
         framesVector.append(new VectorImage(m_pObject));
-        framesImage.append(new QImage( QSize(2,2), QImage::Format_ARGB32_Premultiplied)); // very small image to begin with
 
         framesPosition.append(frameNumber);
         framesSelected.append(false);
         framesFilename.append("");
         framesModified.append(false);
         bubbleSort();
+        emit changed(this);
         return true;
     }
     else
@@ -176,17 +163,17 @@ void LayerVector::removeImageAtFrame(int frameNumber)
     int index = getIndexAtFrame(frameNumber);
     if (index != -1 && framesPosition.size() != 1)
     {
+        VectorTileCache::instance()->invalidate(framesVector.at(index));
+        ThumbnailCache::instance()->invalidate(framesVector.at(index));
         delete framesVector.at(index);
         framesVector.removeAt(index);
 
-        delete framesImage.at(index);
-        framesImage.removeAt(index);
-
         framesPosition.removeAt(index);
         framesSelected.removeAt(index);
         framesFilename.removeAt(index);
         framesModified.removeAt(index);
         bubbleSort();
+        emit changed(this);
     }
 }
 
@@ -197,6 +184,16 @@ void LayerVector::loadImageAtFrame(QString path, int frameNumber)
     framesVector[index]->read(path);
     QFileInfo fi(path);
     framesFilename[index] = fi.fileName();
+    loadThumbnail(index, path);
+}
+
+void LayerVector::requestThumbnail(int index)
+{
+    VectorImage* vectorImage = getVectorImageAtIndex(index);
+    if (vectorImage != NULL)
+    {
+        ThumbnailCache::instance()->requestVector(vectorImage, *vectorImage);
+    }
 }
 
 /*void LayerVector::loadImageAtFrame(VectorImage* picture, int frameNumber) {
@@ -210,7 +207,6 @@ void LayerVector::swap(int i, int j)
 {
     LayerImage::swap(i, j);
     framesVector.swap(i,j);
-    framesImage.swap(i,j);
 }
 
 
@@ -221,7 +217,9 @@ bool LayerVector::saveImage(int index, QString path, int layerNumber)
     QString theFileName = fileName(theFrame, id);
     framesFilename[index] = theFileName;
     //qDebug() << "Write " << theFileName;
-    framesVector[index]->write(path +"/"+ theFileName,"VEC");
+    // XML, which older versions can read, unless the compact binary form is chosen in the preferences
+    bool binary = pencilSettings()->value(SETTING_VECTOR_BINARY_FORMAT, false).toBool();
+    framesVector[index]->write(path +"/"+ theFileName, binary ? "BIN" : "VEC");
     framesModified[index] = false;
 
     return true;
@@ -37,8 +37,8 @@ public:
     virtual void removeImageAtFrame(int frameNumber);
 
     void loadImageAtFrame(QString, int);
-    virtual QImage* getImageAtIndex(int, QSize, bool, bool, qreal, bool );
-    QImage* getLastImageAtFrame(int, int, QSize, bool, bool, qreal, bool );
+    void paintImageAtFrame(QPainter& painter, int frameNumber, int increment,
+                           bool simplified, bool showThinLines, qreal curveOpacity, bool antialiasing);
 
     bool saveImage(int, QString, int);
     void setView(QMatrix view);
@@ -46,6 +46,9 @@ public:
     void setModified(bool trueOrFalse);
     void setModified(int frameNumber, bool trueOrFalse);
 
+    const void* getThumbnailKey(int index) { return getVectorImageAtIndex(index); }
+    void requestThumbnail(int index);
+
     QDomElement createDomElement(QDomDocument& doc);
     virtual void loadDomElement(QDomElement element,  QString dataDirPath);
 
@@ -59,7 +62,6 @@ public:
 
 protected:
     QList<VectorImage*> framesVector;
-    QList<QImage*> framesImage; // bitmap output of the vector pictures
     void swap(int i, int j);
     QMatrix myView;
 };
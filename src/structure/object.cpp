@@ -18,6 +18,7 @@ GNU General Public License for more details.
 #include <QTextStream>
 #include <QMessageBox>
 #include <QProgressDialog>
+#include <QFileInfo>
 
 #include "object.h"
 #include "layer.h"
@@ -25,10 +26,12 @@ GNU General Public License for more details.
 #include "layervector.h"
 #include "layersound.h"
 #include "layercamera.h"
+#include "audiomixer.h"
 
 //#include "flash.h"
 #include "editor.h"
 #include "bitmapimage.h"
+#include "perfmonitor.h"
 
 // ******* Mac-specific: ******** (please comment (or reimplement) the lines below to compile on Windows or Linux
 //#include <CoreFoundation/CoreFoundation.h>
@@ -174,6 +177,7 @@ LayerBitmap *Object::addNewBitmapLayer()
     LayerBitmap* layerBitmap = new LayerBitmap(this);
     layerBitmap->id = 1+getMaxID();
     layer.append( layerBitmap );
+    connect( layerBitmap, SIGNAL( changed( Layer* ) ), this, SIGNAL( layerChanged( Layer* ) ) );
 
     return layerBitmap;
 }
@@ -183,6 +187,7 @@ LayerVector *Object::addNewVectorLayer()
     LayerVector* layerVector = new LayerVector(this);
     layerVector->id = 1+getMaxID();
     layer.append( layerVector );
+    connect( layerVector, SIGNAL( changed( Layer* ) ), this, SIGNAL( layerChanged( Layer* ) ) );
 
     return layerVector;
 }
@@ -192,6 +197,8 @@ LayerSound *Object::addNewSoundLayer()
     LayerSound* layerSound = new LayerSound(this);
     layerSound->id = 1+getMaxID();
     layer.append( layerSound );
+    connect( layerSound, SIGNAL( changed( Layer* ) ), this, SIGNAL( layerChanged( Layer* ) ) );
+    connect( layerSound, SIGNAL( soundChanged() ), this, SIGNAL( soundChanged() ) );
     return layerSound;
 }
 
@@ -200,6 +207,7 @@ LayerCamera *Object::addNewCameraLayer()
     LayerCamera* layerCamera = new LayerCamera(this);
     layerCamera->id = 1+getMaxID();
     layer.append( layerCamera );
+    connect( layerCamera, SIGNAL( changed( Layer* ) ), this, SIGNAL( layerChanged( Layer* ) ) );
 
     return layerCamera;
 }
@@ -240,6 +248,7 @@ void Object::moveLayer(int i, int j)
         {
             layer.removeAt(i);
         }
+        emit layerChanged(NULL);
     }
 }
 
@@ -249,30 +258,24 @@ void Object::deleteLayer(int i)
     {
         //layer.removeAt(i);
         disconnect( layer[i], 0, this, 0); // disconnect the layer from this object
+        bool sound = ( layer[i]->type() == Layer::SOUND );
         delete layer.takeAt(i);
-    }
-}
-
-void Object::playSoundIfAny(int frame,int fps)
-{
-    for(int i=0; i < getLayerCount(); i++)
-    {
-        Layer* layer = getLayer(i);
-        if ( layer->type() == Layer::SOUND)
+        if ( sound )
         {
-            ((LayerSound*)layer)->playSound(frame,fps);
+            emit soundChanged();
         }
+        emit layerChanged(NULL);
     }
 }
 
-void Object::stopSoundIfAny()
+void Object::mixSounds(AudioMixer& mixer, int fps, int firstFrame)
 {
     for(int i=0; i < getLayerCount(); i++)
     {
         Layer* layer = getLayer(i);
-        if ( layer->type() == Layer::SOUND)
+        if ( layer->type() == Layer::SOUND && layer->visible )
         {
-            ((LayerSound*)layer)->stopSound();
+            mixer.addLayer((LayerSound*)layer, fps, firstFrame);
         }
     }
 }
@@ -489,11 +492,11 @@ bool Object::exportFrames(int frameStart, int frameEnd, QMatrix view, Layer* cur
 						  QSize exportSize, QString filePath,
 						  const char* format, int quality,
 						  bool background, bool antialiasing,
+						  qreal curveOpacity,
 						  QProgressDialog* progress=NULL,
 						  int progressMax=50)
 {
-    QSettings settings("Pencil","Pencil");
-    qreal curveOpacity = (100-settings.value("curveOpacity").toInt())/100.0; // default value is 1.0
+    PERF_SCOPE("Object::exportFrames");
 
     QString extension = "";
     QString formatStr = format;
@@ -508,13 +511,38 @@ bool Object::exportFrames(int frameStart, int frameEnd, QMatrix view, Layer* cur
         extension = ".jpg";
         background = true; // JPG doesn't support transparency so we have to include the background
     }
-    if (filePath.endsWith(extension, Qt::CaseInsensitive))
+    if ( formatStr == "TIF" || formatStr == "tif")
+    {
+        format = "TIF";
+        extension = ".tif";
+    }
+    if ( formatStr == "BMP" || formatStr == "bmp")
+    {
+        format = "BMP";
+        extension = ".bmp";
+    }
+    // a suffix of the format is kept as written (out.jpeg, out.PNG), as BatchRenderer::framePath() expects
+    QString suffix = QFileInfo(filePath).suffix();
+    bool knownSuffix = !extension.isEmpty() && suffix.compare(extension.mid(1), Qt::CaseInsensitive) == 0;
+    if (extension == ".jpg" && suffix.compare("jpeg", Qt::CaseInsensitive) == 0)
     {
+        knownSuffix = true;
+    }
+    if (knownSuffix)
+    {
+        extension = "." + suffix;
         filePath.chop(extension.size());
     }
     //qDebug() << "format =" << format << "extension = " << extension;
 
     qDebug() << "Exporting frames from " << frameStart << "to" << frameEnd << "at size " << exportSize;
+    // without a camera layer the frames are painted with the given view
+    bool useCamera = (currentLayer != NULL && currentLayer->type() == Layer::CAMERA);
+    QVector<QMatrix> cameraViews;
+    if (useCamera)
+    {
+        cameraViews = ((LayerCamera*)currentLayer)->getViewsInRange(frameStart, frameEnd);
+    }
     for(int currentFrame = frameStart; currentFrame <= frameEnd ; currentFrame++)
     {
         if ( progress != NULL ) progress->setValue((currentFrame-frameStart)*progressMax/(frameEnd-frameStart));
@@ -524,11 +552,11 @@ bool Object::exportFrames(int frameStart, int frameEnd, QMatrix view, Layer* cur
         // Make sure that old frame is erased before exporting a new one
         tempImage.fill(0x00000000);
 
-        if (currentLayer->type() == Layer::CAMERA)
+        if (useCamera)
         {
             QRect viewRect = ((LayerCamera*)currentLayer)->getViewRect();
             QMatrix mapView = Editor::map( viewRect, QRectF(QPointF(0,0), exportSize) );
-            mapView = ((LayerCamera*)currentLayer)->getViewAtFrame(currentFrame) * mapView;
+            mapView = cameraViews.at(currentFrame - frameStart) * mapView;
             painter.setWorldMatrix(mapView);
         }
         else
@@ -539,10 +567,12 @@ bool Object::exportFrames(int frameStart, int frameEnd, QMatrix view, Layer* cur
 
         QString frameNumberString = QString::number(currentFrame);
         while ( frameNumberString.length() < 4) frameNumberString.prepend("0");
-        tempImage.save(filePath+frameNumberString+extension, format, quality);
+        if (!tempImage.save(filePath+frameNumberString+extension, format, quality))
+        {
+            qDebug() << "Cannot write" << filePath+frameNumberString+extension;
+            return false;
+        }
     }
-
-    // XXX no error handling done yet
     return true;
 }
 
@@ -574,10 +604,12 @@ bool Object::exportFrames1(int frameStart, int frameEnd,
 						   int quality,
 						   bool background,
 						   bool antialiasing,
+						   qreal curveOpacity,
 						   QProgressDialog* progress,
 						   int progressMax,
 						   int fps, int exportFps)
 {
+    PERF_SCOPE("Object::exportFrames1");
     int frameRepeat;
     int frameReminder, frameReminder1;
     int framePutEvery, framePutEvery1;
@@ -585,8 +617,6 @@ bool Object::exportFrames1(int frameStart, int frameEnd,
     int frameNumber;
     int framePerSecond;
 
-    QSettings settings("Pencil","Pencil");
-    qreal curveOpacity = (100-settings.value("curveOpacity").toInt())/100.0; // default value is 1.0
 
     QString extension = "";
     QString formatStr = format;
@@ -608,6 +638,11 @@ bool Object::exportFrames1(int frameStart, int frameEnd,
     //qDebug() << "format =" << format << "extension = " << extension;
 
     qDebug() << "Exporting frames from " << frameStart << "to" << frameEnd << "at size " << exportSize;
+    QVector<QMatrix> cameraViews;
+    if (currentLayer->type() == Layer::CAMERA)
+    {
+        cameraViews = ((LayerCamera*)currentLayer)->getViewsInRange(frameStart, frameEnd);
+    }
     convertNFrames(fps,exportFps,&frameRepeat,&frameReminder,&framePutEvery,&frameSkipEvery);
     qDebug() << "fps " << fps << " exportFps " << exportFps << " frameRepeat " << frameRepeat << " frameReminder " << frameReminder << " framePutEvery " << framePutEvery << " frameSkipEvery " << frameSkipEvery;
     frameNumber = 0;
@@ -628,7 +663,7 @@ bool Object::exportFrames1(int frameStart, int frameEnd,
         {
             QRect viewRect = ((LayerCamera*)currentLayer)->getViewRect();
             QMatrix mapView = Editor::map( viewRect, QRectF(QPointF(0,0), exportSize) );
-            mapView = ((LayerCamera*)currentLayer)->getViewAtFrame(currentFrame) * mapView;
+            mapView = cameraViews.at(currentFrame - frameStart) * mapView;
             painter.setWorldMatrix(mapView);
         }
         else
@@ -689,10 +724,9 @@ bool Object::exportFrames1(int frameStart, int frameEnd,
 
 
 
-bool Object::exportX(int frameStart, int frameEnd, QMatrix view, QSize exportSize, QString filePath, bool antialiasing)
+bool Object::exportX(int frameStart, int frameEnd, QMatrix view, QSize exportSize, QString filePath, bool antialiasing, qreal curveOpacity)
 {
-    QSettings settings("Pencil","Pencil");
-    qreal curveOpacity = (100-settings.value("curveOpacity").toInt())/100.0; // default value is 1.0
+    PERF_SCOPE("Object::exportX");
 
     int page;
     page=0;
@@ -732,11 +766,10 @@ bool Object::exportX(int frameStart, int frameEnd, QMatrix view, QSize exportSiz
     return true;
 }
 
-bool Object::exportIm(int frameStart, int frameEnd, QMatrix view, QSize exportSize, QString filePath, bool antialiasing)
+bool Object::exportIm(int frameStart, int frameEnd, QMatrix view, QSize exportSize, QString filePath, bool antialiasing, qreal curveOpacity)
 {
+    PERF_SCOPE("Object::exportIm");
     Q_UNUSED(frameEnd);
-    QSettings settings("Pencil","Pencil");
-    qreal curveOpacity = (100-settings.value("curveOpacity").toInt())/100.0; // default value is 1.0
     QImage exported(exportSize, QImage::Format_ARGB32_Premultiplied);
     QPainter painter(&exported);
     painter.fillRect(exported.rect(), Qt::white);
@@ -747,6 +780,7 @@ bool Object::exportIm(int frameStart, int frameEnd, QMatrix view, QSize exportSi
 
 bool Object::exportFlash(int startFrame, int endFrame, QMatrix view, QSize exportSize, QString filePath, int fps, int compression)
 {
+    PERF_SCOPE("Object::exportFlash");
     Q_UNUSED(exportSize);
     Q_UNUSED(startFrame);
     Q_UNUSED(endFrame);
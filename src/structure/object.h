@@ -27,6 +27,7 @@ class LayerBitmap;
 class LayerVector;
 class LayerCamera;
 class LayerSound;
+class AudioMixer;
 
 
 class Object : public QObject
@@ -43,6 +44,9 @@ signals:
     void imageAdded(int);
     void imageAdded(int,int);
     void imageRemoved(int);
+    void soundChanged();
+    // the track of a layer has to be drawn again; NULL: all of them, after a layer was moved or deleted
+    void layerChanged(Layer*);
 
 public:
     Object();
@@ -93,16 +97,17 @@ public:
     void moveLayer(int i, int j);
     void deleteLayer(int i);
 
-    void playSoundIfAny(int frame,int fps);
-    void stopSoundIfAny();
+    // adds the clips of the visible sound layers, frame firstFrame being the sample 0
+    void mixSounds(AudioMixer& mixer, int fps, int firstFrame);
 
     void defaultInitialisation();
 
-    bool exportFrames(int frameStart, int frameEnd, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, const char* format, int quality, bool background, bool antialiasing, QProgressDialog* progress, int progressMax);
-    bool exportFrames1(int frameStart, int frameEnd, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, const char* format, int quality, bool background, bool antialiasing, QProgressDialog* progress, int progressMax, int fps, int exportFps);
-    bool exportMovie(int startFrame, int endFrame, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, int fps, int exportFps, QString exportFormat);
-    bool exportX(int frameStart, int frameEnd, QMatrix view, QSize exportSize, QString filePath,  bool antialiasing );
-    bool exportIm(int frameStart, int frameEnd, QMatrix view, QSize exportSize, QString filePath,  bool antialiasing );
+    // the exports take the opacity of the vector strokes from the caller, from 0 to 1 ( PencilSettings::curveOpacity() )
+    bool exportFrames(int frameStart, int frameEnd, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, const char* format, int quality, bool background, bool antialiasing, qreal curveOpacity, QProgressDialog* progress, int progressMax);
+    bool exportFrames1(int frameStart, int frameEnd, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, const char* format, int quality, bool background, bool antialiasing, qreal curveOpacity, QProgressDialog* progress, int progressMax, int fps, int exportFps);
+    bool exportMovie(int startFrame, int endFrame, QMatrix view, Layer* currentLayer, QSize exportSize, QString filePath, int fps, int exportFps, QString exportFormat, qreal curveOpacity);
+    bool exportX(int frameStart, int frameEnd, QMatrix view, QSize exportSize, QString filePath,  bool antialiasing, qreal curveOpacity );
+    bool exportIm(int frameStart, int frameEnd, QMatrix view, QSize exportSize, QString filePath,  bool antialiasing, qreal curveOpacity );
     bool exportFlash(int startFrame, int endFrame, QMatrix view, QSize exportSize, QString filePath, int fps, int compression);
 
 private:
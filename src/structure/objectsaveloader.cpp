@@ -1,8 +1,13 @@
+#include <QTextStream>
+#include <QAtomicInt>
+#include <QCoreApplication>
 #include "pencildef.h"
 #include "JlCompress.h"
 #include "fileformat.h"
 #include "object.h"
+#include "layerimage.h"
 #include "objectsaveloader.h"
+#include "perfmonitor.h"
 
 ObjectSaveLoader::ObjectSaveLoader( QObject *parent ) :
     QObject( parent ),
@@ -12,6 +17,7 @@ ObjectSaveLoader::ObjectSaveLoader( QObject *parent ) :
 
 Object* ObjectSaveLoader::loadFromFile( QString strFilename )
 {
+    PERF_SCOPE( "ObjectSaveLoader::loadFromFile" );
     // ---- test before opening ----
 
     if ( !isFileExists( strFilename ) )
@@ -148,10 +154,80 @@ Object* ObjectSaveLoader::loadFromFile( QString strFilename )
     return pObject;
 }
 
-bool ObjectSaveLoader::saveToFile( Object* object, QString strFileName )
+bool ObjectSaveLoader::saveToFile( Object* object, QString strFileName, const QDomElement& editorElement )
 {
-    Q_UNUSED( object );
-    Q_UNUSED( strFileName );
+    PERF_SCOPE( "ObjectSaveLoader::saveToFile" );
+    QFileInfo fileInfo( strFileName );
+    if ( fileInfo.isDir() )
+    {
+        m_error = PencilError( PCL_ERROR_FILE_CANNOT_OPEN );
+        return false;
+    }
+    bool bIsOldPencilFile = strFileName.endsWith( PFF_OLD_EXTENSION );
+
+    QString strWorkingPath;
+    QString strDataLayersDirPath;
+    QString strMainXMLFilePath;
+    if ( bIsOldPencilFile )
+    {
+        strDataLayersDirPath = strFileName + "." + PFF_LAYERS_DIR;
+        strMainXMLFilePath = strFileName;
+    }
+    else
+    {
+        strWorkingPath = QDir::tempPath() + "/" + fileInfo.completeBaseName() + PFF_TMP_COMPRESS_EXT;
+        removePFFTmpDirectory( strWorkingPath );
+        strDataLayersDirPath = strWorkingPath + "/" + PFF_LAYERS_DIR;
+        strMainXMLFilePath = strWorkingPath + "/" + PFF_XML_FILE_NAME;
+    }
+    QDir( QDir::tempPath() ).mkpath( strDataLayersDirPath );
+
+    // ------- layers and palette -------
+    int nLayers = object->getLayerCount();
+    for ( int i = 0; i < nLayers; i++ )
+    {
+        Layer* layer = object->getLayer( i );
+        emit progressValueChanged( ( i * 100 ) / nLayers );
+        if ( layer->type() == Layer::BITMAP || layer->type() == Layer::VECTOR || layer->type() == Layer::SOUND )
+        {
+            ( ( LayerImage* )layer )->saveImages( strDataLayersDirPath, i );
+        }
+    }
+    object->savePalette( strDataLayersDirPath );
+
+    // ------- main XML file -------
+    QFile file( strMainXMLFilePath );
+    if ( !file.open( QFile::WriteOnly | QFile::Text ) )
+    {
+        m_error = PencilError( PCL_ERROR_FILE_CANNOT_OPEN );
+        return false;
+    }
+    QTextStream out( &file );
+    QDomDocument doc( "PencilDocument" );
+    QDomElement root = doc.createElement( "document" );
+    doc.appendChild( root );
+    if ( !editorElement.isNull() )
+    {
+        root.appendChild( doc.importNode( editorElement, true ) );
+    }
+    root.appendChild( object->createDomElement( doc ) );
+    doc.save( out, 2 );
+    file.close();
+
+    if ( !bIsOldPencilFile )
+    {
+        bool ok = JlCompress::compressDir( strFileName, strWorkingPath );
+        removePFFTmpDirectory( strWorkingPath );
+        if ( !ok )
+        {
+            m_error = PencilError( PCL_ERROR_FILE_CANNOT_OPEN );
+            return false;
+        }
+    }
+    emit progressValueChanged( 100 );
+    object->modified = false;
+    object->setFilePath( strFileName );
+    m_error = PencilError();
     return true;
 }
 
@@ -211,7 +287,10 @@ QString ObjectSaveLoader::extractZipToTempFolder( QString strZipFile )
     // ---- now decompress PFF -----
     QFileInfo zipFileInfo( strZipFile );
 
-    QString strTempWorkingPath = QDir::tempPath() + "/" + zipFileInfo.completeBaseName() + PFF_TMP_DECOMPRESS_EXT;
+    // a folder of its own for every loader, so that several threads or processes can open the same file
+    static QAtomicInt s_lastFolder;
+    QString strUnique = QString( "_%1_%2" ).arg( QCoreApplication::applicationPid() ).arg( s_lastFolder.fetchAndAddRelaxed( 1 ) + 1 );
+    QString strTempWorkingPath = QDir::tempPath() + "/" + zipFileInfo.completeBaseName() + strUnique + PFF_TMP_DECOMPRESS_EXT;
     //qDebug() << "tmpFilePath" << tmpFilePath ;
 
     // --removes an old decompression directory first  - better approach
@@ -21,17 +21,19 @@ public:
     explicit ObjectSaveLoader(QObject *parent = 0);
 
     Object* loadFromFile(QString strFilename);
-    bool    saveToFile(Object* pObject, QString strFileName);
+    // editorElement, when given, is written before the object ( the "editor" node of the document )
+    bool    saveToFile(Object* pObject, QString strFileName, const QDomElement& editorElement = QDomElement());
     QList<ColourRef> loadPaletteFile( QString strFilename );
+    // removes the files unzipped by the last loadFromFile(), once the object they were loaded into is gone
+    void    cleanUpTempFolder();
 
     PencilError error() { return m_error; }
 
 signals:
-    void progressValueChanged(float);
+    void progressValueChanged(int);
 
 private:
     QString extractZipToTempFolder( QString strZipFile );
-    void    cleanUpTempFolder();
     bool    isFileExists(QString strFilename);
     bool    loadDomElement( QDomElement docElem );
 
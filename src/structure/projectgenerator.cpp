@@ -0,0 +1,185 @@
+#include <cmath>
+#include <QPainterPath>
+#include <QScopedPointer>
+#include "object.h"
+#include "layerbitmap.h"
+#include "layervector.h"
+#include "bitmapimage.h"
+#include "vectorimage.h"
+#include "objectsaveloader.h"
+#include "projectgenerator.h"
+
+static const int STROKE_POINTS = 8;
+static const int AREA_POINTS = 6;
+static const int COLOURS = 8; // first colours of the default palette
+static const int MAX_PEN_WIDTH = 8;
+
+ProjectGenerator::Parameters::Parameters()
+    : seed( 1 ),
+      bitmapLayers( 2 ),
+      vectorLayers( 1 ),
+      frames( 24 ),
+      keyInterval( 1 ),
+      canvasSize( 1280, 720 ),
+      strokesPerBitmapKey( 10 ),
+      bitmapDensity( 0.1 ),
+      curvesPerVectorKey( 100 ),
+      areasPerVectorKey( 20 )
+{
+}
+
+qint64 ProjectGenerator::bitmapBytes() const
+{
+    const Parameters& p = m_parameters;
+    int keys = ( qMax( 0, p.frames ) + qMax( 1, p.keyInterval ) - 1 ) / qMax( 1, p.keyInterval );
+    QSize keySize = bitmapKeySize( p.canvasSize, p.bitmapDensity ) + QSize( 2 * MAX_PEN_WIDTH, 2 * MAX_PEN_WIDTH );
+    return qint64( qMax( 0, p.bitmapLayers ) ) * keys * keySize.width() * keySize.height() * 4;
+}
+
+Object* ProjectGenerator::generate() const
+{
+    const Parameters& p = m_parameters;
+    if ( bitmapBytes() > MAX_BITMAP_BYTES )
+    {
+        return NULL;
+    }
+    QRect canvas( QPoint( -p.canvasSize.width() / 2, -p.canvasSize.height() / 2 ), p.canvasSize );
+    int keyInterval = qMax( 1, p.keyInterval );
+
+    Object* object = new Object();
+    object->loadDefaultPalette();
+    object->addNewCameraLayer();
+
+    // each layer draws its keys from a sequence of its own, so that adding layers does not change the others
+    for ( int i = 0; i < p.bitmapLayers; i++ )
+    {
+        SeededRandom random( p.seed + 1000003u * ( i + 1 ) );
+        LayerBitmap* layer = object->addNewBitmapLayer();
+        layer->name = QString( "Bitmap Layer %1" ).arg( i + 1 );
+        for ( int frame = 1; frame <= p.frames; frame += keyInterval )
+        {
+            layer->addImageAtFrame( frame );
+            drawBitmapKey( layer->getBitmapImageAtFrame( frame ), random.next(), canvas, p.strokesPerBitmapKey, p.bitmapDensity );
+        }
+    }
+    for ( int i = 0; i < p.vectorLayers; i++ )
+    {
+        SeededRandom random( p.seed + 2000003u * ( i + 1 ) );
+        LayerVector* layer = object->addNewVectorLayer();
+        layer->name = QString( "Vector Layer %1" ).arg( i + 1 );
+        for ( int frame = 1; frame <= p.frames; frame += keyInterval )
+        {
+            layer->addImageAtFrame( frame );
+            drawVectorKey( layer->getVectorImageAtFrame( frame ), random.next(), canvas, p.curvesPerVectorKey, p.areasPerVectorKey );
+        }
+    }
+    object->modified = true;
+    return object;
+}
+
+bool ProjectGenerator::generate( const QString& filePath ) const
+{
+    QScopedPointer<Object> object( generate() );
+    if ( object.isNull() )
+    {
+        return false;
+    }
+    ObjectSaveLoader saveLoader;
+    return saveLoader.saveToFile( object.data(), filePath );
+}
+
+QSize ProjectGenerator::bitmapKeySize( const QSize& canvas, qreal density )
+{
+    // twice the painted area, so that the blobs still leave some holes
+    qreal scale = sqrt( qBound( 0.01, 2 * density, 1.0 ) );
+    return QSize( qMax( 1, qRound( canvas.width() * scale ) ), qMax( 1, qRound( canvas.height() * scale ) ) );
+}
+
+void ProjectGenerator::drawBitmapKey( BitmapImage* image, quint32 seed, const QRect& canvas, int strokes, qreal density )
+{
+    SeededRandom random( seed );
+    QSize size = bitmapKeySize( canvas.size(), density );
+    QRectF region( QPointF( random.uniform( canvas.left(), canvas.left() + canvas.width() - size.width() + 1 ),
+                            random.uniform( canvas.top(), canvas.top() + canvas.height() - size.height() + 1 ) ),
+                   size );
+    image->extend( region.toAlignedRect().adjusted( -MAX_PEN_WIDTH, -MAX_PEN_WIDTH, MAX_PEN_WIDTH, MAX_PEN_WIDTH ) );
+
+    // blobs of paint until they cover about density of the canvas
+    qreal canvasArea = qreal( canvas.width() ) * canvas.height();
+    qreal painted = 0;
+    qreal maxRadius = 0.15 * qMin( region.width(), region.height() );
+    while ( painted < density * canvasArea )
+    {
+        qreal radius = random.uniform( 0.2 * maxRadius, maxRadius );
+        QColor colour = QColor::fromHsv( random.next() % 360, 80 + random.next() % 176, 80 + random.next() % 176 );
+        QPointF center = random.point( region.adjusted( radius, radius, -radius, -radius ) );
+        image->drawEllipse( QRectF( center.x() - radius, center.y() - radius, 2 * radius, 2 * radius ),
+                            Qt::NoPen, colour, QPainter::CompositionMode_SourceOver, true );
+        painted += 3.14159 * radius * radius;
+    }
+
+    QPen pen( Qt::black, 3, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin );
+    for ( int i = 0; i < strokes; i++ )
+    {
+        pen.setWidthF( random.uniform( 1, MAX_PEN_WIDTH ) );
+        QPainterPath path( random.point( region ) );
+        for ( int k = 0; k < 3; k++ )
+        {
+            path.cubicTo( random.point( region ), random.point( region ), random.point( region ) );
+        }
+        image->drawPath( path, pen, Qt::NoBrush, QPainter::CompositionMode_SourceOver, true );
+    }
+}
+
+void ProjectGenerator::drawVectorKey( VectorImage* image, quint32 seed, const QRectF& canvas, int curves, int areas )
+{
+    SeededRandom random( seed );
+    qreal step = 0.02 * qMin( canvas.width(), canvas.height() );
+
+    // open strokes
+    for ( int i = 0; i < curves; i++ )
+    {
+        QList<QPointF> points;
+        QPointF position = random.point( canvas );
+        for ( int k = 0; k < STROKE_POINTS; k++ )
+        {
+            points << position;
+            position += QPointF( random.uniform( -step, step ), random.uniform( -step, step ) );
+        }
+        BezierCurve curve( points );
+        curve.setWidth( random.uniform( 0.5, 4 ) );
+        curve.setVariableWidth( false );
+        curve.setInvisibility( false );
+        curve.setColourNumber( random.next() % COLOURS );
+        image->curve.append( curve );
+    }
+
+    // closed curves, each filled by an area
+    for ( int i = 0; i < areas; i++ )
+    {
+        QPointF center = random.point( canvas );
+        qreal radius = random.uniform( step, 5 * step );
+        QList<QPointF> points;
+        for ( int k = 0; k < AREA_POINTS; k++ )
+        {
+            qreal angle = 2 * 3.14159265 * k / AREA_POINTS;
+            qreal r = radius * random.uniform( 0.7, 1.3 );
+            points << center + QPointF( r * cos( angle ), r * sin( angle ) );
+        }
+        points << points.first();
+        BezierCurve curve( points );
+        curve.setWidth( 1 );
+        curve.setVariableWidth( false );
+        curve.setInvisibility( false );
+        curve.setColourNumber( 0 );
+        image->curve.append( curve );
+
+        int curveNumber = image->curve.size() - 1;
+        QList<VertexRef> contour;
+        for ( int k = -1; k < curve.getVertexSize(); k++ )
+        {
+            contour << VertexRef( curveNumber, k );
+        }
+        image->addArea( BezierArea( contour, random.next() % COLOURS ) );
+    }
+}
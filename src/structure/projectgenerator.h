@@ -0,0 +1,97 @@
+#ifndef PROJECTGENERATOR_H
+#define PROJECTGENERATOR_H
+
+#include <QtGlobal>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+
+class Object;
+class BitmapImage;
+class VectorImage;
+
+
+/**
+ * Random numbers from a fixed seed.
+ *
+ * A xorshift generator rather than qrand(), so that the same seed gives the
+ * same numbers on every platform and every Qt version.
+ */
+class SeededRandom
+{
+public:
+    explicit SeededRandom( quint32 seed ) : m_state( seed != 0 ? seed : 0x9E3779B9u ) {}
+
+    quint32 next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    // uniform in [low, high)
+    qreal uniform( qreal low, qreal high ) { return low + ( high - low ) * ( next() / 4294967296.0 ); }
+    QPointF point( const QRectF& rect ) { return QPointF( uniform( rect.left(), rect.right() ), uniform( rect.top(), rect.bottom() ) ); }
+
+private:
+    quint32 m_state;
+};
+
+
+/**
+ * Builds projects of a chosen size, for benchmarks and stress tests.
+ *
+ * Every layer gets a key frame every keyInterval frames. The bitmap keys get
+ * a few strokes over blobs of paint whose areas add up to bitmapDensity times
+ * the canvas, so 0 leaves the image mostly empty and 1 covers most of it.
+ * The paint stays in a part of the canvas about twice as large as it, which
+ * is the size of the key: sparse keys are small, as drawn ones are. The
+ * vector keys get open strokes and closed curves filled by an area. The same
+ * parameters always give the same project.
+ *
+ * The whole project is built in memory before it is saved, so the pixels of
+ * the bitmap keys are capped to MAX_BITMAP_BYTES; see bitmapBytes().
+ */
+class ProjectGenerator
+{
+public:
+    struct Parameters
+    {
+        Parameters();
+
+        quint32 seed;
+        int bitmapLayers;
+        int vectorLayers;
+        int frames;
+        int keyInterval;
+        QSize canvasSize;
+        int strokesPerBitmapKey;
+        qreal bitmapDensity;        // 0 to 1
+        int curvesPerVectorKey;
+        int areasPerVectorKey;
+    };
+
+    static const qint64 MAX_BITMAP_BYTES = Q_INT64_C( 2 ) << 30;
+
+    explicit ProjectGenerator( const Parameters& parameters ) : m_parameters( parameters ) {}
+
+    // the memory taken by the pixels of all the bitmap keys, at most
+    qint64 bitmapBytes() const;
+
+    // a new object, owned by the caller, or NULL when the bitmap keys are over the cap
+    Object* generate() const;
+    // generates the project and saves it like the application does
+    bool generate( const QString& filePath ) const;
+
+    // the part of the canvas the paint of a key stays in, for a density
+    static QSize bitmapKeySize( const QSize& canvas, qreal density );
+    static void drawBitmapKey( BitmapImage* image, quint32 seed, const QRect& canvas, int strokes, qreal density );
+    static void drawVectorKey( VectorImage* image, quint32 seed, const QRectF& canvas, int curves, int areas );
+
+private:
+    Parameters m_parameters;
+};
+
+#endif // PROJECTGENERATOR_H
@@ -0,0 +1,251 @@
+#include <QtDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QProcess>
+#include "audiomixer.h"
+#include "soundwaveform.h"
+
+static const quint32 PEAKS_MAGIC = 0x5057564D; // "PWVM"
+static const quint32 PEAKS_VERSION = 1;
+
+void SoundWaveform::build( const QVector<qint16>& samples, int channels, qint64 sourceSize )
+{
+    m_levels.clear();
+    m_sourceSize = sourceSize;
+    m_frames = samples.size() / channels;
+    if ( m_frames == 0 )
+    {
+        return;
+    }
+
+    // finest level, straight from the samples of all the channels
+    int count = int( ( m_frames + BASE_FRAMES - 1 ) / BASE_FRAMES );
+    QVector<qint16> level( 2 * count );
+    const qint16* data = samples.constData();
+    for ( int i = 0; i < count; i++ )
+    {
+        qint64 begin = qint64( i ) * BASE_FRAMES * channels;
+        qint64 end = qMin( qint64( i + 1 ) * BASE_FRAMES, m_frames ) * channels;
+        qint16 low = data[ begin ];
+        qint16 high = data[ begin ];
+        for ( qint64 j = begin + 1; j < end; j++ )
+        {
+            low = qMin( low, data[ j ] );
+            high = qMax( high, data[ j ] );
+        }
+        level[ 2 * i ] = low;
+        level[ 2 * i + 1 ] = high;
+    }
+    m_levels.append( level );
+
+    // each coarser level merges pairs of peaks
+    while ( count > 1 )
+    {
+        const QVector<qint16>& finer = m_levels.last();
+        int finerCount = count;
+        count = ( count + 1 ) / 2;
+        QVector<qint16> coarser( 2 * count );
+        for ( int i = 0; i < count; i++ )
+        {
+            int a = 2 * i;
+            int b = qMin( 2 * i + 1, finerCount - 1 );
+            coarser[ 2 * i ] = qMin( finer[ 2 * a ], finer[ 2 * b ] );
+            coarser[ 2 * i + 1 ] = qMax( finer[ 2 * a + 1 ], finer[ 2 * b + 1 ] );
+        }
+        m_levels.append( coarser );
+    }
+}
+
+void SoundWaveform::peak( qint64 from, qint64 to, qint16* low, qint16* high ) const
+{
+    *low = 0;
+    *high = 0;
+    from = qMax( from, qint64( 0 ) );
+    to = qMin( to, m_frames );
+    if ( from >= to )
+    {
+        return;
+    }
+
+    // the coarsest level whose peaks are not longer than the range
+    int level = 0;
+    qint64 bucket = BASE_FRAMES;
+    while ( level + 1 < m_levels.size() && bucket * 2 <= to - from )
+    {
+        level++;
+        bucket *= 2;
+    }
+
+    const QVector<qint16>& peaks = m_levels.at( level );
+    int first = int( from / bucket );
+    int last = int( ( to - 1 ) / bucket );
+    *low = peaks[ 2 * first ];
+    *high = peaks[ 2 * first + 1 ];
+    for ( int i = first + 1; i <= last; i++ )
+    {
+        *low = qMin( *low, peaks[ 2 * i ] );
+        *high = qMax( *high, peaks[ 2 * i + 1 ] );
+    }
+}
+
+bool SoundWaveform::save( const QString& filePath ) const
+{
+    QFile file( filePath );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        return false;
+    }
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_4_6 );
+    out << PEAKS_MAGIC << PEAKS_VERSION << m_sourceSize << m_frames << quint32( m_levels.size() );
+    for ( int i = 0; i < m_levels.size(); i++ )
+    {
+        out << m_levels.at( i );
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+bool SoundWaveform::load( const QString& filePath, qint64 sourceSize )
+{
+    QFile file( filePath );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+    QDataStream in( &file );
+    in.setVersion( QDataStream::Qt_4_6 );
+
+    quint32 magic, version, levelCount;
+    qint64 size, frames;
+    in >> magic >> version >> size >> frames >> levelCount;
+    if ( in.status() != QDataStream::Ok || magic != PEAKS_MAGIC || version != PEAKS_VERSION || size != sourceSize )
+    {
+        return false; // not ours, or computed from another version of the sound file
+    }
+
+    QList< QVector<qint16> > levels;
+    for ( quint32 i = 0; i < levelCount && in.status() == QDataStream::Ok; i++ )
+    {
+        QVector<qint16> level;
+        in >> level;
+        levels.append( level );
+    }
+    if ( in.status() != QDataStream::Ok )
+    {
+        return false;
+    }
+    m_sourceSize = size;
+    m_frames = frames;
+    m_levels = levels;
+    return true;
+}
+
+// ==== Singleton ====
+static SoundWaveformCache* g_pWaveformCache = NULL;
+
+SoundWaveformCache* SoundWaveformCache::instance()
+{
+    if ( g_pWaveformCache == NULL )
+    {
+        g_pWaveformCache = new SoundWaveformCache();
+    }
+    return g_pWaveformCache;
+}
+
+SoundWaveformCache::SoundWaveformCache( QObject* parent ) : QObject( parent )
+{
+}
+
+SoundWaveform SoundWaveformCache::waveform( const QString& filePath )
+{
+    QFileInfo info( filePath );
+    QString key = info.absoluteFilePath();
+    if ( m_waveforms.contains( key ) )
+    {
+        return m_waveforms.value( key );
+    }
+    if ( !info.exists() || m_decoders.values().contains( key ) )
+    {
+        return SoundWaveform();
+    }
+
+    // saved with the project
+    SoundWaveform peaks;
+    if ( peaks.load( peaksPathOf( key ), info.size() ) )
+    {
+        m_waveforms.insert( key, peaks );
+        return peaks;
+    }
+
+    // already decoded for playback
+    if ( AudioMixer::isDecoded( key ) )
+    {
+        peaks.build( AudioMixer::decode( key ), AudioMixer::CHANNELS, info.size() );
+        m_waveforms.insert( key, peaks );
+        return peaks;
+    }
+
+    startDecoder( key );
+    return SoundWaveform();
+}
+
+bool SoundWaveformCache::decode( const QString& filePath )
+{
+    QFileInfo info( filePath );
+    QString key = info.absoluteFilePath();
+    if ( !info.exists() || m_failed.contains( key ) || AudioMixer::isDecoded( key ) )
+    {
+        return true;
+    }
+    if ( !m_decoders.values().contains( key ) )
+    {
+        startDecoder( key );
+    }
+    return false;
+}
+
+void SoundWaveformCache::startDecoder( const QString& key )
+{
+    QProcess* decoder = new QProcess( this );
+    connect( decoder, SIGNAL( finished( int, QProcess::ExitStatus ) ), this, SLOT( decoderFinished() ) );
+    connect( decoder, SIGNAL( error( QProcess::ProcessError ) ), this, SLOT( decoderFinished() ) );
+    m_decoders.insert( decoder, key );
+    decoder->start( AudioMixer::ffmpegPath(), AudioMixer::decoderArguments( key ) );
+}
+
+bool SoundWaveformCache::save( const QString& filePath, const QString& peaksPath )
+{
+    SoundWaveform peaks = m_waveforms.value( QFileInfo( filePath ).absoluteFilePath() );
+    if ( peaks.isEmpty() )
+    {
+        return false;
+    }
+    return peaks.save( peaksPath );
+}
+
+void SoundWaveformCache::decoderFinished()
+{
+    QProcess* decoder = qobject_cast<QProcess*>( sender() );
+    if ( decoder == NULL || !m_decoders.contains( decoder ) )
+    {
+        return;
+    }
+    QString key = m_decoders.take( decoder );
+    decoder->deleteLater();
+
+    QVector<qint16> samples = AudioMixer::samplesFromDecoder( decoder->readAllStandardOutput() );
+    SoundWaveform peaks;
+    if ( samples.isEmpty() )
+    {
+        qDebug() << "ERROR: could not decode" << key;
+        m_failed.insert( key );
+    }
+    else
+    {
+        AudioMixer::insertDecoded( key, samples );
+        peaks.build( samples, AudioMixer::CHANNELS, QFileInfo( key ).size() );
+    }
+    m_waveforms.insert( key, peaks ); // an empty waveform if decoding failed, so that it is not tried again
+    emit waveformReady();
+}
@@ -0,0 +1,85 @@
+#ifndef SOUNDWAVEFORM_H
+#define SOUNDWAVEFORM_H
+
+#include <QObject>
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+class QProcess;
+
+
+/**
+ * Min/max peaks of a sound clip, at every power of two resolution.
+ *
+ * The finest level holds one peak per BASE_FRAMES sample frames and each
+ * following level halves the number of peaks. Looking up the peak of any
+ * range reads a few values of the level matching its length, so drawing a
+ * waveform costs the same whatever the length of the clip.
+ */
+class SoundWaveform
+{
+public:
+    static const int BASE_FRAMES = 32;
+
+    SoundWaveform() : m_frames( 0 ), m_sourceSize( 0 ) {}
+
+    void build( const QVector<qint16>& samples, int channels, qint64 sourceSize );
+    bool isEmpty() const { return m_levels.isEmpty(); }
+    qint64 frameCount() const { return m_frames; }
+
+    // lowest and highest sample in [from, to)
+    void peak( qint64 from, qint64 to, qint16* low, qint16* high ) const;
+
+    bool save( const QString& filePath ) const;
+    bool load( const QString& filePath, qint64 sourceSize );
+
+private:
+    qint64 m_frames;
+    qint64 m_sourceSize; // size of the sound file the peaks were computed from
+    QList< QVector<qint16> > m_levels; // min and max interleaved
+};
+
+
+/**
+ * Waveforms of all the sound files in use.
+ *
+ * The files are decoded in the background by an ffmpeg process and the
+ * decoded samples are shared with AudioMixer, which playback can ask for
+ * ahead of time with decode(). The peaks are written next to the sound
+ * file when the project is saved, and read back on loading.
+ */
+class SoundWaveformCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static SoundWaveformCache* instance();
+
+    // empty until the file has been decoded
+    SoundWaveform waveform( const QString& filePath );
+    bool save( const QString& filePath, const QString& peaksPath );
+    // true when AudioMixer::decode() will not block on the file: it is decoded, or cannot be;
+    // otherwise starts decoding it in the background, and waveformReady() tells when it is done
+    bool decode( const QString& filePath );
+
+    static QString peaksPathOf( const QString& filePath ) { return filePath + ".peaks"; }
+
+signals:
+    void waveformReady();
+
+private slots:
+    void decoderFinished();
+
+private:
+    explicit SoundWaveformCache( QObject* parent = 0 );
+    void startDecoder( const QString& key );
+
+    QHash<QString, SoundWaveform> m_waveforms;
+    QHash<QProcess*, QString> m_decoders;
+    QSet<QString> m_failed; // not tried again
+};
+
+#endif // SOUNDWAVEFORM_H
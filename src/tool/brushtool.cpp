@@ -1,4 +1,3 @@
-#include <QSettings>
 #include <QPixmap>
 #include <QPainter>
 
@@ -8,6 +7,7 @@
 #include "strokemanager.h"
 #include "editor.h"
 #include "scribblearea.h"
+#include "perfmonitor.h"
 #include "blitrect.h"
 
 #include "brushtool.h"
@@ -24,10 +24,10 @@ ToolType BrushTool::type()
 
 void BrushTool::loadSettings()
 {
-    QSettings settings("Pencil", "Pencil");
+    PencilSettings* settings = pencilSettings();
 
-    properties.width = settings.value("brushWidth").toDouble();
-    properties.feather = settings.value("brushFeather").toDouble();
+    properties.width = settings->value("brushWidth").toDouble();
+    properties.feather = settings->value("brushFeather").toDouble();
 
     properties.pressure = ON;
     properties.invisibility = DISABLED;
@@ -36,12 +36,12 @@ void BrushTool::loadSettings()
     if (properties.width <= 0)
     {
         properties.width = 15;
-        settings.setValue("brushWidth", properties.width);
+        settings->setValue("brushWidth", properties.width);
     }
     if (properties.feather <= 0)
     {
         properties.feather = 200;
-        settings.setValue("brushFeather", properties.feather);
+        settings->setValue("brushFeather", properties.feather);
     }
 
 }
@@ -77,7 +77,6 @@ void BrushTool::mousePressEvent(QMouseEvent *event)
     if (event->button() == Qt::LeftButton)
     {
         m_pEditor->backup(typeName());
-        m_pScribbleArea->setAllDirty();
     }
 
     startStroke();
@@ -98,7 +97,6 @@ void BrushTool::mouseReleaseEvent(QMouseEvent *event)
         if (layer->type() == Layer::BITMAP)
         {
             m_pScribbleArea->paintBitmapBuffer();
-            m_pScribbleArea->setAllDirty();
         }
         else if (layer->type() == Layer::VECTOR)
         {
@@ -128,6 +126,7 @@ void BrushTool::paintAt(QPointF point)
 
 void BrushTool::drawStroke()
 {
+    PERF_SCOPE("BrushTool::drawStroke");
     StrokeTool::drawStroke();
     QList<QPointF> p = m_pStrokeManager->interpolateStroke(currentWidth);
 
@@ -205,12 +204,11 @@ void BrushTool::drawStroke()
         //            m_pScribbleArea->drawLine(a, b, pen, QPainter::CompositionMode_SourceOver);
         //            m_pScribbleArea->refreshVector(QRect(a.toPoint(), b.toPoint()), rad);
         //        }
-        if (p.size() == 4) {
-            QSizeF size(2,2);
+        if (p.size() > 1) {
             QPainterPath path(p[0]);
-            path.cubicTo(p[1],
-                p[2],
-                p[3]);
+            for (int i = 1; i < p.size(); i++) {
+                path.lineTo(p[i]);
+            }
             m_pScribbleArea->drawPath(path, pen, Qt::NoBrush, QPainter::CompositionMode_Source);
             m_pScribbleArea->refreshVector(path.boundingRect().toRect(), rad);
         }
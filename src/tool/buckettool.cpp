@@ -54,7 +54,6 @@ void BucketTool::mousePressEvent(QMouseEvent *event)
     if (event->button() == Qt::LeftButton)
     {
         m_pEditor->backup(typeName());
-        m_pScribbleArea->setAllDirty();
     }
 }
 
@@ -81,16 +80,15 @@ void BucketTool::mouseReleaseEvent(QMouseEvent *event)
             }
             BitmapImage *targetImage = ((LayerBitmap *)targetLayer)->getLastBitmapImageAtFrame(m_pEditor->layerManager()->currentFrameIndex(), 0);
 
-            BitmapImage::floodFill(sourceImage,
-                                   targetImage,
-                                   getLastPoint().toPoint(),
-                                   qRgba(0, 0, 0, 0),
-                                   m_pEditor->colorManager()->frontColor().rgba(),
-                                   10 * 10,
-                                   true);
+            QRect filled = BitmapImage::floodFill(sourceImage,
+                                                  targetImage,
+                                                  getLastPoint().toPoint(),
+                                                  qRgba(0, 0, 0, 0),
+                                                  m_pEditor->colorManager()->frontColor().rgba(),
+                                                  10 * 10,
+                                                  true);
 
-            m_pScribbleArea->setModified(layerNumber, m_pEditor->layerManager()->currentFrameIndex());
-            m_pScribbleArea->setAllDirty();
+            m_pScribbleArea->setModified(layerNumber, m_pEditor->layerManager()->currentFrameIndex(), filled);
         }
         else if (layer->type() == Layer::VECTOR)
         {
@@ -105,7 +103,6 @@ void BucketTool::mouseReleaseEvent(QMouseEvent *event)
                 m_pScribbleArea->floodFill(vectorImage, getLastPixel().toPoint(), qRgba(0, 0, 0, 0), qRgb(200, 200, 200), 100 * 100);
             }
             m_pScribbleArea->setModified(m_pEditor->layerManager()->currentLayerIndex(), m_pEditor->layerManager()->currentFrameIndex());
-            m_pScribbleArea->setAllDirty();
         }
     }
 }
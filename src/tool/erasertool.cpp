@@ -1,8 +1,8 @@
-#include <QSettings>
 #include <QPixmap>
 #include <QPainter>
 
 #include "scribblearea.h"
+#include "perfmonitor.h"
 
 #include "pencilsettings.h"
 #include "strokemanager.h"
@@ -25,10 +25,10 @@ ToolType EraserTool::type()
 
 void EraserTool::loadSettings()
 {
-    QSettings settings("Pencil", "Pencil");
+    PencilSettings* settings = pencilSettings();
 
-    properties.width = settings.value("eraserWidth").toDouble();
-    properties.feather = settings.value("eraserFeather").toDouble();
+    properties.width = settings->value("eraserWidth").toDouble();
+    properties.feather = settings->value("eraserFeather").toDouble();
 
     properties.pressure = ON;
     properties.invisibility = DISABLED;
@@ -37,12 +37,12 @@ void EraserTool::loadSettings()
     if (properties.width <= 0)
     {
         properties.width = 25;
-        settings.setValue("eraserWidth", properties.width);
+        settings->setValue("eraserWidth", properties.width);
     }
     if (properties.feather <= 0)
     {
         properties.feather = 50;
-        settings.setValue("eraserFeather", properties.feather);
+        settings->setValue("eraserFeather", properties.feather);
     }
 }
 
@@ -77,7 +77,6 @@ void EraserTool::mousePressEvent(QMouseEvent *event)
     if (event->button() == Qt::LeftButton)
     {
         m_pEditor->backup(typeName());
-        m_pScribbleArea->setAllDirty();
     }
 
     startStroke();
@@ -98,7 +97,6 @@ void EraserTool::mouseReleaseEvent(QMouseEvent *event)
         if (layer->type() == Layer::BITMAP)
         {
             m_pScribbleArea->paintBitmapBuffer();
-            m_pScribbleArea->setAllDirty();
         }
         else if (layer->type() == Layer::VECTOR)
         {
@@ -149,6 +147,7 @@ void EraserTool::paintAt(QPointF point)
 
 void EraserTool::drawStroke()
 {
+    PERF_SCOPE("EraserTool::drawStroke");
     StrokeTool::drawStroke();
     QList<QPointF> p = m_pStrokeManager->interpolateStroke(currentWidth);
 
@@ -213,12 +212,11 @@ void EraserTool::drawStroke()
         QPen pen(Qt::white, currentWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
         int rad = qRound((currentWidth / 2 + 2) * (qAbs(m_pScribbleArea->getTempViewScaleX()) + qAbs(m_pScribbleArea->getTempViewScaleY())));
 
-        if (p.size() == 4) {
-            QSizeF size(2,2);
+        if (p.size() > 1) {
             QPainterPath path(p[0]);
-            path.cubicTo(p[1],
-                p[2],
-                p[3]);
+            for (int i = 1; i < p.size(); i++) {
+                path.lineTo(p[i]);
+            }
             m_pScribbleArea->drawPath(path, pen, Qt::NoBrush, QPainter::CompositionMode_Source);
             m_pScribbleArea->refreshVector(path.boundingRect().toRect(), rad);
         }
@@ -209,7 +209,6 @@ void MoveTool::mouseMoveEvent( QMouseEvent *event )
 
                 m_pScribbleArea->calculateSelectionTransformation();
                 m_pScribbleArea->update();
-                m_pScribbleArea->setAllDirty();
             }
         }
         else     // there is nothing selected
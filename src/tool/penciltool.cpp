@@ -1,4 +1,3 @@
-#include <QSettings>
 #include <QPixmap>
 #include <QMouseEvent>
 
@@ -10,6 +9,7 @@
 #include "layermanager.h"
 #include "editor.h"
 #include "scribblearea.h"
+#include "perfmonitor.h"
 #include "pencilsettings.h"
 
 #include "penciltool.h"
@@ -26,10 +26,10 @@ ToolType PencilTool::type()
 
 void PencilTool::loadSettings()
 {
-    QSettings settings("Pencil", "Pencil");
+    PencilSettings* settings = pencilSettings();
 
-    properties.width = settings.value("pencilWidth").toDouble();
-    properties.feather = settings.value("pencilFeather").toDouble();
+    properties.width = settings->value("pencilWidth").toDouble();
+    properties.feather = settings->value("pencilFeather").toDouble();
     properties.pressure = 1;
     properties.invisibility = 1;
     properties.preserveAlpha = 0;
@@ -37,12 +37,12 @@ void PencilTool::loadSettings()
     if (properties.width <= 0)
     {
         properties.width = 1;
-        settings.setValue("pencilWidth", properties.width);
+        settings->setValue("pencilWidth", properties.width);
     }
     if (properties.feather > -1) // replace with: <=0 to allow feather
     {
         properties.feather = -1;
-        settings.setValue("pencilFeather", properties.feather);
+        settings->setValue("pencilFeather", properties.feather);
     }
 }
 
@@ -70,7 +70,6 @@ void PencilTool::mousePressEvent(QMouseEvent *event)
         {
             m_pScribbleArea->toggleThinLines();
         }
-        m_pScribbleArea->setAllDirty();
         startStroke(); //start and appends first stroke
 
         //Layer *layer = m_pEditor->getCurrentLayer();
@@ -108,7 +107,6 @@ void PencilTool::mouseReleaseEvent(QMouseEvent *event)
         if (layer->type() == Layer::BITMAP)
         {
             m_pScribbleArea->paintBitmapBuffer();
-            m_pScribbleArea->setAllDirty();
         }
         else if (layer->type() == Layer::VECTOR &&  strokePoints.size() > -1)
         {
@@ -152,6 +150,7 @@ void PencilTool::adjustPressureSensitiveProperties(qreal pressure, bool mouseDev
 
 void PencilTool::drawStroke()
 {
+    PERF_SCOPE("PencilTool::drawStroke");
     float width = 1;
 
     StrokeTool::drawStroke();
@@ -171,32 +170,14 @@ void PencilTool::drawStroke()
             p[i] = m_pScribbleArea->pixelToPoint(p[i]);
         }
 
-        if (p.size() == 4) {
-            // qDebug() << p;
+        if (p.size() > 1) {
             QPainterPath path(p[0]);
-            path.cubicTo(p[1],
-                p[2],
-                p[3]);
+            for (int i = 1; i < p.size(); i++) {
+                path.lineTo(p[i]);
+            }
             //m_pScribbleArea->drawPath(path, pen, brush, QPainter::CompositionMode_SoftLight );
             m_pScribbleArea->drawPath(path, pen, brush, QPainter::CompositionMode_SourceOver );
 
-            if (false) // debug
-            {
-                QSizeF size(2,2);
-                QRectF rect(p[0], size);
-
-                QPen penBlue(Qt::blue);
-
-                m_pScribbleArea->bufferImg->drawRect(rect, Qt::NoPen, QBrush(Qt::red), QPainter::CompositionMode_Source, false);
-                m_pScribbleArea->bufferImg->drawRect(QRectF(p[3], size), Qt::NoPen, QBrush(Qt::red), QPainter::CompositionMode_Source, false);
-                m_pScribbleArea->bufferImg->drawRect(QRectF(p[1], size), Qt::NoPen, QBrush(Qt::green), QPainter::CompositionMode_Source, false);
-                m_pScribbleArea->bufferImg->drawRect(QRectF(p[2], size), Qt::NoPen, QBrush(Qt::green), QPainter::CompositionMode_Source, false);
-                m_pScribbleArea->bufferImg->drawLine(p[0], p[1], penBlue, QPainter::CompositionMode_Source, true);
-                m_pScribbleArea->bufferImg->drawLine(p[2], p[3], penBlue, QPainter::CompositionMode_Source, true);
-                m_pScribbleArea->refreshBitmap(QRectF(p[0], p[3]).toRect(), 20);
-                m_pScribbleArea->refreshBitmap(rect.toRect(), rad);
-            }
-
             m_pScribbleArea->refreshBitmap(path.boundingRect().toRect(), rad);
         }
     }
@@ -210,12 +191,11 @@ void PencilTool::drawStroke()
 
         rad = qRound((properties.width / 2 + 2) * qAbs(m_pScribbleArea->getTempViewScaleX()));
 
-        if (p.size() == 4) {
-            QSizeF size(2,2);
+        if (p.size() > 1) {
             QPainterPath path(p[0]);
-            path.cubicTo(p[1],
-                p[2],
-                p[3]);
+            for (int i = 1; i < p.size(); i++) {
+                path.lineTo(p[i]);
+            }
             m_pScribbleArea->drawPath(path, pen, Qt::NoBrush, QPainter::CompositionMode_Source);
             m_pScribbleArea->refreshVector(path.boundingRect().toRect(), rad);
         }
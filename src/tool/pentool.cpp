@@ -7,6 +7,7 @@
 #include "pencilsettings.h"
 #include "editor.h"
 #include "scribblearea.h"
+#include "perfmonitor.h"
 
 #include "pentool.h"
 
@@ -22,9 +23,9 @@ ToolType PenTool::type()
 
 void PenTool::loadSettings()
 {
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
 
-    properties.width = settings.value("penWidth").toDouble();
+    properties.width = settings->value("penWidth").toDouble();
     properties.feather = -1;
     properties.pressure = ON;
     properties.invisibility = OFF;
@@ -33,7 +34,7 @@ void PenTool::loadSettings()
     if ( properties.width <= 0 )
     {
         properties.width = 1.5;
-        settings.setValue("penWidth", properties.width);
+        settings->setValue("penWidth", properties.width);
     }
 
     currentWidth = properties.width;
@@ -72,7 +73,6 @@ void PenTool::mousePressEvent(QMouseEvent *event)
     if (event->button() == Qt::LeftButton)
     {
         m_pEditor->backup(typeName());
-        m_pScribbleArea->setAllDirty();
     }
 
     startStroke();
@@ -92,7 +92,6 @@ void PenTool::mouseReleaseEvent(QMouseEvent *event)
         if (layer->type() == Layer::BITMAP)
         {
             m_pScribbleArea->paintBitmapBuffer();
-            m_pScribbleArea->setAllDirty();
         }
         else if (layer->type() == Layer::VECTOR && strokePoints.size() > -1)
         {
@@ -131,6 +130,7 @@ void PenTool::mouseMoveEvent(QMouseEvent *event)
 
 void PenTool::drawStroke()
 {
+    PERF_SCOPE("PenTool::drawStroke");
     StrokeTool::drawStroke();
     QList<QPointF> p = m_pStrokeManager->interpolateStroke(currentWidth);
 
@@ -150,13 +150,13 @@ void PenTool::drawStroke()
             p[i] = m_pScribbleArea->pixelToPoint(p[i]);
         }
 
-        if (p.size() == 4) 
+        if (p.size() > 1)
         {
-            QSizeF size(2,2);
-            QPainterPath path( p[0] );
-            path.cubicTo( p[1],
-                          p[2],
-                          p[3] );
+            QPainterPath path(p[0]);
+            for (int i = 1; i < p.size(); i++)
+            {
+                path.lineTo(p[i]);
+            }
             m_pScribbleArea->drawPath(path, pen, Qt::NoBrush, QPainter::CompositionMode_Source);
             m_pScribbleArea->refreshBitmap(path.boundingRect().toRect(), rad);
         }
@@ -171,13 +171,13 @@ void PenTool::drawStroke()
                  Qt::RoundCap,
                  Qt::RoundJoin);
 
-        if (p.size() == 4)
+        if (p.size() > 1)
         {
-            QSizeF size(2,2);
-            QPainterPath path( p[0] );
-            path.cubicTo( p[1],
-                          p[2],
-                          p[3] );
+            QPainterPath path(p[0]);
+            for (int i = 1; i < p.size(); i++)
+            {
+                path.lineTo(p[i]);
+            }
             m_pScribbleArea->drawPath(path, pen, Qt::NoBrush, QPainter::CompositionMode_Source);
             m_pScribbleArea->refreshVector(path.boundingRect().toRect(), rad);
         }
@@ -2,6 +2,7 @@
 
 #include "editor.h"
 #include "scribblearea.h"
+#include "pencilsettings.h"
 
 #include "strokemanager.h"
 #include "layermanager.h"
@@ -22,9 +23,9 @@ ToolType PolylineTool::type()
 
 void PolylineTool::loadSettings()
 {
-    QSettings settings("Pencil","Pencil");
+    PencilSettings* settings = pencilSettings();
 
-    properties.width = settings.value("polyLineWidth").toDouble();
+    properties.width = settings->value("polyLineWidth").toDouble();
     properties.feather = -1;
     properties.pressure = ON;
     properties.invisibility = OFF;
@@ -33,7 +34,7 @@ void PolylineTool::loadSettings()
     if ( properties.width <= 0 )
     {
         properties.width = 1.5;
-        settings.setValue("polyLineWidth", properties.width);
+        settings->setValue("polyLineWidth", properties.width);
     }
 }
 
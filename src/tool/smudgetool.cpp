@@ -1,13 +1,14 @@
 #include <QPixmap>
 #include "editor.h"
 #include "scribblearea.h"
+#include "perfmonitor.h"
+#include "pencilsettings.h"
 
 #include "layermanager.h"
 #include "colormanager.h"
 #include "layerbitmap.h"
 #include "layervector.h"
 #include "strokemanager.h"
-#include "blitrect.h"
 
 #include "smudgetool.h"
 
@@ -24,19 +25,19 @@ ToolType SmudgeTool::type()
 
 void SmudgeTool::loadSettings()
 {
-    QSettings settings("Pencil", "Pencil");
-    properties.width = settings.value("smudgeWidth").toDouble();
-    properties.feather = settings.value("smudgeFeather").toDouble();
+    PencilSettings* settings = pencilSettings();
+    properties.width = settings->value("smudgeWidth").toDouble();
+    properties.feather = settings->value("smudgeFeather").toDouble();
 
     if (properties.width <= 0)
     {
         properties.width = 25;
-        settings.setValue("smudgeWidth", properties.width);
+        settings->setValue("smudgeWidth", properties.width);
     }
     if (properties.feather <= 0)
     {
         properties.feather = 200;
-        settings.setValue("smudgeFeather", properties.feather);
+        settings->setValue("smudgeFeather", properties.feather);
     }
 }
 
@@ -98,7 +99,6 @@ void SmudgeTool::mousePressEvent(QMouseEvent *event)
         if (layer->type() == Layer::BITMAP)
         {
             m_pEditor->backup(typeName());
-            m_pScribbleArea->setAllDirty();
             startStroke();
             lastBrushPoint = getCurrentPoint();
         }
@@ -146,7 +146,6 @@ void SmudgeTool::mouseReleaseEvent(QMouseEvent *event)
         {
             drawStroke();
             m_pScribbleArea->paintBitmapBuffer();
-            m_pScribbleArea->setAllDirty();
             endStroke();
         }
         else if (layer->type() == Layer::VECTOR)
@@ -195,13 +194,17 @@ void SmudgeTool::mouseMoveEvent(QMouseEvent *event)
                     ->getVerticesCloseTo(getCurrentPoint(), m_pScribbleArea->tol / m_pScribbleArea->getTempViewScaleX());
             }
         }
-        m_pScribbleArea->update();
-        m_pScribbleArea->setAllDirty();
+        // the bitmap strokes update the parts they damage
+        if (layer->type() == Layer::VECTOR)
+        {
+            m_pScribbleArea->update();
+        }
     }
 }
 
 void SmudgeTool::drawStroke()
 {
+    PERF_SCOPE("SmudgeTool::drawStroke");
     if ( !m_pScribbleArea->isLayerPaintable() ) return;
 
     Layer *layer = m_pEditor->getCurrentLayer();
@@ -221,7 +224,6 @@ void SmudgeTool::drawStroke()
     //opacity = currentPressure; // todo: Probably not interesting?!
     //brushWidth = brushWidth * opacity;
 
-    BlitRect rect;
     QPointF a = lastBrushPoint;
     QPointF b = getCurrentPoint();
 
@@ -231,13 +233,11 @@ void SmudgeTool::drawStroke()
         qreal brushStep = 2;
         qreal distance = QLineF(b, a).length()/2.0;
         int steps = qRound(distance / brushStep);
-        int rad = qRound(brushWidth / 2.0) + 2;
 
         QPointF sourcePoint = lastBrushPoint;
         for (int i = 0; i < steps; i++)
         {
             QPointF targetPoint = lastBrushPoint + (i + 1) * (brushStep) * (b - lastBrushPoint) / distance;
-            rect.extend(targetPoint.toPoint());
             m_pScribbleArea->liquifyBrush( targetImage,
                                                 sourcePoint,
                                                 targetPoint,
@@ -250,7 +250,6 @@ void SmudgeTool::drawStroke()
                 lastBrushPoint = targetPoint;
             }
             sourcePoint = targetPoint;
-            m_pScribbleArea->refreshBitmap(rect, rad);
             m_pScribbleArea->paintBitmapBuffer();
         }
     }
@@ -259,13 +258,11 @@ void SmudgeTool::drawStroke()
         qreal brushStep = 2.0;
         qreal distance = QLineF(b, a).length();
         int steps = qRound(distance / brushStep);
-        int rad = qRound(brushWidth / 2.0) + 2;
 
         QPointF sourcePoint = lastBrushPoint;
         for (int i = 0; i < steps; i++)
         {
             QPointF targetPoint = lastBrushPoint + (i + 1) * (brushStep) * (b - lastBrushPoint) / distance;
-            rect.extend(targetPoint.toPoint());
             m_pScribbleArea->blurBrush( targetImage,
                                                 sourcePoint,
                                                 targetPoint,
@@ -278,7 +275,6 @@ void SmudgeTool::drawStroke()
                 lastBrushPoint = targetPoint;
             }
             sourcePoint = targetPoint;
-            m_pScribbleArea->refreshBitmap(rect, rad);
             m_pScribbleArea->paintBitmapBuffer();
         }
     }
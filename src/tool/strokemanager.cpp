@@ -50,28 +50,39 @@ void StrokeManager::reset()
 {
     m_strokeStarted = false;
     meter = 0;
-    strokeQueue.clear();
-    nQueued_p = 0;
-    pressure = 0.0f;
+    m_sampleCount = 0;
+    m_interpolated = 0;
+    m_distanceToNext = -1; // the first point is the press
     velocity = QPointF(0,0);
-    hasTangent = false;
 }
 
 void StrokeManager::setPressure(float pressure)
 {
-    while (nQueued_p >= STROKE_PRESSURE_QUEUE_LENGTH)
-    {
-        for (int i = 0; i < nQueued_p - 1; i++)
-        {
-            pressQueue[i] = pressQueue[i+1];
-        }
-        nQueued_p--;
-    }
+    m_tabletPressure = pressure;
+}
 
-    pressQueue[nQueued_p] = pressure;
-    nQueued_p++;
+void StrokeManager::addSample(QPointF pos, float pressure, int xTilt, int yTilt, ulong time)
+{
+    StrokeSample& sample = m_samples[m_sampleCount & (SAMPLE_BUFFER_LENGTH - 1)];
+    sample.pos = pos;
+    sample.pressure = pressure;
+    sample.xTilt = xTilt;
+    sample.yTilt = yTilt;
+    sample.time = time;
+    m_sampleCount++;
+}
 
-    m_tabletPressure = pressure;
+QList<StrokeSample> StrokeManager::samples(int* from) const
+{
+    QList<StrokeSample> result;
+    // the oldest samples may have been overwritten already
+    int first = qMax(*from, m_sampleCount - SAMPLE_BUFFER_LENGTH);
+    for (int i = first; i < m_sampleCount; i++)
+    {
+        result << sampleAt(i);
+    }
+    *from = m_sampleCount;
+    return result;
 }
 
 QPointF StrokeManager::getEventPosition(QMouseEvent *event)
@@ -107,9 +118,8 @@ void StrokeManager::mousePressEvent(QMouseEvent *event)
     m_lastPixel = getEventPosition(event);
 
     m_strokeStarted = true;
-    singleshotTime.start();
-    previousTime = singleshotTime.elapsed();
-
+    addSample(getEventPosition(event), m_tabletInUse ? m_tabletPressure : 1.0f, 0, 0, event->timestamp());
+    m_lastEmitted = getEventPosition(event);
 }
 
 void StrokeManager::mouseReleaseEvent(QMouseEvent *event)
@@ -117,6 +127,12 @@ void StrokeManager::mouseReleaseEvent(QMouseEvent *event)
     // flush out stroke
     if (m_strokeStarted)
     {
+        if (m_tabletInUse && m_sampleCount > 0)
+        {
+            // the last segment is interpolated once a sample follows it
+            StrokeSample last = sampleAt(m_sampleCount - 1);
+            addSample(last.pos, last.pressure, last.xTilt, last.yTilt, last.time);
+        }
         mouseMoveEvent(event);
         mouseMoveEvent(event);
     }
@@ -132,6 +148,12 @@ void StrokeManager::tabletEvent(QTabletEvent *event)
 
     m_tabletPosition = event->posF();
     setPressure(event->pressure());
+
+    // every tablet sample, not only the ones Qt turns into mouse events
+    if (m_strokeStarted && event->type() == QEvent::TabletMove)
+    {
+        addSample(event->posF(), event->pressure(), event->xTilt(), event->yTilt(), event->timestamp());
+    }
 }
 
 void StrokeManager::mouseMoveEvent(QMouseEvent *event)
@@ -149,62 +171,74 @@ void StrokeManager::mouseMoveEvent(QMouseEvent *event)
     if (!m_tabletInUse)   // a mouse is used instead of a tablet
     {
         setPressure(1.0);
+        addSample(pos, 1.0f, 0, 0, event->timestamp());
     }
+}
 
-    // shift queue
-    while (strokeQueue.size()  >= STROKE_QUEUE_LENGTH)
-    {
-        strokeQueue.removeFirst();
-    }
-
-    strokeQueue << smoothPos;
-
+static QPointF catmullRom(const QPointF& p0, const QPointF& p1, const QPointF& p2, const QPointF& p3, qreal t)
+{
+    qreal t2 = t * t;
+    qreal t3 = t2 * t;
+    return 0.5 * ((2.0 * p1) +
+                  (p2 - p0) * t +
+                  (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * t2 +
+                  (3.0 * p1 - p0 - 3.0 * p2 + p3) * t3);
 }
 
 QList<QPointF> StrokeManager::interpolateStroke(int radius)
 {
     QList<QPointF> result;
 
-    int time = singleshotTime.elapsed();
-    static const qreal smoothness = 0.5f;
-    QLineF line(m_lastPixel, m_currentPixel);
-
+    // close enough for a polyline through the points to look like a curve
+    qreal spacing = qBound(1.0, 0.25 * radius, 4.0);
+    if (m_distanceToNext < 0)
+    {
+        m_distanceToNext = spacing;
+    }
 
-    qreal scaleFactor = line.length();
+    if (m_sampleCount - m_interpolated > SAMPLE_BUFFER_LENGTH - 1)
+    {
+        // fell behind the ring buffer, continue from the oldest sample still there
+        m_interpolated = m_sampleCount - SAMPLE_BUFFER_LENGTH + 1;
+    }
 
-    if (!hasTangent && scaleFactor > 0.01f)
+    // a segment goes through the samples at both of its ends and is known once the sample after it is
+    while (m_interpolated + 2 < m_sampleCount + (m_strokeStarted ? 0 : 1))
     {
-        hasTangent = true;
-//        qDebug() << "scaleFactor" << scaleFactor << "current pixel " << m_currentPixel << "last pixel" << m_lastPixel;
-        m_previousTangent = (m_currentPixel - m_lastPixel) * smoothness / (3.0 * scaleFactor);
-//        qDebug() << "previous tangent" << m_previousTangent;
-        QLineF _line(QPointF(0,0), m_previousTangent);
-        // don't bother for small tangents, as they can induce single pixel wobbliness
-        if (_line.length() < 2) {
-            m_previousTangent = QPointF(0,0);
-        }
-    } else {
-        QPointF c1 = m_lastPixel + m_previousTangent * scaleFactor;
-        QPointF newTangent = (m_currentPixel - c1) * smoothness / (3.0 * scaleFactor);
-//        qDebug() << "scalefactor1" << scaleFactor << m_previousTangent << newTangent;
-        if (scaleFactor == 0) {
-            newTangent = QPointF(0,0);
-        } else {
-        QLineF _line(QPointF(0,0), newTangent);
-        if (_line.length() < 2) {
-            newTangent = QPointF(0,0);
-        }
+        int i = m_interpolated;
+        const QPointF& p1 = sampleAt(i).pos;
+        const QPointF& p2 = sampleAt(i + 1).pos;
+        const QPointF& p0 = (i > 0 && m_sampleCount - i < SAMPLE_BUFFER_LENGTH) ? sampleAt(i - 1).pos : p1;
+        const QPointF& p3 = (i + 2 < m_sampleCount) ? sampleAt(i + 2).pos : p2;
+
+        QPointF from = p1;
+        for (int step = 1; step <= SEGMENT_STEPS; step++)
+        {
+            QPointF to = catmullRom(p0, p1, p2, p3, qreal(step) / SEGMENT_STEPS);
+            qreal length = QLineF(from, to).length();
+            while (m_distanceToNext <= length && length > 0)
+            {
+                from += (to - from) * (m_distanceToNext / length);
+                length -= m_distanceToNext;
+                result << from;
+                m_distanceToNext = spacing;
+            }
+            m_distanceToNext -= length;
+            from = to;
         }
-        QPointF c2 = m_currentPixel - newTangent * scaleFactor;
-//        qDebug() << "scalefactor2" << scaleFactor << m_previousTangent << newTangent;
-
-        result << m_lastPixel << c1 << c2 << m_currentPixel;
-
-        m_previousTangent = newTangent;
+        m_interpolated++;
     }
 
-    previousTime = time;
+    if (!m_strokeStarted && m_sampleCount > 0 && (result.isEmpty() ? m_lastEmitted : result.last()) != sampleAt(m_sampleCount - 1).pos)
+    {
+        // the end of the stroke, closer than the spacing
+        result << sampleAt(m_sampleCount - 1).pos;
+    }
 
+    if (!result.isEmpty())
+    {
+        result.prepend(m_lastEmitted);
+        m_lastEmitted = result.last();
+    }
     return result;
 }
-
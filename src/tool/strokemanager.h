@@ -9,6 +9,18 @@
 #include <QTimer>
 #include <QTime>
 
+/**
+ * One input event of a stroke: where the pointer was, in widget pixels,
+ * with the pressure and tilt of the pen ( 1 and 0 for a mouse ).
+ */
+struct StrokeSample
+{
+    QPointF pos;
+    float pressure;
+    int xTilt, yTilt;
+    ulong time; // milliseconds, from the event
+};
+
 class StrokeManager
 {
 public:
@@ -23,6 +35,11 @@ public:
     float getPressure() { return m_tabletPressure; }
     bool isTabletInUse() { return m_tabletInUse; }
 
+    // the samples recorded since *from, which is moved past them; a tablet sends many per move event
+    QList<StrokeSample> samples(int* from) const;
+
+    // points evenly spaced along a curve through the samples not interpolated yet,
+    // starting with the last point returned by the previous call
     QList<QPointF> interpolateStroke(int radius);
 
     bool isUsingHighResPosition() { return m_useHighResPosition; }
@@ -33,20 +50,22 @@ public:
     QPointF getLastPixel() const { return m_lastPixel; }
 
 protected:
-    static const int STROKE_QUEUE_LENGTH = 3; // 4 points for cubic bezier
-    static const int STROKE_PRESSURE_QUEUE_LENGTH = 16;
+    static const int SAMPLE_BUFFER_LENGTH = 256; // a power of two
+    static const int SEGMENT_STEPS = 8;
 
     void reset();
+    void addSample(QPointF pos, float pressure, int xTilt, int yTilt, ulong time);
+    const StrokeSample& sampleAt(int index) const { return m_samples[index & (SAMPLE_BUFFER_LENGTH - 1)]; }
 
     QPointF getEventPosition(QMouseEvent *);
 
-    float pressure; // last pressure
-    QList<QPointF> strokeQueue;
-
-    float pressQueue[STROKE_PRESSURE_QUEUE_LENGTH + 1];
-    int nQueued_p;
+    // ring buffer of the samples of the current stroke
+    StrokeSample m_samples[SAMPLE_BUFFER_LENGTH];
+    int m_sampleCount; // since the stroke started, the last ones are in the buffer
 
-    QTime singleshotTime;
+    int m_interpolated;       // the segment starting at this sample is the next one to interpolate
+    qreal m_distanceToNext;   // along the curve, to the next point to emit
+    QPointF m_lastEmitted;
 
     long meter;
     QPointF velocity;
@@ -56,10 +75,6 @@ protected:
     QPointF m_currentPixel;
     QPointF m_lastPixel;
 
-    QPointF m_previousTangent;
-    bool hasTangent;
-    int previousTime;
-
     bool m_strokeStarted;
 
     bool m_tabletInUse;
@@ -29,6 +29,8 @@ void StrokeTool::startStroke()
     strokePoints << m_pScribbleArea->pixelToPoint(lastPixel);
     strokePressures.clear();
     strokePressures << m_pStrokeManager->getPressure();
+    m_samplesRead = 0;
+    m_pStrokeManager->samples(&m_samplesRead); // the press, added above
     disableCoalescing();
 }
 
@@ -46,8 +48,12 @@ void StrokeTool::drawStroke()
     if (pixel != lastPixel || !m_firstDraw)
     {
         lastPixel = pixel;
-        strokePoints << m_pScribbleArea->pixelToPoint(pixel);
-        strokePressures << m_pStrokeManager->getPressure();
+        // all the samples since the last move event, a tablet sends several
+        foreach (const StrokeSample& sample, m_pStrokeManager->samples(&m_samplesRead))
+        {
+            strokePoints << m_pScribbleArea->pixelToPoint(sample.pos);
+            strokePressures << sample.pressure;
+        }
     }
     else
     {
@@ -29,6 +29,7 @@ protected:
     QPointF lastPixel;
     QList<QPointF> strokePoints;
     QList<qreal> strokePressures;
+    int m_samplesRead; // from the stroke manager
 
     qreal currentWidth;
     qreal currentPressure;
@@ -102,6 +102,10 @@ enum ToolPropertyType
 #define SHORTCUTS_GROUP "shortcuts"
 #define SETTING_TOOL_CURSOR "toolCursors"
 #define SETTING_HIGH_RESOLUTION "highResPosition"
+#define SETTING_VECTOR_CACHE_SIZE "vectorCacheSize"
+#define SETTING_VECTOR_BINARY_FORMAT "vectorBinaryFormat"
+#define SETTING_UNDO_MEMORY       "undoMemory"
+#define SETTING_TIMELINE_THUMBNAILS "timelineThumbnails"
 
 
 #endif // PENCILDEF_H
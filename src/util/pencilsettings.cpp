@@ -1,15 +1,200 @@
 #include <QStringList>
+#include <QSettings>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <QCoreApplication>
 #include <QDebug>
 #include "pencilsettings.h"
 
+// writes the changes of a store on its writer thread
+class SettingsWriter : public QRunnable
+{
+public:
+    SettingsWriter( PencilSettings* settings ) : m_settings( settings ) {}
+    void run() { m_settings->writeChanges(); }
+
+private:
+    PencilSettings* m_settings;
+};
+
+
+PencilSettings::PencilSettings( QObject* parent ) : QObject( parent )
+    , m_writeScheduled( false )
+{
+    m_writer.setMaxThreadCount( 1 );
+    load();
+}
+
+PencilSettings::PencilSettings( const QString& iniFilePath, QObject* parent ) : QObject( parent )
+    , m_iniFilePath( iniFilePath )
+    , m_writeScheduled( false )
+{
+    m_writer.setMaxThreadCount( 1 );
+    load();
+}
+
+PencilSettings::~PencilSettings()
+{
+    sync();
+}
+
+QSettings* PencilSettings::openBackend() const
+{
+    if ( m_iniFilePath.isEmpty() )
+    {
+        return new QSettings( "Pencil", "Pencil" );
+    }
+    return new QSettings( m_iniFilePath, QSettings::IniFormat );
+}
+
+void PencilSettings::load()
+{
+    QScopedPointer<QSettings> settings( openBackend() );
+    foreach ( QString key, settings->allKeys() )
+    {
+        m_values.insert( key, settings->value( key ) );
+    }
+}
+
+QVariant PencilSettings::value( const QString& key, const QVariant& defaultValue ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_values.value( key, defaultValue );
+}
+
+bool PencilSettings::boolValue( const QString& key, bool defaultValue ) const
+{
+    return value( key, defaultValue ).toBool();
+}
+
+int PencilSettings::intValue( const QString& key, int defaultValue ) const
+{
+    return value( key, defaultValue ).toInt();
+}
+
+qreal PencilSettings::realValue( const QString& key, qreal defaultValue ) const
+{
+    return value( key, defaultValue ).toDouble();
+}
+
+QString PencilSettings::stringValue( const QString& key, const QString& defaultValue ) const
+{
+    return value( key, defaultValue ).toString();
+}
+
+bool PencilSettings::contains( const QString& key ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_values.contains( key );
+}
+
+QStringList PencilSettings::allKeys( const QString& group ) const
+{
+    QMutexLocker locker( &m_mutex );
+    if ( group.isEmpty() )
+    {
+        return m_values.keys();
+    }
+    QString prefix = group + "/";
+    QStringList keys;
+    for ( QMap<QString, QVariant>::const_iterator i = m_values.lowerBound( prefix ); i != m_values.constEnd() && i.key().startsWith( prefix ); ++i )
+    {
+        keys.append( i.key().mid( prefix.size() ) );
+    }
+    return keys;
+}
+
+void PencilSettings::setValue( const QString& key, const QVariant& value )
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        QMap<QString, QVariant>::iterator i = m_values.find( key );
+        if ( i != m_values.end() && i.value() == value && i.value().type() == value.type() )
+        {
+            return;
+        }
+        m_values.insert( key, value );
+    }
+    Change change = { key, value, false };
+    scheduleWrite( change );
+    emit valueChanged( key, value );
+}
+
+void PencilSettings::remove( const QString& key )
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        QString prefix = key + "/";
+        QMap<QString, QVariant>::iterator i = m_values.lowerBound( prefix );
+        while ( i != m_values.end() && i.key().startsWith( prefix ) )
+        {
+            i = m_values.erase( i );
+        }
+        m_values.remove( key );
+    }
+    Change change = { key, QVariant(), true };
+    scheduleWrite( change );
+    emit valueChanged( key, QVariant() );
+}
+
+void PencilSettings::sync()
+{
+    m_writer.waitForDone();
+}
+
+void PencilSettings::scheduleWrite( const Change& change )
+{
+    QMutexLocker locker( &m_changesMutex );
+    m_changes.append( change );
+    if ( !m_writeScheduled )
+    {
+        // the changes made until the writer runs are written together
+        m_writeScheduled = true;
+        m_writer.start( new SettingsWriter( this ) );
+    }
+}
+
+void PencilSettings::writeChanges()
+{
+    QList<Change> changes;
+    {
+        QMutexLocker locker( &m_changesMutex );
+        changes.swap( m_changes );
+        m_writeScheduled = false;
+    }
+    // opened here, as the pool may run each batch on a new thread and a QSettings belongs to one
+    QScopedPointer<QSettings> backend( openBackend() );
+    foreach ( const Change& change, changes )
+    {
+        if ( change.removed )
+        {
+            backend->remove( change.key );
+        }
+        else
+        {
+            backend->setValue( change.key, change.value );
+        }
+    }
+    backend->sync();
+}
+
+
 // ==== Singleton ====
-static QSettings* g_pSettings = NULL;
+static PencilSettings* g_pSettings = NULL;
 
-QSettings* pencilSettings()
+// the store is never deleted: its last changes are written when the application goes
+static void syncSettings()
+{
+    g_pSettings->sync();
+}
+
+PencilSettings* pencilSettings()
 {
     if ( g_pSettings == NULL )
     {
-        g_pSettings = new QSettings("Pencil", "Pencil");
+        g_pSettings = new PencilSettings();
+        qAddPostRoutine( syncSettings );
 
         if ( !g_pSettings->contains("InitPencilSetting") )
         {
@@ -22,7 +207,7 @@ QSettings* pencilSettings()
 
 void restoreToDefaultSetting() // TODO: finish reset list
 {
-    QSettings* s = pencilSettings();
+    PencilSettings* s = pencilSettings();
 
     s->setValue("penWidth", 2.0);
     s->setValue("pencilWidth", 1.0);
@@ -33,8 +218,6 @@ void restoreToDefaultSetting() // TODO: finish reset list
 
     s->setValue("autosaveNumber", 15);
     s->setValue("toolCursors", true);
-
-    s->sync();
     qDebug("restored default tools");
 }
 
@@ -50,25 +233,22 @@ void checkExistingShortcuts()
         }
     }
 
-    pencilSettings()->beginGroup(SHORTCUTS_GROUP);
     defaultKey.beginGroup(SHORTCUTS_GROUP);
-    foreach (QString pKey, pencilSettings()->allKeys())
+    foreach (QString pKey, pencilSettings()->allKeys(SHORTCUTS_GROUP))
     {
         if ( !defaultKey.contains(pKey) )
         {
-            pencilSettings()->remove(pKey);
+            pencilSettings()->remove(QString(SHORTCUTS_GROUP) + "/" + pKey);
         }
     }
     defaultKey.endGroup();
-    pencilSettings()->endGroup();
-    pencilSettings()->sync();
 }
 
 void restoreShortcutsToDefault()
 {
     QSettings defaultKey(":resources/kb.ini", QSettings::IniFormat);
 
-    pencilSettings()->remove("shortcuts");
+    pencilSettings()->remove(SHORTCUTS_GROUP);
 
     foreach (QString pShortcutsKey, defaultKey.allKeys())
     {
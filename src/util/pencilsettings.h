@@ -2,10 +2,89 @@
 #define PENCILSETTINGS_H
 
 #include <QObject>
-#include <QSettings>
+#include <QMap>
+#include <QList>
+#include <QMutex>
+#include <QVariant>
+#include <QStringList>
+#include <QThreadPool>
 #include "pencildef.h"
 
-QSettings* pencilSettings();
+class QSettings;
+
+
+/**
+ * The preferences of the application, kept in memory.
+ *
+ * The settings are read from QSettings once, when the store is created, and
+ * then served from memory, so reading one costs a lookup rather than a
+ * parse of the settings file. Changes are applied at once, announced by
+ * valueChanged(), and written to QSettings in the background by a thread of
+ * the store; sync() waits for them. The store may be read from any thread.
+ *
+ * Keys in a group are written "group/key", as with QSettings.
+ */
+class PencilSettings : public QObject
+{
+    Q_OBJECT
+
+public:
+    // the settings of the application
+    PencilSettings( QObject* parent = 0 );
+    // settings kept in an ini file, for tests and tools
+    explicit PencilSettings( const QString& iniFilePath, QObject* parent = 0 );
+    ~PencilSettings();
+
+    QVariant value( const QString& key, const QVariant& defaultValue = QVariant() ) const;
+    bool boolValue( const QString& key, bool defaultValue = false ) const;
+    int intValue( const QString& key, int defaultValue = 0 ) const;
+    qreal realValue( const QString& key, qreal defaultValue = 0 ) const;
+    QString stringValue( const QString& key, const QString& defaultValue = QString() ) const;
+
+    // from 0 to 1; stored as the transparency in percent, 0 by default
+    qreal curveOpacity() const { return ( 100 - intValue( "curveOpacity" ) ) / 100.0; }
+
+    bool contains( const QString& key ) const;
+    // all the keys, or the keys of a group without the group prefix
+    QStringList allKeys( const QString& group = QString() ) const;
+
+    void setValue( const QString& key, const QVariant& value );
+    // removes a key, or a whole group
+    void remove( const QString& key );
+    // waits until the changes are written
+    void sync();
+
+signals:
+    void valueChanged( const QString& key, const QVariant& value );
+
+private:
+    friend class SettingsWriter;
+
+    struct Change
+    {
+        QString key;
+        QVariant value;
+        bool removed;
+    };
+
+    void load();
+    void scheduleWrite( const Change& change );
+    void writeChanges(); // on the writer thread
+    QSettings* openBackend() const;
+
+    QString m_iniFilePath;  // empty: the settings of the application
+
+    mutable QMutex m_mutex; // guards the values
+    QMap<QString, QVariant> m_values;
+
+    QMutex m_changesMutex;  // guards the changes not written yet
+    QList<Change> m_changes;
+    bool m_writeScheduled;
+    QThreadPool m_writer;   // a single thread, so the changes are written in order
+};
+
+
+PencilSettings* pencilSettings();
 void restoreToDefaultSetting();
 
 void restoreShortcutsToDefault();
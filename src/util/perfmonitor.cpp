@@ -0,0 +1,126 @@
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QMutexLocker>
+#include "perfmonitor.h"
+
+static const qreal AVERAGE_WEIGHT = 0.1; // of the newest call in the running average
+
+// ==== Singleton ====
+// created once whichever thread asks first: the scopes are timed from worker threads too
+struct PerfMonitorHolder
+{
+    PerfMonitor monitor;
+};
+Q_GLOBAL_STATIC( PerfMonitorHolder, g_perfMonitorHolder )
+
+PerfMonitor* PerfMonitor::instance()
+{
+    return &g_perfMonitorHolder()->monitor;
+}
+
+PerfMonitor::PerfMonitor() : m_events( MAX_EVENTS ), m_next( 0 ), m_eventCount( 0 )
+{
+    m_clock.start();
+}
+
+void PerfMonitor::append( const Event& event )
+{
+    m_events[ m_next ] = event;
+    m_next = ( m_next + 1 ) % MAX_EVENTS;
+    m_eventCount = qMin( m_eventCount + 1, int( MAX_EVENTS ) );
+}
+
+void PerfMonitor::record( const char* name, qint64 start, qint64 duration )
+{
+    QMutexLocker locker( &m_mutex );
+    Event event;
+    event.name = name;
+    event.thread = quintptr( QThread::currentThreadId() );
+    event.start = start;
+    event.duration = duration;
+    event.value = 0;
+    append( event );
+
+    Stat& stat = m_stats[ QByteArray::fromRawData( name, qstrlen( name ) ) ];
+    stat.average = ( stat.calls == 0 ) ? duration : stat.average + AVERAGE_WEIGHT * ( duration - stat.average );
+    stat.last = duration;
+    stat.calls++;
+}
+
+void PerfMonitor::count( const char* name, qint64 n )
+{
+    qint64 time = now();
+    QMutexLocker locker( &m_mutex );
+    qint64& total = m_counters[ QByteArray::fromRawData( name, qstrlen( name ) ) ];
+    total += n;
+
+    Event event;
+    event.name = name;
+    event.thread = quintptr( QThread::currentThreadId() );
+    event.start = time;
+    event.duration = -1;
+    event.value = total;
+    append( event );
+}
+
+PerfMonitor::Stat PerfMonitor::stat( const char* name ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_stats.value( QByteArray::fromRawData( name, qstrlen( name ) ) );
+}
+
+qint64 PerfMonitor::counter( const char* name ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_counters.value( QByteArray::fromRawData( name, qstrlen( name ) ) );
+}
+
+int PerfMonitor::eventCount() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_eventCount;
+}
+
+void PerfMonitor::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    m_next = 0;
+    m_eventCount = 0;
+    m_stats.clear();
+    m_counters.clear();
+}
+
+bool PerfMonitor::saveChromeTrace( const QString& filePath ) const
+{
+    QFile file( filePath );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+        return false;
+    }
+    QTextStream out( &file );
+
+    QMutexLocker locker( &m_mutex );
+    // complete events ( "X" ) for the timings, counter events ( "C" ) for the counters,
+    // oldest first; the names are code identifiers, nothing needs escaping
+    out << "{\"traceEvents\":[";
+    int first = ( m_next - m_eventCount + MAX_EVENTS ) % MAX_EVENTS;
+    for ( int i = 0; i < m_eventCount; i++ )
+    {
+        const Event& event = m_events.at( ( first + i ) % MAX_EVENTS );
+        out << ( i > 0 ? ",\n" : "\n" );
+        out << "{\"name\":\"" << event.name << "\",\"cat\":\"pencil\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << event.start;
+        if ( event.duration >= 0 )
+        {
+            out << ",\"ph\":\"X\",\"dur\":" << event.duration << "}";
+        }
+        else
+        {
+            out << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.flush();
+    return out.status() == QTextStream::Ok && file.error() == QFile::NoError;
+}
@@ -0,0 +1,102 @@
+#ifndef PERFMONITOR_H
+#define PERFMONITOR_H
+
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QElapsedTimer>
+
+
+/**
+ * Timings and counters of the hot paths of the application.
+ *
+ * Code is timed with PERF_SCOPE( "name" ), which measures the enclosing
+ * block, and things are counted with PERF_COUNT( "name", n ). Both compile
+ * to nothing unless the application is built with CONFIG+=profiling, so a
+ * release build pays nothing for them.
+ *
+ * The monitor keeps the last MAX_EVENTS timings, which can be saved as a
+ * Chrome trace ( chrome://tracing ) for offline analysis, and running
+ * statistics per name, which the canvas shows in its performance overlay.
+ * Names must be string literals: they are stored, not copied.
+ */
+class PerfMonitor
+{
+public:
+    static const int MAX_EVENTS = 65536;
+
+    struct Stat
+    {
+        Stat() : calls( 0 ), last( 0 ), average( 0 ) {}
+        qint64 calls;
+        qint64 last;    // microseconds
+        qreal average;  // microseconds, recent calls weigh more
+    };
+
+    static PerfMonitor* instance();
+
+    // microseconds since the monitor was created
+    qint64 now() const { return m_clock.nsecsElapsed() / 1000; }
+
+    void record( const char* name, qint64 start, qint64 duration );
+    void count( const char* name, qint64 n );
+
+    Stat stat( const char* name ) const;
+    qint64 counter( const char* name ) const;
+    int eventCount() const;
+
+    bool saveChromeTrace( const QString& filePath ) const;
+    void clear();
+
+private:
+    friend struct PerfMonitorHolder;
+    PerfMonitor();
+
+    struct Event
+    {
+        const char* name;
+        quintptr thread;
+        qint64 start;
+        qint64 duration; // -1 for counter samples
+        qint64 value;
+    };
+    void append( const Event& event );
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QVector<Event> m_events; // ring buffer
+    int m_next;
+    int m_eventCount;
+    QHash<QByteArray, Stat> m_stats;
+    QHash<QByteArray, qint64> m_counters;
+};
+
+
+// times the lifetime of the object
+class PerfScope
+{
+public:
+    explicit PerfScope( const char* name ) : m_name( name ), m_start( PerfMonitor::instance()->now() ) {}
+    ~PerfScope()
+    {
+        PerfMonitor* monitor = PerfMonitor::instance();
+        monitor->record( m_name, m_start, monitor->now() - m_start );
+    }
+
+private:
+    const char* m_name;
+    qint64 m_start;
+};
+
+
+#ifdef PENCIL_PROFILING
+#define PERF_SCOPE( name ) PerfScope perfScope( name )
+#define PERF_COUNT( name, n ) PerfMonitor::instance()->count( name, n )
+#else
+#define PERF_SCOPE( name ) do {} while ( 0 )
+#define PERF_COUNT( name, n ) do {} while ( 0 )
+#endif
+
+#endif // PERFMONITOR_H
@@ -0,0 +1,104 @@
+#include "bitmapimage.h"
+#include "strokerenderer.h"
+#include "bench_inputs.h"
+#include "bench_bitmap.h"
+
+static const QRect CANVAS( 0, 0, 1920, 1080 );
+
+static BrushDab dabAt( QPointF center, qreal width )
+{
+    QRadialGradient gradient( center, 0.5 * width );
+    gradient.setColorAt( 0.0, QColor( 20, 40, 160, 255 ) );
+    gradient.setColorAt( 1.0, QColor( 20, 40, 160, 0 ) );
+
+    BrushDab dab;
+    dab.rect = QRectF( center.x() - 0.5 * width, center.y() - 0.5 * width, width, width );
+    dab.gradient = gradient;
+    dab.antialiasing = true;
+    return dab;
+}
+
+BenchBitmap::BenchBitmap()
+{
+}
+
+void BenchBitmap::floodFill()
+{
+    BitmapImage drawing( NULL, CANVAS, QColor( 0, 0, 0, 0 ) );
+    drawScribbles( drawing, 1, CANVAS, 20 );
+
+    QBENCHMARK
+    {
+        BitmapImage fill( NULL );
+        BitmapImage::floodFill( &drawing, &fill, CANVAS.center(), qRgba( 0, 0, 0, 0 ), qRgb( 255, 200, 0 ), 100 * 100, true );
+    }
+}
+
+void BenchBitmap::blur()
+{
+    BitmapImage drawing( NULL, CANVAS, QColor( 0, 0, 0, 0 ) );
+    drawScribbles( drawing, 2, CANVAS, 20 );
+
+    QBENCHMARK
+    {
+        BitmapImage blurred( drawing );
+        blurred.blur( 8 );
+    }
+}
+
+void BenchBitmap::brushDabs()
+{
+    SeededRandom random( 3 );
+    QList<BrushDab> dabs;
+    QPointF position = CANVAS.center();
+    for ( int i = 0; i < 2000; i++ )
+    {
+        position += QPointF( random.uniform( -6, 6 ), random.uniform( -6, 6 ) );
+        dabs << dabAt( position, random.uniform( 10, 40 ) );
+    }
+
+    StrokeRenderer renderer;
+    QBENCHMARK
+    {
+        BitmapImage target( NULL );
+        foreach ( BrushDab dab, dabs )
+        {
+            renderer.drawDab( dab );
+        }
+        renderer.finish( &target );
+    }
+}
+
+void BenchBitmap::paste()
+{
+    BitmapImage stroke( NULL, CANVAS, QColor( 0, 0, 0, 0 ) );
+    drawScribbles( stroke, 4, CANVAS, 5 );
+    BitmapImage drawing( NULL, CANVAS, QColor( 0, 0, 0, 0 ) );
+    drawScribbles( drawing, 5, CANVAS, 20 );
+
+    QBENCHMARK
+    {
+        BitmapImage target( drawing );
+        target.paste( &stroke, QPainter::CompositionMode_SourceOver );
+    }
+}
+
+void BenchBitmap::extend()
+{
+    SeededRandom random( 6 );
+    QList<QRect> rects;
+    for ( int i = 0; i < 200; i++ )
+    {
+        rects << QRectF( random.point( CANVAS ), QSizeF( 40, 40 ) ).toRect();
+    }
+
+    // the image grows a little for every dab of a stroke wandering over the canvas
+    QBENCHMARK
+    {
+        BitmapImage image( NULL );
+        foreach ( QRect rect, rects )
+        {
+            image.extend( rect );
+        }
+    }
+}
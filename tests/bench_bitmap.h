@@ -0,0 +1,26 @@
+#ifndef BENCH_BITMAP_H
+#define BENCH_BITMAP_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class BenchBitmap : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchBitmap();
+
+private slots:
+    void floodFill();
+    void blur();
+    void brushDabs();
+    void paste();
+    void extend();
+};
+
+DECLARE_TEST(BenchBitmap)
+
+#endif // BENCH_BITMAP_H
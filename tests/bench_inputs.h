@@ -0,0 +1,30 @@
+#ifndef BENCH_INPUTS_H
+#define BENCH_INPUTS_H
+
+#include <QRect>
+#include <QPainterPath>
+#include "bitmapimage.h"
+#include "projectgenerator.h"
+
+
+// closed outlines and open scribbles over the area, like a cleaned up drawing
+inline void drawScribbles( BitmapImage& image, quint32 seed, const QRect& area, int count )
+{
+    SeededRandom random( seed );
+    QPen pen( Qt::black, 3, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin );
+    for ( int i = 0; i < count; i++ )
+    {
+        QPainterPath path( random.point( area ) );
+        for ( int k = 0; k < 4; k++ )
+        {
+            path.cubicTo( random.point( area ), random.point( area ), random.point( area ) );
+        }
+        if ( i % 2 == 0 )
+        {
+            path.closeSubpath();
+        }
+        image.drawPath( path, pen, Qt::NoBrush, QPainter::CompositionMode_SourceOver, true );
+    }
+}
+
+#endif // BENCH_INPUTS_H
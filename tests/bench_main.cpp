@@ -0,0 +1,42 @@
+#include <QDir>
+#include <QStringList>
+#include "AutoTest.h"
+
+
+// pencil_bench [-outdir DIR] [QTest options]
+//
+// With -outdir, every benchmark class writes its results to DIR/<class>.xml,
+// in the xml format of QTest, so that the runs of two releases can be compared
+// by a script. The other options go to QTest, e.g. -iterations or -callgrind.
+int main(int argc, char *argv[])
+{
+    QStringList arguments;
+    QString strOutDir;
+    for ( int i = 0; i < argc; i++ )
+    {
+        if ( QString( argv[ i ] ) == "-outdir" && i + 1 < argc )
+        {
+            strOutDir = argv[ ++i ];
+        }
+        else
+        {
+            arguments << argv[ i ];
+        }
+    }
+    if ( !strOutDir.isEmpty() )
+    {
+        QDir().mkpath( strOutDir );
+    }
+
+    int ret = 0;
+    foreach ( QObject* bench, AutoTest::testList() )
+    {
+        QStringList benchArguments = arguments;
+        if ( !strOutDir.isEmpty() )
+        {
+            benchArguments << "-o" << QDir( strOutDir ).filePath( bench->objectName() + ".xml" ) + ",xml";
+        }
+        ret += QTest::qExec( bench, benchArguments );
+    }
+    return ret;
+}
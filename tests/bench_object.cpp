@@ -0,0 +1,106 @@
+#include "object.h"
+#include "layerbitmap.h"
+#include "objectsaveloader.h"
+#include "projectgenerator.h"
+#include "bench_object.h"
+
+static const QRect CANVAS( 0, 0, 1920, 1080 );
+
+BenchObject::BenchObject() : m_pProject( NULL )
+{
+}
+
+void BenchObject::initTestCase()
+{
+    // a short scene: a few bitmap layers with a drawing every frame, and a vector layer
+    ProjectGenerator::Parameters parameters;
+    parameters.seed = 20;
+    parameters.bitmapLayers = 4;
+    parameters.vectorLayers = 1;
+    parameters.frames = 24;
+    parameters.canvasSize = CANVAS.size();
+    parameters.curvesPerVectorKey = 50;
+    parameters.areasPerVectorKey = 10;
+    m_pProject = ProjectGenerator( parameters ).generate();
+
+    m_strProjectPath = QDir::temp().filePath( "bench_object.pclx" );
+    QFile::remove( m_strProjectPath );
+    ObjectSaveLoader saveLoader;
+    QVERIFY( saveLoader.saveToFile( m_pProject, m_strProjectPath ) );
+}
+
+void BenchObject::cleanupTestCase()
+{
+    delete m_pProject;
+    QFile::remove( m_strProjectPath );
+}
+
+void BenchObject::compose_data()
+{
+    QTest::addColumn<int>( "layerCount" );
+    QTest::newRow( "1 layer" ) << 1;
+    QTest::newRow( "8 layers" ) << 8;
+    QTest::newRow( "32 layers" ) << 32;
+}
+
+void BenchObject::compose()
+{
+    // what ScribbleArea::updateCanvas does for the current frame, without the widget
+    QFETCH( int, layerCount );
+    ProjectGenerator::Parameters parameters;
+    parameters.seed = 30;
+    parameters.bitmapLayers = layerCount;
+    parameters.vectorLayers = 0;
+    parameters.frames = 1;
+    parameters.canvasSize = CANVAS.size();
+    QScopedPointer<Object> object( ProjectGenerator( parameters ).generate() );
+    QImage canvas( CANVAS.size(), QImage::Format_ARGB32_Premultiplied );
+
+    QBENCHMARK
+    {
+        canvas.fill( Qt::transparent );
+        QPainter painter( &canvas );
+        painter.translate( CANVAS.width() / 2, CANVAS.height() / 2 );
+        object->paintImage( painter, 1, true, 1.0, true );
+    }
+}
+
+void BenchObject::keyframeLookup()
+{
+    // a long layer, a key every other frame
+    Object object;
+    LayerBitmap* pLayer = object.addNewBitmapLayer();
+    for ( int frame = 3; frame <= 10000; frame += 2 )
+    {
+        pLayer->addImageAtFrame( frame );
+    }
+
+    QBENCHMARK
+    {
+        for ( int frame = 1; frame <= 10000; frame += 7 )
+        {
+            pLayer->getLastBitmapImageAtFrame( frame, 0 );
+        }
+    }
+}
+
+void BenchObject::saveProject()
+{
+    QString strFilePath = QDir::temp().filePath( "bench_object_save.pclx" );
+    QBENCHMARK
+    {
+        QFile::remove( strFilePath );
+        ObjectSaveLoader saveLoader;
+        saveLoader.saveToFile( m_pProject, strFilePath );
+    }
+    QFile::remove( strFilePath );
+}
+
+void BenchObject::loadProject()
+{
+    QBENCHMARK
+    {
+        ObjectSaveLoader saveLoader;
+        delete saveLoader.loadFromFile( m_strProjectPath );
+    }
+}
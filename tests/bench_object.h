@@ -0,0 +1,35 @@
+#ifndef BENCH_OBJECT_H
+#define BENCH_OBJECT_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+class Object;
+
+
+class BenchObject : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchObject();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void compose_data();
+    void compose();
+    void keyframeLookup();
+    void saveProject();
+    void loadProject();
+
+private:
+    Object* m_pProject;   // saved and loaded
+    QString m_strProjectPath;
+};
+
+DECLARE_TEST(BenchObject)
+
+#endif // BENCH_OBJECT_H
@@ -0,0 +1,102 @@
+#include "vectorimage.h"
+#include "bench_inputs.h"
+#include "bench_vector.h"
+
+static const QRectF CANVAS( 0, 0, 1920, 1080 );
+
+// a pen stroke of a few dozen points wandering from a random place
+static BezierCurve randomStroke( SeededRandom& random )
+{
+    QList<QPointF> points;
+    QList<qreal> pressures;
+    QPointF position = random.point( CANVAS );
+    for ( int i = 0; i < 30; i++ )
+    {
+        position += QPointF( random.uniform( -8, 8 ), random.uniform( -8, 8 ) );
+        points << position;
+        pressures << random.uniform( 0.3, 1.0 );
+    }
+    BezierCurve curve( points, pressures, 0.5 );
+    curve.setWidth( 2.0 );
+    curve.setVariableWidth( true );
+    curve.setInvisibility( false );
+    curve.setColourNumber( 0 );
+    return curve;
+}
+
+static void fillImage( VectorImage& image, quint32 seed, int count )
+{
+    SeededRandom random( seed );
+    for ( int i = 0; i < count; i++ )
+    {
+        image.curve.append( randomStroke( random ) );
+    }
+}
+
+BenchVector::BenchVector()
+{
+}
+
+void BenchVector::addCurve_data()
+{
+    QTest::addColumn<int>( "curveCount" );
+    QTest::newRow( "100 curves" ) << 100;
+    QTest::newRow( "1000 curves" ) << 1000;
+}
+
+void BenchVector::addCurve()
+{
+    QFETCH( int, curveCount );
+    VectorImage drawing;
+    fillImage( drawing, 10, curveCount );
+    SeededRandom random( 11 );
+    BezierCurve stroke = randomStroke( random );
+
+    // the new stroke is connected to the curves around its ends
+    QBENCHMARK
+    {
+        VectorImage image( drawing );
+        BezierCurve newCurve = stroke;
+        image.addCurve( newCurve, 1.0 );
+    }
+}
+
+void BenchVector::curvesCloseTo()
+{
+    VectorImage image;
+    fillImage( image, 12, 1000 );
+    SeededRandom random( 13 );
+    QList<QPointF> queries;
+    for ( int i = 0; i < 100; i++ )
+    {
+        queries << random.point( CANVAS );
+    }
+
+    QBENCHMARK
+    {
+        foreach ( QPointF point, queries )
+        {
+            image.getCurvesCloseTo( point, 6.0 );
+        }
+    }
+}
+
+void BenchVector::verticesCloseTo()
+{
+    VectorImage image;
+    fillImage( image, 14, 1000 );
+    SeededRandom random( 15 );
+    QList<QPointF> queries;
+    for ( int i = 0; i < 100; i++ )
+    {
+        queries << random.point( CANVAS );
+    }
+
+    QBENCHMARK
+    {
+        foreach ( QPointF point, queries )
+        {
+            image.getVerticesCloseTo( point, 6.0 );
+        }
+    }
+}
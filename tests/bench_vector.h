@@ -0,0 +1,25 @@
+#ifndef BENCH_VECTOR_H
+#define BENCH_VECTOR_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class BenchVector : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchVector();
+
+private slots:
+    void addCurve_data();
+    void addCurve();
+    void curvesCloseTo();
+    void verticesCloseTo();
+};
+
+DECLARE_TEST(BenchVector)
+
+#endif // BENCH_VECTOR_H
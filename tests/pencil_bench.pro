@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# Benchmarks of the drawing, composition and file code
+#
+# pencil_bench -outdir results/ writes one QTest xml file per benchmark class
+#
+#-------------------------------------------------
+
+QT       += core gui widgets xml xmlpatterns phonon svg multimedia testlib
+
+TARGET = pencil_bench
+CONFIG   += console release
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+include($$PWD/../src/pencil.pri)
+
+HEADERS += \
+    AutoTest.h \
+    bench_inputs.h \
+    bench_bitmap.h \
+    bench_vector.h \
+    bench_object.h
+
+SOURCES += \
+    bench_main.cpp \
+    bench_bitmap.cpp \
+    bench_vector.cpp \
+    bench_object.cpp
+
+RESOURCES += $$PWD/../pencil.qrc
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui widgets xml xmlpatterns phonon svg testlib
+QT       += core gui widgets xml xmlpatterns phonon svg multimedia testlib
 
 TARGET = pencil_test
 CONFIG   += console
@@ -18,13 +18,35 @@ HEADERS += \
     AutoTest.h \
     test_objectsaveloader.h \
     test_layer.h \
-    test_layermanager.h
+    test_layermanager.h \
+    test_vectorimage.h \
+    test_audiomixer.h \
+    test_soundwaveform.h \
+    test_cameratrack.h \
+    test_bitmapmipmaps.h \
+    test_strokemanager.h \
+    test_strokerenderer.h \
+    test_perfmonitor.h \
+    test_projectgenerator.h \
+    test_batchrenderer.h \
+    test_pencilsettings.h
 
 SOURCES += \
     main.cpp \
     test_objectsaveloader.cpp \
     test_layer.cpp \
-    test_layermanager.cpp
+    test_layermanager.cpp \
+    test_vectorimage.cpp \
+    test_audiomixer.cpp \
+    test_soundwaveform.cpp \
+    test_cameratrack.cpp \
+    test_bitmapmipmaps.cpp \
+    test_strokemanager.cpp \
+    test_strokerenderer.cpp \
+    test_perfmonitor.cpp \
+    test_projectgenerator.cpp \
+    test_batchrenderer.cpp \
+    test_pencilsettings.cpp
 
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
 
@@ -0,0 +1,66 @@
+#include "audiomixer.h"
+#include "test_audiomixer.h"
+
+static QVector<qint16> constantClip( int frames, qint16 value )
+{
+    return QVector<qint16>( frames * AudioMixer::CHANNELS, value );
+}
+
+TestAudioMixer::TestAudioMixer()
+{
+}
+
+void TestAudioMixer::testClipOffset()
+{
+    AudioMixer mixer;
+    mixer.addClip( constantClip( 10, 100 ), 5 );
+
+    QVector<qint16> buffer( 20 * AudioMixer::CHANNELS, 0 );
+    mixer.mix( buffer.data(), 0, 20 );
+
+    for ( int frame = 0; frame < 20; frame++ )
+    {
+        qint16 expected = ( frame >= 5 && frame < 15 ) ? 100 : 0;
+        QCOMPARE( buffer[ frame * AudioMixer::CHANNELS ], expected );
+        QCOMPARE( buffer[ frame * AudioMixer::CHANNELS + 1 ], expected );
+    }
+}
+
+void TestAudioMixer::testSaturation()
+{
+    AudioMixer mixer;
+    mixer.addClip( constantClip( 37, 30000 ), 0 );
+    mixer.addClip( constantClip( 37, 10000 ), 0 );
+    mixer.addClip( constantClip( 37, -30000 ), 100 );
+    mixer.addClip( constantClip( 37, -10000 ), 100 );
+
+    QVector<qint16> buffer( 137 * AudioMixer::CHANNELS, 0 );
+    mixer.mix( buffer.data(), 0, 137 );
+
+    QCOMPARE( buffer.first(), qint16( 32767 ) );
+    QCOMPARE( buffer[ 36 * AudioMixer::CHANNELS + 1 ], qint16( 32767 ) );
+    QCOMPARE( buffer[ 37 * AudioMixer::CHANNELS ], qint16( 0 ) );
+    QCOMPARE( buffer.last(), qint16( -32768 ) );
+}
+
+void TestAudioMixer::testBlocksMatchWholeMix()
+{
+    QVector<qint16> ramp;
+    for ( int i = 0; i < 1000 * AudioMixer::CHANNELS; i++ )
+    {
+        ramp.append( qint16( i * 31 % 20000 - 10000 ) );
+    }
+    AudioMixer mixer;
+    mixer.addClip( ramp, 3 );
+    mixer.addClip( ramp, 421 );
+
+    QVector<qint16> whole( 1500 * AudioMixer::CHANNELS, 0 );
+    mixer.mix( whole.data(), 0, 1500 );
+
+    QVector<qint16> blocks( 1500 * AudioMixer::CHANNELS, 0 );
+    for ( int position = 0; position < 1500; position += 97 )
+    {
+        mixer.mix( blocks.data() + position * AudioMixer::CHANNELS, position, qMin( 97, 1500 - position ) );
+    }
+    QCOMPARE( blocks, whole );
+}
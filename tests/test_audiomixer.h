@@ -0,0 +1,24 @@
+#ifndef TEST_AUDIOMIXER_H
+#define TEST_AUDIOMIXER_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestAudioMixer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestAudioMixer();
+
+private slots:
+    void testClipOffset();
+    void testSaturation();
+    void testBlocksMatchWholeMix();
+};
+
+DECLARE_TEST(TestAudioMixer)
+
+#endif // TEST_AUDIOMIXER_H
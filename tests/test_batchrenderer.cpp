@@ -0,0 +1,225 @@
+#include "projectgenerator.h"
+#include "batchrenderer.h"
+#include "test_batchrenderer.h"
+
+// a small project in a new temporary folder
+static QString generateProject( QDir* folder, const QString& name, int frames )
+{
+    ProjectGenerator::Parameters parameters;
+    parameters.frames = frames;
+    parameters.canvasSize = QSize( 120, 80 );
+    parameters.curvesPerVectorKey = 10;
+    parameters.areasPerVectorKey = 2;
+
+    *folder = QDir::temp();
+    folder->mkdir( name );
+    folder->cd( name );
+    QString strProject = folder->filePath( "project.pclx" );
+    return ProjectGenerator( parameters ).generate( strProject ) ? strProject : QString();
+}
+
+static void removeFolder( QDir folder )
+{
+    foreach ( QString strFile, folder.entryList( QDir::Files ) )
+    {
+        folder.remove( strFile );
+    }
+    QString name = folder.dirName();
+    folder.cdUp();
+    folder.rmdir( name );
+}
+
+TestBatchRenderer::TestBatchRenderer()
+{
+}
+
+void TestBatchRenderer::testParseJob()
+{
+    RenderJob job;
+    QString error;
+    QStringList arguments;
+    arguments << "in.pclx" << "out.png" << "--start" << "5" << "--end" << "9" << "--size" << "320x240" << "--background";
+    QVERIFY( BatchRenderer::parseJob( arguments, &job, &error ) );
+    QCOMPARE( job.projectPath, QString( "in.pclx" ) );
+    QCOMPARE( job.outputPath, QString( "out.png" ) );
+    QCOMPARE( job.startFrame, 5 );
+    QCOMPARE( job.endFrame, 9 );
+    QCOMPARE( job.size, QSize( 320, 240 ) );
+    QVERIFY( job.background );
+    QVERIFY( job.antialiasing );
+    QCOMPARE( job.curveOpacity, 1.0 );
+
+    RenderJob badJob;
+    QVERIFY( !BatchRenderer::parseJob( QStringList() << "in.pclx", &badJob, &error ) );
+    QVERIFY( !BatchRenderer::parseJob( QStringList() << "in.pclx" << "out.png" << "--size" << "big", &badJob, &error ) );
+    QVERIFY( !BatchRenderer::parseJob( QStringList() << "in.pclx" << "out.png" << "--end", &badJob, &error ) );
+    QVERIFY( !BatchRenderer::parseJob( QStringList() << "in.pclx" << "out.png" << "--shard" << "9/8", &badJob, &error ) );
+
+    RenderJob shardJob;
+    QVERIFY( BatchRenderer::parseJob( QStringList() << "in.pclx" << "out.png" << "--shard" << "3/8", &shardJob, &error ) );
+    QCOMPARE( shardJob.shard, 3 );
+    QCOMPARE( shardJob.shardCount, 8 );
+
+    QCOMPARE( QString( BatchRenderer::formatOf( "a/b.JPG" ) ), QString( "JPG" ) );
+    QVERIFY( BatchRenderer::formatOf( "a/b.gif" ) == NULL );
+}
+
+void TestBatchRenderer::testReadJobFile()
+{
+    QDir folder = QDir::temp();
+    QString strJobFile = folder.filePath( "test_batchrenderer.jobs" );
+    QFile file( strJobFile );
+    QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Text ) );
+    file.write( "# shots of the week\n"
+                "\n"
+                "shot1.pclx renders/shot1.png --end 24\n"
+                "\"my shot 2.pclx\" /tmp/shot2.jpg --camera \"Camera Layer\" --no-antialiasing\n" );
+    file.close();
+
+    QList<RenderJob> jobs;
+    QString error;
+    QVERIFY( BatchRenderer::readJobFile( strJobFile, &jobs, &error ) );
+    QCOMPARE( jobs.size(), 2 );
+    QCOMPARE( jobs.at( 0 ).projectPath, folder.absoluteFilePath( "shot1.pclx" ) );
+    QCOMPARE( jobs.at( 0 ).outputPath, folder.absoluteFilePath( "renders/shot1.png" ) );
+    QCOMPARE( jobs.at( 0 ).endFrame, 24 );
+    QCOMPARE( jobs.at( 1 ).projectPath, folder.absoluteFilePath( "my shot 2.pclx" ) );
+    QCOMPARE( jobs.at( 1 ).outputPath, QString( "/tmp/shot2.jpg" ) );
+    QCOMPARE( jobs.at( 1 ).camera, QString( "Camera Layer" ) );
+    QVERIFY( !jobs.at( 1 ).antialiasing );
+
+    QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Text ) );
+    file.write( "shot1.pclx renders/shot1.png --frames 24\n" );
+    file.close();
+    QVERIFY( !BatchRenderer::readJobFile( strJobFile, &jobs, &error ) );
+    QVERIFY( error.contains( ":1:" ) );
+    QFile::remove( strJobFile );
+}
+
+void TestBatchRenderer::testRenderFrames()
+{
+    QDir folder;
+    QString strProject = generateProject( &folder, "test_batchrenderer", 5 );
+    QVERIFY( !strProject.isEmpty() );
+
+    RenderJob job;
+    job.projectPath = strProject;
+    job.outputPath = folder.filePath( "frame.png" );
+    job.startFrame = 2;
+    job.size = QSize( 60, 40 );
+    job.camera = "none";
+
+    // more threads than frames
+    RenderResult result = BatchRenderer( 8 ).render( job );
+    QCOMPARE( result.exitCode, int( RenderResult::OK ) );
+    QCOMPARE( result.framesWritten, 4 );
+    QVERIFY( !QFile::exists( folder.filePath( "frame0001.png" ) ) );
+    for ( int frame = 2; frame <= 5; frame++ )
+    {
+        QImage image( folder.filePath( QString( "frame%1.png" ).arg( frame, 4, 10, QChar( '0' ) ) ) );
+        QCOMPARE( image.size(), QSize( 60, 40 ) );
+    }
+    removeFolder( folder );
+}
+
+void TestBatchRenderer::testCannotOpen()
+{
+    RenderJob job;
+    job.projectPath = QDir::temp().filePath( "test_batchrenderer_missing.pclx" );
+    job.outputPath = QDir::temp().filePath( "frame.png" );
+    RenderResult result = BatchRenderer( 2 ).render( job );
+    QCOMPARE( result.exitCode, int( RenderResult::CANNOT_OPEN ) );
+    QCOMPARE( result.framesWritten, 0 );
+
+    job.outputPath = QDir::temp().filePath( "frame.gif" );
+    QCOMPARE( BatchRenderer( 2 ).render( job ).exitCode, int( RenderResult::BAD_JOB ) );
+
+    // the frames keep the suffix of the output
+    QVERIFY( BatchRenderer::formatOf( "frame.jpeg" ) != NULL );
+    QVERIFY( BatchRenderer::framePath( "/tmp/frame.jpeg", 12 ).endsWith( "frame0012.jpeg" ) );
+    QVERIFY( BatchRenderer::framePath( "/tmp/frame.PNG", 12 ).endsWith( "frame0012.PNG" ) );
+}
+
+void TestBatchRenderer::testShardsAndMerge()
+{
+    QDir folder;
+    QString strProject = generateProject( &folder, "test_batchrenderer_shards", 7 );
+    QVERIFY( !strProject.isEmpty() );
+    QDir otherFolder = QDir::temp();
+    otherFolder.mkdir( "test_batchrenderer_node2" );
+    otherFolder.cd( "test_batchrenderer_node2" );
+
+    // shards 1 and 2 here, shard 3 on another machine
+    RenderJob job;
+    job.projectPath = strProject;
+    job.outputPath = folder.filePath( "frame.png" );
+    job.size = QSize( 60, 40 );
+    job.shardCount = 3;
+    job.shard = 1;
+    RenderResult result = BatchRenderer( 2 ).render( job );
+    QCOMPARE( result.exitCode, int( RenderResult::OK ) );
+    QCOMPARE( result.framesWritten, 3 ); // 1, 4 and 7
+    QVERIFY( QFile::exists( folder.filePath( "frame0004.png" ) ) );
+    QVERIFY( !QFile::exists( folder.filePath( "frame0002.png" ) ) );
+    job.shard = 2;
+    QCOMPARE( BatchRenderer( 2 ).render( job ).framesWritten, 2 ); // 2 and 5
+
+    result = BatchRenderer::mergeShards( job.outputPath, 3, QStringList() << otherFolder.path(), "", 24 );
+    QCOMPARE( result.exitCode, int( RenderResult::INCOMPLETE ) );
+    QCOMPARE( BatchRenderer::mergeShards( job.outputPath, 1, QStringList(), "", 24 ).exitCode, int( RenderResult::BAD_JOB ) );
+
+    job.shard = 3;
+    job.outputPath = otherFolder.filePath( "frame.png" );
+    QCOMPARE( BatchRenderer( 2 ).render( job ).framesWritten, 2 ); // 3 and 6
+
+    // a frame lost on the way
+    QFile::remove( otherFolder.filePath( "frame0006.png" ) );
+    result = BatchRenderer::mergeShards( folder.filePath( "frame.png" ), 3, QStringList() << otherFolder.path(), "", 24 );
+    QCOMPARE( result.exitCode, int( RenderResult::INCOMPLETE ) );
+    QVERIFY( result.error.contains( "6" ) );
+
+    QVERIFY( BatchRenderer( 1 ).render( job ).exitCode == RenderResult::OK );
+    result = BatchRenderer::mergeShards( folder.filePath( "frame.png" ), 3, QStringList() << otherFolder.path(), "", 24 );
+    QCOMPARE( result.exitCode, int( RenderResult::OK ) );
+    QCOMPARE( result.framesWritten, 7 );
+    for ( int frame = 1; frame <= 7; frame++ )
+    {
+        QVERIFY( QFile::exists( BatchRenderer::framePath( folder.filePath( "frame.png" ), frame ) ) );
+    }
+    QVERIFY( !QFile::exists( BatchRenderer::shardManifestPath( folder.filePath( "frame.png" ), 1, 3 ) ) );
+
+    removeFolder( folder );
+    removeFolder( otherFolder );
+}
+
+void TestBatchRenderer::testMergeKeepsSuffix()
+{
+    QDir folder;
+    QString strProject = generateProject( &folder, "test_batchrenderer_suffix", 4 );
+    QVERIFY( !strProject.isEmpty() );
+
+    // the frames are written and merged under the suffix of the output, whatever its spelling
+    QStringList outputs;
+    outputs << "frame.jpeg" << "still.PNG";
+    foreach ( QString output, outputs )
+    {
+        RenderJob job;
+        job.projectPath = strProject;
+        job.outputPath = folder.filePath( output );
+        job.size = QSize( 60, 40 );
+        job.shardCount = 2;
+        for ( job.shard = 1; job.shard <= 2; job.shard++ )
+        {
+            QCOMPARE( BatchRenderer( 2 ).render( job ).framesWritten, 2 );
+        }
+        RenderResult result = BatchRenderer::mergeShards( job.outputPath, 2, QStringList(), "", 24 );
+        QCOMPARE( result.exitCode, int( RenderResult::OK ) );
+        QCOMPARE( result.framesWritten, 4 );
+    }
+    QVERIFY( QFile::exists( folder.filePath( "frame0003.jpeg" ) ) );
+    QVERIFY( !QFile::exists( folder.filePath( "frame.jpeg0003.jpg" ) ) );
+    QVERIFY( QFile::exists( folder.filePath( "still0003.PNG" ) ) );
+    QVERIFY( !QFile::exists( folder.filePath( "still0003.png" ) ) );
+
+    removeFolder( folder );
+}
@@ -0,0 +1,27 @@
+#ifndef TEST_BATCHRENDERER_H
+#define TEST_BATCHRENDERER_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestBatchRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBatchRenderer();
+
+private slots:
+    void testParseJob();
+    void testReadJobFile();
+    void testRenderFrames();
+    void testCannotOpen();
+    void testShardsAndMerge();
+    void testMergeKeepsSuffix();
+};
+
+DECLARE_TEST(TestBatchRenderer)
+
+#endif // TEST_BATCHRENDERER_H
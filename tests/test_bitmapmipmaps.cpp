@@ -0,0 +1,92 @@
+#include <QPainter>
+#include "bitmapmipmaps.h"
+#include "test_bitmapmipmaps.h"
+
+static QImage noise( int width, int height )
+{
+    QImage image( width, height, QImage::Format_ARGB32_Premultiplied );
+    quint32 seed = 4321;
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            seed = seed * 1103515245 + 12345;
+            int alpha = ( seed >> 24 ) & 0xff;
+            int grey = ( ( seed >> 16 ) & 0xff ) * alpha / 255;
+            image.setPixel( x, y, qRgba( grey, grey / 2, grey / 3, alpha ) );
+        }
+    }
+    return image;
+}
+
+TestBitmapMipmaps::TestBitmapMipmaps()
+{
+}
+
+void TestBitmapMipmaps::testLevelFor()
+{
+    QCOMPARE( BitmapMipmaps::levelFor( 1.0 ), 0 );
+    QCOMPARE( BitmapMipmaps::levelFor( 0.6 ), 0 );
+    QCOMPARE( BitmapMipmaps::levelFor( 0.5 ), 1 );
+    QCOMPARE( BitmapMipmaps::levelFor( 0.3 ), 1 );
+    QCOMPARE( BitmapMipmaps::levelFor( 0.25 ), 2 );
+    QCOMPARE( BitmapMipmaps::levelFor( 0.1 ), 3 );
+    QCOMPARE( BitmapMipmaps::levelFor( 2.0 ), 0 );
+}
+
+void TestBitmapMipmaps::testHalvedAverages()
+{
+    QImage image( 2, 2, QImage::Format_ARGB32_Premultiplied );
+    image.setPixel( 0, 0, qRgba( 0, 0, 0, 0 ) );
+    image.setPixel( 1, 0, qRgba( 255, 0, 0, 255 ) );
+    image.setPixel( 0, 1, qRgba( 0, 100, 0, 100 ) );
+    image.setPixel( 1, 1, qRgba( 0, 0, 200, 200 ) );
+
+    QImage half = BitmapMipmaps::halved( image );
+    QCOMPARE( half.size(), QSize( 1, 1 ) );
+    QRgb pixel = half.pixel( 0, 0 );
+    QCOMPARE( qRed( pixel ), 64 );
+    QCOMPARE( qGreen( pixel ), 25 );
+    QCOMPARE( qBlue( pixel ), 50 );
+    QCOMPARE( qAlpha( pixel ), 139 );
+}
+
+void TestBitmapMipmaps::testOddSizes()
+{
+    BitmapMipmaps mipmaps;
+    QImage image = noise( 37, 5 );
+    int level = 3;
+    QImage reduced = mipmaps.image( image, &level );
+    QCOMPARE( level, 3 );
+    QCOMPARE( reduced.size(), QSize( 5, 1 ) );
+
+    // not more levels than down to one pixel
+    level = 10;
+    reduced = mipmaps.image( image, &level );
+    QCOMPARE( level, 6 );
+    QCOMPARE( reduced.size(), QSize( 1, 1 ) );
+}
+
+void TestBitmapMipmaps::testChangedMatchesRebuild()
+{
+    QImage image = noise( 301, 203 );
+    BitmapMipmaps mipmaps;
+    int level = 4;
+    mipmaps.image( image, &level );
+
+    // a change reported with its extent only updates the pixels around it
+    qint64 key = image.cacheKey();
+    QRect dirty( 101, 37, 23, 61 );
+    QPainter painter( &image );
+    painter.fillRect( dirty, QColor( 10, 200, 30, 180 ) );
+    painter.end();
+    mipmaps.changed( key, image, dirty );
+
+    BitmapMipmaps rebuilt;
+    for ( level = 1; level <= 4; level++ )
+    {
+        int updatedLevel = level;
+        int rebuiltLevel = level;
+        QCOMPARE( mipmaps.image( image, &updatedLevel ), rebuilt.image( image, &rebuiltLevel ) );
+    }
+}
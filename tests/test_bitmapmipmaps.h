@@ -0,0 +1,25 @@
+#ifndef TEST_BITMAPMIPMAPS_H
+#define TEST_BITMAPMIPMAPS_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestBitmapMipmaps : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBitmapMipmaps();
+
+private slots:
+    void testLevelFor();
+    void testHalvedAverages();
+    void testOddSizes();
+    void testChangedMatchesRebuild();
+};
+
+DECLARE_TEST(TestBitmapMipmaps)
+
+#endif // TEST_BITMAPMIPMAPS_H
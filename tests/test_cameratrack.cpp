@@ -0,0 +1,69 @@
+#include <cmath>
+#include "cameratrack.h"
+#include "test_cameratrack.h"
+
+static bool fuzzyEqual( const QMatrix& a, const QMatrix& b )
+{
+    return qAbs( a.m11() - b.m11() ) < 1e-6 && qAbs( a.m12() - b.m12() ) < 1e-6
+        && qAbs( a.m21() - b.m21() ) < 1e-6 && qAbs( a.m22() - b.m22() ) < 1e-6
+        && qAbs( a.dx() - b.dx() ) < 1e-6 && qAbs( a.dy() - b.dy() ) < 1e-6;
+}
+
+TestCameraTrack::TestCameraTrack()
+{
+}
+
+void TestCameraTrack::testKeysAreExact()
+{
+    QMatrix first = QMatrix().translate( 10, -20 ).rotate( 30 ).scale( 2, 2 );
+    QMatrix second = QMatrix().translate( -50, 5 ).rotate( -60 ).scale( 0.5, 0.5 );
+    CameraTrack track;
+    track.addKey( 1, first );
+    track.addKey( 11, second );
+
+    QCOMPARE( track.viewAt( 1 ), first );
+    QCOMPARE( track.viewAt( 11 ), second );
+    // before the first key and after the last one, the camera stays still
+    QCOMPARE( track.viewAt( -5 ), first );
+    QCOMPARE( track.viewAt( 40 ), second );
+}
+
+void TestCameraTrack::testRotationKeepsScale()
+{
+    CameraTrack track;
+    track.addKey( 0, QMatrix() );
+    track.addKey( 10, QMatrix().rotate( 90 ) );
+
+    // blending the matrices would shrink the drawing half way, the rotation keeps its size
+    QMatrix middle = track.viewAt( 5 );
+    QVERIFY( fuzzyEqual( middle, QMatrix().rotate( 45 ) ) );
+    QVERIFY( qAbs( middle.determinant() - 1.0 ) < 1e-6 );
+}
+
+void TestCameraTrack::testEasing()
+{
+    CameraTrack track;
+    track.addKey( 0, QMatrix().translate( 0, 0 ), QEasingCurve::InQuad );
+    track.addKey( 10, QMatrix().translate( -100, 0 ) );
+
+    // the centre of the view moves from (0,0) to (100,0), slowly at first
+    QPointF center = track.viewAt( 5 ).inverted().map( QPointF( 0, 0 ) );
+    QVERIFY( qAbs( center.x() - 25.0 ) < 1e-6 );
+    QVERIFY( qAbs( center.y() ) < 1e-6 );
+}
+
+void TestCameraTrack::testRangeMatchesSingleFrames()
+{
+    CameraTrack track;
+    track.addKey( 3, QMatrix().scale( 1, 1 ) );
+    track.addKey( 8, QMatrix().translate( 30, 40 ).scale( 4, 4 ), QEasingCurve::InOutQuad );
+    track.addKey( 20, QMatrix().rotate( 170 ).translate( -10, 0 ) );
+    track.addKey( 21, QMatrix().rotate( -170 ) );
+
+    QVector<QMatrix> views = track.views( 0, 25 );
+    QCOMPARE( views.size(), 26 );
+    for ( int frame = 0; frame <= 25; frame++ )
+    {
+        QVERIFY( fuzzyEqual( views.at( frame ), track.viewAt( frame ) ) );
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef TEST_CAMERATRACK_H
+#define TEST_CAMERATRACK_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestCameraTrack : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestCameraTrack();
+
+private slots:
+    void testKeysAreExact();
+    void testRotationKeepsScale();
+    void testEasing();
+    void testRangeMatchesSingleFrames();
+};
+
+DECLARE_TEST(TestCameraTrack)
+
+#endif // TEST_CAMERATRACK_H
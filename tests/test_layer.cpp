@@ -1,5 +1,6 @@
 #include "layer.h"
 #include "layerbitmap.h"
+#include "layersound.h"
 #include "object.h"
 #include "test_layer.h"
 
@@ -146,3 +147,42 @@ void TestLayer::testRemoveImageAtFrame()
 
     delete pLayer;
 }
+
+void TestLayer::testSoundChanged()
+{
+    Object object;
+    QSignalSpy spy( &object, SIGNAL( soundChanged() ) );
+
+    LayerSound* pLayer = object.addNewSoundLayer();
+    QVERIFY( pLayer->addImageAtFrame( 5 ) );
+    QCOMPARE( spy.count(), 1 );
+    QVERIFY( !pLayer->addImageAtFrame( 5 ) );
+    QCOMPARE( spy.count(), 1 ); // nothing changed
+
+    pLayer->loadSoundAtFrame( "missing.wav", 5 );
+    QCOMPARE( spy.count(), 2 );
+    pLayer->removeImageAtFrame( 5 );
+    QCOMPARE( spy.count(), 3 );
+
+    object.deleteLayer( object.getLayerCount() - 1 );
+    QCOMPARE( spy.count(), 4 );
+}
+
+void TestLayer::testLayerChanged()
+{
+    Object object;
+    LayerBitmap* pLayer = object.addNewBitmapLayer();
+    QSignalSpy spy( &object, SIGNAL( layerChanged( Layer* ) ) );
+
+    QVERIFY( pLayer->addImageAtFrame( 3 ) );
+    QCOMPARE( spy.count(), 1 );
+    QCOMPARE( spy.last().at( 0 ).value<Layer*>(), ( Layer* )pLayer );
+
+    pLayer->deselectAllFrames();
+    pLayer->switchVisibility();
+    QCOMPARE( spy.count(), 3 );
+
+    object.deleteLayer( object.getLayerCount() - 1 );
+    QCOMPARE( spy.count(), 4 );
+    QVERIFY( spy.last().at( 0 ).value<Layer*>() == NULL ); // all the tracks
+}
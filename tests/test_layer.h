@@ -28,6 +28,8 @@ private slots:
     void testHasKeyframeAtPosition();
     void testGetFramePositionAt();
     void testRemoveImageAtFrame();
+    void testSoundChanged();
+    void testLayerChanged();
 
 private:
     Object* m_pObject;
@@ -1,4 +1,6 @@
 
+#include "object.h"
+#include "layerbitmap.h"
 #include "objectsaveloader.h"
 #include "test_objectsaveloader.h"
 
@@ -77,6 +79,25 @@ void TestObjectSaveLoader::testMinimalPencilDocument()
     QVERIFY( pSaveLoader.error().code() == PCL_OK );
 }
 
+void TestObjectSaveLoader::testSaveAndLoadAgain()
+{
+    Object object;
+    object.defaultInitialisation();
+    LayerBitmap* pLayer = object.addNewBitmapLayer();
+    pLayer->addImageAtFrame( 5 );
+    pLayer->getBitmapImageAtFrame( 5 )->drawRect( QRectF( 10, 10, 40, 20 ), QPen( Qt::black ), QBrush( Qt::red ), QPainter::CompositionMode_SourceOver, false );
+
+    QString strFilePath = QDir::tempPath() + "/test_objectsaveloader.pclx";
+    QFile::remove( strFilePath );
+    ObjectSaveLoader pSaveLoader;
+    QVERIFY( pSaveLoader.saveToFile( &object, strFilePath ) );
+    QVERIFY( pSaveLoader.error().code() == PCL_OK );
 
-
-
+    QScopedPointer<Object> pLoaded( pSaveLoader.loadFromFile( strFilePath ) );
+    QVERIFY( pLoaded != NULL );
+    QCOMPARE( pLoaded->getLayerCount(), object.getLayerCount() );
+    LayerBitmap* pLoadedLayer = ( LayerBitmap* )pLoaded->getLayer( object.getLayerCount() - 1 );
+    QVERIFY( pLoadedLayer->type() == Layer::BITMAP );
+    QVERIFY( pLoadedLayer->getBitmapImageAtFrame( 5 ) != NULL );
+    QCOMPARE( pLoadedLayer->getBitmapImageAtFrame( 5 )->pixel( 30, 20 ), qRgb( 255, 0, 0 ) );
+}
@@ -21,6 +21,7 @@ private Q_SLOTS:
     void testInvalidXML();
     void testInvalidPencilDocument();
     void testMinimalPencilDocument();
+    void testSaveAndLoadAgain();
 };
 
 DECLARE_TEST(TestObjectSaveLoader)
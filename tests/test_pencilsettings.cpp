@@ -0,0 +1,98 @@
+#include "pencilsettings.h"
+#include "test_pencilsettings.h"
+
+TestPencilSettings::TestPencilSettings()
+{
+}
+
+void TestPencilSettings::init()
+{
+    m_strIniFile = QDir::temp().filePath( "test_pencilsettings.ini" );
+    QFile::remove( m_strIniFile );
+}
+
+void TestPencilSettings::cleanup()
+{
+    QFile::remove( m_strIniFile );
+}
+
+void TestPencilSettings::testTypedValues()
+{
+    PencilSettings settings( m_strIniFile );
+    QVERIFY( !settings.contains( "penWidth" ) );
+    QCOMPARE( settings.realValue( "penWidth", 2.0 ), 2.0 );
+    QCOMPARE( settings.curveOpacity(), 1.0 );
+
+    settings.setValue( "penWidth", 3.5 );
+    settings.setValue( "autosave", "true" );
+    settings.setValue( "fps", 24 );
+    settings.setValue( "curveOpacity", 25 );
+    QVERIFY( settings.contains( "penWidth" ) );
+    QCOMPARE( settings.realValue( "penWidth" ), 3.5 );
+    QVERIFY( settings.boolValue( "autosave" ) );
+    QCOMPARE( settings.intValue( "fps" ), 24 );
+    QCOMPARE( settings.stringValue( "fps" ), QString( "24" ) );
+    QCOMPARE( settings.curveOpacity(), 0.75 );
+}
+
+void TestPencilSettings::testValueChanged()
+{
+    PencilSettings settings( m_strIniFile );
+    QSignalSpy spy( &settings, SIGNAL( valueChanged( const QString&, const QVariant& ) ) );
+
+    settings.setValue( "fps", 12 );
+    QCOMPARE( spy.count(), 1 );
+    QCOMPARE( spy.at( 0 ).at( 0 ).toString(), QString( "fps" ) );
+    QCOMPARE( spy.at( 0 ).at( 1 ).toInt(), 12 );
+
+    // the same value again changes nothing
+    settings.setValue( "fps", 12 );
+    QCOMPARE( spy.count(), 1 );
+
+    settings.remove( "fps" );
+    QCOMPARE( spy.count(), 2 );
+    QVERIFY( !settings.contains( "fps" ) );
+}
+
+void TestPencilSettings::testWriteThrough()
+{
+    {
+        PencilSettings settings( m_strIniFile );
+        settings.setValue( "lastFilePath", "/tmp/shot1.pclx" );
+        settings.setValue( "frameSize", 16 );
+        settings.sync();
+
+        QSettings written( m_strIniFile, QSettings::IniFormat );
+        QCOMPARE( written.value( "lastFilePath" ).toString(), QString( "/tmp/shot1.pclx" ) );
+        QCOMPARE( written.value( "frameSize" ).toInt(), 16 );
+
+        settings.remove( "frameSize" );
+    } // the store writes its last changes when it goes
+
+    PencilSettings loaded( m_strIniFile );
+    QCOMPARE( loaded.stringValue( "lastFilePath" ), QString( "/tmp/shot1.pclx" ) );
+    QVERIFY( !loaded.contains( "frameSize" ) );
+}
+
+void TestPencilSettings::testGroups()
+{
+    PencilSettings settings( m_strIniFile );
+    settings.setValue( "shortcuts/CmdNewFile", "Ctrl+N" );
+    settings.setValue( "shortcuts/CmdOpenFile", "Ctrl+O" );
+    settings.setValue( "shortcutsVisible", true );
+
+    QStringList keys = settings.allKeys( "shortcuts" );
+    QCOMPARE( keys.size(), 2 );
+    QVERIFY( keys.contains( "CmdNewFile" ) );
+    QVERIFY( keys.contains( "CmdOpenFile" ) );
+    QCOMPARE( settings.allKeys().size(), 3 );
+
+    settings.remove( "shortcuts" );
+    QVERIFY( settings.allKeys( "shortcuts" ).isEmpty() );
+    QVERIFY( settings.contains( "shortcutsVisible" ) );
+    settings.sync();
+
+    QSettings written( m_strIniFile, QSettings::IniFormat );
+    QVERIFY( !written.contains( "shortcuts/CmdNewFile" ) );
+    QVERIFY( written.contains( "shortcutsVisible" ) );
+}
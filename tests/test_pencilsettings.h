@@ -0,0 +1,31 @@
+#ifndef TEST_PENCILSETTINGS_H
+#define TEST_PENCILSETTINGS_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestPencilSettings : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestPencilSettings();
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testTypedValues();
+    void testValueChanged();
+    void testWriteThrough();
+    void testGroups();
+
+private:
+    QString m_strIniFile;
+};
+
+DECLARE_TEST(TestPencilSettings)
+
+#endif // TEST_PENCILSETTINGS_H
@@ -0,0 +1,71 @@
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "perfmonitor.h"
+#include "test_perfmonitor.h"
+
+TestPerfMonitor::TestPerfMonitor()
+{
+}
+
+void TestPerfMonitor::init()
+{
+    PerfMonitor::instance()->clear();
+}
+
+void TestPerfMonitor::testStatsAndCounters()
+{
+    PerfMonitor* monitor = PerfMonitor::instance();
+    monitor->record( "test::draw", 0, 100 );
+    monitor->record( "test::draw", 200, 300 );
+    monitor->count( "test hits", 2 );
+    monitor->count( "test hits", 3 );
+
+    PerfMonitor::Stat stat = monitor->stat( "test::draw" );
+    QCOMPARE( stat.calls, qint64( 2 ) );
+    QCOMPARE( stat.last, qint64( 300 ) );
+    QVERIFY( stat.average > 100 && stat.average < 300 );
+    QCOMPARE( monitor->counter( "test hits" ), qint64( 5 ) );
+    QCOMPARE( monitor->stat( "test::unknown" ).calls, qint64( 0 ) );
+    QCOMPARE( monitor->eventCount(), 4 );
+
+    // the names are looked up by content, not by address
+    QByteArray name( "test::draw" );
+    QCOMPARE( monitor->stat( name.constData() ).calls, qint64( 2 ) );
+
+    {
+        PerfScope scope( "test::scope" );
+    }
+    QCOMPARE( monitor->stat( "test::scope" ).calls, qint64( 1 ) );
+}
+
+void TestPerfMonitor::testChromeTrace()
+{
+    PerfMonitor* monitor = PerfMonitor::instance();
+    for ( int i = 0; i < PerfMonitor::MAX_EVENTS + 10; i++ )
+    {
+        monitor->record( "test::frame", 10 * i, 5 );
+    }
+    monitor->count( "test misses", 1 );
+
+    QString filePath = QDir::temp().filePath( "test_perfmonitor.json" );
+    QVERIFY( monitor->saveChromeTrace( filePath ) );
+
+    QFile file( filePath );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    QJsonParseError error;
+    QJsonDocument trace = QJsonDocument::fromJson( file.readAll(), &error );
+    QCOMPARE( error.error, QJsonParseError::NoError );
+
+    // only the last events are kept, oldest first
+    QJsonArray events = trace.object().value( "traceEvents" ).toArray();
+    QCOMPARE( events.size(), int( PerfMonitor::MAX_EVENTS ) );
+    QJsonObject first = events.at( 0 ).toObject();
+    QCOMPARE( first.value( "name" ).toString(), QString( "test::frame" ) );
+    QCOMPARE( first.value( "ph" ).toString(), QString( "X" ) );
+    QCOMPARE( first.value( "ts" ).toDouble(), 10.0 * 11 );
+    QCOMPARE( first.value( "dur" ).toDouble(), 5.0 );
+    QJsonObject last = events.last().toObject();
+    QCOMPARE( last.value( "ph" ).toString(), QString( "C" ) );
+    QCOMPARE( last.value( "args" ).toObject().value( "value" ).toDouble(), 1.0 );
+}
@@ -0,0 +1,24 @@
+#ifndef TEST_PERFMONITOR_H
+#define TEST_PERFMONITOR_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestPerfMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestPerfMonitor();
+
+private slots:
+    void init();
+    void testStatsAndCounters();
+    void testChromeTrace();
+};
+
+DECLARE_TEST(TestPerfMonitor)
+
+#endif // TEST_PERFMONITOR_H
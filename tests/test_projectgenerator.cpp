@@ -0,0 +1,125 @@
+#include "object.h"
+#include "layerbitmap.h"
+#include "layervector.h"
+#include "objectsaveloader.h"
+#include "projectgenerator.h"
+#include "test_projectgenerator.h"
+
+static ProjectGenerator::Parameters smallProject( quint32 seed )
+{
+    ProjectGenerator::Parameters parameters;
+    parameters.seed = seed;
+    parameters.bitmapLayers = 2;
+    parameters.vectorLayers = 1;
+    parameters.frames = 10;
+    parameters.keyInterval = 2;
+    parameters.canvasSize = QSize( 200, 100 );
+    parameters.bitmapDensity = 0.5;
+    parameters.curvesPerVectorKey = 30;
+    parameters.areasPerVectorKey = 5;
+    return parameters;
+}
+
+static QByteArray pixelsOf( Object* object )
+{
+    QByteArray pixels;
+    for ( int i = 0; i < object->getLayerCount(); i++ )
+    {
+        if ( object->getLayer( i )->type() == Layer::BITMAP )
+        {
+            LayerBitmap* layer = ( LayerBitmap* )object->getLayer( i );
+            for ( int k = 0; layer->getBitmapImageAtIndex( k ) != NULL; k++ )
+            {
+                QImage* image = layer->getBitmapImageAtIndex( k )->image;
+                pixels.append( ( const char* )image->constBits(), image->byteCount() );
+            }
+        }
+    }
+    return pixels;
+}
+
+TestProjectGenerator::TestProjectGenerator()
+{
+}
+
+void TestProjectGenerator::testLayersAndKeys()
+{
+    QScopedPointer<Object> object( ProjectGenerator( smallProject( 1 ) ).generate() );
+
+    // camera, 2 bitmap layers, 1 vector layer
+    QCOMPARE( object->getLayerCount(), 4 );
+    QVERIFY( object->getLayer( 0 )->type() == Layer::CAMERA );
+    LayerBitmap* bitmapLayer = ( LayerBitmap* )object->getLayer( 1 );
+    QVERIFY( bitmapLayer->type() == Layer::BITMAP );
+    QVERIFY( bitmapLayer->hasKeyframeAtPosition( 9 ) );
+    QVERIFY( !bitmapLayer->hasKeyframeAtPosition( 10 ) );
+    QVERIFY( bitmapLayer->getBitmapImageAtIndex( 4 ) != NULL );
+    QVERIFY( bitmapLayer->getBitmapImageAtIndex( 5 ) == NULL );
+    // density 0.5 paints over the whole canvas
+    QVERIFY( bitmapLayer->getBitmapImageAtFrame( 1 )->width() >= 200 );
+
+    LayerVector* vectorLayer = ( LayerVector* )object->getLayer( 3 );
+    QVERIFY( vectorLayer->type() == Layer::VECTOR );
+    VectorImage* vectorImage = vectorLayer->getVectorImageAtFrame( 5 );
+    QCOMPARE( vectorImage->curve.size(), 30 + 5 );
+    QCOMPARE( vectorImage->area.size(), 5 );
+}
+
+void TestProjectGenerator::testSameSeedSameProject()
+{
+    QScopedPointer<Object> first( ProjectGenerator( smallProject( 7 ) ).generate() );
+    QScopedPointer<Object> second( ProjectGenerator( smallProject( 7 ) ).generate() );
+    QScopedPointer<Object> other( ProjectGenerator( smallProject( 8 ) ).generate() );
+
+    QVERIFY( !pixelsOf( first.data() ).isEmpty() );
+    QCOMPARE( pixelsOf( first.data() ), pixelsOf( second.data() ) );
+    QVERIFY( pixelsOf( first.data() ) != pixelsOf( other.data() ) );
+
+    VectorImage* a = ( ( LayerVector* )first->getLayer( 3 ) )->getVectorImageAtFrame( 3 );
+    VectorImage* b = ( ( LayerVector* )second->getLayer( 3 ) )->getVectorImageAtFrame( 3 );
+    QCOMPARE( a->getVertex( 10, 2 ), b->getVertex( 10, 2 ) );
+}
+
+void TestProjectGenerator::testSparseKeysAreSmall()
+{
+    ProjectGenerator::Parameters parameters = smallProject( 5 );
+    parameters.canvasSize = QSize( 1000, 1000 );
+    parameters.bitmapDensity = 0.02;
+    QScopedPointer<Object> object( ProjectGenerator( parameters ).generate() );
+
+    // the paint of the key stays in about 4 % of the canvas
+    BitmapImage* image = ( ( LayerBitmap* )object->getLayer( 1 ) )->getBitmapImageAtFrame( 3 );
+    QVERIFY( image->width() > 0 );
+    QVERIFY( image->width() < 220 );
+    QVERIFY( image->height() < 220 );
+}
+
+void TestProjectGenerator::testBitmapCap()
+{
+    ProjectGenerator::Parameters parameters = smallProject( 1 );
+    parameters.canvasSize = QSize( 1920, 1080 );
+    parameters.bitmapLayers = 20;
+    parameters.frames = 2000;
+    parameters.keyInterval = 1;
+    parameters.bitmapDensity = 0.9;
+    ProjectGenerator generator( parameters );
+
+    QVERIFY( generator.bitmapBytes() > ProjectGenerator::MAX_BITMAP_BYTES );
+    QVERIFY( generator.generate() == NULL );
+    QVERIFY( !generator.generate( QDir::temp().filePath( "test_projectgenerator_cap.pclx" ) ) );
+}
+
+void TestProjectGenerator::testSaveAndLoad()
+{
+    QString strFilePath = QDir::temp().filePath( "test_projectgenerator.pclx" );
+    QFile::remove( strFilePath );
+    QVERIFY( ProjectGenerator( smallProject( 3 ) ).generate( strFilePath ) );
+
+    ObjectSaveLoader saveLoader;
+    QScopedPointer<Object> loaded( saveLoader.loadFromFile( strFilePath ) );
+    QVERIFY( loaded != NULL );
+    QCOMPARE( loaded->getLayerCount(), 4 );
+    LayerVector* vectorLayer = ( LayerVector* )loaded->getLayer( 3 );
+    QCOMPARE( vectorLayer->getVectorImageAtFrame( 7 )->area.size(), 5 );
+    QFile::remove( strFilePath );
+}
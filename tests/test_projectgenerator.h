@@ -0,0 +1,26 @@
+#ifndef TEST_PROJECTGENERATOR_H
+#define TEST_PROJECTGENERATOR_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestProjectGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestProjectGenerator();
+
+private slots:
+    void testLayersAndKeys();
+    void testSameSeedSameProject();
+    void testSparseKeysAreSmall();
+    void testBitmapCap();
+    void testSaveAndLoad();
+};
+
+DECLARE_TEST(TestProjectGenerator)
+
+#endif // TEST_PROJECTGENERATOR_H
@@ -0,0 +1,80 @@
+#include "soundwaveform.h"
+#include "test_soundwaveform.h"
+
+static QVector<qint16> noise( int frames )
+{
+    QVector<qint16> samples( frames * 2 );
+    quint32 seed = 12345;
+    for ( int i = 0; i < samples.size(); i++ )
+    {
+        seed = seed * 1103515245 + 12345;
+        samples[ i ] = qint16( ( seed >> 16 ) & 0xffff );
+    }
+    return samples;
+}
+
+TestSoundWaveform::TestSoundWaveform()
+{
+}
+
+void TestSoundWaveform::testPeakMatchesSamples()
+{
+    QVector<qint16> samples = noise( 10000 );
+    SoundWaveform waveform;
+    waveform.build( samples, 2, 0 );
+    QCOMPARE( waveform.frameCount(), qint64( 10000 ) );
+
+    // ranges aligned on the peaks at every level: exact result
+    for ( qint64 length = SoundWaveform::BASE_FRAMES; length <= 4096; length *= 2 )
+    {
+        for ( qint64 from = 0; from + length <= 10000; from += length * 3 )
+        {
+            qint16 low, high;
+            waveform.peak( from, from + length, &low, &high );
+
+            qint16 expectedLow = samples[ from * 2 ];
+            qint16 expectedHigh = samples[ from * 2 ];
+            for ( qint64 i = from * 2; i < ( from + length ) * 2; i++ )
+            {
+                expectedLow = qMin( expectedLow, samples[ i ] );
+                expectedHigh = qMax( expectedHigh, samples[ i ] );
+            }
+            QCOMPARE( low, expectedLow );
+            QCOMPARE( high, expectedHigh );
+        }
+    }
+}
+
+void TestSoundWaveform::testPeakOutsideClip()
+{
+    SoundWaveform waveform;
+    waveform.build( noise( 100 ), 2, 0 );
+
+    qint16 low, high;
+    waveform.peak( 200, 300, &low, &high );
+    QCOMPARE( low, qint16( 0 ) );
+    QCOMPARE( high, qint16( 0 ) );
+}
+
+void TestSoundWaveform::testSaveAndLoad()
+{
+    SoundWaveform waveform;
+    waveform.build( noise( 5000 ), 2, 777 );
+
+    QString path = QDir::temp().filePath( "test_soundwaveform.peaks" );
+    QVERIFY( waveform.save( path ) );
+
+    SoundWaveform other;
+    QVERIFY( !other.load( path, 778 ) ); // the sound file has changed
+    QVERIFY( other.load( path, 777 ) );
+    QCOMPARE( other.frameCount(), waveform.frameCount() );
+    for ( qint64 from = 0; from < 5000; from += 333 )
+    {
+        qint16 low1, high1, low2, high2;
+        waveform.peak( from, from + 500, &low1, &high1 );
+        other.peak( from, from + 500, &low2, &high2 );
+        QCOMPARE( low1, low2 );
+        QCOMPARE( high1, high2 );
+    }
+    QFile::remove( path );
+}
@@ -0,0 +1,24 @@
+#ifndef TEST_SOUNDWAVEFORM_H
+#define TEST_SOUNDWAVEFORM_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestSoundWaveform : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestSoundWaveform();
+
+private slots:
+    void testPeakMatchesSamples();
+    void testPeakOutsideClip();
+    void testSaveAndLoad();
+};
+
+DECLARE_TEST(TestSoundWaveform)
+
+#endif // TEST_SOUNDWAVEFORM_H
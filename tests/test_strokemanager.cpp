@@ -0,0 +1,108 @@
+#include <QMouseEvent>
+#include <QTabletEvent>
+#include "strokemanager.h"
+#include "test_strokemanager.h"
+
+static QMouseEvent mouseEvent( QEvent::Type type, QPointF pos )
+{
+    return QMouseEvent( type, pos, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier );
+}
+
+static QTabletEvent tabletEvent( QEvent::Type type, QPointF pos, qreal pressure )
+{
+    return QTabletEvent( type, pos, pos, QTabletEvent::Stylus, QTabletEvent::Pen,
+                         pressure, 10, -10, 0, 0, 0, Qt::NoModifier, 1 );
+}
+
+TestStrokeManager::TestStrokeManager()
+{
+}
+
+void TestStrokeManager::testEvenlySpaced()
+{
+    StrokeManager manager;
+    QMouseEvent press = mouseEvent( QEvent::MouseButtonPress, QPointF( 0, 0 ) );
+    manager.mousePressEvent( &press );
+
+    QList<QPointF> points;
+    for ( int x = 10; x <= 200; x += 10 )
+    {
+        QMouseEvent move = mouseEvent( QEvent::MouseMove, QPointF( x, 0.1 * x ) );
+        manager.mouseMoveEvent( &move );
+        QList<QPointF> batch = manager.interpolateStroke( 8 );
+        if ( !batch.isEmpty() )
+        {
+            // each batch starts where the previous one ended
+            QCOMPARE( batch.first(), points.isEmpty() ? QPointF( 0, 0 ) : points.last() );
+            batch.removeFirst();
+            points << batch;
+        }
+    }
+    QMouseEvent release = mouseEvent( QEvent::MouseButtonRelease, QPointF( 200, 20 ) );
+    manager.mouseReleaseEvent( &release );
+    QList<QPointF> last = manager.interpolateStroke( 8 );
+    QVERIFY( !last.isEmpty() );
+    last.removeFirst();
+    points << last;
+
+    QCOMPARE( points.last(), QPointF( 200, 20 ) );
+    QPointF previous( 0, 0 );
+    for ( int i = 0; i < points.size() - 1; i++ )
+    {
+        // the radius 8 spaces them 2 pixels apart along the curve, a little less in a straight line
+        qreal distance = QLineF( previous, points.at( i ) ).length();
+        QVERIFY( distance > 1.9 && distance < 2.0001 );
+        previous = points.at( i );
+    }
+}
+
+void TestStrokeManager::testEveryTabletSample()
+{
+    StrokeManager manager;
+    QTabletEvent tabletPress = tabletEvent( QEvent::TabletPress, QPointF( 0, 0 ), 0.2 );
+    manager.tabletEvent( &tabletPress );
+    QMouseEvent press = mouseEvent( QEvent::MouseButtonPress, QPointF( 0, 0 ) );
+    manager.mousePressEvent( &press );
+
+    // five tablet samples arrive before the next mouse move
+    for ( int i = 1; i <= 5; i++ )
+    {
+        QTabletEvent move = tabletEvent( QEvent::TabletMove, QPointF( 2 * i, i ), 0.2 + 0.1 * i );
+        manager.tabletEvent( &move );
+    }
+    QMouseEvent move = mouseEvent( QEvent::MouseMove, QPointF( 10, 5 ) );
+    manager.mouseMoveEvent( &move );
+
+    int read = 1; // after the press
+    QList<StrokeSample> samples = manager.samples( &read );
+    QCOMPARE( samples.size(), 5 );
+    QCOMPARE( read, 6 );
+    for ( int i = 0; i < 5; i++ )
+    {
+        QCOMPARE( samples.at( i ).pos, QPointF( 2 * ( i + 1 ), i + 1 ) );
+        QVERIFY( qAbs( samples.at( i ).pressure - ( 0.3 + 0.1 * i ) ) < 1e-6 );
+        QCOMPARE( samples.at( i ).xTilt, 10 );
+        QCOMPARE( samples.at( i ).yTilt, -10 );
+    }
+    QVERIFY( manager.samples( &read ).isEmpty() );
+}
+
+void TestStrokeManager::testRingBufferKeepsLastSamples()
+{
+    StrokeManager manager;
+    QMouseEvent press = mouseEvent( QEvent::MouseButtonPress, QPointF( 0, 0 ) );
+    manager.mousePressEvent( &press );
+    for ( int i = 1; i <= 1000; i++ )
+    {
+        QMouseEvent move = mouseEvent( QEvent::MouseMove, QPointF( i, 0 ) );
+        manager.mouseMoveEvent( &move );
+    }
+
+    // only the newest samples are still there for a reader that fell behind
+    int read = 0;
+    QList<StrokeSample> samples = manager.samples( &read );
+    QCOMPARE( read, 1001 );
+    QVERIFY( samples.size() < 1001 );
+    QCOMPARE( samples.last().pos, QPointF( 1000, 0 ) );
+    QCOMPARE( samples.first().pos, QPointF( 1001 - samples.size(), 0 ) );
+}
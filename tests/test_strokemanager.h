@@ -0,0 +1,24 @@
+#ifndef TEST_STROKEMANAGER_H
+#define TEST_STROKEMANAGER_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestStrokeManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestStrokeManager();
+
+private slots:
+    void testEvenlySpaced();
+    void testEveryTabletSample();
+    void testRingBufferKeepsLastSamples();
+};
+
+DECLARE_TEST(TestStrokeManager)
+
+#endif // TEST_STROKEMANAGER_H
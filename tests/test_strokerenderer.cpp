@@ -0,0 +1,67 @@
+#include <cmath>
+#include "strokerenderer.h"
+#include "test_strokerenderer.h"
+
+static BrushDab dabAt( QPointF center, qreal width )
+{
+    QRadialGradient gradient( center, 0.5 * width );
+    gradient.setColorAt( 0.0, QColor( 200, 50, 0, 255 ) );
+    gradient.setColorAt( 1.0, QColor( 200, 50, 0, 0 ) );
+
+    BrushDab dab;
+    dab.rect = QRectF( center.x() - 0.5 * width, center.y() - 0.5 * width, width, width );
+    dab.gradient = gradient;
+    dab.antialiasing = true;
+    return dab;
+}
+
+TestStrokeRenderer::TestStrokeRenderer()
+{
+}
+
+void TestStrokeRenderer::testFinishMatchesDirectDrawing()
+{
+    StrokeRenderer renderer;
+    BitmapImage expected( NULL );
+    for ( int i = 0; i < 200; i++ )
+    {
+        BrushDab dab = dabAt( QPointF( 3.5 * i, 40 + 20 * sin( 0.1 * i ) ), 30 );
+        renderer.drawDab( dab );
+
+        BitmapImage dabImage( NULL );
+        dabImage.drawRect( dab.rect, Qt::NoPen, dab.gradient, QPainter::CompositionMode_Source, true );
+        expected.paste( &dabImage );
+    }
+
+    // every queued dab is drawn, in order, before the buffer is handed over
+    BitmapImage result( NULL );
+    renderer.finish( &result );
+    QCOMPARE( result.boundaries, expected.boundaries );
+    QVERIFY( *result.image == *expected.image );
+
+    // and the buffer is empty for the next stroke
+    BitmapImage next( NULL );
+    renderer.finish( &next );
+    QVERIFY( next.boundaries.isEmpty() );
+}
+
+void TestStrokeRenderer::testClearDropsDabs()
+{
+    StrokeRenderer renderer;
+    for ( int i = 0; i < 100; i++ )
+    {
+        renderer.drawDab( dabAt( QPointF( i, i ), 50 ) );
+    }
+    renderer.clear();
+    renderer.drawDab( dabAt( QPointF( 500, 500 ), 10 ) );
+
+    BitmapImage expected( NULL );
+    BrushDab last = dabAt( QPointF( 500, 500 ), 10 );
+    expected.drawRect( last.rect, Qt::NoPen, last.gradient, QPainter::CompositionMode_Source, true );
+
+    // only the dab queued after clear() is left
+    BitmapImage result( NULL );
+    renderer.finish( &result );
+    QCOMPARE( result.boundaries, expected.boundaries );
+    QVERIFY( *result.image == *expected.image );
+}
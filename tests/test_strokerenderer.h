@@ -0,0 +1,23 @@
+#ifndef TEST_STROKERENDERER_H
+#define TEST_STROKERENDERER_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestStrokeRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestStrokeRenderer();
+
+private slots:
+    void testFinishMatchesDirectDrawing();
+    void testClearDropsDabs();
+};
+
+DECLARE_TEST(TestStrokeRenderer)
+
+#endif // TEST_STROKERENDERER_H
@@ -0,0 +1,188 @@
+#include "vectorimage.h"
+#include "test_vectorimage.h"
+
+static QString xmlOf( VectorImage& image )
+{
+    QDomDocument doc( "PencilVectorImage" );
+    doc.appendChild( image.createDomElement( doc ) );
+    return doc.toString();
+}
+
+static void addStroke( VectorImage& image )
+{
+    QList<QPointF> points;
+    QList<qreal> pressures;
+    for ( int i = 0; i < 40; i++ )
+    {
+        points << QPointF( 3.14159 * i, 100.0 * sin( i / 7.0 ) + 0.1 );
+        pressures << 0.3 + 0.01 * i;
+    }
+    BezierCurve stroke( points, pressures, 0.5 );
+    stroke.setWidth( 2.3 );
+    stroke.setFeather( 0.7 );
+    stroke.setVariableWidth( true );
+    stroke.setInvisibility( false );
+    stroke.setColourNumber( 2 );
+    image.curve.append( stroke );
+}
+
+static BezierCurve lineCurve( QPointF p1, QPointF p2 )
+{
+    QList<QPointF> points;
+    points << p1 << p2;
+    BezierCurve curve( points );
+    curve.setWidth( 1.0 );
+    curve.setVariableWidth( false );
+    curve.setInvisibility( false );
+    curve.setColourNumber( 0 );
+    return curve;
+}
+
+static void addSquare( VectorImage& image, QRectF rect )
+{
+    image.curve.append( lineCurve( rect.topLeft(), rect.topRight() ) );
+    image.curve.append( lineCurve( rect.topRight(), rect.bottomRight() ) );
+    image.curve.append( lineCurve( rect.bottomRight(), rect.bottomLeft() ) );
+    image.curve.append( lineCurve( rect.bottomLeft(), rect.topLeft() ) );
+}
+
+TestVectorImage::TestVectorImage()
+{
+}
+
+void TestVectorImage::testContourOfSquare()
+{
+    VectorImage image;
+    addSquare( image, QRectF( 0, 0, 100, 100 ) );
+
+    QList<VertexRef> contour = image.getContourAt( QPointF( 30, 60 ), 1.0 );
+    QVERIFY( contour.size() >= 4 );
+
+    BezierArea area( contour, 0 );
+    image.updateArea( area );
+    QVERIFY( area.path.contains( QPointF( 30, 60 ) ) );
+    QVERIFY( !area.path.contains( QPointF( 130, 60 ) ) );
+}
+
+void TestVectorImage::testContourOutside()
+{
+    VectorImage image;
+    addSquare( image, QRectF( 0, 0, 100, 100 ) );
+
+    QVERIFY( image.getContourAt( QPointF( -30, 50 ), 1.0 ).isEmpty() );
+}
+
+void TestVectorImage::testContourWithGap()
+{
+    VectorImage image;
+    image.curve.append( lineCurve( QPointF( 0, 0 ), QPointF( 100, 0 ) ) );
+    image.curve.append( lineCurve( QPointF( 100, 0 ), QPointF( 100, 100 ) ) );
+    image.curve.append( lineCurve( QPointF( 100, 100 ), QPointF( 0, 100 ) ) );
+    image.curve.append( lineCurve( QPointF( 0, 100 ), QPointF( 0, 10 ) ) ); // does not reach the first curve
+
+    QVERIFY( image.getContourAt( QPointF( 50, 50 ), 1.0 ).isEmpty() );
+}
+
+void TestVectorImage::testContourIgnoresDanglingStroke()
+{
+    VectorImage image;
+    addSquare( image, QRectF( 0, 0, 100, 100 ) );
+    image.curve.append( lineCurve( QPointF( 100, 50 ), QPointF( 70, 50 ) ) ); // hangs inside, to the right of the point
+
+    QList<VertexRef> contour = image.getContourAt( QPointF( 40, 50 ), 1.0 );
+    QVERIFY( !contour.isEmpty() );
+
+    BezierArea area( contour, 0 );
+    image.updateArea( area );
+    QVERIFY( area.path.contains( QPointF( 40, 50 ) ) );
+}
+
+void TestVectorImage::testContourOfInnerSquare()
+{
+    VectorImage image;
+    addSquare( image, QRectF( 0, 0, 100, 100 ) );
+    addSquare( image, QRectF( 40, 40, 20, 20 ) );
+
+    QList<VertexRef> contour = image.getContourAt( QPointF( 50, 50 ), 1.0 );
+    BezierArea area( contour, 0 );
+    image.updateArea( area );
+    QVERIFY( area.path.contains( QPointF( 50, 50 ) ) );
+    QVERIFY( !area.path.contains( QPointF( 20, 20 ) ) );
+
+    // the ray from this point crosses the inner square first
+    contour = image.getContourAt( QPointF( 20, 50 ), 1.0 );
+    area = BezierArea( contour, 0 );
+    image.updateArea( area );
+    QVERIFY( area.path.contains( QPointF( 20, 50 ) ) );
+}
+
+void TestVectorImage::testBinaryRoundTrip()
+{
+    VectorImage image;
+    addSquare( image, QRectF( 0, 0, 100, 100 ) );
+    addStroke( image );
+    image.addArea( BezierArea( image.getContourAt( QPointF( 50, 50 ), 1.0 ), 1 ) );
+
+    QString path = QDir::tempPath() + "/test_vectorimage.vec";
+    QVERIFY( image.write( path, "BIN" ) );
+
+    VectorImage loaded;
+    QVERIFY( loaded.read( path ) );
+    QCOMPARE( loaded.curve.size(), image.curve.size() );
+    QCOMPARE( loaded.area.size(), 1 );
+    QCOMPARE( xmlOf( loaded ), xmlOf( image ) );
+
+    QFile::remove( path );
+}
+
+void TestVectorImage::testBinaryMatchesXml()
+{
+    VectorImage image;
+    addStroke( image );
+
+    QString xmlPath = QDir::tempPath() + "/test_vectorimage_xml.vec";
+    QString binPath = QDir::tempPath() + "/test_vectorimage_bin.vec";
+    QVERIFY( image.write( xmlPath, "VEC" ) );
+    QVERIFY( image.write( binPath, "BIN" ) );
+
+    VectorImage fromXml;
+    VectorImage fromBin;
+    QVERIFY( fromXml.read( xmlPath ) );
+    QVERIFY( fromBin.read( binPath ) );
+    QCOMPARE( fromBin.curve.size(), fromXml.curve.size() );
+    for ( int i = 0; i < fromXml.curve.at( 0 ).getVertexSize(); i++ )
+    {
+        QCOMPARE( fromBin.curve.at( 0 ).getVertex( i ), fromXml.curve.at( 0 ).getVertex( i ) );
+        QCOMPARE( fromBin.curve.at( 0 ).getC1( i ), fromXml.curve.at( 0 ).getC1( i ) );
+        QCOMPARE( fromBin.curve.at( 0 ).getPressure( i ), fromXml.curve.at( 0 ).getPressure( i ) );
+    }
+    QCOMPARE( fromBin.curve.at( 0 ).getWidth(), fromXml.curve.at( 0 ).getWidth() );
+    QCOMPARE( fromBin.curve.at( 0 ).getFeather(), fromXml.curve.at( 0 ).getFeather() );
+
+    // the binary file is the smaller one
+    QVERIFY( QFileInfo( binPath ).size() < QFileInfo( xmlPath ).size() );
+
+    QFile::remove( xmlPath );
+    QFile::remove( binPath );
+}
+
+void TestVectorImage::testChangedRectOfNewCurve()
+{
+    VectorImage image;
+    addSquare( image, QRectF( 0, 0, 100, 100 ) );
+    image.setModified( false );
+
+    // a stroke far from the square only changes its own surroundings
+    BezierCurve stroke = lineCurve( QPointF( 500, 500 ), QPointF( 600, 520 ) );
+    image.addCurve( stroke, 1.0 );
+    QVERIFY( image.isModified() );
+    QRectF changed = image.getChangedRect();
+    QVERIFY( !changed.isNull() );
+    QVERIFY( changed.contains( QRectF( 500, 500, 100, 20 ) ) );
+    QVERIFY( !changed.intersects( QRectF( 0, 0, 100, 100 ) ) );
+
+    // changes without an extent make the whole image change
+    image.setModified( false );
+    image.setModified( true );
+    QVERIFY( image.getChangedRect().isNull() );
+}
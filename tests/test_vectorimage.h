@@ -0,0 +1,30 @@
+
+#ifndef TEST_VECTORIMAGE_H
+#define TEST_VECTORIMAGE_H
+
+
+#include <QtTest>
+#include "AutoTest.h"
+
+
+class TestVectorImage : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestVectorImage();
+
+private slots:
+    void testContourOfSquare();
+    void testContourOutside();
+    void testContourWithGap();
+    void testContourIgnoresDanglingStroke();
+    void testContourOfInnerSquare();
+    void testBinaryRoundTrip();
+    void testBinaryMatchesXml();
+    void testChangedRectOfNewCurve();
+};
+
+DECLARE_TEST(TestVectorImage)
+
+#endif // TEST_VECTORIMAGE_H